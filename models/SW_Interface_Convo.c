@@ -1,20 +1,71 @@
-// Memory-mapped register addresses (as defined by the hardware design)
-#define ACCELERATOR_START_ADDR  0x80001000
-#define ACCELERATOR_INPUT_ADDR  0x80001004
-#define ACCELERATOR_OUTPUT_ADDR 0x80001008
-#define ACCELERATOR_OP_TYPE     0x8000100C
-#define ACCELERATOR_START       0x80001010
-
-// Example function to start convolution operation
-void start_convolution(uint32_t input_addr, uint32_t output_addr) {
-    // Set input and output data addresses
-    *((volatile uint32_t *) ACCELERATOR_INPUT_ADDR) = input_addr;
-    *((volatile uint32_t *) ACCELERATOR_OUTPUT_ADDR) = output_addr;
-
-    // Set operation type to "convolution" (assuming 0 is convolution)
-    *((volatile uint32_t *) ACCELERATOR_OP_TYPE) = 0;
-
-    // Start the hardware accelerator
-    *((volatile uint32_t *) ACCELERATOR_START) = 1;
+#include <stdint.h>
+#include <stdio.h>
+
+#include "cnn_driver.h"
+
+// Example use of the accelerator through cnn_driver.h
+//
+// Build (RISC-V): riscv64-unknown-elf-gcc -O2 -c SW_Interface_Convo.c cnn_driver.c
+
+// Base address of the accelerator (data RAM, filter RAM, registers)
+#define ACCELERATOR_BASE        0x80000000
+
+// Build of the accelerator: MAX_SIZE and single precision operands
+#define ACCELERATOR_MAX_SIZE    4096
+#define ACCELERATOR_ELEM_BYTES  4
+
+static cnn_device accelerator;
+
+void accelerator_init(void) {
+    cnn_device_init_mmio(&accelerator, ACCELERATOR_BASE, ACCELERATOR_MAX_SIZE, ACCELERATOR_ELEM_BYTES);
 }
 
+// Example function to start a 'same' convolution of an n x n image with a
+// k x k filter, poll the returned job with cnn_poll or cnn_wait
+int start_convolution(const uint32_t *image, int n, const uint32_t *filt, int k, uint32_t *output,
+    cnn_job *job) {
+    cnn_job_config cfg;
+    cnn_job_config_init(&cfg);
+    cfg.opType   = CNN_OP_CONV;
+    cfg.pad      = k / 2;
+    cfg.filtRows = k;
+    cfg.filtCols = k;
+    cfg.dataRows = n;
+    cfg.dataCols = n;
+
+    cnn_load_filter(&accelerator, filt, (size_t) k * k);
+    cnn_load_data(&accelerator, image, (size_t) n * n);
+    return cnn_submit(&accelerator, &cfg, job, output);
+}
+
+// Example function to start matrix multiply C = A * B
+// A is rows x inner row-major, B is given column-major (cols x inner)
+int start_matmul(const uint32_t *a, const uint32_t *bt, int rows, int inner, int cols, uint32_t *output,
+    cnn_job *job) {
+    cnn_job_config cfg;
+    cnn_job_config_init(&cfg);
+    cfg.opType   = CNN_OP_GEMM;
+    cfg.filtRows = cols;
+    cfg.filtCols = inner;
+    cfg.dataRows = rows;
+    cfg.dataCols = inner;
+
+    cnn_load_filter(&accelerator, bt, (size_t) cols * inner);
+    cnn_load_data(&accelerator, a, (size_t) rows * inner);
+    return cnn_submit(&accelerator, &cfg, job, output);
+}
+
+// Run a convolution to completion and print the performance counters
+int run_convolution(const uint32_t *image, int n, const uint32_t *filt, int k, uint32_t *output) {
+    cnn_job job;
+    cnn_perf_start(&accelerator);
+    if (start_convolution(image, n, filt, k, output, &job) != CNN_OK) {
+        return -1;
+    }
+    int result = cnn_wait(&accelerator, &job);
+    cnn_perf_stop(&accelerator);
+    for (int sel = 0; sel < CNN_PERF_EVENTS; sel++) {
+        printf("%-17s %lu\n", cnn_perf_name(sel), (unsigned long) cnn_perf_read(&accelerator, sel));
+    }
+    return (result == CNN_DONE) ? 0 : -1;
+}
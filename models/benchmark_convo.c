@@ -1,25 +1,52 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define CONVO_X86
+#endif
+
+// CPU baselines for 'same' 2D convolution with zero padding
+//
+// Build with: gcc -O3 -fopenmp benchmark_convo.c -o benchmark_convo -lpthread -lm
+// (-fopenmp is optional and only enables the OpenMP variant)
+//
+// Usage: benchmark_convo           1024x1024 image, 5x5 kernel, all variants
+//        benchmark_convo --sweep   sweep image and kernel sizes
+//        benchmark_convo --accel   sweep the sizes the accelerator holds
+//                                  (images up to the 4096-element data RAM)
 
 #define IMAGE_SIZE 1024  // Define the size of the input image (IMAGE_SIZE x IMAGE_SIZE)
 #define KERNEL_SIZE 5    // Define the size of the kernel (KERNEL_SIZE x KERNEL_SIZE)
 
+#define ALIGNMENT 64     // Alignment of contiguous buffers (cache line / AVX-512)
+#define TILE_COLS 512    // Output columns per tile, keeps KERNEL rows of a tile in L1
+#define NUM_RUNS  3      // Best of NUM_RUNS is reported
+
 // Function to perform 2D convolution
-void cpu_convolution(float **image, float **kernel, float **output) {
+// Original baseline: row-pointer arrays with a bounds check per tap
+void cpu_convolution(float **image, float **kernel, float **output, int imageSize, int kernelSize) {
     int i, j, m, n;
-    int kernel_radius = KERNEL_SIZE / 2;
+    int kernel_radius = kernelSize / 2;
 
     // Iterate over each pixel in the output image
-    for (i = 0; i < IMAGE_SIZE; i++) {
-        for (j = 0; j < IMAGE_SIZE; j++) {
+    for (i = 0; i < imageSize; i++) {
+        for (j = 0; j < imageSize; j++) {
             float sum = 0.0;
 
             // Apply the kernel to the surrounding pixels
             for (m = -kernel_radius; m <= kernel_radius; m++) {
                 for (n = -kernel_radius; n <= kernel_radius; n++) {
                     // Check if the indices are within bounds
-                    if ((i + m >= 0 && i + m < IMAGE_SIZE) && (j + n >= 0 && j + n < IMAGE_SIZE)) {
+                    if ((i + m >= 0 && i + m < imageSize) && (j + n >= 0 && j + n < imageSize)) {
                         sum += image[i + m][j + n] * kernel[m + kernel_radius][n + kernel_radius];
                     }
                 }
@@ -31,59 +58,457 @@ void cpu_convolution(float **image, float **kernel, float **output) {
     }
 }
 
-int main() {
-    // Dynamically allocate memory for image, kernel, and output arrays
-    float **image = (float **)malloc(IMAGE_SIZE * sizeof(float *));
-    float **output = (float **)malloc(IMAGE_SIZE * sizeof(float *));
-    for (int i = 0; i < IMAGE_SIZE; i++) {
-        image[i] = (float *)malloc(IMAGE_SIZE * sizeof(float));
-        output[i] = (float *)malloc(IMAGE_SIZE * sizeof(float));
+// Problem description shared by the contiguous variants
+typedef struct {
+    const float *image;
+    const float *kernel;
+    float *output;
+    int imageSize;
+    int kernelSize;
+} conv_problem;
+
+// Kernel used for the rows [rowStart, rowEnd) of the output
+typedef void (*conv_rows_fn)(const conv_problem *p, int rowStart, int rowEnd);
+
+// Single output pixel with bounds checks, only used near the border
+static float conv_pixel_checked(const conv_problem *p, int i, int j) {
+    int n = p->imageSize;
+    int k = p->kernelSize;
+    int r = k / 2;
+    float sum = 0.0f;
+    for (int m = 0; m < k; m++) {
+        int row = i + m - r;
+        if (row < 0 || row >= n) {
+            continue;
+        }
+        for (int c = 0; c < k; c++) {
+            int col = j + c - r;
+            if (col >= 0 && col < n) {
+                sum += p->image[(size_t)row * n + col] * p->kernel[m * k + c];
+            }
+        }
     }
+    return sum;
+}
 
-    float **kernel = (float **)malloc(KERNEL_SIZE * sizeof(float *));
-    for (int i = 0; i < KERNEL_SIZE; i++) {
-        kernel[i] = (float *)malloc(KERNEL_SIZE * sizeof(float));
+// Border pixels of one output row: all columns for the top/bottom rows,
+// otherwise only the left and right kernel radius
+static void conv_row_border(const conv_problem *p, int i) {
+    int n = p->imageSize;
+    int r = p->kernelSize / 2;
+    float *out = p->output + (size_t)i * n;
+    if (i < r || i >= n - r) {
+        for (int j = 0; j < n; j++) {
+            out[j] = conv_pixel_checked(p, i, j);
+        }
+        return;
+    }
+    for (int j = 0; j < r && j < n; j++) {
+        out[j] = conv_pixel_checked(p, i, j);
     }
+    for (int j = (n - r > r) ? n - r : r; j < n; j++) {
+        out[j] = conv_pixel_checked(p, i, j);
+    }
+}
 
-    // Populate the image with random values
-    for (int i = 0; i < IMAGE_SIZE; i++) {
-        for (int j = 0; j < IMAGE_SIZE; j++) {
-            image[i][j] = (float)(rand() % 256);  // Random values between 0 and 255
+static int row_is_interior(const conv_problem *p, int i) {
+    int r = p->kernelSize / 2;
+    return i >= r && i < p->imageSize - r;
+}
+
+// Contiguous storage, border handling hoisted out of the inner loops
+static void conv_rows_contiguous(const conv_problem *p, int rowStart, int rowEnd) {
+    int n = p->imageSize;
+    int k = p->kernelSize;
+    int r = k / 2;
+    for (int i = rowStart; i < rowEnd; i++) {
+        conv_row_border(p, i);
+        if (!row_is_interior(p, i)) {
+            continue;
+        }
+        float *out = p->output + (size_t)i * n;
+        for (int j = r; j < n - r; j++) {
+            const float *window = p->image + (size_t)(i - r) * n + (j - r);
+            float sum = 0.0f;
+            for (int m = 0; m < k; m++) {
+                for (int c = 0; c < k; c++) {
+                    sum += window[(size_t)m * n + c] * p->kernel[m * k + c];
+                }
+            }
+            out[j] = sum;
+        }
+    }
+}
+
+#ifdef CONVO_X86
+
+// Interior pixels are computed *_BLOCK vectors of outputs at a time:
+// each tap is broadcast and multiplied against shifted input rows.
+// Columns are processed in tiles so the kernel rows of a tile stay in L1.
+
+#define AVX2_BLOCK 4
+
+__attribute__((target("avx2,fma")))
+static void conv_rows_avx2(const conv_problem *p, int rowStart, int rowEnd) {
+    int n = p->imageSize;
+    int k = p->kernelSize;
+    int r = k / 2;
+    int colEnd = n - r;
+    for (int i = rowStart; i < rowEnd; i++) {
+        conv_row_border(p, i);
+    }
+    for (int tile = r; tile < colEnd; tile += TILE_COLS) {
+        int tileEnd = (tile + TILE_COLS < colEnd) ? tile + TILE_COLS : colEnd;
+        for (int i = rowStart; i < rowEnd; i++) {
+            if (!row_is_interior(p, i)) {
+                continue;
+            }
+            float *out = p->output + (size_t)i * n;
+            const float *base = p->image + (size_t)(i - r) * n - r;
+            int j = tile;
+            for (; j + 8 * AVX2_BLOCK <= tileEnd; j += 8 * AVX2_BLOCK) {
+                __m256 acc[AVX2_BLOCK];
+                for (int v = 0; v < AVX2_BLOCK; v++) {
+                    acc[v] = _mm256_setzero_ps();
+                }
+                for (int m = 0; m < k; m++) {
+                    const float *row = base + (size_t)m * n + j;
+                    for (int c = 0; c < k; c++) {
+                        __m256 w = _mm256_broadcast_ss(&p->kernel[m * k + c]);
+                        for (int v = 0; v < AVX2_BLOCK; v++) {
+                            acc[v] = _mm256_fmadd_ps(_mm256_loadu_ps(row + c + 8 * v), w, acc[v]);
+                        }
+                    }
+                }
+                for (int v = 0; v < AVX2_BLOCK; v++) {
+                    _mm256_storeu_ps(out + j + 8 * v, acc[v]);
+                }
+            }
+            for (; j + 8 <= tileEnd; j += 8) {
+                __m256 acc = _mm256_setzero_ps();
+                for (int m = 0; m < k; m++) {
+                    const float *row = base + (size_t)m * n + j;
+                    for (int c = 0; c < k; c++) {
+                        acc = _mm256_fmadd_ps(_mm256_loadu_ps(row + c), _mm256_broadcast_ss(&p->kernel[m * k + c]), acc);
+                    }
+                }
+                _mm256_storeu_ps(out + j, acc);
+            }
+            for (; j < tileEnd; j++) {
+                const float *window = base + j;
+                float sum = 0.0f;
+                for (int m = 0; m < k; m++) {
+                    for (int c = 0; c < k; c++) {
+                        sum += window[(size_t)m * n + c] * p->kernel[m * k + c];
+                    }
+                }
+                out[j] = sum;
+            }
+        }
+    }
+}
+
+#define AVX512_BLOCK 4
+
+__attribute__((target("avx512f")))
+static void conv_rows_avx512(const conv_problem *p, int rowStart, int rowEnd) {
+    int n = p->imageSize;
+    int k = p->kernelSize;
+    int r = k / 2;
+    int colEnd = n - r;
+    for (int i = rowStart; i < rowEnd; i++) {
+        conv_row_border(p, i);
+    }
+    for (int tile = r; tile < colEnd; tile += TILE_COLS) {
+        int tileEnd = (tile + TILE_COLS < colEnd) ? tile + TILE_COLS : colEnd;
+        for (int i = rowStart; i < rowEnd; i++) {
+            if (!row_is_interior(p, i)) {
+                continue;
+            }
+            float *out = p->output + (size_t)i * n;
+            const float *base = p->image + (size_t)(i - r) * n - r;
+            int j = tile;
+            for (; j + 16 * AVX512_BLOCK <= tileEnd; j += 16 * AVX512_BLOCK) {
+                __m512 acc[AVX512_BLOCK];
+                for (int v = 0; v < AVX512_BLOCK; v++) {
+                    acc[v] = _mm512_setzero_ps();
+                }
+                for (int m = 0; m < k; m++) {
+                    const float *row = base + (size_t)m * n + j;
+                    for (int c = 0; c < k; c++) {
+                        __m512 w = _mm512_set1_ps(p->kernel[m * k + c]);
+                        for (int v = 0; v < AVX512_BLOCK; v++) {
+                            acc[v] = _mm512_fmadd_ps(_mm512_loadu_ps(row + c + 16 * v), w, acc[v]);
+                        }
+                    }
+                }
+                for (int v = 0; v < AVX512_BLOCK; v++) {
+                    _mm512_storeu_ps(out + j + 16 * v, acc[v]);
+                }
+            }
+            // Remaining columns use a masked vector
+            for (; j < tileEnd; j += 16) {
+                int count = (tileEnd - j < 16) ? tileEnd - j : 16;
+                __mmask16 mask = (__mmask16)((1u << count) - 1);
+                __m512 acc = _mm512_setzero_ps();
+                for (int m = 0; m < k; m++) {
+                    const float *row = base + (size_t)m * n + j;
+                    for (int c = 0; c < k; c++) {
+                        acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, row + c), _mm512_set1_ps(p->kernel[m * k + c]), acc);
+                    }
+                }
+                _mm512_mask_storeu_ps(out + j, mask, acc);
+            }
+        }
+    }
+}
+
+#endif
+
+// Best single-threaded kernel supported by the host
+static conv_rows_fn best_rows_fn(const char **name) {
+#ifdef CONVO_X86
+    if (__builtin_cpu_supports("avx512f")) {
+        *name = "avx512";
+        return conv_rows_avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        *name = "avx2";
+        return conv_rows_avx2;
+    }
+#endif
+    *name = "contiguous";
+    return conv_rows_contiguous;
+}
+
+// Thread pool variant: output rows are split into contiguous bands
+typedef struct {
+    const conv_problem *problem;
+    conv_rows_fn fn;
+    int rowStart;
+    int rowEnd;
+} conv_band;
+
+static void *conv_band_worker(void *arg) {
+    conv_band *band = (conv_band *)arg;
+    band->fn(band->problem, band->rowStart, band->rowEnd);
+    return NULL;
+}
+
+static int numThreads = 1;
+static conv_rows_fn simdRows = conv_rows_contiguous;
+
+static void conv_pthreads(const conv_problem *p) {
+    pthread_t threads[256];
+    conv_band bands[256];
+    int count = (numThreads < 256) ? numThreads : 256;
+    int n = p->imageSize;
+    for (int t = 0; t < count; t++) {
+        bands[t].problem = p;
+        bands[t].fn = simdRows;
+        bands[t].rowStart = (int)((long)n * t / count);
+        bands[t].rowEnd = (int)((long)n * (t + 1) / count);
+        pthread_create(&threads[t], NULL, conv_band_worker, &bands[t]);
+    }
+    for (int t = 0; t < count; t++) {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+#ifdef _OPENMP
+static void conv_openmp(const conv_problem *p) {
+    // Bands of 8 rows keep the kernel rows shared between neighbours in cache
+    int n = p->imageSize;
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int band = 0; band < (n + 7) / 8; band++) {
+        int rowEnd = (band * 8 + 8 < n) ? band * 8 + 8 : n;
+        simdRows(p, band * 8, rowEnd);
+    }
+}
+#endif
+
+static void conv_contiguous(const conv_problem *p) {
+    conv_rows_contiguous(p, 0, p->imageSize);
+}
+
+static void conv_simd(const conv_problem *p) {
+    simdRows(p, 0, p->imageSize);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *aligned_buffer(size_t numFloats) {
+    size_t bytes = (numFloats * sizeof(float) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    void *ptr = aligned_alloc(ALIGNMENT, bytes);
+    if (!ptr) {
+        printf("Allocation of %zu bytes failed\n", bytes);
+        exit(1);
+    }
+    return ptr;
+}
+
+// Print one result line, GFLOP/s counts every tap including the padding
+static void report(const char *variant, int imageSize, int kernelSize, double seconds, double maxErr) {
+    double outputs = (double)imageSize * imageSize;
+    double flops = 2.0 * outputs * kernelSize * kernelSize;
+    printf("%-12s %6d %4d %12.6f %10.3f %10.3f %10.2e\n", variant, imageSize, kernelSize, seconds,
+        flops / seconds * 1e-9, seconds / outputs * 1e9, maxErr);
+}
+
+static double max_error(const float *a, const float *b, size_t count) {
+    double err = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        double d = fabs((double)a[i] - (double)b[i]);
+        if (d > err) {
+            err = d;
         }
     }
+    return err;
+}
 
-    // Define a 5x5 kernel (edge detection kernel)
-    kernel[0][0] = -1; kernel[0][1] = -1; kernel[0][2] = -1; kernel[0][3] = -1; kernel[0][4] = -1;
-    kernel[1][0] = -1; kernel[1][1] =  1; kernel[1][2] =  1; kernel[1][3] =  1; kernel[1][4] = -1;
-    kernel[2][0] = -1; kernel[2][1] =  1; kernel[2][2] =  8; kernel[2][3] =  1; kernel[2][4] = -1;
-    kernel[3][0] = -1; kernel[3][1] =  1; kernel[3][2] =  1; kernel[3][3] =  1; kernel[3][4] = -1;
-    kernel[4][0] = -1; kernel[4][1] = -1; kernel[4][2] = -1; kernel[4][3] = -1; kernel[4][4] = -1;
+typedef void (*conv_fn)(const conv_problem *p);
 
-    // Start measuring execution time
-    clock_t start = clock();
+static double time_variant(conv_fn fn, const conv_problem *p) {
+    double best = 1e30;
+    for (int run = 0; run < NUM_RUNS; run++) {
+        double start = now_seconds();
+        fn(p);
+        double t = now_seconds() - start;
+        if (t < best) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+// Run every variant for one image/kernel size and check against the naive result
+static int benchmark(int imageSize, int kernelSize, const float *kernelValues, int includeNaive) {
+    size_t numPixels = (size_t)imageSize * imageSize;
+    float *image = (float *)aligned_buffer(numPixels);
+    float *kernel = (float *)aligned_buffer((size_t)kernelSize * kernelSize);
+    float *reference = (float *)aligned_buffer(numPixels);
+    float *output = (float *)aligned_buffer(numPixels);
+
+    // Populate the image with random values
+    for (size_t i = 0; i < numPixels; i++) {
+        image[i] = (float)(rand() % 256);  // Random values between 0 and 255
+    }
+    for (int i = 0; i < kernelSize * kernelSize; i++) {
+        kernel[i] = kernelValues ? kernelValues[i] : (float)(rand() % 17 - 8) / 8.0f;
+    }
 
-    // Perform the convolution
-    cpu_convolution(image, kernel, output);
+    conv_problem problem = {image, kernel, reference, imageSize, kernelSize};
 
-    // Stop measuring execution time
-    clock_t end = clock();
+    // Original row-pointer baseline over the same storage
+    if (includeNaive) {
+        float **imageRows = (float **)malloc(imageSize * sizeof(float *));
+        float **outputRows = (float **)malloc(imageSize * sizeof(float *));
+        float **kernelRows = (float **)malloc(kernelSize * sizeof(float *));
+        for (int i = 0; i < imageSize; i++) {
+            imageRows[i] = image + (size_t)i * imageSize;
+            outputRows[i] = output + (size_t)i * imageSize;
+        }
+        for (int i = 0; i < kernelSize; i++) {
+            kernelRows[i] = kernel + (size_t)i * kernelSize;
+        }
+        double start = now_seconds();
+        cpu_convolution(imageRows, kernelRows, outputRows, imageSize, kernelSize);
+        double t = now_seconds() - start;
+        free(imageRows);
+        free(outputRows);
+        free(kernelRows);
+        conv_contiguous(&problem);
+        report("naive", imageSize, kernelSize, t, max_error(reference, output, numPixels));
+    }
 
-    // Calculate and print the execution time
-    double time_spent = (double)(end - start) / CLOCKS_PER_SEC;
-    printf("Execution time (CPU convolution): %f seconds\n", time_spent);
+    // Tolerance allows for reassociation and FMA in the vector kernels
+    double tolerance = 0.0;
+    for (int i = 0; i < kernelSize * kernelSize; i++) {
+        tolerance += 255.0 * fabs(kernel[i]);
+    }
+    tolerance *= 1e-5;
 
-    // Free dynamically allocated memory
-    for (int i = 0; i < IMAGE_SIZE; i++) {
-        free(image[i]);
-        free(output[i]);
+    const char *simdName;
+    simdRows = best_rows_fn(&simdName);
+
+    const char *names[4] = {"contiguous", simdName, "pthreads", "openmp"};
+    conv_fn fns[4] = {conv_contiguous, conv_simd, conv_pthreads, NULL};
+#ifdef _OPENMP
+    fns[3] = conv_openmp;
+#endif
+
+    int errors = 0;
+    problem.output = output;
+    for (int v = 0; v < 4; v++) {
+        if (!fns[v]) {
+            continue;
+        }
+        memset(output, 0, numPixels * sizeof(float));
+        double t = time_variant(fns[v], &problem);
+        double err = max_error(reference, output, numPixels);
+        if (err > tolerance) {
+            printf("Mismatch in %s variant (max error %e)\n", names[v], err);
+            errors++;
+        }
+        report(names[v], imageSize, kernelSize, t, err);
     }
+
     free(image);
+    free(kernel);
+    free(reference);
     free(output);
+    return errors;
+}
 
-    for (int i = 0; i < KERNEL_SIZE; i++) {
-        free(kernel[i]);
+int main(int argc, char **argv) {
+    int sweep = (argc > 1) && (strcmp(argv[1], "--sweep") == 0);
+    int accel = (argc > 1) && (strcmp(argv[1], "--accel") == 0);
+
+    numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(numThreads);
+#endif
+    srand(0);
+
+    printf("Threads: %d\n", numThreads);
+    printf("%-12s %6s %4s %12s %10s %10s %10s\n", "variant", "image", "k", "seconds", "GFLOP/s", "ns/output", "max_err");
+
+    int errors = 0;
+    if (sweep) {
+        const int imageSizes[] = {64, 256, 1024, 2048};
+        const int kernelSizes[] = {1, 3, 5, 7, 11};
+        for (size_t i = 0; i < sizeof(imageSizes) / sizeof(imageSizes[0]); i++) {
+            for (size_t j = 0; j < sizeof(kernelSizes) / sizeof(kernelSizes[0]); j++) {
+                errors += benchmark(imageSizes[i], kernelSizes[j], NULL, imageSizes[i] <= 1024);
+            }
+        }
+    } else if (accel) {
+        const int imageSizes[] = {8, 16, 32, 64};
+        const int kernelSizes[] = {1, 3, 5, 7, 9, 11};
+        for (size_t i = 0; i < sizeof(imageSizes) / sizeof(imageSizes[0]); i++) {
+            for (size_t j = 0; j < sizeof(kernelSizes) / sizeof(kernelSizes[0]); j++) {
+                if (kernelSizes[j] <= imageSizes[i]) {
+                    errors += benchmark(imageSizes[i], kernelSizes[j], NULL, 1);
+                }
+            }
+        }
+    } else {
+        // Define a 5x5 kernel (edge detection kernel)
+        const float edgeKernel[KERNEL_SIZE * KERNEL_SIZE] = {
+            -1, -1, -1, -1, -1,
+            -1,  1,  1,  1, -1,
+            -1,  1,  8,  1, -1,
+            -1,  1,  1,  1, -1,
+            -1, -1, -1, -1, -1};
+        errors += benchmark(IMAGE_SIZE, KERNEL_SIZE, edgeKernel, 1);
     }
-    free(kernel);
 
-    return 0;
+    return errors ? 1 : 0;
 }
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "floating_point.h"
+
+// Throughput benchmark for the batched floating-point models
+// Build with: gcc -O2 benchmark_floating_point.c floating_point.c -o benchmark_floating_point
+
+#define NUM_ELEMENTS (1 << 24)  // Number of operand pairs per run
+#define NUM_RUNS     3          // Best of NUM_RUNS is reported
+
+// Xorshift generator, keeps operand generation deterministic and fast
+static uint64_t rngState = 88172645463325252ull;
+
+static uint32_t next_random(void) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return (uint32_t)rngState;
+}
+
+// Biased operands: mostly uniform bit patterns with extra subnormals,
+// Inf/NaN, all-ones mantissas (round carries) and close exponents
+static uint32_t random_operand(void) {
+    uint32_t x = next_random();
+    switch (next_random() % 8) {
+        case 0:  return x & 0x807FFFFF;
+        case 1:  return (x & 0x80000000) | 0x7F800000 | ((x & 4) ? (x & 0x7FFFFF) : 0);
+        case 2:  return x | 0x007FFFFF;
+        default: return x;
+    }
+}
+
+// Adder corner cases where the RTL differs from the old MEX model:
+// a rounding carry into the exponent, -Inf + Inf and a NaN payload
+static const uint32_t addVectors[][3] = {
+    {0x3F7FFFFF, 0x33400000, 0x3F800000},  // 1 - 2^-24 rounds up to 1.0 (old: 0x3F000000)
+    {0x4B7FFFFF, 0x3F000001, 0x4B800000},  // 2^24 - 1 rounds up to 2^24 (old: 0x4B000000)
+    {0xFF800000, 0x7F800000, 0x7FC00000},  // -Inf + Inf is NaN (old: -Inf)
+    {0x7F800123, 0x3F800000, 0x7FC00000},  // NaN inputs return the RTL payload
+};
+
+#define NUM_ADD_VECTORS (sizeof(addVectors) / sizeof(addVectors[0]))
+
+typedef void (*array_op)(floating_point_impl, float *, const float *, const float *, size_t);
+
+static double run(array_op op, floating_point_impl impl, float *out, const float *a, const float *b) {
+    double best = 1e30;
+    for (int r = 0; r < NUM_RUNS; r++) {
+        clock_t start = clock();
+        op(impl, out, a, b, NUM_ELEMENTS);
+        clock_t end = clock();
+        double t = (double)(end - start) / CLOCKS_PER_SEC;
+        if (t < best) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+int main() {
+    float *a = (float *)malloc(NUM_ELEMENTS * sizeof(float));
+    float *b = (float *)malloc(NUM_ELEMENTS * sizeof(float));
+    float *ref = (float *)malloc(NUM_ELEMENTS * sizeof(float));
+    float *out = (float *)malloc(NUM_ELEMENTS * sizeof(float));
+    if (!a || !b || !ref || !out) {
+        printf("Allocation failed\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < NUM_ELEMENTS; i++) {
+        uint32_t x = random_operand();
+        uint32_t y = random_operand();
+        // Every other pair shares an exponent to exercise cancellation
+        if (i & 1) {
+            y = (y & 0x807FFFFF) | (x & 0x7F800000);
+        }
+        memcpy(&a[i], &x, sizeof(float));
+        memcpy(&b[i], &y, sizeof(float));
+    }
+
+    // Every kernel must reproduce the fixed adder vectors
+    int errors = 0;
+    for (int impl = FLOATING_POINT_SCALAR; impl < FLOATING_POINT_NUM_IMPLS; impl++) {
+        if (!floating_point_impl_supported((floating_point_impl)impl)) {
+            continue;
+        }
+        for (size_t i = 0; i < NUM_ADD_VECTORS; i++) {
+            float x, y, sum;
+            uint32_t sumBits;
+            memcpy(&x, &addVectors[i][0], sizeof(float));
+            memcpy(&y, &addVectors[i][1], sizeof(float));
+            floating_point_add_array_impl((floating_point_impl)impl, &sum, &x, &y, 1);
+            memcpy(&sumBits, &sum, sizeof(float));
+            if (sumBits != addVectors[i][2]) {
+                printf("%s: 0x%08X + 0x%08X = 0x%08X, expected 0x%08X\n",
+                    floating_point_impl_name((floating_point_impl)impl),
+                    addVectors[i][0], addVectors[i][1], sumBits, addVectors[i][2]);
+                errors++;
+            }
+        }
+    }
+
+    const char *opNames[2] = {"add", "multiply"};
+    array_op ops[2] = {floating_point_add_array_impl, floating_point_multiply_array_impl};
+
+    printf("%-10s %-8s %12s %10s %8s\n", "op", "kernel", "Mops/s", "speedup", "exact");
+    for (int k = 0; k < 2; k++) {
+        double scalarTime = run(ops[k], FLOATING_POINT_SCALAR, ref, a, b);
+        for (int impl = FLOATING_POINT_SCALAR; impl < FLOATING_POINT_NUM_IMPLS; impl++) {
+            if (!floating_point_impl_supported((floating_point_impl)impl)) {
+                printf("%-10s %-8s %12s\n", opNames[k], floating_point_impl_name((floating_point_impl)impl), "n/a");
+                continue;
+            }
+            double t = (impl == FLOATING_POINT_SCALAR) ? scalarTime : run(ops[k], (floating_point_impl)impl, out, a, b);
+            int exact = (impl == FLOATING_POINT_SCALAR) || (memcmp(ref, out, NUM_ELEMENTS * sizeof(float)) == 0);
+            errors += !exact;
+            printf("%-10s %-8s %12.1f %9.2fx %8s\n", opNames[k], floating_point_impl_name((floating_point_impl)impl),
+                NUM_ELEMENTS / t / 1e6, scalarTime / t, exact ? "yes" : "NO");
+        }
+    }
+
+    free(a);
+    free(b);
+    free(ref);
+    free(out);
+
+    return errors ? 1 : 0;
+}
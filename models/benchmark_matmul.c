@@ -1,50 +1,466 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <time.h>
 
-#define N 512  // Size of the matrices (NxN)
+// CPU baselines for single-precision matrix multiplication C = A * B
+//
+// Host build:   gcc -O3 benchmark_matmul.c -o benchmark_matmul -lpthread
+// Rocket Chip:  build Matmul_bm_rocketchip.c (defines MATMUL_BARE_METAL) with the
+//               Chipyard bare-metal toolchain. Only the scalar kernels and the
+//               cycle counter are used on that target.
+//
+// Variants:
+//   naive     original i-j-k loop, column-strided access to B
+//   blocked   cache-blocked GEMM with packed A/B panels and a scalar microkernel
+//   avx2      blocked GEMM with a 6x16 AVX2/FMA microkernel (host only)
+//   avx512    blocked GEMM with a 14x32 AVX-512 microkernel (host only)
+//   threads   fastest microkernel with C row blocks split across cores (host only)
+
+#if defined(__riscv) && !defined(__linux__) && !defined(MATMUL_BARE_METAL)
+#define MATMUL_BARE_METAL
+#endif
+
+#ifndef MATMUL_BARE_METAL
+#include <pthread.h>
+#include <unistd.h>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#include <x86intrin.h>
+#define MATMUL_X86
+#endif
+#endif
+
+#define ALIGNMENT 64    // Alignment of matrix and packing buffers
+
+// Cache blocking: KC x NC panel of B stays in L2/L3, MC x KC block of A in L2
+#define BLOCK_MC  112
+#define BLOCK_KC  256
+#define BLOCK_NC  2048
+
+// Largest microkernel tile
+#define MAX_MR    14
+#define MAX_NR    32
+
+#ifdef MATMUL_BARE_METAL
+#define NUM_RUNS  1
+#else
+#define NUM_RUNS  3
+#endif
 
 // Function to multiply two matrices A and B and store the result in matrix C
-void matrix_multiply(float A[N][N], float B[N][N], float C[N][N]) {
-    for (int i = 0; i < N; i++) {
-        for (int j = 0; j < N; j++) {
-            C[i][j] = 0;
-            for (int k = 0; k < N; k++) {
-                C[i][j] += A[i][k] * B[k][j];
+void matrix_multiply(const float *A, const float *B, float *C, int n) {
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            C[i * n + j] = 0;
+            for (int k = 0; k < n; k++) {
+                C[i * n + j] += A[i * n + k] * B[k * n + j];
+            }
+        }
+    }
+}
+
+// Cycle counter of the target
+static inline uint64_t read_cycles(void) {
+#if defined(__riscv)
+    uint64_t cycles;
+    __asm__ volatile ("rdcycle %0" : "=r"(cycles));
+    return cycles;
+#elif defined(MATMUL_X86)
+    return __rdtsc();
+#else
+    return (uint64_t)clock();
+#endif
+}
+
+static double now_seconds(void) {
+#ifdef MATMUL_BARE_METAL
+    return 0.0;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Aligned heap allocation built on malloc so it also works on bare metal
+static void *aligned_buffer(size_t bytes) {
+    unsigned char *raw = (unsigned char *)malloc(bytes + ALIGNMENT + sizeof(void *));
+    if (!raw) {
+        printf("Allocation of %lu bytes failed\n", (unsigned long)bytes);
+        exit(1);
+    }
+    uintptr_t addr = ((uintptr_t)(raw + sizeof(void *)) + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1);
+    ((void **)addr)[-1] = raw;
+    return (void *)addr;
+}
+
+static void aligned_free(void *ptr) {
+    if (ptr) {
+        free(((void **)ptr)[-1]);
+    }
+}
+
+// Microkernel computes an mr x nr tile: C += Apanel * Bpanel over kc
+// Apanel is stored column-by-column (mr values per k), Bpanel row-by-row (nr values per k)
+typedef void (*microkernel_fn)(int kc, const float *a, const float *b, float *c, int ldc);
+
+typedef struct {
+    const char *name;
+    int mr;
+    int nr;
+    microkernel_fn kernel;
+} gemm_kernel;
+
+#define SCALAR_MR 4
+#define SCALAR_NR 8
+
+static void microkernel_scalar(int kc, const float *a, const float *b, float *c, int ldc) {
+    float acc[SCALAR_MR][SCALAR_NR] = {{0}};
+    for (int k = 0; k < kc; k++) {
+        for (int i = 0; i < SCALAR_MR; i++) {
+            float aik = a[k * SCALAR_MR + i];
+            for (int j = 0; j < SCALAR_NR; j++) {
+                acc[i][j] += aik * b[k * SCALAR_NR + j];
+            }
+        }
+    }
+    for (int i = 0; i < SCALAR_MR; i++) {
+        for (int j = 0; j < SCALAR_NR; j++) {
+            c[i * ldc + j] += acc[i][j];
+        }
+    }
+}
+
+#ifdef MATMUL_X86
+
+__attribute__((target("avx2,fma")))
+static void microkernel_avx2(int kc, const float *a, const float *b, float *c, int ldc) {
+    // 6 rows x 2 vectors of 8 columns = 12 accumulators
+    __m256 acc[6][2];
+    for (int i = 0; i < 6; i++) {
+        acc[i][0] = _mm256_setzero_ps();
+        acc[i][1] = _mm256_setzero_ps();
+    }
+    for (int k = 0; k < kc; k++) {
+        __m256 b0 = _mm256_load_ps(b + k * 16);
+        __m256 b1 = _mm256_load_ps(b + k * 16 + 8);
+        for (int i = 0; i < 6; i++) {
+            __m256 ai = _mm256_broadcast_ss(a + k * 6 + i);
+            acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+        }
+    }
+    for (int i = 0; i < 6; i++) {
+        float *ci = c + i * ldc;
+        _mm256_storeu_ps(ci, _mm256_add_ps(_mm256_loadu_ps(ci), acc[i][0]));
+        _mm256_storeu_ps(ci + 8, _mm256_add_ps(_mm256_loadu_ps(ci + 8), acc[i][1]));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void microkernel_avx512(int kc, const float *a, const float *b, float *c, int ldc) {
+    // 14 rows x 2 vectors of 16 columns = 28 accumulators
+    __m512 acc[14][2];
+    for (int i = 0; i < 14; i++) {
+        acc[i][0] = _mm512_setzero_ps();
+        acc[i][1] = _mm512_setzero_ps();
+    }
+    for (int k = 0; k < kc; k++) {
+        __m512 b0 = _mm512_load_ps(b + k * 32);
+        __m512 b1 = _mm512_load_ps(b + k * 32 + 16);
+        for (int i = 0; i < 14; i++) {
+            __m512 ai = _mm512_set1_ps(a[k * 14 + i]);
+            acc[i][0] = _mm512_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_ps(ai, b1, acc[i][1]);
+        }
+    }
+    for (int i = 0; i < 14; i++) {
+        float *ci = c + i * ldc;
+        _mm512_storeu_ps(ci, _mm512_add_ps(_mm512_loadu_ps(ci), acc[i][0]));
+        _mm512_storeu_ps(ci + 16, _mm512_add_ps(_mm512_loadu_ps(ci + 16), acc[i][1]));
+    }
+}
+
+#endif
+
+// Pack an mc x kc block of A into mr-row slivers, zero-padding the last sliver
+static void pack_a(const float *A, int lda, int mc, int kc, int mr, float *packed) {
+    for (int i0 = 0; i0 < mc; i0 += mr) {
+        for (int k = 0; k < kc; k++) {
+            for (int i = 0; i < mr; i++) {
+                *packed++ = (i0 + i < mc) ? A[(i0 + i) * lda + k] : 0.0f;
+            }
+        }
+    }
+}
+
+// Pack a kc x nc panel of B into nr-column slivers, zero-padding the last sliver
+static void pack_b(const float *B, int ldb, int kc, int nc, int nr, float *packed) {
+    for (int j0 = 0; j0 < nc; j0 += nr) {
+        for (int k = 0; k < kc; k++) {
+            for (int j = 0; j < nr; j++) {
+                *packed++ = (j0 + j < nc) ? B[k * ldb + j0 + j] : 0.0f;
             }
         }
     }
 }
 
-int main() {
-    // Declare and allocate memory for matrices A, B, and C
-    float A[N][N];
-    float B[N][N];
-    float C[N][N];
+// Blocked GEMM over rows [rowStart, rowEnd) of C, C must be zeroed
+static void gemm_blocked(const gemm_kernel *kern, const float *A, const float *B, float *C, int n,
+    int rowStart, int rowEnd) {
+    int mr = kern->mr;
+    int nr = kern->nr;
+    int mcMax = (BLOCK_MC / mr) * mr;
+    int ncMax = (BLOCK_NC / nr) * nr;
+    float *packA = (float *)aligned_buffer((size_t)(mcMax + mr) * BLOCK_KC * sizeof(float));
+    float *packB = (float *)aligned_buffer((size_t)(ncMax + nr) * BLOCK_KC * sizeof(float));
+    float edge[MAX_MR * MAX_NR];
 
-    // Initialize matrices A and B with some values (for example, random values)
-    srand(time(NULL)); // Seed for random number generation
-    for (int i = 0; i < N; i++) {
-        for (int j = 0; j < N; j++) {
-            A[i][j] = (float)(rand() % 100);
-            B[i][j] = (float)(rand() % 100);
+    for (int jc = 0; jc < n; jc += ncMax) {
+        int nc = (n - jc < ncMax) ? n - jc : ncMax;
+        for (int pc = 0; pc < n; pc += BLOCK_KC) {
+            int kc = (n - pc < BLOCK_KC) ? n - pc : BLOCK_KC;
+            pack_b(B + (size_t)pc * n + jc, n, kc, nc, nr, packB);
+            for (int ic = rowStart; ic < rowEnd; ic += mcMax) {
+                int mc = (rowEnd - ic < mcMax) ? rowEnd - ic : mcMax;
+                pack_a(A + (size_t)ic * n + pc, n, mc, kc, mr, packA);
+                for (int jr = 0; jr < nc; jr += nr) {
+                    const float *bSliver = packB + (size_t)jr * kc;
+                    for (int ir = 0; ir < mc; ir += mr) {
+                        const float *aSliver = packA + (size_t)ir * kc;
+                        float *cTile = C + (size_t)(ic + ir) * n + jc + jr;
+                        int m = (mc - ir < mr) ? mc - ir : mr;
+                        int w = (nc - jr < nr) ? nc - jr : nr;
+                        if (m == mr && w == nr) {
+                            kern->kernel(kc, aSliver, bSliver, cTile, n);
+                        } else {
+                            // Partial tile computed in a scratch buffer
+                            memset(edge, 0, sizeof(edge));
+                            kern->kernel(kc, aSliver, bSliver, edge, nr);
+                            for (int i = 0; i < m; i++) {
+                                for (int j = 0; j < w; j++) {
+                                    cTile[(size_t)i * n + j] += edge[i * nr + j];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
         }
     }
 
-    // Start timing the matrix multiplication
-    clock_t start = clock();
+    aligned_free(packA);
+    aligned_free(packB);
+}
+
+static const gemm_kernel scalarKernel = {"blocked", SCALAR_MR, SCALAR_NR, microkernel_scalar};
+#ifdef MATMUL_X86
+static const gemm_kernel avx2Kernel = {"avx2", 6, 16, microkernel_avx2};
+static const gemm_kernel avx512Kernel = {"avx512", 14, 32, microkernel_avx512};
+#endif
 
-    // Perform matrix multiplication
-    matrix_multiply(A, B, C);
+#ifndef MATMUL_BARE_METAL
 
-    // Stop timing the matrix multiplication
-    clock_t end = clock();
+static int numThreads = 1;
 
-    // Calculate the time taken in seconds
-    double cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
+static const gemm_kernel *best_kernel(void) {
+#ifdef MATMUL_X86
+    if (__builtin_cpu_supports("avx512f")) {
+        return &avx512Kernel;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return &avx2Kernel;
+    }
+#endif
+    return &scalarKernel;
+}
 
-    // Output the result of the benchmark
-    printf("CPU Matrix Multiplication took %f seconds\n", cpu_time_used);
+// Multithreaded variant: each thread owns a band of rows of C
+typedef struct {
+    const gemm_kernel *kern;
+    const float *A;
+    const float *B;
+    float *C;
+    int n;
+    int rowStart;
+    int rowEnd;
+} gemm_band;
+
+static void *gemm_band_worker(void *arg) {
+    gemm_band *band = (gemm_band *)arg;
+    gemm_blocked(band->kern, band->A, band->B, band->C, band->n, band->rowStart, band->rowEnd);
+    return NULL;
+}
+
+static void gemm_threads(const gemm_kernel *kern, const float *A, const float *B, float *C, int n, int numThreads) {
+    pthread_t threads[256];
+    gemm_band bands[256];
+    int count = (numThreads < 256) ? numThreads : 256;
+    int mr = kern->mr;
+    int numSlivers = (n + mr - 1) / mr;
+    if (count > numSlivers) {
+        count = numSlivers;
+    }
+    for (int t = 0; t < count; t++) {
+        // Band boundaries fall on microkernel rows
+        int start = (int)((long)numSlivers * t / count) * mr;
+        int end = (int)((long)numSlivers * (t + 1) / count) * mr;
+        bands[t] = (gemm_band){kern, A, B, C, n, start, (end < n) ? end : n};
+        pthread_create(&threads[t], NULL, gemm_band_worker, &bands[t]);
+    }
+    for (int t = 0; t < count; t++) {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+#endif
+
+static double max_relative_error(const float *ref, const float *c, int n) {
+    double maxRef = 0.0;
+    double maxErr = 0.0;
+    for (long i = 0; i < (long)n * n; i++) {
+        double r = ref[i] < 0 ? -ref[i] : ref[i];
+        double d = (double)ref[i] - (double)c[i];
+        d = d < 0 ? -d : d;
+        if (r > maxRef) {
+            maxRef = r;
+        }
+        if (d > maxErr) {
+            maxErr = d;
+        }
+    }
+    return maxRef > 0 ? maxErr / maxRef : maxErr;
+}
+
+static void report(const char *variant, int n, uint64_t cycles, double seconds, double err) {
+    double flops = 2.0 * n * (double)n * n;
+#ifdef MATMUL_BARE_METAL
+    (void)seconds;
+    printf("%-8s %5d %14lu %10.3f %10.2e\n", variant, n, (unsigned long)cycles, flops / cycles, err);
+#else
+    printf("%-8s %5d %14lu %10.3f %10.3f %12.6f %10.2e\n", variant, n, (unsigned long)cycles,
+        flops / cycles, flops / seconds * 1e-9, seconds, err);
+#endif
+}
+
+enum { VARIANT_NAIVE, VARIANT_BLOCKED, VARIANT_AVX2, VARIANT_AVX512, VARIANT_THREADS, NUM_VARIANTS };
+
+// Run one variant into C, keeping the fastest of NUM_RUNS
+static int run_variant(int variant, const float *A, const float *B, float *C, int n, uint64_t *cycles, double *seconds) {
+    const gemm_kernel *kern = &scalarKernel;
+#ifdef MATMUL_X86
+    if (variant == VARIANT_AVX2) {
+        if (!(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))) {
+            return 0;
+        }
+        kern = &avx2Kernel;
+    }
+    if (variant == VARIANT_AVX512) {
+        if (!__builtin_cpu_supports("avx512f")) {
+            return 0;
+        }
+        kern = &avx512Kernel;
+    }
+#else
+    if (variant == VARIANT_AVX2 || variant == VARIANT_AVX512) {
+        return 0;
+    }
+#endif
+#ifdef MATMUL_BARE_METAL
+    if (variant == VARIANT_THREADS) {
+        return 0;
+    }
+#endif
+
+    *cycles = (uint64_t)-1;
+    *seconds = 1e30;
+    for (int run = 0; run < NUM_RUNS; run++) {
+        memset(C, 0, (size_t)n * n * sizeof(float));
+        double start = now_seconds();
+        uint64_t startCycles = read_cycles();
+        if (variant == VARIANT_NAIVE) {
+            matrix_multiply(A, B, C, n);
+        } else if (variant == VARIANT_THREADS) {
+#ifndef MATMUL_BARE_METAL
+            gemm_threads(best_kernel(), A, B, C, n, numThreads);
+#endif
+        } else {
+            gemm_blocked(kern, A, B, C, n, 0, n);
+        }
+        uint64_t c = read_cycles() - startCycles;
+        double t = now_seconds() - start;
+        if (c < *cycles) {
+            *cycles = c;
+        }
+        if (t < *seconds) {
+            *seconds = t;
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+#ifdef MATMUL_BARE_METAL
+    const int sizes[] = {32, 64, 128};
+    const int naiveLimit = 128;
+    srand(0); // Use a fixed seed for reproducibility on RocketChip
+    printf("%-8s %5s %14s %10s %10s\n", "variant", "N", "cycles", "flop/cyc", "rel_err");
+#else
+    const int sizes[] = {64, 128, 256, 512, 1024, 2048};
+    const int naiveLimit = 1024;
+    numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    srand(0);
+    printf("Threads: %d\n", numThreads);
+    printf("%-8s %5s %14s %10s %10s %12s %10s\n", "variant", "N", "cycles", "flop/cyc", "GFLOP/s", "seconds", "rel_err");
+#endif
+    const char *names[NUM_VARIANTS] = {"naive", "blocked", "avx2", "avx512", "threads"};
+
+    int errors = 0;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int n = sizes[s];
+        size_t bytes = (size_t)n * n * sizeof(float);
+        float *A = (float *)aligned_buffer(bytes);
+        float *B = (float *)aligned_buffer(bytes);
+        float *C = (float *)aligned_buffer(bytes);
+        float *ref = (float *)aligned_buffer(bytes);
+
+        // Initialize matrices A and B with some values (for example, random values)
+        for (long i = 0; i < (long)n * n; i++) {
+            A[i] = (float)(rand() % 100);
+            B[i] = (float)(rand() % 100);
+        }
+
+        // The blocked scalar result is the reference for every variant
+        memset(ref, 0, bytes);
+        gemm_blocked(&scalarKernel, A, B, ref, n, 0, n);
+
+        for (int v = 0; v < NUM_VARIANTS; v++) {
+            uint64_t cycles;
+            double seconds;
+            if (v == VARIANT_NAIVE && n > naiveLimit) {
+                continue;
+            }
+            if (!run_variant(v, A, B, C, n, &cycles, &seconds)) {
+                continue;
+            }
+            double err = max_relative_error(ref, C, n);
+            if (err > 1e-5) {
+                printf("Mismatch in %s variant for N = %d\n", names[v], n);
+                errors++;
+            }
+            report(names[v], n, cycles, seconds, err);
+        }
+
+        aligned_free(A);
+        aligned_free(B);
+        aligned_free(C);
+        aligned_free(ref);
+    }
 
-    return 0;
+    return errors ? 1 : 0;
 }
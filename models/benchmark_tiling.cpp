@@ -0,0 +1,237 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cnn_hw_accelerator_model.h"
+#include "cnn_tiling.h"
+
+// End-to-end benchmark of a large convolution split into accelerator tiles
+//
+// The image is padded in memory, tiled with cnn_tiling and the resulting
+// descriptor list is executed the way src/cnn_dma.v does: load descriptors
+// copy strided tiles, run descriptors compute the tile with the
+// bit-accurate model and store the outputs with the output row stride.
+// The stitched result is checked bit-for-bit against the untiled model and
+// every output pixel must be written exactly once.
+//
+// Accelerator cycles are estimated from the descriptor list: one bus word
+// per cycle for loads, one MAC beat per cycle plus the pipeline latency
+// for every run (stores overlap the run).
+//
+// Build with:
+//   gcc -O2 -c floating_point.c integer_mac.c cnn_tiling.c
+//   g++ -O2 -std=c++17 -pthread benchmark_tiling.cpp cnn_hw_accelerator_model.cpp floating_point.o integer_mac.o cnn_tiling.o -o benchmark_tiling
+
+using namespace cnn_hw_accelerator_model;
+
+// Approximate cycles from startIn to the first result
+static constexpr long ACCEL_LATENCY = 100;
+
+// Element size and bus word size in bytes
+static constexpr uint32_t ELEM_BYTES = 4;
+static constexpr uint32_t WORD_BYTES = 8;
+
+static void usage(const char *name)
+{
+    std::printf("Usage: %s [options]\n", name);
+    std::printf("  --size N        rows and columns of the image (default 1024)\n");
+    std::printf("  --filt N        rows and columns of the filter (default 5)\n");
+    std::printf("  --stride N      convolution stride, power of two (default 1)\n");
+    std::printf("  --pad N         zero padding, -1 for 'same' size (default -1)\n");
+    std::printf("  --dilation N    convolution dilation, power of two (default 1)\n");
+    std::printf("  --max-size N    MAX_SIZE of the accelerator (default %d)\n", MAX_SIZE);
+    std::printf("  --threads N     worker threads, 0 for all cores (default 0)\n");
+}
+
+static std::vector<uint32_t> random_matrix(std::mt19937 &gen, std::size_t numElements)
+{
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    std::vector<uint32_t> values(numElements);
+    for (auto &value : values)
+    {
+        float sample = dist(gen);
+        std::memcpy(&value, &sample, sizeof(float));
+    }
+    return values;
+}
+
+// Bus words touched by a strided tile
+static long tile_words(uint32_t addr, uint32_t stride, int rows, int cols)
+{
+    long words = 0;
+    for (int row = 0; row < rows; ++row)
+    {
+        uint32_t first = addr + row*stride;
+        uint32_t last = first + cols*ELEM_BYTES - 1;
+        words += last/WORD_BYTES - first/WORD_BYTES + 1;
+    }
+    return words;
+}
+
+int main(int argc, char **argv)
+{
+    int size = 1024;
+    int filtSize = 5;
+    int stride = 1;
+    int pad = -1;
+    int dilation = 1;
+    int maxSize = MAX_SIZE;
+    int numThreads = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if ((i + 1 < argc) && (arg == "--size" || arg == "--filt" || arg == "--stride" || arg == "--pad" ||
+            arg == "--dilation" || arg == "--max-size" || arg == "--threads"))
+        {
+            int value = std::atoi(argv[++i]);
+            if (arg == "--size")      size = value;
+            if (arg == "--filt")      filtSize = value;
+            if (arg == "--stride")    stride = value;
+            if (arg == "--pad")       pad = value;
+            if (arg == "--dilation")  dilation = value;
+            if (arg == "--max-size")  maxSize = value;
+            if (arg == "--threads")   numThreads = value;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (pad < 0)
+    {
+        pad = dilation*(filtSize - 1)/2;
+    }
+
+    if ((pad > MAX_PAD) || (filtSize < 1))
+    {
+        std::printf("Padding must be at most %d and the filter non-empty\n", MAX_PAD);
+        return 1;
+    }
+
+    // Whole convolution on the padded image
+    cnn_tiling_config cfg = {size + 2*pad, size + 2*pad, filtSize, filtSize, stride, dilation};
+    cnn_tile_plan plan;
+    if ((size < 1) || (cnn_tiling_plan(&cfg, maxSize, &plan) != 0))
+    {
+        std::printf("Configuration cannot be tiled for MAX_SIZE = %d\n", maxSize);
+        return 1;
+    }
+    int numTiles = cnn_tiling_num_tiles(&plan);
+
+    std::mt19937 gen(0);
+    std::vector<uint32_t> image = random_matrix(gen, (std::size_t) size*size);
+    std::vector<uint32_t> filt = random_matrix(gen, (std::size_t) filtSize*filtSize);
+
+    // Memory map: padded image, filter, then output matrix
+    uint32_t dataStride = cfg.dataCols*ELEM_BYTES;
+    uint32_t outStride  = plan.outCols*ELEM_BYTES;
+    uint32_t dataAddr   = 0;
+    uint32_t filtAddr   = dataAddr + cfg.dataRows*dataStride;
+    uint32_t outAddr    = filtAddr + filtSize*filtSize*ELEM_BYTES;
+    std::vector<uint32_t> mem((outAddr + plan.outRows*outStride)/ELEM_BYTES, 0);
+    std::vector<int> writes((std::size_t) plan.outRows*plan.outCols, 0);
+    std::memcpy(&mem[filtAddr/ELEM_BYTES], filt.data(), filt.size()*sizeof(uint32_t));
+
+    std::vector<uint64_t> desc((std::size_t) numTiles*CNN_TILING_DESC_PER_TILE*CNN_DESC_WORDS);
+    std::size_t numDesc = cnn_tiling_build_descriptors(&cfg, &plan, dataAddr, dataStride, filtAddr,
+        outAddr, outStride, desc.data(), desc.size()/CNN_DESC_WORDS);
+
+    // Run the descriptor list
+    auto start = std::chrono::steady_clock::now();
+    cnn_tiling_pad(&mem[dataAddr/ELEM_BYTES], image.data(), size, size, pad);
+
+    ConvConfig tileCfg = {0, 0, 0, 0, stride, 0, dilation};
+    std::vector<uint32_t> tileData, tileFilt;
+    long loadCycles = 0;
+    long runCycles = 0;
+    long beats = 0;
+    int beatLanes = VECTOR_SIZE/dilation;
+    for (std::size_t d = 0; d < numDesc; ++d)
+    {
+        uint32_t addr = (uint32_t) desc[2*d];
+        uint32_t rowStride = (uint32_t) (desc[2*d] >> 32);
+        int rows = (int) (desc[2*d+1] & 0xFFFF);
+        int cols = (int) ((desc[2*d+1] >> 16) & 0xFFFF);
+        int type = (int) ((desc[2*d+1] >> 32) & 0x3);
+
+        if (type == CNN_DESC_RUN)
+        {
+            std::vector<uint32_t> out = conv2d(tileCfg, tileData, tileFilt, numThreads);
+            for (int row = 0; row < rows; ++row)
+            {
+                for (int col = 0; col < cols; ++col)
+                {
+                    uint32_t outElem = (addr + row*rowStride - outAddr)/ELEM_BYTES + col;
+                    mem[outAddr/ELEM_BYTES + outElem] = out[(std::size_t) row*cols + col];
+                    ++writes[outElem];
+                }
+            }
+            long tileBeats = (long) rows*cols*tileCfg.filtRows*((tileCfg.filtCols + beatLanes - 1)/beatLanes);
+            beats     += tileBeats;
+            runCycles += tileBeats + ACCEL_LATENCY;
+        }
+        else
+        {
+            std::vector<uint32_t> &tile = (type == CNN_DESC_DATA) ? tileData : tileFilt;
+            tile.resize((std::size_t) rows*cols);
+            for (int row = 0; row < rows; ++row)
+            {
+                std::memcpy(&tile[(std::size_t) row*cols], &mem[(addr + row*rowStride)/ELEM_BYTES],
+                    cols*sizeof(uint32_t));
+            }
+            if (type == CNN_DESC_DATA)
+            {
+                tileCfg.dataRows = rows;
+                tileCfg.dataCols = cols;
+            }
+            else
+            {
+                tileCfg.filtRows = rows;
+                tileCfg.filtCols = cols;
+            }
+            loadCycles += tile_words(addr, rowStride, rows, cols);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    // Stitched result against the untiled convolution
+    ConvConfig fullCfg = {size, size, filtSize, filtSize, stride, pad, dilation};
+    std::vector<uint32_t> ref = conv2d(fullCfg, image, filt, numThreads);
+    long mismatches = 0;
+    long badWrites = 0;
+    for (std::size_t i = 0; i < ref.size(); ++i)
+    {
+        mismatches += (mem[outAddr/ELEM_BYTES + i] != ref[i]);
+        badWrites += (writes[i] != 1);
+    }
+
+    std::size_t numOutputs = ref.size();
+    std::size_t loaded = cnn_tiling_loaded_elements(&cfg, &plan);
+    long totalCycles = loadCycles + runCycles;
+    std::printf("Image %dx%d, filter %dx%d, stride %d, pad %d, dilation %d, MAX_SIZE %d\n",
+        size, size, filtSize, filtSize, stride, pad, dilation, maxSize);
+    std::printf("Tiles:          %d (%dx%d grid of %dx%d outputs), %zu descriptors\n", numTiles,
+        plan.numTileRows, plan.numTileCols, plan.tileOutRows, plan.tileOutCols, numDesc);
+    std::printf("Input loaded:   %zu elements (%.3fx padded image, halo overhead)\n", loaded,
+        (double) loaded/((double) cfg.dataRows*cfg.dataCols));
+    std::printf("Est. cycles:    %ld (loads %ld, runs %ld, %ld MAC beats)\n", totalCycles, loadCycles,
+        runCycles, beats);
+    std::printf("Est. throughput %.4f outputs/cycle, %.1f%% of cycles issuing MAC beats\n",
+        (double) numOutputs/totalCycles, 100.0*beats/totalCycles);
+    std::printf("Model:          %zu outputs in %f seconds (%.1f outputs/s)\n", numOutputs, seconds,
+        seconds > 0 ? numOutputs/seconds : 0.0);
+    if ((mismatches != 0) || (badWrites != 0))
+    {
+        std::printf("FAILED: %ld mismatches, %ld pixels not written exactly once\n", mismatches, badWrites);
+        return 1;
+    }
+    std::printf("PASSED: stitched output matches untiled model\n");
+    return 0;
+}
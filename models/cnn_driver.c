@@ -0,0 +1,261 @@
+#include "cnn_driver.h"
+
+// OP register fields
+#define OP_STRIDE_BIT   2
+#define OP_PAD_BIT      4
+#define OP_DIL_BIT      8
+#define OP_PACK_BIT     10
+#define OP_HOLD_BIT     11
+
+// POST register fields
+#define POST_ACT_BIT    1
+#define POST_POOL_BIT   3
+#define POST_AVG_BIT    5
+
+static const char *const perf_names[CNN_PERF_EVENTS] = {
+    "busy cycles",
+    "throttle stalls",
+    "masked MAC lanes",
+    "data RAM reads",
+    "filter RAM reads",
+    "MAC beats",
+    "results written",
+    "output stalls"
+};
+
+static uint32_t mmio_read32(void *ctx, uint32_t offset)
+{
+    return *((volatile uint32_t *) ((uintptr_t) ctx + offset));
+}
+
+static void mmio_write32(void *ctx, uint32_t offset, uint32_t value)
+{
+    *((volatile uint32_t *) ((uintptr_t) ctx + offset)) = value;
+}
+
+static uint32_t reg_read(const cnn_device *dev, uint32_t reg)
+{
+    return dev->read32(dev->ctx, dev->regAddr + reg);
+}
+
+static void reg_write(const cnn_device *dev, uint32_t reg, uint32_t value)
+{
+    dev->write32(dev->ctx, dev->regAddr + reg, value);
+}
+
+static int log2_int(int value)
+{
+    int result = 0;
+    while ((1 << result) < value)
+    {
+        ++result;
+    }
+    return result;
+}
+
+void cnn_device_init_mmio(cnn_device *dev, uintptr_t base, int maxSize, int elemBytes)
+{
+    // Filter RAM follows the data RAM, registers follow both (see
+    // cnn_register_file.v)
+    dev->read32   = mmio_read32;
+    dev->write32  = mmio_write32;
+    dev->ctx      = (void *) base;
+    dev->filtAddr = (uint32_t) (1u << (log2_int(maxSize) + log2_int(elemBytes)));
+    dev->regAddr  = 2*dev->filtAddr;
+}
+
+void cnn_job_config_init(cnn_job_config *cfg)
+{
+    cfg->opType       = CNN_OP_CONV;
+    cfg->strideLog2   = 0;
+    cfg->pad          = 0;
+    cfg->dilationLog2 = 0;
+    cfg->pack         = 0;
+    cfg->filtRows     = 0;
+    cfg->filtCols     = 0;
+    cfg->dataRows     = 0;
+    cfg->dataCols     = 0;
+    cfg->quantMult    = 0;
+    cfg->quantShift   = 0;
+    cfg->quantZero    = 0;
+    cfg->biasEn       = 0;
+    cfg->bias         = 0;
+    cfg->act          = CNN_ACT_NONE;
+    cfg->slope        = 0;
+    cfg->poolSize     = 0;
+    cfg->poolAvg      = 0;
+    cfg->dataBase     = 0;
+    cfg->filtBase     = 0;
+    cfg->holdBank     = 0;
+    cfg->channels     = 1;
+}
+
+size_t cnn_job_outputs(const cnn_job_config *cfg)
+{
+    int rows, cols;
+    if (cfg->opType == CNN_OP_GEMM)
+    {
+        rows = cfg->dataRows;
+        cols = cfg->filtRows;
+    }
+    else
+    {
+        int dilation = 1 << cfg->dilationLog2;
+        rows = ((cfg->dataRows + 2*cfg->pad - (cfg->filtRows - 1)*dilation - 1) >> cfg->strideLog2) + 1;
+        cols = ((cfg->dataCols + 2*cfg->pad - (cfg->filtCols - 1)*dilation - 1) >> cfg->strideLog2) + 1;
+    }
+    if (cfg->poolSize >= 2)
+    {
+        rows /= cfg->poolSize;
+        cols /= cfg->poolSize;
+    }
+    return (rows > 0 && cols > 0) ? (size_t) rows*cols : 0;
+}
+
+void cnn_load_data(const cnn_device *dev, const uint32_t *words, size_t numWords)
+{
+    cnn_load_data_at(dev, 0, words, numWords);
+}
+
+void cnn_load_filter(const cnn_device *dev, const uint32_t *words, size_t numWords)
+{
+    cnn_load_filter_at(dev, 0, words, numWords);
+}
+
+void cnn_load_data_at(const cnn_device *dev, size_t wordOffset, const uint32_t *words, size_t numWords)
+{
+    for (size_t i = 0; i < numWords; i++)
+    {
+        dev->write32(dev->ctx, (uint32_t) (4*(wordOffset + i)), words[i]);
+    }
+}
+
+void cnn_load_filter_at(const cnn_device *dev, size_t wordOffset, const uint32_t *words, size_t numWords)
+{
+    for (size_t i = 0; i < numWords; i++)
+    {
+        dev->write32(dev->ctx, dev->filtAddr + (uint32_t) (4*(wordOffset + i)), words[i]);
+    }
+}
+
+int cnn_submit(const cnn_device *dev, const cnn_job_config *cfg, cnn_job *job, uint32_t *out)
+{
+    uint32_t op = (uint32_t) cfg->opType | ((uint32_t) cfg->strideLog2 << OP_STRIDE_BIT) |
+        ((uint32_t) cfg->pad << OP_PAD_BIT) | ((uint32_t) cfg->dilationLog2 << OP_DIL_BIT) |
+        ((uint32_t) (cfg->pack != 0) << OP_PACK_BIT) | ((uint32_t) (cfg->holdBank != 0) << OP_HOLD_BIT);
+    uint32_t post = (uint32_t) (cfg->biasEn != 0) | ((uint32_t) cfg->act << POST_ACT_BIT) |
+        ((uint32_t) (cfg->poolSize & 0x3) << POST_POOL_BIT) | ((uint32_t) (cfg->poolAvg != 0) << POST_AVG_BIT);
+
+    reg_write(dev, CNN_REG_OP, op);
+    reg_write(dev, CNN_REG_FILT_DIMS, (uint32_t) cfg->filtRows | ((uint32_t) cfg->filtCols << 16));
+    reg_write(dev, CNN_REG_DATA_DIMS, (uint32_t) cfg->dataRows | ((uint32_t) cfg->dataCols << 16));
+    reg_write(dev, CNN_REG_QUANT_MULT, cfg->quantMult);
+    reg_write(dev, CNN_REG_QUANT, (uint32_t) cfg->quantShift | ((uint32_t) (uint8_t) cfg->quantZero << 8));
+    reg_write(dev, CNN_REG_BIAS, cfg->bias);
+    reg_write(dev, CNN_REG_POST, post);
+    reg_write(dev, CNN_REG_SLOPE, cfg->slope);
+    reg_write(dev, CNN_REG_BASE, (uint32_t) cfg->dataBase | ((uint32_t) cfg->filtBase << 16));
+    reg_write(dev, CNN_REG_CHANNELS, (uint32_t) cfg->channels);
+    reg_write(dev, CNN_REG_CONTROL, 1);
+
+    // A refused start sets an error bit instead of starting
+    uint32_t errors = reg_read(dev, CNN_REG_ERROR);
+    if (errors & (CNN_ERROR_BUSY | CNN_ERROR_DIMS))
+    {
+        reg_write(dev, CNN_REG_ERROR, errors & (CNN_ERROR_BUSY | CNN_ERROR_DIMS));
+        return (errors & CNN_ERROR_BUSY) ? CNN_ERR_BUSY : CNN_ERR_CONFIG;
+    }
+
+    job->out        = out;
+    job->numOutputs = cnn_job_outputs(cfg);
+    job->numRead    = 0;
+    job->done       = 0;
+    return CNN_OK;
+}
+
+int cnn_poll(const cnn_device *dev, cnn_job *job)
+{
+    if (job->done)
+    {
+        return CNN_DONE;
+    }
+
+    // Read at most the results buffered, none belong to a later job
+    size_t count = CNN_STATUS_COUNT(reg_read(dev, CNN_REG_STATUS));
+    size_t left = job->numOutputs - job->numRead;
+    if (count > left)
+    {
+        count = left;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        job->out[job->numRead++] = reg_read(dev, CNN_REG_RESULT);
+    }
+    if (count > 0 && (reg_read(dev, CNN_REG_ERROR) & CNN_ERROR_EMPTY))
+    {
+        reg_write(dev, CNN_REG_ERROR, CNN_ERROR_EMPTY);
+        return CNN_ERR_BUS;
+    }
+    if (job->numRead == job->numOutputs)
+    {
+        job->done = 1;
+        return CNN_DONE;
+    }
+    return CNN_PENDING;
+}
+
+int cnn_wait(const cnn_device *dev, cnn_job *job)
+{
+    int result;
+    do
+    {
+        result = cnn_poll(dev, job);
+    } while (result == CNN_PENDING);
+    return result;
+}
+
+uint32_t cnn_status(const cnn_device *dev)
+{
+    return reg_read(dev, CNN_REG_STATUS);
+}
+
+uint32_t cnn_errors(const cnn_device *dev)
+{
+    return reg_read(dev, CNN_REG_ERROR);
+}
+
+void cnn_clear_errors(const cnn_device *dev)
+{
+    reg_write(dev, CNN_REG_ERROR, CNN_ERROR_BUSY | CNN_ERROR_DIMS | CNN_ERROR_EMPTY);
+}
+
+void cnn_irq_enable(const cnn_device *dev, uint32_t sources)
+{
+    reg_write(dev, CNN_REG_IRQ_ENABLE, sources);
+}
+
+void cnn_clear_done(const cnn_device *dev)
+{
+    reg_write(dev, CNN_REG_STATUS, CNN_STATUS_DONE);
+}
+
+void cnn_perf_start(const cnn_device *dev)
+{
+    reg_write(dev, CNN_REG_PERF_CTRL, CNN_PERF_CLEAR | CNN_PERF_START);
+}
+
+void cnn_perf_stop(const cnn_device *dev)
+{
+    reg_write(dev, CNN_REG_PERF_CTRL, CNN_PERF_STOP);
+}
+
+uint32_t cnn_perf_read(const cnn_device *dev, int sel)
+{
+    reg_write(dev, CNN_REG_PERF_SEL, (uint32_t) sel);
+    return reg_read(dev, CNN_REG_PERF_DATA);
+}
+
+const char *cnn_perf_name(int sel)
+{
+    return (sel >= 0 && sel < CNN_PERF_EVENTS) ? perf_names[sel] : "";
+}
@@ -0,0 +1,203 @@
+#ifndef CNN_DRIVER_H
+#define CNN_DRIVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Host driver of src/cnn_register_file.v
+//
+// Jobs are submitted without blocking: cnn_submit writes the configuration
+// registers and starts the accelerator, cnn_poll copies the results
+// buffered so far and reports whether the job is complete, and cnn_wait
+// polls until it is. The data and filter RAMs have two banks, so the next
+// job may be loaded and submitted while the previous one computes. Jobs
+// complete in submission order, so the oldest job is the one polled.
+//
+// Submitted jobs are queued by the accelerator. Several small jobs can be
+// loaded into one bank at different offsets (cnn_load_data_at and
+// cnn_load_filter_at, with dataBase and filtBase of their configuration)
+// and submitted back to back with holdBank set on all but the first, so
+// they run without a host round trip in between.
+//
+// Registers are accessed through the read32/write32 callbacks of
+// cnn_device, cnn_device_init_mmio maps them onto volatile loads and
+// stores at a base address, a simulation supplies its own.
+//
+// Build (host): gcc -O2 -c cnn_driver.c
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Register byte offsets within the register window
+#define CNN_REG_CONTROL         0x00
+#define CNN_REG_STATUS          0x04
+#define CNN_REG_IRQ_ENABLE      0x08
+#define CNN_REG_OP              0x0C
+#define CNN_REG_FILT_DIMS       0x10
+#define CNN_REG_DATA_DIMS       0x14
+#define CNN_REG_QUANT_MULT      0x18
+#define CNN_REG_QUANT           0x1C
+#define CNN_REG_BIAS            0x20
+#define CNN_REG_POST            0x24
+#define CNN_REG_SLOPE           0x28
+#define CNN_REG_RESULT          0x2C
+#define CNN_REG_PERF_CTRL       0x30
+#define CNN_REG_PERF_SEL        0x34
+#define CNN_REG_PERF_DATA       0x38
+#define CNN_REG_ERROR           0x3C
+#define CNN_REG_BASE            0x40
+#define CNN_REG_CHANNELS        0x44
+
+// STATUS fields
+#define CNN_STATUS_BUSY         0x1
+#define CNN_STATUS_DONE         0x2
+#define CNN_STATUS_ERROR        0x4
+#define CNN_STATUS_READY        0x8
+#define CNN_STATUS_JOBS(s)      (((s) >> 4) & 0xF)
+#define CNN_STATUS_QUEUE_FULL   0x100
+#define CNN_STATUS_COUNT(s)     ((s) >> 16)
+
+// ERROR bits
+#define CNN_ERROR_BUSY          0x1
+#define CNN_ERROR_DIMS          0x2
+#define CNN_ERROR_EMPTY         0x4
+
+// IRQ_ENABLE bits
+#define CNN_IRQ_DONE            0x1
+#define CNN_IRQ_ERROR           0x2
+
+// PERF_CTRL bits and counters (perfSelIn of cnn_hw_accelerator.v)
+#define CNN_PERF_START          0x1
+#define CNN_PERF_STOP           0x2
+#define CNN_PERF_CLEAR          0x4
+#define CNN_PERF_EVENTS         8
+
+// Operation types and activations
+#define CNN_OP_CONV             0
+#define CNN_OP_GEMM             1
+#define CNN_ACT_NONE            0
+#define CNN_ACT_RELU            1
+#define CNN_ACT_LEAKY           2
+
+// Return codes
+#define CNN_OK                  0
+#define CNN_PENDING             0
+#define CNN_DONE                1
+#define CNN_ERR_BUSY            (-1)
+#define CNN_ERR_CONFIG          (-2)
+#define CNN_ERR_BUS             (-3)
+
+// Accelerator address space, offsets are bytes from its base
+typedef struct
+{
+    uint32_t (*read32)(void *ctx, uint32_t offset);
+    void (*write32)(void *ctx, uint32_t offset, uint32_t value);
+    void *ctx;
+
+    // Filter RAM and register window (FILT_ADDR and REG_ADDR)
+    uint32_t filtAddr;
+    uint32_t regAddr;
+} cnn_device;
+
+// Configuration of one job, fields follow the ports of cnn_hw_accelerator.v
+// Bias and slope are single precision bit patterns (bias is an int32 for
+// INT8 builds). dataBase and filtBase are element offsets of the operands
+// within their bank, holdBank computes from the bank of the previous job
+// instead of the one loaded since. A convolution of channels input channels
+// (0 or 1 for one) reads channel after channel of dataRows x dataCols data
+// planes from dataBase and filtRows x filtCols filter planes from filtBase,
+// and sums every output over all of them. Data rows are stored at the row
+// pitch of the job, the padded pitch for packed jobs, and the whole stack
+// must fit in MAX_SIZE elements from its base.
+typedef struct
+{
+    int opType;
+    int strideLog2;
+    int pad;
+    int dilationLog2;
+    int pack;
+    int filtRows;
+    int filtCols;
+    int dataRows;
+    int dataCols;
+    uint32_t quantMult;
+    int quantShift;
+    int8_t quantZero;
+    int biasEn;
+    uint32_t bias;
+    int act;
+    uint32_t slope;
+    int poolSize;
+    int poolAvg;
+    int dataBase;
+    int filtBase;
+    int holdBank;
+    int channels;
+} cnn_job_config;
+
+// Job in flight, results are copied to out as they are polled
+typedef struct
+{
+    uint32_t *out;
+    size_t numOutputs;
+    size_t numRead;
+    int done;
+} cnn_job;
+
+// Map the device onto memory at base for a build of maxSize elements and
+// elemBytes bytes per operand (4 for single precision)
+void cnn_device_init_mmio(cnn_device *dev, uintptr_t base, int maxSize, int elemBytes);
+
+// Configuration with every optional field cleared
+void cnn_job_config_init(cnn_job_config *cfg);
+
+// Results written by a job, after pooling
+size_t cnn_job_outputs(const cnn_job_config *cfg);
+
+// Copy numWords 32-bit words of the RAM image into the load bank of the
+// data or filter RAM
+void cnn_load_data(const cnn_device *dev, const uint32_t *words, size_t numWords);
+void cnn_load_filter(const cnn_device *dev, const uint32_t *words, size_t numWords);
+
+// Same from a word offset into the bank, the element offset of the
+// operands is wordOffset * 4 / element bytes
+void cnn_load_data_at(const cnn_device *dev, size_t wordOffset, const uint32_t *words, size_t numWords);
+void cnn_load_filter_at(const cnn_device *dev, size_t wordOffset, const uint32_t *words, size_t numWords);
+
+// Start a job whose operands have been loaded, results go to out
+// (cnn_job_outputs(cfg) elements). Returns CNN_OK, CNN_ERR_BUSY while the
+// previous job still reads its bank (or the job queue is full for a job
+// holding the bank) or CNN_ERR_CONFIG for dimensions the accelerator
+// refuses
+int cnn_submit(const cnn_device *dev, const cnn_job_config *cfg, cnn_job *job, uint32_t *out);
+
+// Copy the results buffered so far without blocking
+// Returns CNN_DONE once every result has been read, CNN_PENDING before
+// that or CNN_ERR_BUS if a result was read from an empty FIFO
+int cnn_poll(const cnn_device *dev, cnn_job *job);
+
+// Poll until the job is complete, returns CNN_DONE or CNN_ERR_BUS
+int cnn_wait(const cnn_device *dev, cnn_job *job);
+
+// STATUS and ERROR registers, cnn_clear_errors clears every error bit
+uint32_t cnn_status(const cnn_device *dev);
+uint32_t cnn_errors(const cnn_device *dev);
+void cnn_clear_errors(const cnn_device *dev);
+
+// Interrupt sources (CNN_IRQ_DONE, CNN_IRQ_ERROR), done is cleared with
+// cnn_clear_done once handled
+void cnn_irq_enable(const cnn_device *dev, uint32_t sources);
+void cnn_clear_done(const cnn_device *dev);
+
+// Performance counters, start clears them first
+void cnn_perf_start(const cnn_device *dev);
+void cnn_perf_stop(const cnn_device *dev);
+uint32_t cnn_perf_read(const cnn_device *dev, int sel);
+const char *cnn_perf_name(int sel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
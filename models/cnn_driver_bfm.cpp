@@ -0,0 +1,573 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "cnn_driver.h"
+#include "cnn_hw_accelerator_model.h"
+
+// End-to-end test of cnn_driver.c against a bus-functional model of
+// src/cnn_register_file.v and src/cnn_hw_accelerator.v
+//
+// Every bus access advances the model by one step. A started job takes
+// the bank just loaded (or holds the bank of the previous job), so the
+// next job can be loaded while it computes, and writes one result per step
+// into an output FIFO of FIFO_DEPTH results after START_LATENCY steps,
+// stalling while the FIFO is full. Up to JOB_QUEUE jobs wait behind the
+// one computing and follow it without a gap. The accelerator is busy
+// until the jobs have written their last result.
+// Results come from the bit-accurate model, so the driver must copy every
+// result of every job in order.
+//
+// Build with:
+//   gcc -O2 -c floating_point.c integer_mac.c cnn_driver.c
+//   g++ -O2 -std=c++17 -pthread cnn_driver_bfm.cpp cnn_hw_accelerator_model.cpp floating_point.o integer_mac.o cnn_driver.o -o cnn_driver_bfm
+
+using namespace cnn_hw_accelerator_model;
+
+static constexpr int FIFO_DEPTH    = 512;
+static constexpr int START_LATENCY = 100;
+static constexpr int ELEM_BYTES    = 4;
+static constexpr int JOB_QUEUE     = 4;
+
+class AcceleratorBfm
+{
+public:
+    AcceleratorBfm()
+    {
+        for (int bank = 0; bank < 2; ++bank)
+        {
+            data_[bank].assign(MAX_SIZE, 0);
+            filt_[bank].assign(MAX_SIZE, 0);
+        }
+        device.read32   = read32;
+        device.write32  = write32;
+        device.ctx      = this;
+        device.filtAddr = MAX_SIZE*ELEM_BYTES;
+        device.regAddr  = 2*device.filtAddr;
+    }
+
+    cnn_device device;
+
+    // Interrupt line
+    bool irq() const
+    {
+        return ((irqEnable_ & CNN_IRQ_DONE) && done_) || ((irqEnable_ & CNN_IRQ_ERROR) && errors_);
+    }
+
+    long long accesses() const { return steps_; }
+    long badAccesses() const { return badAccesses_; }
+
+private:
+    struct Job
+    {
+        std::vector<uint32_t> results;
+        std::size_t written;
+        long long start;
+    };
+
+    static uint32_t read32(void *ctx, uint32_t offset)
+    {
+        return static_cast<AcceleratorBfm *>(ctx)->read(offset);
+    }
+
+    static void write32(void *ctx, uint32_t offset, uint32_t value)
+    {
+        static_cast<AcceleratorBfm *>(ctx)->write(offset, value);
+    }
+
+    // One step of the compute pipeline
+    void step()
+    {
+        ++steps_;
+        if (!compute_.empty())
+        {
+            Job &job = compute_.front();
+            if ((steps_ - job.start >= START_LATENCY) && (fifo_.size() < FIFO_DEPTH))
+            {
+                bool last = (job.written + 1 == job.results.size());
+                fifo_.push_back({job.results[job.written++], last});
+                ++perf_[6];
+                if (last)
+                {
+                    compute_.pop_front();
+                }
+            }
+            ++perf_[0];
+        }
+    }
+
+    bool busy() const { return !compute_.empty(); }
+    bool queueFull() const { return compute_.size() > JOB_QUEUE; }
+
+    uint32_t read(uint32_t offset)
+    {
+        step();
+        if (offset < device.regAddr)
+        {
+            std::printf("Read of RAM address 0x%x\n", offset);
+            ++badAccesses_;
+            return 0;
+        }
+        switch (offset - device.regAddr)
+        {
+            case CNN_REG_STATUS:
+                return (busy() ? CNN_STATUS_BUSY : 0) | (done_ ? CNN_STATUS_DONE : 0) |
+                    (errors_ ? CNN_STATUS_ERROR : 0) | (fifo_.empty() ? 0 : CNN_STATUS_READY) |
+                    ((uint32_t) (jobs_ & 0xF) << 4) | (queueFull() ? CNN_STATUS_QUEUE_FULL : 0) |
+                    ((uint32_t) fifo_.size() << 16);
+            case CNN_REG_IRQ_ENABLE:
+                return irqEnable_;
+            case CNN_REG_RESULT:
+            {
+                if (fifo_.empty())
+                {
+                    errors_ |= CNN_ERROR_EMPTY;
+                    return 0;
+                }
+                auto result = fifo_.front();
+                fifo_.pop_front();
+                if (result.second)
+                {
+                    done_ = true;
+                    --jobs_;
+                }
+                return result.first;
+            }
+            case CNN_REG_PERF_DATA:
+                return perf_[perfSel_ % CNN_PERF_EVENTS];
+            case CNN_REG_ERROR:
+                return errors_;
+            default:
+                return regs_[((offset - device.regAddr) >> 2) & 0x1F];
+        }
+    }
+
+    void write(uint32_t offset, uint32_t value)
+    {
+        step();
+        if (offset >= device.regAddr)
+        {
+            uint32_t reg = offset - device.regAddr;
+            regs_[(reg >> 2) & 0x1F] = value;
+            switch (reg)
+            {
+                case CNN_REG_CONTROL:
+                    if (value & 1)
+                    {
+                        start();
+                    }
+                    break;
+                case CNN_REG_STATUS:
+                    if (value & CNN_STATUS_DONE)
+                    {
+                        done_ = false;
+                    }
+                    break;
+                case CNN_REG_IRQ_ENABLE:
+                    irqEnable_ = value & 0x3;
+                    break;
+                case CNN_REG_PERF_CTRL:
+                    if (value & CNN_PERF_CLEAR)
+                    {
+                        std::memset(perf_, 0, sizeof(perf_));
+                    }
+                    break;
+                case CNN_REG_PERF_SEL:
+                    perfSel_ = value;
+                    break;
+                case CNN_REG_ERROR:
+                    errors_ &= ~value;
+                    break;
+                default:
+                    break;
+            }
+        }
+        else if (offset >= device.filtAddr)
+        {
+            filt_[loadBank_][(offset - device.filtAddr)/ELEM_BYTES] = value;
+        }
+        else
+        {
+            data_[loadBank_][offset/ELEM_BYTES] = value;
+        }
+    }
+
+    uint32_t reg(uint32_t offset) const { return regs_[offset >> 2]; }
+
+    void start()
+    {
+        uint32_t op = reg(CNN_REG_OP);
+        uint32_t post = reg(CNN_REG_POST);
+        int filtRows = reg(CNN_REG_FILT_DIMS) & 0xFFFF;
+        int filtCols = reg(CNN_REG_FILT_DIMS) >> 16;
+        int dataRows = reg(CNN_REG_DATA_DIMS) & 0xFFFF;
+        int dataCols = reg(CNN_REG_DATA_DIMS) >> 16;
+        int dataBase = reg(CNN_REG_BASE) & 0xFFFF;
+        int filtBase = reg(CNN_REG_BASE) >> 16;
+        bool isGemm = op & 1;
+        int channels = isGemm ? 1 : std::max(1u, reg(CNN_REG_CHANNELS) & 0xFFFF);
+        int pad = (op >> 4) & 0xF;
+        int dilationLog2 = (op >> 8) & 0x3;
+        bool hold = (op >> 11) & 1;
+
+        // Packed convolutions read the data rows at a padded pitch
+        bool packed = ((op >> 10) & 1) && !isGemm && (dilationLog2 == 0);
+        int dataPitch = packed ? dataCols + ((filtCols - dataCols) & (VECTOR_SIZE - 1)) : dataCols;
+
+        // Stack sizes without wrapping, and the dilated filter of a
+        // convolution within the padded data
+        int64_t filtSize = (int64_t) channels*filtRows*filtCols;
+        int64_t dataSize = (int64_t) channels*dataRows*dataPitch;
+        bool geometry = isGemm || ((((filtCols - 1) << dilationLog2) + 1 <= dataCols + 2*pad) &&
+            (((filtRows - 1) << dilationLog2) + 1 <= dataRows + 2*pad));
+        if (hold ? queueFull() : busy())
+        {
+            errors_ |= CNN_ERROR_BUSY;
+            return;
+        }
+        if ((filtRows == 0) || (filtCols == 0) || (dataRows == 0) || (dataCols == 0) ||
+            (filtBase + filtSize > MAX_SIZE) || (dataBase + dataSize > MAX_SIZE) || !geometry)
+        {
+            errors_ |= CNN_ERROR_DIMS;
+            return;
+        }
+
+        PostConfig postCfg;
+        postCfg.biasEn   = post & 1;
+        postCfg.bias     = reg(CNN_REG_BIAS);
+        postCfg.act      = static_cast<Activation>((post >> 1) & 0x3);
+        postCfg.slope    = reg(CNN_REG_SLOPE);
+        postCfg.poolSize = ((post >> 3) & 0x3) >= 2 ? (post >> 3) & 0x3 : 1;
+        postCfg.poolAvg  = (post >> 5) & 1;
+
+        int bank = hold ? !loadBank_ : loadBank_;
+        auto dataBegin = data_[bank].begin() + dataBase;
+        auto filtBegin = filt_[bank].begin() + filtBase;
+        std::vector<uint32_t> data(dataBegin, dataBegin + channels*dataRows*dataCols);
+        std::vector<uint32_t> filt(filtBegin, filtBegin + channels*filtRows*filtCols);
+        Job job = {{}, 0, steps_};
+        if (isGemm)
+        {
+            GemmConfig cfg = {dataRows, dataCols, filtRows};
+            cfg.post = postCfg;
+            data.resize(dataRows*dataCols);
+            filt.resize(filtRows*filtCols);
+            job.results = gemm(cfg, data, filt, 1);
+        }
+        else
+        {
+            ConvConfig cfg = {dataRows, dataCols, filtRows, filtCols, 1 << ((op >> 2) & 0x3), (int) (op >> 4) & 0xF,
+                1 << ((op >> 8) & 0x3)};
+            cfg.post = postCfg;
+            cfg.channels = channels;
+            job.results = conv2d(cfg, data, filt, 1);
+        }
+        ++jobs_;
+        if (!hold)
+        {
+            loadBank_ = !loadBank_;
+        }
+        if (!job.results.empty())
+        {
+            compute_.push_back(job);
+        }
+    }
+
+    std::vector<uint32_t> data_[2];
+    std::vector<uint32_t> filt_[2];
+    int loadBank_ = 0;
+    uint32_t regs_[32] = {};
+    uint32_t irqEnable_ = 0;
+    uint32_t errors_ = 0;
+    uint32_t perfSel_ = 0;
+    uint32_t perf_[CNN_PERF_EVENTS] = {};
+    bool done_ = false;
+    int jobs_ = 0;
+    long long steps_ = 0;
+    long badAccesses_ = 0;
+    std::deque<Job> compute_;
+    std::deque<std::pair<uint32_t, bool>> fifo_;
+};
+
+static std::vector<uint32_t> random_matrix(std::mt19937 &gen, std::size_t numElements)
+{
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    std::vector<uint32_t> values(numElements);
+    for (auto &value : values)
+    {
+        float sample = dist(gen);
+        std::memcpy(&value, &sample, sizeof(float));
+    }
+    return values;
+}
+
+static int failures = 0;
+
+static void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::printf("FAILED: %s\n", what);
+        ++failures;
+    }
+}
+
+static std::vector<uint32_t> expected_conv(const cnn_job_config &job, const std::vector<uint32_t> &data,
+    const std::vector<uint32_t> &filt)
+{
+    ConvConfig cfg = {job.dataRows, job.dataCols, job.filtRows, job.filtCols, 1 << job.strideLog2, job.pad,
+        1 << job.dilationLog2};
+    cfg.post.biasEn   = job.biasEn;
+    cfg.post.bias     = job.bias;
+    cfg.post.act      = static_cast<Activation>(job.act);
+    cfg.post.slope    = job.slope;
+    cfg.post.poolSize = job.poolSize >= 2 ? job.poolSize : 1;
+    cfg.post.poolAvg  = job.poolAvg;
+    cfg.channels      = std::max(1, job.channels);
+    return conv2d(cfg, data, filt, 1);
+}
+
+int main()
+{
+    std::mt19937 gen(0);
+    AcceleratorBfm bfm;
+    const cnn_device *dev = &bfm.device;
+
+    // Single convolution, waited on
+    {
+        cnn_job_config cfg;
+        cnn_job_config_init(&cfg);
+        cfg.filtRows = 3;
+        cfg.filtCols = 3;
+        cfg.dataRows = 40;
+        cfg.dataCols = 40;
+        cfg.pad      = 1;
+        std::vector<uint32_t> data = random_matrix(gen, 40*40);
+        std::vector<uint32_t> filt = random_matrix(gen, 3*3);
+        std::vector<uint32_t> out(cnn_job_outputs(&cfg));
+
+        cnn_perf_start(dev);
+        cnn_load_filter(dev, filt.data(), filt.size());
+        cnn_load_data(dev, data.data(), data.size());
+        cnn_job job;
+        check(cnn_submit(dev, &cfg, &job, out.data()) == CNN_OK, "submit of a single job");
+        check(cnn_wait(dev, &job) == CNN_DONE, "wait of a single job");
+        cnn_perf_stop(dev);
+        check(out == expected_conv(cfg, data, filt), "results of a single job");
+        check(cnn_perf_read(dev, 6) == out.size(), "results written counter");
+        check(cnn_status(dev) & CNN_STATUS_DONE, "done after the last result");
+        cnn_clear_done(dev);
+        check(!(cnn_status(dev) & CNN_STATUS_DONE), "done cleared");
+    }
+
+    // Two jobs in flight: the second is loaded into the other bank and
+    // submitted while the first computes, polling the first meanwhile
+    {
+        cnn_job_config cfgA, cfgB;
+        cnn_job_config_init(&cfgA);
+        cnn_job_config_init(&cfgB);
+        cfgA.filtRows = cfgA.filtCols = 5;
+        cfgA.dataRows = cfgA.dataCols = 48;
+        cfgA.pad      = 2;
+        cfgB.filtRows = cfgB.filtCols = 3;
+        cfgB.dataRows = cfgB.dataCols = 32;
+        cfgB.act      = CNN_ACT_RELU;
+        cfgB.poolSize = 2;
+        std::vector<uint32_t> dataA = random_matrix(gen, 48*48), filtA = random_matrix(gen, 25);
+        std::vector<uint32_t> dataB = random_matrix(gen, 32*32), filtB = random_matrix(gen, 9);
+        std::vector<uint32_t> outA(cnn_job_outputs(&cfgA)), outB(cnn_job_outputs(&cfgB));
+
+        cnn_irq_enable(dev, CNN_IRQ_DONE);
+        cnn_job jobA, jobB;
+        cnn_load_filter(dev, filtA.data(), filtA.size());
+        cnn_load_data(dev, dataA.data(), dataA.size());
+        check(cnn_submit(dev, &cfgA, &jobA, outA.data()) == CNN_OK, "submit of the first job");
+        check(!bfm.irq(), "no interrupt while computing");
+        cnn_load_filter(dev, filtB.data(), filtB.size());
+        cnn_load_data(dev, dataB.data(), dataB.size());
+
+        int busyRetries = 0;
+        int polls = 0;
+        int result;
+        while ((result = cnn_submit(dev, &cfgB, &jobB, outB.data())) == CNN_ERR_BUSY)
+        {
+            ++busyRetries;
+            polls += (cnn_poll(dev, &jobA) == CNN_PENDING);
+        }
+        check(result == CNN_OK, "submit of the second job");
+        check(busyRetries > 0, "second job refused while the first computes");
+        check(polls > 0, "first job polled without blocking");
+        check(CNN_STATUS_JOBS(cnn_status(dev)) >= 1, "jobs in flight");
+        check(cnn_wait(dev, &jobA) == CNN_DONE, "wait of the first job");
+        check(bfm.irq(), "done interrupt");
+        cnn_clear_done(dev);
+        check(!bfm.irq(), "done interrupt cleared");
+        check(cnn_wait(dev, &jobB) == CNN_DONE, "wait of the second job");
+        check(outA == expected_conv(cfgA, dataA, filtA), "results of the first job");
+        check(outB == expected_conv(cfgB, dataB, filtB), "results of the second job");
+        check(CNN_STATUS_JOBS(cnn_status(dev)) == 0, "no jobs left");
+        cnn_clear_done(dev);
+        cnn_irq_enable(dev, 0);
+    }
+
+    // Matrix multiply, with more columns of B than rows of A and a channel
+    // count that only applies to convolutions (4 x 20 x 60 is above
+    // MAX_SIZE)
+    {
+        int rows = 20, inner = 60, cols = 24;
+        cnn_job_config cfg;
+        cnn_job_config_init(&cfg);
+        cfg.opType   = CNN_OP_GEMM;
+        cfg.channels = 4;
+        cfg.filtRows = cols;
+        cfg.filtCols = inner;
+        cfg.dataRows = rows;
+        cfg.dataCols = inner;
+        std::vector<uint32_t> a = random_matrix(gen, rows*inner), bt = random_matrix(gen, cols*inner);
+        std::vector<uint32_t> out(cnn_job_outputs(&cfg));
+        cnn_job job;
+        cnn_load_filter(dev, bt.data(), bt.size());
+        cnn_load_data(dev, a.data(), a.size());
+        check(cnn_submit(dev, &cfg, &job, out.data()) == CNN_OK, "submit of a matrix multiply");
+        check(cnn_wait(dev, &job) == CNN_DONE, "wait of a matrix multiply");
+        check(out == gemm(GemmConfig{rows, inner, cols}, a, bt, 1), "results of a matrix multiply");
+        cnn_clear_done(dev);
+    }
+
+    // Layer of several input channels, every output sums the windows of
+    // all channel planes
+    {
+        const int channels = 4;
+        cnn_job_config cfg;
+        cnn_job_config_init(&cfg);
+        cfg.filtRows = cfg.filtCols = 3;
+        cfg.dataRows = cfg.dataCols = 24;
+        cfg.pad      = 1;
+        cfg.channels = channels;
+        cfg.biasEn   = 1;
+        cfg.act      = CNN_ACT_RELU;
+        std::vector<uint32_t> data = random_matrix(gen, channels*24*24), filt = random_matrix(gen, channels*9);
+        std::vector<uint32_t> out(cnn_job_outputs(&cfg));
+        cnn_job job;
+        cnn_load_filter(dev, filt.data(), filt.size());
+        cnn_load_data(dev, data.data(), data.size());
+        check(cnn_submit(dev, &cfg, &job, out.data()) == CNN_OK, "submit of a multi-channel job");
+        check(cnn_wait(dev, &job) == CNN_DONE, "wait of a multi-channel job");
+        check(out == expected_conv(cfg, data, filt), "results of a multi-channel job");
+        cnn_clear_done(dev);
+    }
+
+    // Small jobs loaded into one bank at their own offsets and queued back
+    // to back, holding the bank after the first
+    {
+        const int numJobs = 7;
+        cnn_job_config cfg[numJobs];
+        std::vector<uint32_t> data[numJobs], filt[numJobs], out[numJobs];
+        for (int k = 0; k < numJobs; ++k)
+        {
+            cnn_job_config_init(&cfg[k]);
+            cfg[k].filtRows = cfg[k].filtCols = 3;
+            cfg[k].dataRows = cfg[k].dataCols = 8 + (k & 1);
+            cfg[k].pad      = k % 2;
+            cfg[k].act      = (k % 3 == 0) ? CNN_ACT_RELU : CNN_ACT_NONE;
+            cfg[k].dataBase = 100*k;
+            cfg[k].filtBase = 9*k;
+            cfg[k].holdBank = (k != 0);
+            data[k] = random_matrix(gen, cfg[k].dataRows*cfg[k].dataCols);
+            filt[k] = random_matrix(gen, 9);
+            out[k].resize(cnn_job_outputs(&cfg[k]));
+            cnn_load_data_at(dev, cfg[k].dataBase, data[k].data(), data[k].size());
+            cnn_load_filter_at(dev, cfg[k].filtBase, filt[k].data(), filt[k].size());
+        }
+
+        cnn_job job[numJobs];
+        int submitted = 0, completed = 0, fullRetries = 0;
+        while (completed < numJobs)
+        {
+            if (submitted < numJobs)
+            {
+                int result = cnn_submit(dev, &cfg[submitted], &job[submitted], out[submitted].data());
+                if (result == CNN_OK)
+                {
+                    ++submitted;
+                    continue;
+                }
+                check(result == CNN_ERR_BUSY, "queued job refused only while the queue is full");
+                ++fullRetries;
+            }
+            if ((completed < submitted) && (cnn_poll(dev, &job[completed]) == CNN_DONE))
+            {
+                ++completed;
+            }
+        }
+        check(fullRetries > 0, "jobs refused while the queue is full");
+        for (int k = 0; k < numJobs; ++k)
+        {
+            check(out[k] == expected_conv(cfg[k], data[k], filt[k]), "results of a queued job");
+        }
+        cnn_clear_done(dev);
+    }
+
+    // Refused configurations and error interrupt
+    {
+        cnn_job_config cfg;
+        cnn_job_config_init(&cfg);
+        cfg.filtRows = 3;
+        cfg.filtCols = 3;
+        cnn_job job;
+        uint32_t out[1];
+        check(cnn_submit(dev, &cfg, &job, out) == CNN_ERR_CONFIG, "empty data matrix refused");
+        cfg.dataRows = 128;
+        cfg.dataCols = 128;
+        check(cnn_submit(dev, &cfg, &job, out) == CNN_ERR_CONFIG, "data matrix above MAX_SIZE refused");
+        cfg.dataRows = 64;
+        cfg.dataCols = 60;
+        cfg.pack     = 1;
+        check(cnn_submit(dev, &cfg, &job, out) == CNN_ERR_CONFIG, "packed data matrix above MAX_SIZE at its pitch refused");
+        cfg.pack      = 0;
+        cfg.channels  = 4;
+        cfg.filtRows  = 0x8000;
+        cfg.filtCols  = 0x8000;
+        cfg.dataRows  = 0x8000;
+        cfg.dataCols  = 0x8000;
+        check(cnn_submit(dev, &cfg, &job, out) == CNN_ERR_CONFIG, "stack size wrapping in 32 bits refused");
+        cfg.channels  = 1;
+        cfg.filtRows  = 5;
+        cfg.filtCols  = 5;
+        cfg.dataRows  = 4;
+        cfg.dataCols  = 4;
+        check(cnn_submit(dev, &cfg, &job, out) == CNN_ERR_CONFIG, "filter larger than the data refused");
+        cfg.filtRows     = 3;
+        cfg.filtCols     = 3;
+        cfg.dilationLog2 = 1;
+        check(cnn_submit(dev, &cfg, &job, out) == CNN_ERR_CONFIG, "dilated filter larger than the data refused");
+        cfg.dilationLog2 = 0;
+        cfg.filtRows     = 8;
+        cfg.dataRows     = 5;
+        cfg.dataCols     = 5;
+        cfg.pad          = 1;
+        check(cnn_submit(dev, &cfg, &job, out) == CNN_ERR_CONFIG, "filter taller than the padded data refused");
+        cfg.pad          = 0;
+        check(cnn_errors(dev) == 0, "errors cleared by submit");
+
+        cnn_irq_enable(dev, CNN_IRQ_ERROR);
+        dev->read32(dev->ctx, dev->regAddr + CNN_REG_RESULT);
+        check(cnn_errors(dev) == CNN_ERROR_EMPTY, "empty result read flagged");
+        check(bfm.irq(), "error interrupt");
+        cnn_clear_errors(dev);
+        check(!bfm.irq() && !(cnn_status(dev) & CNN_STATUS_ERROR), "error interrupt cleared");
+    }
+
+    check(bfm.badAccesses() == 0, "no reads of the RAMs");
+    std::printf("%lld bus accesses\n", bfm.accesses());
+    if (failures != 0)
+    {
+        std::printf("FAILED: %d checks\n", failures);
+        return 1;
+    }
+    std::printf("PASSED: driver matches the model through the register file\n");
+    return 0;
+}
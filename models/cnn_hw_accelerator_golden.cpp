@@ -0,0 +1,354 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cnn_hw_accelerator_model.h"
+#include "floating_point.h"
+
+// Generates golden vectors for tb/cnn_hw_accelerator_tb.v
+//
+// Writes data.txt and filt.txt (columns, rows, then row-major elements) and
+// output.txt (expected dataOut stream), all as one hex word per line.
+//
+// With --op gemm, data.txt holds A (data-rows x data-cols) and filt.txt holds
+// B transposed (filt-rows = columns of B, filt-cols = data-cols), as loaded
+// for the OP_GEMM mode of the accelerator.
+//
+// --stride, --pad and --dilation must match the STRIDE_LOG2, PAD and
+// DILATION_LOG2 parameters of the testbench.
+//
+// --format bf16|fp16 writes 16-bit operands (low bits of each word) for a
+// testbench built with FRAC_WIDTH/EXP_WIDTH of that type and VECTOR_SIZE =
+// 16; outputs stay single precision. --format int8 writes int8 operands for
+// MAC_STYLE = "INT8" with VECTOR_SIZE = 32, --quant-mult, --quant-shift and
+// --quant-zero must match QUANT_MULT, QUANT_SHIFT and QUANT_ZERO.
+//
+// --channels N convolves N input channels and writes their stacks: data.txt
+// holds N planes of data-rows rows (N * data-rows rows in its header) and
+// filt.txt N filter planes, as loaded for channelsIn = N. It must match
+// CHANNELS of the testbench. --load splits both files into N planes.
+//
+// --bias, --act, --slope, --pool and --pool-avg select the fused
+// post-processing and must match BIAS_EN/BIAS, ACT, SLOPE, POOL_SIZE and
+// POOL_AVG (the bit patterns are printed). output.txt then holds the
+// pooled outputs.
+//
+// Build with:
+//   gcc -O2 -c floating_point.c integer_mac.c
+//   g++ -O2 -std=c++17 -pthread cnn_hw_accelerator_golden.cpp cnn_hw_accelerator_model.cpp floating_point.o integer_mac.o -o cnn_hw_accelerator_golden
+
+using namespace cnn_hw_accelerator_model;
+
+static void usage(const char *name)
+{
+    std::printf("Usage: %s [options]\n", name);
+    std::printf("  --data-rows N   rows of data matrix (default 32)\n");
+    std::printf("  --data-cols N   columns of data matrix (default 32)\n");
+    std::printf("  --filt-rows N   rows of filter matrix (default 1)\n");
+    std::printf("  --filt-cols N   columns of filter matrix (default 32)\n");
+    std::printf("  --op conv|gemm  operation type (default conv)\n");
+    std::printf("  --stride N      convolution stride, power of two (default 1)\n");
+    std::printf("  --pad N         convolution zero padding (default 0)\n");
+    std::printf("  --dilation N    convolution dilation, power of two (default 1)\n");
+    std::printf("  --pack          pack filter rows into each beat (data.txt keeps the unpitched layout)\n");
+    std::printf("  --channels N    input channels accumulated into every output (default 1)\n");
+    std::printf("  --format F      operand type fp32, bf16, fp16 or int8 (default fp32)\n");
+    std::printf("  --quant-mult N  int8 requantization multiplier, 0 for raw int32 sums (default 0)\n");
+    std::printf("  --quant-shift N int8 requantization right shift (default 0)\n");
+    std::printf("  --quant-zero N  int8 output zero point (default 0)\n");
+    std::printf("  --bias X        add bias X to every output (int32 for int8)\n");
+    std::printf("  --act A         activation none, relu or leaky (default none)\n");
+    std::printf("  --slope X       leaky ReLU slope (default 0.125)\n");
+    std::printf("  --pool N        N x N pooling, 2 or 3 (default none)\n");
+    std::printf("  --pool-avg      average instead of max pooling\n");
+    std::printf("  --seed N        random seed (default 0)\n");
+    std::printf("  --threads N     worker threads, 0 for all cores (default 0)\n");
+    std::printf("  --max-size N    MAX_SIZE of the accelerator, 0 for no limit (default %d)\n", MAX_SIZE);
+    std::printf("  --dir PATH      directory for the vector files (default .)\n");
+    std::printf("  --load          read data.txt/filt.txt instead of generating them\n");
+}
+
+static bool write_matrix(const std::string &path, int rows, int cols, const std::vector<uint32_t> &values,
+    bool header)
+{
+    FILE *fid = std::fopen(path.c_str(), "w");
+    if (!fid)
+    {
+        std::printf("Could not open \"%s\"\n", path.c_str());
+        return false;
+    }
+    if (header)
+    {
+        std::fprintf(fid, "%08X\n%08X\n", cols, rows);
+    }
+    for (uint32_t value : values)
+    {
+        std::fprintf(fid, "%08X\n", value);
+    }
+    std::fclose(fid);
+    return true;
+}
+
+static bool read_matrix(const std::string &path, int &rows, int &cols, std::vector<uint32_t> &values)
+{
+    FILE *fid = std::fopen(path.c_str(), "r");
+    if (!fid)
+    {
+        std::printf("Could not open \"%s\"\n", path.c_str());
+        return false;
+    }
+    unsigned c = 0, r = 0;
+    bool ok = (std::fscanf(fid, "%x", &c) == 1) && (std::fscanf(fid, "%x", &r) == 1);
+    values.assign((std::size_t) r * c, 0);
+    for (std::size_t i = 0; ok && (i < values.size()); ++i)
+    {
+        unsigned value;
+        ok = (std::fscanf(fid, "%x", &value) == 1);
+        values[i] = value;
+    }
+    std::fclose(fid);
+    if (!ok)
+    {
+        std::printf("Malformed matrix file \"%s\"\n", path.c_str());
+        return false;
+    }
+    rows = (int) r;
+    cols = (int) c;
+    return true;
+}
+
+static std::vector<uint32_t> random_matrix(std::mt19937 &gen, std::size_t numElements, OperandFormat format)
+{
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    std::vector<uint32_t> values(numElements);
+    for (auto &value : values)
+    {
+        float sample = dist(gen);
+        std::memcpy(&value, &sample, sizeof(float));
+        if (format == OperandFormat::BF16)
+        {
+            value = floating_point_fp32_to_bf16_bits(value);
+        }
+        else if (format == OperandFormat::FP16)
+        {
+            value = floating_point_fp32_to_fp16_bits(value);
+        }
+        else if (format == OperandFormat::INT8)
+        {
+            value = (uint8_t) integer_quantize(sample, 1.0f/32, 0);
+        }
+    }
+    return values;
+}
+
+int main(int argc, char **argv)
+{
+    ConvConfig cfg = {32, 32, 1, 32};
+    unsigned seed = 0;
+    int numThreads = 0;
+    int maxSize = MAX_SIZE;
+    bool load = false;
+    bool isGemm = false;
+    std::string dir = ".";
+    std::string bias;
+    float slope = 0.125f;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--load")
+        {
+            load = true;
+        }
+        else if (arg == "--pack")
+        {
+            cfg.pack = true;
+        }
+        else if (arg == "--pool-avg")
+        {
+            cfg.post.poolAvg = true;
+        }
+        else if ((arg == "--bias") && hasValue)
+        {
+            bias = argv[++i];
+        }
+        else if ((arg == "--slope") && hasValue)
+        {
+            slope = std::strtof(argv[++i], nullptr);
+        }
+        else if ((arg == "--act") && hasValue && (std::string(argv[i+1]) == "none" ||
+            std::string(argv[i+1]) == "relu" || std::string(argv[i+1]) == "leaky"))
+        {
+            std::string act = argv[++i];
+            cfg.post.act = (act == "relu")  ? Activation::RELU :
+                           (act == "leaky") ? Activation::LEAKY : Activation::NONE;
+        }
+        else if ((arg == "--format") && hasValue && (std::string(argv[i+1]) == "fp32" ||
+            std::string(argv[i+1]) == "bf16" || std::string(argv[i+1]) == "fp16" ||
+            std::string(argv[i+1]) == "int8"))
+        {
+            std::string format = argv[++i];
+            cfg.format = (format == "bf16") ? OperandFormat::BF16 :
+                         (format == "fp16") ? OperandFormat::FP16 :
+                         (format == "int8") ? OperandFormat::INT8 : OperandFormat::FP32;
+        }
+        else if ((arg == "--dir") && hasValue)
+        {
+            dir = argv[++i];
+        }
+        else if ((arg == "--op") && hasValue && (std::string(argv[i+1]) == "conv" || std::string(argv[i+1]) == "gemm"))
+        {
+            isGemm = (std::string(argv[++i]) == "gemm");
+        }
+        else if (hasValue && (arg == "--data-rows" || arg == "--data-cols" || arg == "--filt-rows" ||
+            arg == "--filt-cols" || arg == "--stride" || arg == "--pad" || arg == "--dilation" ||
+            arg == "--seed" || arg == "--threads" || arg == "--max-size" || arg == "--quant-mult" ||
+            arg == "--quant-shift" || arg == "--quant-zero" || arg == "--pool" || arg == "--channels"))
+        {
+            long value = std::strtol(argv[++i], nullptr, 0);
+            if (arg == "--data-rows") cfg.dataRows = value;
+            if (arg == "--data-cols") cfg.dataCols = value;
+            if (arg == "--filt-rows") cfg.filtRows = value;
+            if (arg == "--filt-cols") cfg.filtCols = value;
+            if (arg == "--stride")    cfg.stride = value;
+            if (arg == "--pad")       cfg.pad = value;
+            if (arg == "--dilation")  cfg.dilation = value;
+            if (arg == "--seed")      seed = (unsigned) value;
+            if (arg == "--threads")   numThreads = value;
+            if (arg == "--max-size")  maxSize = value;
+            if (arg == "--quant-mult")  cfg.quant.mult = (int32_t) value;
+            if (arg == "--quant-shift") cfg.quant.shift = value;
+            if (arg == "--quant-zero")  cfg.quant.zero = (int8_t) value;
+            if (arg == "--pool")        cfg.post.poolSize = value;
+            if (arg == "--channels")    cfg.channels = value;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Bias is an int32 for the INT8 engine, single precision otherwise
+    if (!bias.empty())
+    {
+        float biasValue = std::strtof(bias.c_str(), nullptr);
+        cfg.post.biasEn = true;
+        cfg.post.bias = (uint32_t) std::strtol(bias.c_str(), nullptr, 0);
+        if (cfg.format != OperandFormat::INT8)
+        {
+            std::memcpy(&cfg.post.bias, &biasValue, sizeof(float));
+        }
+    }
+    std::memcpy(&cfg.post.slope, &slope, sizeof(float));
+
+    // Both operands of a matrix multiply share the inner dimension
+    if (isGemm && !load)
+    {
+        cfg.filtCols = cfg.dataCols;
+    }
+
+    // Channel stacks are a single matrix of channels times the rows
+    if ((cfg.channels < 1) || (isGemm && (cfg.channels != 1)))
+    {
+        std::printf("Channels must be at least 1, and 1 for gemm\n");
+        return 1;
+    }
+    std::vector<uint32_t> data, filt;
+    if (load)
+    {
+        if (!read_matrix(dir + "/data.txt", cfg.dataRows, cfg.dataCols, data) ||
+            !read_matrix(dir + "/filt.txt", cfg.filtRows, cfg.filtCols, filt))
+        {
+            return 1;
+        }
+        if ((cfg.dataRows % cfg.channels != 0) || (cfg.filtRows % cfg.channels != 0))
+        {
+            std::printf("Matrix rows are not a multiple of %d channels\n", cfg.channels);
+            return 1;
+        }
+        cfg.dataRows /= cfg.channels;
+        cfg.filtRows /= cfg.channels;
+    }
+    else
+    {
+        std::mt19937 gen(seed);
+        data = random_matrix(gen, (std::size_t) cfg.channels * cfg.dataRows * cfg.dataCols, cfg.format);
+        filt = random_matrix(gen, (std::size_t) cfg.channels * cfg.filtRows * cfg.filtCols, cfg.format);
+    }
+
+    // Both matrices must fit in the accelerator RAM banks
+    if ((maxSize > 0) && (((std::size_t) cfg.channels * cfg.dataRows * data_pitch(cfg) > (std::size_t) maxSize) ||
+        (filt.size() > (std::size_t) maxSize)))
+    {
+        std::printf("Matrices exceed MAX_SIZE = %d elements\n", maxSize);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint32_t> out;
+    try
+    {
+        if (isGemm)
+        {
+            if (cfg.filtCols != cfg.dataCols)
+            {
+                std::printf("Inner dimensions differ (%d and %d)\n", cfg.dataCols, cfg.filtCols);
+                return 1;
+            }
+            out = gemm({cfg.dataRows, cfg.dataCols, cfg.filtRows, cfg.format, cfg.quant, cfg.post}, data, filt,
+                numThreads);
+        }
+        else
+        {
+            out = conv2d(cfg, data, filt, numThreads);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::printf("Invalid configuration: %s\n", e.what());
+        return 1;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    if (!load)
+    {
+        if (!write_matrix(dir + "/data.txt", cfg.channels * cfg.dataRows, cfg.dataCols, data, true) ||
+            !write_matrix(dir + "/filt.txt", cfg.channels * cfg.filtRows, cfg.filtCols, filt, true))
+        {
+            return 1;
+        }
+    }
+    if (!write_matrix(dir + "/output.txt", 0, 0, out, false))
+    {
+        return 1;
+    }
+
+    if (!isGemm)
+    {
+        RamReads before = conv2d_ram_reads(cfg, false);
+        RamReads after = conv2d_ram_reads(cfg, true);
+        double numConv = (double) output_rows(cfg)*output_cols(cfg);
+        std::printf("MAC beats: %lld (%.1f%% lane utilization), filter RAM reads: %lld\n", after.beats,
+            100.0*after.filtReads/(after.beats*vector_size(cfg.format)), after.filtReads);
+        std::printf("Data RAM reads: %lld without line buffer, %lld with (%.2f vs %.2f per output)\n",
+            before.dataReads, after.dataReads, before.dataReads/numConv, after.dataReads/numConv);
+    }
+    if (cfg.post.biasEn || (cfg.post.act != Activation::NONE) || (cfg.post.poolSize > 1))
+    {
+        std::printf("Post-processing: BIAS_EN = %d, BIAS = 0x%08X, ACT = %d, SLOPE = 0x%08X, POOL_SIZE = %d, POOL_AVG = %d\n",
+            cfg.post.biasEn, cfg.post.bias, (int) cfg.post.act, cfg.post.slope,
+            (cfg.post.poolSize > 1) ? cfg.post.poolSize : 0, cfg.post.poolAvg);
+    }
+    std::printf("Computed %zu %s outputs (%dx%dx%d data, %dx%d filter, stride %d, pad %d, dilation %d) in %f seconds (%.1f outputs/s)\n",
+        out.size(), isGemm ? "gemm" : "conv", cfg.channels, cfg.dataRows, cfg.dataCols, cfg.filtRows, cfg.filtCols,
+        cfg.stride, cfg.pad, cfg.dilation, seconds, seconds > 0 ? out.size() / seconds : 0.0);
+
+    return 0;
+}
@@ -0,0 +1,507 @@
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#include "cnn_hw_accelerator_model.h"
+#include "floating_point.h"
+
+namespace cnn_hw_accelerator_model
+{
+    void Accumulator::push(uint32_t data)
+    {
+        if (format_ == OperandFormat::INT8)
+        {
+            sum_ += data;
+            return;
+        }
+
+        // Each slot only sees every ACCUM_SLOTS-th sample
+        // The first sample of a slot is added to the zero feedback
+        std::size_t slot = count_ % ACCUM_SLOTS;
+        uint32_t feedback = (count_ < ACCUM_SLOTS) ? 0 : slots_[slot];
+        slots_[slot] = floating_point_add_bits(data, feedback);
+        ++count_;
+    }
+
+    uint32_t Accumulator::result() const
+    {
+        if (format_ == OperandFormat::INT8)
+        {
+            return sum_;
+        }
+
+        // Partial sums leave the feedback loop in the order their last
+        // sample entered, starting with the oldest slot
+        std::size_t numSamples = std::min<std::size_t>(count_, ACCUM_SLOTS);
+        uint32_t samples[ACCUM_SLOTS];
+        for (std::size_t i = 0; i < numSamples; ++i)
+        {
+            samples[i] = slots_[(count_ - numSamples + i) % ACCUM_SLOTS];
+        }
+
+        // Each stage adds consecutive pairs (newer sample on port A)
+        // An unpaired final sample is added to zero
+        for (int stage = 0; stage < ACCUM_STAGES; ++stage)
+        {
+            std::size_t numOut = 0;
+            for (std::size_t i = 0; i < numSamples; i += 2)
+            {
+                if (i + 1 < numSamples)
+                {
+                    samples[numOut++] = floating_point_add_bits(samples[i+1], samples[i]);
+                }
+                else
+                {
+                    samples[numOut++] = floating_point_add_bits(samples[i], 0);
+                }
+            }
+            numSamples = numOut;
+        }
+        return samples[0];
+    }
+
+    int vector_size(OperandFormat format)
+    {
+        switch (format)
+        {
+            case OperandFormat::FP32: return VECTOR_SIZE;
+            case OperandFormat::INT8: return 4*VECTOR_SIZE;
+            default:                  return 2*VECTOR_SIZE;
+        }
+    }
+
+    // Valid mask of the first numLanes lanes
+    static unsigned lane_mask(int numLanes)
+    {
+        return (numLanes >= 32) ? ~0u : (1u << numLanes) - 1;
+    }
+
+    uint32_t widen_operand(uint32_t bits, OperandFormat format)
+    {
+        switch (format)
+        {
+            case OperandFormat::BF16: return floating_point_bf16_to_fp32_bits((uint16_t) bits);
+            case OperandFormat::FP16: return floating_point_fp16_to_fp32_bits((uint16_t) bits);
+            default:                  return bits;
+        }
+    }
+
+    uint32_t multiply_add_tree(const uint32_t *dataA, const uint32_t *dataB, unsigned validMask,
+        OperandFormat format)
+    {
+        // Integer engine, order does not matter for a wrapping sum
+        int numLanes = vector_size(format);
+        if (format == OperandFormat::INT8)
+        {
+            int8_t a[MAX_VECTOR_SIZE];
+            int8_t b[MAX_VECTOR_SIZE];
+            for (int i = 0; i < numLanes; ++i)
+            {
+                a[i] = ((validMask >> i) & 1) ? (int8_t) dataA[i] : 0;
+                b[i] = ((validMask >> i) & 1) ? (int8_t) dataB[i] : 0;
+            }
+            return (uint32_t) integer_mac_dot(a, b, numLanes, 0);
+        }
+
+        // Elementwise multiplication of the widened operands
+        uint32_t stageData[MAX_VECTOR_SIZE];
+        unsigned stageValid = validMask;
+        for (int i = 0; i < numLanes; ++i)
+        {
+            stageData[i] = ((validMask >> i) & 1) ?
+                floating_point_multiply_bits(widen_operand(dataA[i], format), widen_operand(dataB[i], format)) : 0;
+        }
+
+        // Adder tree, invalid inputs are replaced by zero and
+        // an adder output is valid if either input is valid
+        for (int numAdds = numLanes/2; numAdds > 0; numAdds /= 2)
+        {
+            unsigned nextValid = 0;
+            for (int j = 0; j < numAdds; ++j)
+            {
+                bool validA = (stageValid >> (2*j)) & 1;
+                bool validB = (stageValid >> (2*j+1)) & 1;
+                if (validA || validB)
+                {
+                    stageData[j] = floating_point_add_bits(validA ? stageData[2*j] : 0,
+                        validB ? stageData[2*j+1] : 0);
+                    nextValid |= 1u << j;
+                }
+            }
+            stageValid = nextValid;
+        }
+        return stageData[0];
+    }
+
+    int output_rows(const ConvConfig &cfg)
+    {
+        return (cfg.dataRows + 2*cfg.pad - cfg.dilation*(cfg.filtRows - 1) - 1)/cfg.stride + 1;
+    }
+
+    int output_cols(const ConvConfig &cfg)
+    {
+        return (cfg.dataCols + 2*cfg.pad - cfg.dilation*(cfg.filtCols - 1) - 1)/cfg.stride + 1;
+    }
+
+    bool is_packed(const ConvConfig &cfg)
+    {
+        return cfg.pack && (cfg.dilation == 1);
+    }
+
+    int data_pitch(const ConvConfig &cfg)
+    {
+        int lanes = vector_size(cfg.format);
+        return is_packed(cfg) ? cfg.dataCols + ((cfg.filtCols - cfg.dataCols) & (lanes - 1)) : cfg.dataCols;
+    }
+
+    static bool is_power_of_two(int value)
+    {
+        return (value > 0) && ((value & (value - 1)) == 0);
+    }
+
+    // Push one row of products in beats of up to VECTOR_SIZE columns
+    // Lanes past the end of the row are masked off
+    static void push_row(Accumulator &accum, const uint32_t *dataRow, const uint32_t *filtRow, int numCols,
+        OperandFormat format)
+    {
+        int lanes = vector_size(format);
+        uint32_t dataBeat[MAX_VECTOR_SIZE];
+        uint32_t filtBeat[MAX_VECTOR_SIZE];
+        for (int col = 0; col < numCols; col += lanes)
+        {
+            int beatCols = std::min(lanes, numCols - col);
+            for (int i = 0; i < lanes; ++i)
+            {
+                dataBeat[i] = (i < beatCols) ? dataRow[col + i] : 0;
+                filtBeat[i] = (i < beatCols) ? filtRow[col + i] : 0;
+            }
+            accum.push(multiply_add_tree(dataBeat, filtBeat, lane_mask(beatCols), format));
+        }
+    }
+
+    // Push one row of a convolution window in beats of VECTOR_SIZE/dilation
+    // filter columns, the data column of filter column i is col + i*dilation
+    // Columns in the padding are zero but still occupy their lane
+    static void push_window_row(Accumulator &accum, const ConvConfig &cfg, const uint32_t *data,
+        const uint32_t *filtRow, int dataRow, int dataCol)
+    {
+        int lanes = vector_size(cfg.format);
+        int beatLanes = lanes/cfg.dilation;
+        bool rowInside = (dataRow >= 0) && (dataRow < cfg.dataRows);
+        uint32_t dataBeat[MAX_VECTOR_SIZE];
+        uint32_t filtBeat[MAX_VECTOR_SIZE];
+        for (int col = 0; col < cfg.filtCols; col += beatLanes)
+        {
+            int beatCols = std::min(beatLanes, cfg.filtCols - col);
+            for (int i = 0; i < lanes; ++i)
+            {
+                int pos = dataCol + (col + i)*cfg.dilation;
+                bool inside = rowInside && (pos >= 0) && (pos < cfg.dataCols);
+                dataBeat[i] = ((i < beatCols) && inside) ? data[(std::size_t) dataRow * cfg.dataCols + pos] : 0;
+                filtBeat[i] = (i < beatCols) ? filtRow[col + i] : 0;
+            }
+            accum.push(multiply_add_tree(dataBeat, filtBeat, lane_mask(beatCols), cfg.format));
+        }
+    }
+
+    // Push a whole convolution window in beats of VECTOR_SIZE consecutive
+    // elements of the row-major window, crossing filter rows
+    static void push_packed_window(Accumulator &accum, const ConvConfig &cfg, const uint32_t *data,
+        const uint32_t *filt, int dataRow, int dataCol)
+    {
+        int lanes = vector_size(cfg.format);
+        int numElems = cfg.filtRows*cfg.filtCols;
+        uint32_t dataBeat[MAX_VECTOR_SIZE];
+        uint32_t filtBeat[MAX_VECTOR_SIZE];
+        for (int elem = 0; elem < numElems; elem += lanes)
+        {
+            int beatElems = std::min(lanes, numElems - elem);
+            for (int i = 0; i < lanes; ++i)
+            {
+                int row = dataRow + (elem + i)/cfg.filtCols;
+                int col = dataCol + (elem + i) % cfg.filtCols;
+                bool inside = (row >= 0) && (row < cfg.dataRows) && (col >= 0) && (col < cfg.dataCols);
+                dataBeat[i] = ((i < beatElems) && inside) ? data[(std::size_t) row * cfg.dataCols + col] : 0;
+                filtBeat[i] = (i < beatElems) ? filt[elem + i] : 0;
+            }
+            accum.push(multiply_add_tree(dataBeat, filtBeat, lane_mask(beatElems), cfg.format));
+        }
+    }
+
+    // Output before pooling, INT8 accumulations are requantized
+    // (integer_requantize.v) and single precision results go through the
+    // bias and activation stages of post_process.v
+    static uint32_t output_value(const Accumulator &accum, OperandFormat format, const integer_quant &quant,
+        const PostConfig &post)
+    {
+        uint32_t value = accum.result();
+        if (format == OperandFormat::INT8)
+        {
+            int32_t acc = (int32_t) (value + (post.biasEn ? post.bias : 0));
+            int32_t out = integer_requantize(acc, &quant);
+            if (post.act != Activation::NONE)
+            {
+                out = std::max(out, (quant.mult == 0) ? 0 : (int32_t) quant.zero);
+            }
+            return (uint32_t) out;
+        }
+
+        if (post.biasEn)
+        {
+            value = floating_point_add_bits(value, post.bias);
+        }
+        if ((value >> 31) && (post.act == Activation::RELU))
+        {
+            value = 0;
+        }
+        else if ((value >> 31) && (post.act == Activation::LEAKY))
+        {
+            value = floating_point_multiply_bits(value, post.slope);
+        }
+        return value;
+    }
+
+    // Combine two samples of a pooling window (pool_combine.v)
+    // Maximum in the IEEE-754 total order, integer sums wrap
+    static uint32_t pool_combine(uint32_t a, uint32_t b, bool avg, OperandFormat format)
+    {
+        if (format == OperandFormat::INT8)
+        {
+            return avg ? a + b : ((int32_t) b > (int32_t) a) ? b : a;
+        }
+        if (avg)
+        {
+            return floating_point_add_bits(a, b);
+        }
+        uint32_t keyA = (a >> 31) ? ~a : (a | 0x80000000u);
+        uint32_t keyB = (b >> 31) ? ~b : (b | 0x80000000u);
+        return (keyB > keyA) ? b : a;
+    }
+
+    std::vector<uint32_t> pool_outputs(const PostConfig &post, OperandFormat format, int rows, int cols,
+        const std::vector<uint32_t> &out)
+    {
+        int size = post.poolSize;
+        if (size <= 1)
+        {
+            return out;
+        }
+        if ((size > 3) || (size > rows) || (size > cols) || (cols/size > POOL_COLS))
+        {
+            throw std::invalid_argument("pooling window must be 2 or 3 and fit in the output matrix and line buffer");
+        }
+
+        // Windows reduce left to right in every row, then top to bottom
+        int poolRows = rows/size;
+        int poolCols = cols/size;
+        std::vector<uint32_t> pooled((std::size_t) poolRows * poolCols);
+        for (int row = 0; row < poolRows; ++row)
+        {
+            for (int col = 0; col < poolCols; ++col)
+            {
+                uint32_t window = 0;
+                for (int i = 0; i < size; ++i)
+                {
+                    const uint32_t *line = &out[(std::size_t) (row*size + i) * cols + col*size];
+                    uint32_t lineValue = line[0];
+                    for (int j = 1; j < size; ++j)
+                    {
+                        lineValue = pool_combine(lineValue, line[j], post.poolAvg, format);
+                    }
+                    window = (i == 0) ? lineValue : pool_combine(window, lineValue, post.poolAvg, format);
+                }
+
+                // Averages multiply by the reciprocal of the window size
+                if (post.poolAvg && (format == OperandFormat::INT8))
+                {
+                    int64_t recip = (size == 3) ? 7282 : 16384;
+                    window = (uint32_t) (((int64_t) (int32_t) window * recip + (1 << 15)) >> 16);
+                }
+                else if (post.poolAvg)
+                {
+                    window = floating_point_multiply_bits(window, (size == 3) ? 0x3DE38E39u : 0x3E800000u);
+                }
+                pooled[(std::size_t) row * poolCols + col] = window;
+            }
+        }
+        return pooled;
+    }
+
+    // Run body(row) for every row in [0, numRows) across worker threads
+    static void parallel_rows(int numRows, int numThreads, const std::function<void(int)> &body)
+    {
+        if (numThreads <= 0)
+        {
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        numThreads = std::min(numThreads, numRows);
+        if (numThreads <= 1)
+        {
+            for (int row = 0; row < numRows; ++row)
+            {
+                body(row);
+            }
+            return;
+        }
+
+        // Rows are handed out dynamically so uneven rows balance
+        std::atomic<int> nextRow(0);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < numThreads; ++t)
+        {
+            workers.emplace_back([&]() {
+                for (int row = nextRow++; row < numRows; row = nextRow++)
+                {
+                    body(row);
+                }
+            });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    std::vector<uint32_t> conv2d(const ConvConfig &cfg, const std::vector<uint32_t> &data,
+        const std::vector<uint32_t> &filt, int numThreads)
+    {
+        if (!is_power_of_two(cfg.stride) || (cfg.stride > MAX_STRIDE) ||
+            !is_power_of_two(cfg.dilation) || (cfg.dilation > vector_size(cfg.format)) ||
+            (cfg.pad < 0) || (cfg.pad > MAX_PAD))
+        {
+            throw std::invalid_argument("stride and dilation must be supported powers of two and padding in range");
+        }
+        if ((cfg.channels < 1) || (cfg.filtRows < 1) || (cfg.filtCols < 1) ||
+            (cfg.dilation*(cfg.filtRows - 1) + 1 > cfg.dataRows + 2*cfg.pad) ||
+            (cfg.dilation*(cfg.filtCols - 1) + 1 > cfg.dataCols + 2*cfg.pad))
+        {
+            throw std::invalid_argument("filter and channels must be non-empty and fit inside the padded data matrix");
+        }
+        std::size_t dataPlane = (std::size_t) cfg.dataRows * cfg.dataCols;
+        std::size_t filtPlane = (std::size_t) cfg.filtRows * cfg.filtCols;
+        if ((data.size() != cfg.channels * dataPlane) || (filt.size() != cfg.channels * filtPlane))
+        {
+            throw std::invalid_argument("matrix sizes do not match the configuration");
+        }
+
+        int outRows = output_rows(cfg);
+        int outCols = output_cols(cfg);
+        std::vector<uint32_t> out((std::size_t) outRows * outCols);
+
+        parallel_rows(outRows, numThreads, [&](int row) {
+            Accumulator accum(cfg.format);
+            for (int col = 0; col < outCols; ++col)
+            {
+                // The windows of all channels feed one accumulation
+                accum.clear();
+                for (int chan = 0; chan < cfg.channels; ++chan)
+                {
+                    const uint32_t *dataChan = &data[chan*dataPlane];
+                    const uint32_t *filtChan = &filt[chan*filtPlane];
+                    if (is_packed(cfg))
+                    {
+                        push_packed_window(accum, cfg, dataChan, filtChan, row*cfg.stride - cfg.pad,
+                            col*cfg.stride - cfg.pad);
+                        continue;
+                    }
+                    for (int filtRow = 0; filtRow < cfg.filtRows; ++filtRow)
+                    {
+                        push_window_row(accum, cfg, dataChan, &filtChan[(std::size_t) filtRow * cfg.filtCols],
+                            row*cfg.stride + filtRow*cfg.dilation - cfg.pad, col*cfg.stride - cfg.pad);
+                    }
+                }
+                out[(std::size_t) row * outCols + col] = output_value(accum, cfg.format, cfg.quant, cfg.post);
+            }
+        });
+
+        return pool_outputs(cfg.post, cfg.format, outRows, outCols, out);
+    }
+
+    RamReads conv2d_ram_reads(const ConvConfig &cfg, bool lineBuffer)
+    {
+        // Line buffer holds the window of every filter row in one beat,
+        // for a single channel only
+        bool window = lineBuffer && !is_packed(cfg) && (cfg.dilation == 1) && (cfg.filtCols <= vector_size(cfg.format)) &&
+            (cfg.filtRows <= WINDOW_ROWS) && (cfg.channels == 1);
+        int lanes = vector_size(cfg.format);
+        int beatLanes = lanes/cfg.dilation;
+        int numElems = cfg.filtRows*cfg.filtCols;
+        RamReads reads = {0, 0, 0};
+        for (int row = 0; row < output_rows(cfg); ++row)
+        {
+            for (int col = 0; col < output_cols(cfg); ++col)
+            {
+                // Packed beats read every element of the window once
+                if (is_packed(cfg))
+                {
+                    for (int elem = 0; elem < numElems; ++elem)
+                    {
+                        int dataRow = row*cfg.stride + elem/cfg.filtCols - cfg.pad;
+                        int dataCol = col*cfg.stride + elem % cfg.filtCols - cfg.pad;
+                        reads.beats += (elem % lanes == 0);
+                        reads.dataReads += (dataRow >= 0) && (dataRow < cfg.dataRows) &&
+                            (dataCol >= 0) && (dataCol < cfg.dataCols);
+                        ++reads.filtReads;
+                    }
+                    continue;
+                }
+                for (int filtRow = 0; filtRow < cfg.filtRows; ++filtRow)
+                {
+                    int dataRow = row*cfg.stride + filtRow*cfg.dilation - cfg.pad;
+                    for (int filtCol = 0; filtCol < cfg.filtCols; filtCol += beatLanes)
+                    {
+                        ++reads.beats;
+                        for (int i = filtCol; i < std::min(filtCol + beatLanes, cfg.filtCols); ++i)
+                        {
+                            // Padding is never read, the line buffer only
+                            // reads the columns entering the window
+                            int dataCol = col*cfg.stride + i*cfg.dilation - cfg.pad;
+                            bool inside = (dataRow >= 0) && (dataRow < cfg.dataRows) &&
+                                (dataCol >= 0) && (dataCol < cfg.dataCols);
+                            bool reused = window && (col != 0) && (i + cfg.stride < cfg.filtCols);
+                            reads.dataReads += inside && !reused;
+                            ++reads.filtReads;
+                        }
+                    }
+                }
+            }
+        }
+        // Every channel reads its window like a single channel job
+        reads.beats *= cfg.channels;
+        reads.dataReads *= cfg.channels;
+        reads.filtReads *= cfg.channels;
+        return reads;
+    }
+
+    std::vector<uint32_t> gemm(const GemmConfig &cfg, const std::vector<uint32_t> &a,
+        const std::vector<uint32_t> &bt, int numThreads)
+    {
+        if ((cfg.rows < 1) || (cfg.inner < 1) || (cfg.cols < 1))
+        {
+            throw std::invalid_argument("matrix dimensions must be non-zero");
+        }
+        if ((a.size() != (std::size_t) cfg.rows * cfg.inner) ||
+            (bt.size() != (std::size_t) cfg.cols * cfg.inner))
+        {
+            throw std::invalid_argument("matrix sizes do not match the configuration");
+        }
+
+        // Each output is a single accumulation over one row of A and one
+        // row of B transposed
+        std::vector<uint32_t> out((std::size_t) cfg.rows * cfg.cols);
+        parallel_rows(cfg.rows, numThreads, [&](int row) {
+            Accumulator accum(cfg.format);
+            for (int col = 0; col < cfg.cols; ++col)
+            {
+                accum.clear();
+                push_row(accum, &a[(std::size_t) row * cfg.inner], &bt[(std::size_t) col * cfg.inner], cfg.inner,
+                    cfg.format);
+                out[(std::size_t) row * cfg.cols + col] = output_value(accum, cfg.format, cfg.quant, cfg.post);
+            }
+        });
+
+        return pool_outputs(cfg.post, cfg.format, cfg.rows, cfg.cols, out);
+    }
+}
@@ -0,0 +1,206 @@
+#ifndef CNN_HW_ACCELERATOR_MODEL_H
+#define CNN_HW_ACCELERATOR_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "integer_mac.h"
+
+// Bit-accurate model of src/cnn_hw_accelerator.v
+//
+// All values are IEEE-754 single precision bit patterns, except the
+// operands of a 16-bit build and the integers of the INT8 MAC engine
+// (see OperandFormat). Results reproduce
+// the summation order of the hardware: VECTOR_SIZE-lane multiply, log2 adder
+// tree (mutliply_and_accumulate.v) and the interleaved feedback plus final
+// combine stages of floating_point_accumulator.v.
+
+namespace cnn_hw_accelerator_model
+{
+    // Multiply and accumulate input width (VECTOR_SIZE in the RTL)
+    constexpr int VECTOR_SIZE    = 8;
+    
+    // Lanes of an INT8 build, four operands per 32 bits of RAM
+    constexpr int MAX_VECTOR_SIZE = 4*VECTOR_SIZE;
+    
+    // Operand type of the data and filter RAMs (FRAC_WIDTH/EXP_WIDTH)
+    // 16-bit operands are held in the low bits of each uint32_t and are
+    // widened to single precision before the multipliers
+    // INT8 operands (MAC_STYLE = "INT8") are held in the low byte and
+    // accumulate in 32-bit integers, outputs are requantized
+    enum class OperandFormat
+    {
+        FP32,
+        BF16,
+        FP16,
+        INT8
+    };
+
+    // MAC lanes of a build with the given operand type
+    int vector_size(OperandFormat format);
+
+    // Single precision bit pattern of an operand (floating_point_convert.v)
+    uint32_t widen_operand(uint32_t bits, OperandFormat format);
+
+    // Interleaved partial sums in floating_point_accumulator.v
+    // Feedback path is ADD_LATENCY plus the output register
+    constexpr int ADD_LATENCY    = 13;
+    constexpr int ACCUM_SLOTS    = ADD_LATENCY + 1;
+
+    // Combine stages after the accumulator, $clog2(ADD_LATENCY+1)
+    constexpr int ACCUM_STAGES   = 4;
+
+    // Default maximum size of input matrices (MAX_SIZE in the RTL)
+    constexpr int MAX_SIZE       = 4096;
+
+    // Model of floating_point_accumulator.v for a single accumulation
+    // INT8 accumulations are wrapping integer sums
+    class Accumulator
+    {
+    public:
+        explicit Accumulator(OperandFormat format = OperandFormat::FP32) : format_(format) { clear(); }
+
+        // Start a new accumulation
+        void clear() { count_ = 0; sum_ = 0; }
+
+        // Add one sample from the adder tree
+        void push(uint32_t data);
+
+        // Combine the partial sums as the output stages do
+        uint32_t result() const;
+
+    private:
+        OperandFormat format_;
+        uint32_t slots_[ACCUM_SLOTS];
+        std::size_t count_;
+        uint32_t sum_;
+    };
+
+    // Adder tree of mutliply_and_accumulate.v for one vector beat of
+    // vector_size(format) lanes, lane i is used when bit i of validMask is set
+    uint32_t multiply_add_tree(const uint32_t *dataA, const uint32_t *dataB, unsigned validMask,
+        OperandFormat format = OperandFormat::FP32);
+
+    // Filter rows held by the sliding-window line buffer (WINDOW_ROWS)
+    constexpr int WINDOW_ROWS    = 16;
+
+    // Largest zero padding of the accelerator (4-bit padIn)
+    constexpr int MAX_PAD        = 15;
+
+    // Largest power-of-two stride of the accelerator (2-bit strideLog2In)
+    constexpr int MAX_STRIDE     = 8;
+
+    // Activation of the post-processing stage (actIn)
+    enum class Activation
+    {
+        NONE,
+        RELU,
+        LEAKY
+    };
+
+    // Default depth of the pooling line buffer (POOL_COLS in the RTL)
+    constexpr int POOL_COLS      = MAX_SIZE/4;
+
+    // Fused post-processing of the outputs (post_process.v)
+    // The bias is added, then outputs with the sign bit set are zeroed
+    // (ReLU) or multiplied by slope (leaky ReLU), then non-overlapping
+    // poolSize x poolSize windows (2 or 3) are reduced to their maximum or
+    // average, dropping outputs beyond the last whole window
+    // bias and slope are single precision bit patterns. INT8 builds add
+    // bias as an int32 to the accumulation before requantization and clamp
+    // at the zero point for either activation
+    struct PostConfig
+    {
+        bool biasEn    = false;
+        uint32_t bias  = 0;
+        Activation act = Activation::NONE;
+        uint32_t slope = 0;
+        int poolSize   = 1;
+        bool poolAvg   = false;
+    };
+
+    // Apply the pooling of post_process.v to a rows x cols output matrix,
+    // bias and activation are applied when the outputs are computed
+    // Returns rows/poolSize x cols/poolSize outputs in dataOut order
+    std::vector<uint32_t> pool_outputs(const PostConfig &post, OperandFormat format, int rows, int cols,
+        const std::vector<uint32_t> &out);
+
+    // Dimensions and geometry of a 2D convolution job
+    // Stride and dilation are powers of two, a dilated beat covers
+    // VECTOR_SIZE/dilation filter columns
+    // Packed jobs (packIn, ignored with dilation) fill every beat with
+    // VECTOR_SIZE consecutive elements of the row-major filter window
+    // VECTOR_SIZE is vector_size(format) throughout
+    // With several input channels (channelsIn) data and filter hold
+    // channels planes of dataRows x dataCols and filtRows x filtCols one
+    // after the other, and every output accumulates its window over all
+    // channels in order before it is post-processed
+    struct ConvConfig
+    {
+        int dataRows;
+        int dataCols;
+        int filtRows;
+        int filtCols;
+        int stride   = 1;
+        int pad      = 0;
+        int dilation = 1;
+        bool pack    = false;
+        OperandFormat format = OperandFormat::FP32;
+        integer_quant quant  = {0, 0, 0};
+        PostConfig post      = {};
+        int channels         = 1;
+    };
+
+    // Whether a job runs with packed beats
+    bool is_packed(const ConvConfig &cfg);
+
+    // Row pitch of the data matrix in the data RAM
+    // Packed jobs round dataCols up to filtCols modulo VECTOR_SIZE
+    int data_pitch(const ConvConfig &cfg);
+
+    // Output dimensions of a 2D convolution job
+    int output_rows(const ConvConfig &cfg);
+    int output_cols(const ConvConfig &cfg);
+
+    // Dimensions of a matrix multiply job C = A * B
+    // A is rows x inner, B is inner x cols
+    struct GemmConfig
+    {
+        int rows;
+        int inner;
+        int cols;
+        OperandFormat format = OperandFormat::FP32;
+        integer_quant quant  = {0, 0, 0};
+        PostConfig post      = {};
+    };
+
+    // MAC beats (one per cycle when not throttled) and elements read from
+    // the data and filter RAMs by a 2D convolution job
+    struct RamReads
+    {
+        long long beats;
+        long long dataReads;
+        long long filtReads;
+    };
+
+    // Read counts of the address pipeline with or without the line buffer
+    // (LINE_BUFFER in the RTL)
+    RamReads conv2d_ram_reads(const ConvConfig &cfg, bool lineBuffer);
+
+    // Output pixels of a 2D convolution in the order they leave dataOut,
+    // after post-processing
+    // Output rows are split across numThreads worker threads
+    // (0 selects the number of hardware threads)
+    std::vector<uint32_t> conv2d(const ConvConfig &cfg, const std::vector<uint32_t> &data,
+        const std::vector<uint32_t> &filt, int numThreads = 0);
+
+    // Elements of C = A * B in the order they leave dataOut (row-major),
+    // after post-processing
+    // a is A row-major as loaded into the data RAM and bt is B column-major
+    // (B transposed, cols x inner) as loaded into the filter RAM
+    std::vector<uint32_t> gemm(const GemmConfig &cfg, const std::vector<uint32_t> &a,
+        const std::vector<uint32_t> &bt, int numThreads = 0);
+}
+
+#endif
@@ -0,0 +1,177 @@
+#include <string.h>
+#include "cnn_tiling.h"
+
+// Descriptor word 1 fields (see cnn_dma.v)
+#define DESC_COLS_BIT   16
+#define DESC_TYPE_BIT   32
+#define DESC_LAST_BIT   35
+#define DESC_STRIDE_BIT 36
+#define DESC_DIL_BIT    42
+
+// Largest power-of-two stride and dilation of the accelerator
+#define MAX_STRIDE      8
+#define MAX_DILATION    8
+
+static int log2_int(int value)
+{
+    int result = 0;
+    while ((1 << result) < value)
+    {
+        ++result;
+    }
+    return result;
+}
+
+static int is_power_of_two(int value)
+{
+    return (value > 0) && ((value & (value - 1)) == 0);
+}
+
+static int ceil_div(int a, int b)
+{
+    return (a + b - 1)/b;
+}
+
+// Input rows/columns needed for numOut outputs of a filter dimension
+static int input_span(int numOut, int filtSize, const cnn_tiling_config *cfg)
+{
+    return (numOut - 1)*cfg->stride + (filtSize - 1)*cfg->dilation + 1;
+}
+
+int cnn_tiling_plan(const cnn_tiling_config *cfg, int maxSize, cnn_tile_plan *plan)
+{
+    if (!is_power_of_two(cfg->stride) || (cfg->stride > MAX_STRIDE) ||
+        !is_power_of_two(cfg->dilation) || (cfg->dilation > MAX_DILATION) ||
+        (cfg->filtRows < 1) || (cfg->filtCols < 1) || (cfg->filtRows*cfg->filtCols > maxSize) ||
+        (input_span(1, cfg->filtRows, cfg) > cfg->dataRows) ||
+        (input_span(1, cfg->filtCols, cfg) > cfg->dataCols))
+    {
+        return -1;
+    }
+
+    int outRows = (cfg->dataRows - input_span(1, cfg->filtRows, cfg))/cfg->stride + 1;
+    int outCols = (cfg->dataCols - input_span(1, cfg->filtCols, cfg))/cfg->stride + 1;
+    int found = 0;
+    int bestTiles = 0;
+    size_t bestLoaded = 0;
+
+    // Try every tile width, the tallest tile that fits follows from it
+    for (int tileOutCols = 1; tileOutCols <= outCols; ++tileOutCols)
+    {
+        int inCols = input_span(tileOutCols, cfg->filtCols, cfg);
+        int maxInRows = maxSize/inCols;
+        if (maxInRows < input_span(1, cfg->filtRows, cfg))
+        {
+            break;
+        }
+        int tileOutRows = (maxInRows - input_span(1, cfg->filtRows, cfg))/cfg->stride + 1;
+        if (tileOutRows > outRows)
+        {
+            tileOutRows = outRows;
+        }
+
+        cnn_tile_plan candidate;
+        candidate.outRows     = outRows;
+        candidate.outCols     = outCols;
+        candidate.tileOutRows = tileOutRows;
+        candidate.tileOutCols = tileOutCols;
+        candidate.numTileRows = ceil_div(outRows, tileOutRows);
+        candidate.numTileCols = ceil_div(outCols, tileOutCols);
+
+        int numTiles = cnn_tiling_num_tiles(&candidate);
+        size_t loaded = cnn_tiling_loaded_elements(cfg, &candidate);
+        if (!found || (numTiles < bestTiles) || ((numTiles == bestTiles) && (loaded < bestLoaded)))
+        {
+            *plan       = candidate;
+            bestTiles   = numTiles;
+            bestLoaded  = loaded;
+            found       = 1;
+        }
+    }
+    return found ? 0 : -1;
+}
+
+int cnn_tiling_num_tiles(const cnn_tile_plan *plan)
+{
+    return plan->numTileRows*plan->numTileCols;
+}
+
+void cnn_tiling_get_tile(const cnn_tiling_config *cfg, const cnn_tile_plan *plan, int idx, cnn_tile *tile)
+{
+    int tileRow = idx/plan->numTileCols;
+    int tileCol = idx % plan->numTileCols;
+
+    // Last tile row and column hold the remaining outputs
+    tile->outRow  = tileRow*plan->tileOutRows;
+    tile->outCol  = tileCol*plan->tileOutCols;
+    tile->outRows = (tileRow == plan->numTileRows - 1) ? plan->outRows - tile->outRow : plan->tileOutRows;
+    tile->outCols = (tileCol == plan->numTileCols - 1) ? plan->outCols - tile->outCol : plan->tileOutCols;
+
+    // Input window including the halo
+    tile->inRow   = tile->outRow*cfg->stride;
+    tile->inCol   = tile->outCol*cfg->stride;
+    tile->inRows  = input_span(tile->outRows, cfg->filtRows, cfg);
+    tile->inCols  = input_span(tile->outCols, cfg->filtCols, cfg);
+}
+
+size_t cnn_tiling_loaded_elements(const cnn_tiling_config *cfg, const cnn_tile_plan *plan)
+{
+    size_t loaded = 0;
+    cnn_tile tile;
+    for (int idx = 0; idx < cnn_tiling_num_tiles(plan); ++idx)
+    {
+        cnn_tiling_get_tile(cfg, plan, idx, &tile);
+        loaded += (size_t) tile.inRows*tile.inCols;
+    }
+    return loaded;
+}
+
+static void write_desc(uint64_t *desc, uint32_t addr, uint32_t stride, int rows, int cols, int type,
+    int last, const cnn_tiling_config *cfg)
+{
+    desc[0] = ((uint64_t) stride << 32) | addr;
+    desc[1] = (uint64_t) rows | ((uint64_t) cols << DESC_COLS_BIT) | ((uint64_t) type << DESC_TYPE_BIT) |
+              ((uint64_t) last << DESC_LAST_BIT);
+    if (type == CNN_DESC_RUN)
+    {
+        desc[1] |= ((uint64_t) log2_int(cfg->stride) << DESC_STRIDE_BIT) |
+                   ((uint64_t) log2_int(cfg->dilation) << DESC_DIL_BIT);
+    }
+}
+
+size_t cnn_tiling_build_descriptors(const cnn_tiling_config *cfg, const cnn_tile_plan *plan,
+    uint32_t dataAddr, uint32_t dataStride, uint32_t filtAddr, uint32_t outAddr, uint32_t outStride,
+    uint64_t *desc, size_t maxDesc)
+{
+    int numTiles = cnn_tiling_num_tiles(plan);
+    size_t numDesc = (size_t) numTiles*CNN_TILING_DESC_PER_TILE;
+    if (numDesc > maxDesc)
+    {
+        return 0;
+    }
+
+    // Both operands are reloaded for every job (ping-pong banks)
+    cnn_tile tile;
+    for (int idx = 0; idx < numTiles; ++idx)
+    {
+        uint64_t *tileDesc = &desc[(size_t) idx*CNN_TILING_DESC_PER_TILE*CNN_DESC_WORDS];
+        cnn_tiling_get_tile(cfg, plan, idx, &tile);
+        write_desc(&tileDesc[0], dataAddr + tile.inRow*dataStride + 4*tile.inCol, dataStride,
+            tile.inRows, tile.inCols, CNN_DESC_DATA, 0, cfg);
+        write_desc(&tileDesc[CNN_DESC_WORDS], filtAddr, 4*cfg->filtCols,
+            cfg->filtRows, cfg->filtCols, CNN_DESC_FILT, 0, cfg);
+        write_desc(&tileDesc[2*CNN_DESC_WORDS], outAddr + tile.outRow*outStride + 4*tile.outCol, outStride,
+            tile.outRows, tile.outCols, CNN_DESC_RUN, idx == numTiles - 1, cfg);
+    }
+    return numDesc;
+}
+
+void cnn_tiling_pad(uint32_t *dst, const uint32_t *src, int rows, int cols, int pad)
+{
+    int padCols = cols + 2*pad;
+    memset(dst, 0, sizeof(uint32_t)*(size_t) (rows + 2*pad)*padCols);
+    for (int row = 0; row < rows; ++row)
+    {
+        memcpy(&dst[(size_t) (row + pad)*padCols + pad], &src[(size_t) row*cols], sizeof(uint32_t)*cols);
+    }
+}
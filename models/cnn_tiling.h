@@ -0,0 +1,101 @@
+#ifndef CNN_TILING_H
+#define CNN_TILING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Halo-aware tiling of large convolutions for src/cnn_dma.v
+//
+// An image too large for the data RAM (MAX_SIZE elements) is split into
+// tiles of output pixels. Each tile loads the input window its outputs
+// need, including the (filtRows-1)*dilation x (filtCols-1)*dilation halo
+// shared with its neighbours, so tiles overlap on the input side and
+// partition the output exactly once. The descriptor list stores every tile
+// straight into its place in the full output matrix, so the results are
+// stitched by the DMA row stride.
+//
+// Tiles are run with padIn = 0. Zero padding is applied to the image in
+// memory first (see cnn_tiling_pad).
+//
+// Build (host): gcc -O2 -c cnn_tiling.c
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Descriptor types and fields of cnn_dma.v
+#define CNN_DESC_DATA           0
+#define CNN_DESC_FILT           1
+#define CNN_DESC_RUN            2
+#define CNN_DESC_WORDS          2
+
+// Descriptors per tile (data load, filter load, run)
+#define CNN_TILING_DESC_PER_TILE 3
+
+// Geometry of a whole convolution (image already padded)
+// Stride and dilation are powers of two supported by the accelerator
+typedef struct
+{
+    int dataRows;
+    int dataCols;
+    int filtRows;
+    int filtCols;
+    int stride;
+    int dilation;
+} cnn_tiling_config;
+
+// Tile grid chosen for a convolution
+// All tiles have tileOutRows x tileOutCols outputs except the last
+// tile row and column, which hold the remainder
+typedef struct
+{
+    int outRows;
+    int outCols;
+    int tileOutRows;
+    int tileOutCols;
+    int numTileRows;
+    int numTileCols;
+} cnn_tile_plan;
+
+// One tile: input window and the outputs it produces
+typedef struct
+{
+    int inRow;
+    int inCol;
+    int inRows;
+    int inCols;
+    int outRow;
+    int outCol;
+    int outRows;
+    int outCols;
+} cnn_tile;
+
+// Choose the tile grid with the fewest tiles whose input windows fit in
+// maxSize elements, ties are broken by the fewest elements loaded
+// Returns 0 on success, -1 if the configuration cannot be tiled
+int cnn_tiling_plan(const cnn_tiling_config *cfg, int maxSize, cnn_tile_plan *plan);
+
+// Number of tiles in a plan and tile idx in row-major tile order
+int cnn_tiling_num_tiles(const cnn_tile_plan *plan);
+void cnn_tiling_get_tile(const cnn_tiling_config *cfg, const cnn_tile_plan *plan, int idx, cnn_tile *tile);
+
+// Input elements loaded by all tiles (image elements plus halo reloads)
+size_t cnn_tiling_loaded_elements(const cnn_tiling_config *cfg, const cnn_tile_plan *plan);
+
+// Write the descriptor list of a plan to desc (CNN_DESC_WORDS words per
+// descriptor, CNN_TILING_DESC_PER_TILE descriptors per tile)
+// Addresses are byte addresses, row strides are in bytes
+// Returns the number of descriptors written, 0 if maxDesc is too small
+size_t cnn_tiling_build_descriptors(const cnn_tiling_config *cfg, const cnn_tile_plan *plan,
+    uint32_t dataAddr, uint32_t dataStride, uint32_t filtAddr, uint32_t outAddr, uint32_t outStride,
+    uint64_t *desc, size_t maxDesc);
+
+// Copy a rows x cols image into the centre of a zero-filled
+// (rows + 2*pad) x (cols + 2*pad) image
+void cnn_tiling_pad(uint32_t *dst, const uint32_t *src, int rows, int cols, int pad);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
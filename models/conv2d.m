@@ -1,12 +1,38 @@
-function Y = conv2d(X,H)
+function Y = conv2d(X,H,stride,pad,dilation,pack)
+
+    % Optional convolution geometry, stride and dilation are powers of two
+    if nargin < 3
+        stride = 1;
+    end
+    if nargin < 4
+        pad = 0;
+    end
+    if nargin < 5
+        dilation = 1;
+    end
+
+    % Packing fills each beat with consecutive window elements across
+    % filter rows, it is not applied to dilated jobs
+    if nargin < 6
+        pack = 0;
+    end
+    pack = pack && (dilation == 1);
 
     % Cast input matrix to single precision
     X = single(X);
     H = single(H);
 
+    % Zero padding on every side of the data matrix
+    X = [zeros(pad, size(X,2)+2*pad, 'single');
+         zeros(size(X,1), pad, 'single'), X, zeros(size(X,1), pad, 'single');
+         zeros(pad, size(X,2)+2*pad, 'single')];
+
     % Get the size of the output matrix
-    nRows = size(X,1) - size(H,1) + 1;
-    nCols = size(X,2) - size(H,2) + 1;
+    nRows = floor((size(X,1) - dilation*(size(H,1)-1) - 1)/stride) + 1;
+    nCols = floor((size(X,2) - dilation*(size(H,2)-1) - 1)/stride) + 1;
+
+    % A dilated beat holds 8/dilation filter columns
+    beatSize = 8/dilation;
 
     % Initialize the output matrix
     Y = zeros(nRows, nCols, 'single');
@@ -14,21 +40,31 @@ function Y = conv2d(X,H)
     % Compute each element of the output matrix
     for i = 1:numel(Y)
         % Determine Column and row index
-        rowIdx = mod(i-1, nRows) + 1;
-        colIdx = floor((i-1)/nRows) + 1;
+        rowIdx = (mod(i-1, nRows))*stride + 1;
+        colIdx = (floor((i-1)/nRows))*stride + 1;
 
         % Transpose because C indexing is reversed
-        xVec = X(rowIdx:(rowIdx+size(H,1)-1), colIdx:(colIdx+size(H,2)-1)).';
+        xVec = X(rowIdx + dilation*(0:size(H,1)-1), colIdx + dilation*(0:size(H,2)-1)).';
         hVec = H.';
+        if pack
+            xVec = xVec(:);
+            hVec = hVec(:);
+        end
 
-        % Add zeros to fill vector units
-        if mod(size(xVec,1),8) ~= 0
-            padSize = 8 - mod(size(xVec,1),8);
+        % Add zeros to fill each beat
+        if mod(size(xVec,1),beatSize) ~= 0
+            padSize = beatSize - mod(size(xVec,1),beatSize);
             xVec = [xVec; zeros(padSize, size(xVec,2), 'single')];
             hVec = [hVec; zeros(padSize, size(hVec,2), 'single')];
         end
 
+        % Spread beats over the vector units
+        xVec = reshape(xVec, beatSize, []);
+        hVec = reshape(hVec, beatSize, []);
+        xVec = [xVec; zeros(8-beatSize, size(xVec,2), 'single')];
+        hVec = [hVec; zeros(8-beatSize, size(hVec,2), 'single')];
+
         % Perform multiply and accumulate operation
         Y(i) = multiply_and_accumulate(xVec(:),hVec(:));
     end
-end
\ No newline at end of file
+end
@@ -2,7 +2,21 @@ N = 32;
 rng(0);
 X = randn(N, N, 'single');
 H = randn(1, N, 'Single');
-Y = conv2d(X,H);
+
+% Must match STRIDE_LOG2, PAD and DILATION_LOG2 of the testbench
+stride = 1;
+pad = 0;
+dilation = 1;
+pack = 0;
+Y = conv2d(X,H,stride,pad,dilation,pack);
+
+% Must match BIAS_EN/BIAS, ACT, SLOPE, POOL_SIZE and POOL_AVG
+bias = [];
+act = 'none';
+slope = 0.125;
+poolSize = 1;
+poolAvg = 0;
+Y = post_process(Y,bias,act,slope,poolSize,poolAvg);
 
 fid = fopen('data.txt', 'w');
 fprintf(fid, '%08X\n', size(X,2));
@@ -0,0 +1,991 @@
+#include <string.h>
+#include "floating_point.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define FLOATING_POINT_X86
+#endif
+
+// Floating-point bit mapping
+#define NUM_BITS 32
+#define EXP_BITS 8
+#define MANTISSA_BITS 23
+
+// Location of sign bit and exponent field
+#define SIGN_BIT (NUM_BITS - 1)
+#define EXP_BIT  (SIGN_BIT - EXP_BITS)
+
+// Masks to extract exponent and mantissa fields
+#define EXP_MASK      ((1u << EXP_BITS) - 1)
+#define MANTISSA_MASK ((1u << MANTISSA_BITS) - 1)
+
+// Maximum exponent field
+#define MAX_EXP EXP_MASK
+
+// Floating point Bias
+#define BIAS ((1 << (EXP_BITS - 1)) - 1)
+
+// NaN and Inf bit-mapping (matches NAN/INF in floating_point_add.v)
+#define NAN_BITS ((MAX_EXP << EXP_BIT) | (1u << (MANTISSA_BITS - 1)))
+#define INF_BITS (MAX_EXP << EXP_BIT)
+
+// Adder: padded mantissa, +1 bit for sign, +1 bit for rounding
+#define PAD_WIDTH   (MANTISSA_BITS + 2)
+#define SUM_WIDTH   (2 * PAD_WIDTH)
+
+// Multiplier: mantissa product width and maximum right shift
+#define FRAC_BITS   (MANTISSA_BITS + 1)
+#define PROD_WIDTH  (2 * FRAC_BITS)
+#define MAX_R_SHIFT (FRAC_BITS + 1)
+
+uint32_t floating_point_add_bits(uint32_t a, uint32_t b)
+{
+    // Extract the sign, exponent, and mantissa fields
+    uint32_t aSign = a >> SIGN_BIT;
+    uint32_t bSign = b >> SIGN_BIT;
+    uint32_t aExp = (a >> EXP_BIT) & EXP_MASK;
+    uint32_t bExp = (b >> EXP_BIT) & EXP_MASK;
+    uint32_t aMantissa = a & MANTISSA_MASK;
+    uint32_t bMantissa = b & MANTISSA_MASK;
+
+    // Inf/NaN checks
+    uint32_t aInf = (aExp == MAX_EXP) && (aMantissa == 0);
+    uint32_t bInf = (bExp == MAX_EXP) && (bMantissa == 0);
+    uint32_t aNaN = (aExp == MAX_EXP) && (aMantissa != 0);
+    uint32_t bNaN = (bExp == MAX_EXP) && (bMantissa != 0);
+
+    // Determine implicit bits in mantissa
+    // subnormal => 2^(-126) * (0.fraction)
+    // normal    => 2^(exp - 127) * (1.fraction)
+    int64_t aOperand = (aExp == 0) ? (aMantissa << 1) : (aMantissa | (1u << MANTISSA_BITS));
+    int64_t bOperand = (bExp == 0) ? (bMantissa << 1) : (bMantissa | (1u << MANTISSA_BITS));
+
+    // Determine the minimum and maximum exponent
+    uint32_t maxSel = bExp > aExp;
+    uint32_t maxExp = maxSel ? bExp : aExp;
+    uint32_t minExp = maxSel ? aExp : bExp;
+
+    // Handle Inf and NaN
+    uint32_t sumInf = aInf | bInf;
+    uint32_t sumInfSign = aInf ? aSign : bSign;
+    uint32_t sumNaN = aNaN | bNaN | (aInf & bInf & (aSign ^ bSign));
+
+    // Create 2's complement numbers
+    if (aSign)
+    {
+        aOperand = -aOperand;
+    }
+    if (bSign)
+    {
+        bOperand = -bOperand;
+    }
+
+    // Limit the operand shift
+    uint32_t expShift = maxExp - minExp;
+    if (expShift > PAD_WIDTH)
+    {
+        expShift = PAD_WIDTH;
+    }
+
+    // Align and sum both operands
+    int64_t maxOperand = maxSel ? bOperand : aOperand;
+    int64_t minOperand = maxSel ? aOperand : bOperand;
+    int64_t sumOperand = maxOperand * ((int64_t) 1 << PAD_WIDTH)
+        + minOperand * ((int64_t) 1 << (PAD_WIDTH - expShift));
+
+    // Determine the absolute value and sign of the result
+    uint32_t sumSign = sumOperand < 0;
+    uint64_t sumMagnitude = (uint64_t) (sumSign ? -sumOperand : sumOperand);
+    if (sumInf)
+    {
+        sumSign = sumInfSign;
+    }
+
+    // Limit shift of result (8-bit register in hardware)
+    uint32_t maxShift = (maxExp + 1) & EXP_MASK;
+
+    // Determine how far to shift the sum to the left
+    // Want first significant bit in MSB of output
+    uint32_t sumZero = (sumMagnitude == 0);
+    uint32_t sumShift = 0;
+    if (!sumZero)
+    {
+        int maxBit = 63 - __builtin_clzll(sumMagnitude);
+        sumShift = (SUM_WIDTH - 1) - (uint32_t) maxBit;
+    }
+    if (sumShift > maxShift)
+    {
+        sumShift = maxShift;
+    }
+
+    // Determine resulting exponent
+    uint32_t sumExp = sumZero ? 0 : ((maxShift - sumShift) & EXP_MASK);
+
+    // Shift result so significant bits are in MSB
+    sumMagnitude = sumMagnitude << sumShift;
+
+    // Select significant bits and determine round from convergent round
+    uint32_t sumMantissa = (uint32_t) (sumMagnitude >> (PAD_WIDTH + 1));
+    uint32_t roundBit = 0;
+    if ((sumMagnitude >> PAD_WIDTH) & 1)
+    {
+        if ((sumMagnitude & ((1ull << PAD_WIDTH) - 1)) || ((sumMagnitude >> (PAD_WIDTH + 1)) & 1))
+        {
+            roundBit = 1;
+        }
+    }
+
+    // Round result and handle overflow in round
+    sumMantissa = sumMantissa + roundBit;
+    if ((sumMantissa >> (PAD_WIDTH - 1)) & 1)
+    {
+        sumExp = (sumExp + 1) & EXP_MASK;
+        sumMantissa = sumMantissa >> 1;
+    }
+
+    // Handle special cases and pack result
+    if (sumNaN)
+    {
+        return NAN_BITS;
+    }
+    else if (sumInf || (sumExp == MAX_EXP))
+    {
+        return (sumSign << SIGN_BIT) | INF_BITS;
+    }
+    return (sumSign << SIGN_BIT) | (sumExp << EXP_BIT) | (sumMantissa & MANTISSA_MASK);
+}
+
+uint32_t floating_point_multiply_bits(uint32_t a, uint32_t b)
+{
+    // Extract the sign, exponent, and mantissa fields
+    uint32_t aSign = a >> SIGN_BIT;
+    uint32_t bSign = b >> SIGN_BIT;
+    uint32_t aExp = (a >> EXP_BIT) & EXP_MASK;
+    uint32_t bExp = (b >> EXP_BIT) & EXP_MASK;
+    uint32_t aMantissa = a & MANTISSA_MASK;
+    uint32_t bMantissa = b & MANTISSA_MASK;
+
+    // Inf/NaN/zero checks
+    uint32_t aInf = (aExp == MAX_EXP) && (aMantissa == 0);
+    uint32_t bInf = (bExp == MAX_EXP) && (bMantissa == 0);
+    uint32_t aNaN = (aExp == MAX_EXP) && (aMantissa != 0);
+    uint32_t bNaN = (bExp == MAX_EXP) && (bMantissa != 0);
+    uint32_t aZero = (aExp == 0) && (aMantissa == 0);
+    uint32_t bZero = (bExp == 0) && (bMantissa == 0);
+
+    // Determine sign of product
+    uint32_t prodSign = aSign ^ bSign;
+
+    // Determine if product is infinity or NaN
+    // Note that NaN takes precedence over infinity when determining result
+    uint32_t prodInf = aInf | bInf;
+    uint32_t prodNaN = aNaN | bNaN | (aInf & bZero) | (bInf & aZero);
+
+    // Determine implicit bits in mantissa
+    uint64_t aOperand = (aExp == 0) ? (aMantissa << 1) : (aMantissa | (1u << MANTISSA_BITS));
+    uint64_t bOperand = (bExp == 0) ? (bMantissa << 1) : (bMantissa | (1u << MANTISSA_BITS));
+
+    // Compute exponent
+    // Ensure exponents are zero when either of the inputs is zero
+    int32_t prodExp = (int32_t) (aExp + bExp) - (BIAS - 1);
+    if (aZero || bZero)
+    {
+        prodExp = 0;
+    }
+
+    // Multiply mantissas
+    uint64_t prod = aOperand * bOperand;
+
+    // Determine highest active bit of product and place it in the MSB
+    uint32_t prodShift = 0;
+    if (prod != 0)
+    {
+        prodShift = (PROD_WIDTH - 1) - (uint32_t) (63 - __builtin_clzll(prod));
+    }
+    prod = prod << prodShift;
+    prodExp = prodExp - (int32_t) prodShift;
+
+    // Determine shift required to make exponent positive
+    // Maximum shift of output ensures that no significant bits result from round
+    uint32_t roundShift = 0;
+    if (prodExp <= 0)
+    {
+        roundShift = (prodExp < -FRAC_BITS) ? MAX_R_SHIFT : (uint32_t) (-prodExp + 1);
+        prodExp = 0;
+    }
+
+    // Clamp exponent
+    if (prodExp > (int32_t) MAX_EXP)
+    {
+        prodExp = MAX_EXP;
+    }
+
+    // Extract mantissa and truncated bits
+    uint32_t prodMantissa = (uint32_t) (prod >> (FRAC_BITS + roundShift));
+    uint32_t roundPos = MANTISSA_BITS + roundShift;
+    uint32_t roundBit = 0;
+    if ((prod >> roundPos) & 1)
+    {
+        if ((prodMantissa & 1) || (prod & ((1ull << roundPos) - 1)))
+        {
+            roundBit = 1;
+        }
+    }
+
+    // Determine if mantissa is at its maximum value
+    uint32_t maxMantissa = 0;
+    if ((prodMantissa & MANTISSA_MASK) == MANTISSA_MASK)
+    {
+        maxMantissa = (roundShift == 0) ? ((prodMantissa >> MANTISSA_BITS) & 1) : 1;
+    }
+
+    // Determine if product is infinity
+    uint32_t prodSoftInf = (prodExp == MAX_EXP - 1);
+    if (prodExp == MAX_EXP)
+    {
+        prodInf = 1;
+    }
+
+    // Increment mantissa when rounding up
+    // Increment exponent when mantissa wraps
+    prodMantissa = (prodMantissa + roundBit) & MANTISSA_MASK;
+    if (maxMantissa && roundBit)
+    {
+        prodExp = (prodExp + 1) & EXP_MASK;
+        if (prodSoftInf)
+        {
+            prodInf = 1;
+        }
+    }
+
+    // Handle special cases and pack result
+    if (prodNaN)
+    {
+        return (prodSign << SIGN_BIT) | NAN_BITS;
+    }
+    else if (prodInf)
+    {
+        return (prodSign << SIGN_BIT) | INF_BITS;
+    }
+    return (prodSign << SIGN_BIT) | ((uint32_t) prodExp << EXP_BIT) | prodMantissa;
+}
+
+// 16-bit operand types: mantissa and exponent field widths
+#define BF16_MANTISSA_BITS 7
+#define BF16_EXP_BITS      8
+#define FP16_MANTISSA_BITS 10
+#define FP16_EXP_BITS      5
+
+// Widen a 16-bit type to single precision (floating_point_convert.v)
+static uint32_t widen_bits(uint16_t a, int mantissaBits, int expBits)
+{
+    uint32_t sign = (a >> (mantissaBits + expBits)) & 1;
+    uint32_t exp = (a >> mantissaBits) & ((1u << expBits) - 1);
+    uint32_t mantissa = a & ((1u << mantissaBits) - 1);
+    uint32_t maxExp = (1u << expBits) - 1;
+    int bias = (1 << (expBits - 1)) - 1;
+    int shift = MANTISSA_BITS - mantissaBits;
+
+    if (exp == maxExp)
+    {
+        // Infinity and NaN, payload kept
+        exp = MAX_EXP;
+    }
+    else if ((exp == 0) && (mantissa != 0) && (expBits != EXP_BITS))
+    {
+        // Subnormals become normal in the wider exponent range
+        exp = BIAS - bias + 1;
+        while (!(mantissa >> (mantissaBits - 1)))
+        {
+            mantissa <<= 1;
+            --exp;
+        }
+        mantissa = (mantissa << 1) & ((1u << mantissaBits) - 1);
+        --exp;
+    }
+    else if (exp != 0)
+    {
+        exp = exp + BIAS - bias;
+    }
+    return (sign << SIGN_BIT) | (exp << EXP_BIT) | (mantissa << shift);
+}
+
+// Round single precision to a 16-bit type, nearest even
+static uint16_t narrow_bits(uint32_t a, int mantissaBits, int expBits)
+{
+    uint32_t sign = (a >> SIGN_BIT) << (mantissaBits + expBits);
+    uint32_t exp = (a >> EXP_BIT) & EXP_MASK;
+    uint32_t mantissa = a & MANTISSA_MASK;
+    uint32_t maxExp = (1u << expBits) - 1;
+    int bias = (1 << (expBits - 1)) - 1;
+
+    if (exp == MAX_EXP)
+    {
+        // Infinity, or quiet NaN keeping the upper payload bits
+        uint32_t payload = mantissa ? (mantissa >> (MANTISSA_BITS - mantissaBits)) | (1u << (mantissaBits - 1)) : 0;
+        return (uint16_t) (sign | (maxExp << mantissaBits) | payload);
+    }
+
+    // Value is sig * 2^scale
+    uint64_t sig = (exp == 0) ? mantissa : (mantissa | (1u << MANTISSA_BITS));
+    int scale = ((exp == 0) ? 1 : (int) exp) - BIAS - MANTISSA_BITS;
+    if (sig == 0)
+    {
+        return (uint16_t) sign;
+    }
+
+    // Exponent of the result, clamped to the subnormal range
+    int msb = 63 - __builtin_clzll(sig);
+    int resExp = msb + scale;
+    if (resExp < 1 - bias)
+    {
+        resExp = 1 - bias;
+    }
+
+    // Drop the bits below the result quantum, round to nearest even
+    int drop = (resExp - mantissaBits) - scale;
+    uint64_t rounded;
+    if (drop <= 0)
+    {
+        rounded = sig << -drop;
+    }
+    else if (drop > 40)
+    {
+        rounded = 0;
+    }
+    else
+    {
+        uint64_t half = 1ull << (drop - 1);
+        uint64_t rest = sig & ((1ull << drop) - 1);
+        rounded = sig >> drop;
+        if ((rest > half) || ((rest == half) && (rounded & 1)))
+        {
+            ++rounded;
+        }
+    }
+
+    // The hidden bit carries into the exponent field
+    uint64_t bits = ((uint64_t) (resExp + bias - 1) << mantissaBits) + rounded;
+    if ((bits >> mantissaBits) >= maxExp)
+    {
+        bits = (uint64_t) maxExp << mantissaBits;
+    }
+    return (uint16_t) (sign | bits);
+}
+
+uint32_t floating_point_bf16_to_fp32_bits(uint16_t a)
+{
+    return widen_bits(a, BF16_MANTISSA_BITS, BF16_EXP_BITS);
+}
+
+uint32_t floating_point_fp16_to_fp32_bits(uint16_t a)
+{
+    return widen_bits(a, FP16_MANTISSA_BITS, FP16_EXP_BITS);
+}
+
+uint16_t floating_point_fp32_to_bf16_bits(uint32_t a)
+{
+    return narrow_bits(a, BF16_MANTISSA_BITS, BF16_EXP_BITS);
+}
+
+uint16_t floating_point_fp32_to_fp16_bits(uint32_t a)
+{
+    return narrow_bits(a, FP16_MANTISSA_BITS, FP16_EXP_BITS);
+}
+
+uint32_t floating_point_multiply_bf16_bits(uint16_t a, uint16_t b)
+{
+    return floating_point_multiply_bits(floating_point_bf16_to_fp32_bits(a), floating_point_bf16_to_fp32_bits(b));
+}
+
+uint32_t floating_point_multiply_fp16_bits(uint16_t a, uint16_t b)
+{
+    return floating_point_multiply_bits(floating_point_fp16_to_fp32_bits(a), floating_point_fp16_to_fp32_bits(b));
+}
+
+float floating_point_add(float a, float b)
+{
+    uint32_t aUint32, bUint32, sumUint32;
+    float sum;
+    memcpy(&aUint32, &a, sizeof(float));
+    memcpy(&bUint32, &b, sizeof(float));
+    sumUint32 = floating_point_add_bits(aUint32, bUint32);
+    memcpy(&sum, &sumUint32, sizeof(float));
+    return sum;
+}
+
+float floating_point_multiply(float a, float b)
+{
+    uint32_t aUint32, bUint32, prodUint32;
+    float prod;
+    memcpy(&aUint32, &a, sizeof(float));
+    memcpy(&bUint32, &b, sizeof(float));
+    prodUint32 = floating_point_multiply_bits(aUint32, bUint32);
+    memcpy(&prod, &prodUint32, sizeof(float));
+    return prod;
+}
+
+static void add_array_scalar(float *sum, const float *a, const float *b, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        sum[i] = floating_point_add(a[i], b[i]);
+    }
+}
+
+static void multiply_array_scalar(float *prod, const float *a, const float *b, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        prod[i] = floating_point_multiply(a[i], b[i]);
+    }
+}
+
+#ifdef FLOATING_POINT_X86
+
+// The vector kernels evaluate every lane in 64-bit integer arithmetic using
+// the same steps as the scalar model. The position of the leading one of a
+// value below 2^52 is taken from the exponent of its exact conversion to
+// double (x | 0x4330000000000000) - 2^52, which only needs AVX2/AVX-512F.
+
+#define DOUBLE_MAGIC 0x4330000000000000ll
+
+__attribute__((target("avx2")))
+static inline __m256i msb_epi64_avx2(__m256i x)
+{
+    const __m256i magic = _mm256_set1_epi64x(DOUBLE_MAGIC);
+    __m256d d = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(x, magic)),
+        _mm256_castsi256_pd(magic));
+    __m256i e = _mm256_srli_epi64(_mm256_castpd_si256(d), 52);
+    return _mm256_sub_epi64(e, _mm256_set1_epi64x(1023));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i min_epi64_avx2(__m256i a, __m256i b)
+{
+    return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i select_epi64_avx2(__m256i mask, __m256i t, __m256i f)
+{
+    return _mm256_blendv_epi8(f, t, mask);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i load4_epi64_avx2(const float *p)
+{
+    return _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *) p));
+}
+
+__attribute__((target("avx2")))
+static inline void store4_epi64_avx2(float *p, __m256i x)
+{
+    const __m256i idx = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    _mm_storeu_si128((__m128i *) p, _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(x, idx)));
+}
+
+__attribute__((target("avx2")))
+static __m256i add_kernel_avx2(__m256i a, __m256i b)
+{
+    const __m256i zero     = _mm256_setzero_si256();
+    const __m256i one      = _mm256_set1_epi64x(1);
+    const __m256i expMask  = _mm256_set1_epi64x(EXP_MASK);
+    const __m256i manMask  = _mm256_set1_epi64x(MANTISSA_MASK);
+    const __m256i implicit = _mm256_set1_epi64x(1 << MANTISSA_BITS);
+    const __m256i maxExpV  = _mm256_set1_epi64x(MAX_EXP);
+
+    __m256i aSign = _mm256_srli_epi64(a, SIGN_BIT);
+    __m256i bSign = _mm256_srli_epi64(b, SIGN_BIT);
+    __m256i aExp  = _mm256_and_si256(_mm256_srli_epi64(a, EXP_BIT), expMask);
+    __m256i bExp  = _mm256_and_si256(_mm256_srli_epi64(b, EXP_BIT), expMask);
+    __m256i aMan  = _mm256_and_si256(a, manMask);
+    __m256i bMan  = _mm256_and_si256(b, manMask);
+
+    // Inf/NaN checks
+    __m256i aMaxExp = _mm256_cmpeq_epi64(aExp, maxExpV);
+    __m256i bMaxExp = _mm256_cmpeq_epi64(bExp, maxExpV);
+    __m256i aManZero = _mm256_cmpeq_epi64(aMan, zero);
+    __m256i bManZero = _mm256_cmpeq_epi64(bMan, zero);
+    __m256i aInf = _mm256_and_si256(aMaxExp, aManZero);
+    __m256i bInf = _mm256_and_si256(bMaxExp, bManZero);
+    __m256i aNaN = _mm256_andnot_si256(aManZero, aMaxExp);
+    __m256i bNaN = _mm256_andnot_si256(bManZero, bMaxExp);
+    __m256i signDiff = _mm256_cmpeq_epi64(_mm256_xor_si256(aSign, bSign), one);
+    __m256i sumNaN = _mm256_or_si256(_mm256_or_si256(aNaN, bNaN),
+        _mm256_and_si256(_mm256_and_si256(aInf, bInf), signDiff));
+    __m256i sumInf = _mm256_or_si256(aInf, bInf);
+    __m256i infSign = select_epi64_avx2(aInf, aSign, bSign);
+
+    // Implicit bits and subnormal handling
+    __m256i aOp = select_epi64_avx2(_mm256_cmpeq_epi64(aExp, zero),
+        _mm256_slli_epi64(aMan, 1), _mm256_or_si256(aMan, implicit));
+    __m256i bOp = select_epi64_avx2(_mm256_cmpeq_epi64(bExp, zero),
+        _mm256_slli_epi64(bMan, 1), _mm256_or_si256(bMan, implicit));
+
+    // 2's complement operands
+    aOp = select_epi64_avx2(_mm256_cmpeq_epi64(aSign, one), _mm256_sub_epi64(zero, aOp), aOp);
+    bOp = select_epi64_avx2(_mm256_cmpeq_epi64(bSign, one), _mm256_sub_epi64(zero, bOp), bOp);
+
+    // Minimum and maximum exponent
+    __m256i maxSel = _mm256_cmpgt_epi64(bExp, aExp);
+    __m256i maxExp = select_epi64_avx2(maxSel, bExp, aExp);
+    __m256i minExp = select_epi64_avx2(maxSel, aExp, bExp);
+    __m256i maxOp  = select_epi64_avx2(maxSel, bOp, aOp);
+    __m256i minOp  = select_epi64_avx2(maxSel, aOp, bOp);
+
+    // Align and sum
+    __m256i expShift = min_epi64_avx2(_mm256_sub_epi64(maxExp, minExp), _mm256_set1_epi64x(PAD_WIDTH));
+    __m256i sum = _mm256_add_epi64(_mm256_slli_epi64(maxOp, PAD_WIDTH),
+        _mm256_sllv_epi64(minOp, _mm256_sub_epi64(_mm256_set1_epi64x(PAD_WIDTH), expShift)));
+
+    // Absolute value and sign
+    __m256i neg = _mm256_cmpgt_epi64(zero, sum);
+    __m256i mag = select_epi64_avx2(neg, _mm256_sub_epi64(zero, sum), sum);
+    __m256i sumSign = select_epi64_avx2(sumInf, infSign, _mm256_and_si256(neg, one));
+
+    // Normalization shift limited by exponent
+    __m256i maxShift = _mm256_and_si256(_mm256_add_epi64(maxExp, one), expMask);
+    __m256i sumZero = _mm256_cmpeq_epi64(mag, zero);
+    __m256i sumShift = _mm256_sub_epi64(_mm256_set1_epi64x(SUM_WIDTH - 1), msb_epi64_avx2(mag));
+    sumShift = _mm256_andnot_si256(sumZero, sumShift);
+    sumShift = min_epi64_avx2(sumShift, maxShift);
+    __m256i sumExp = _mm256_andnot_si256(sumZero,
+        _mm256_and_si256(_mm256_sub_epi64(maxShift, sumShift), expMask));
+    mag = _mm256_sllv_epi64(mag, sumShift);
+
+    // Convergent round
+    __m256i sumMan = _mm256_srli_epi64(mag, PAD_WIDTH + 1);
+    __m256i half   = _mm256_and_si256(_mm256_srli_epi64(mag, PAD_WIDTH), one);
+    __m256i sticky = _mm256_and_si256(mag, _mm256_set1_epi64x((1ll << PAD_WIDTH) - 1));
+    __m256i odd    = _mm256_and_si256(sumMan, one);
+    __m256i roundUp = _mm256_andnot_si256(
+        _mm256_and_si256(_mm256_cmpeq_epi64(sticky, zero), _mm256_cmpeq_epi64(odd, zero)),
+        _mm256_cmpeq_epi64(half, one));
+    sumMan = _mm256_sub_epi64(sumMan, roundUp);
+
+    // Overflow in round
+    __m256i carry = _mm256_cmpeq_epi64(_mm256_srli_epi64(sumMan, PAD_WIDTH - 1), one);
+    sumExp = select_epi64_avx2(carry, _mm256_and_si256(_mm256_add_epi64(sumExp, one), expMask), sumExp);
+    sumMan = select_epi64_avx2(carry, _mm256_srli_epi64(sumMan, 1), sumMan);
+
+    // Pack result and handle special cases
+    __m256i signBits = _mm256_slli_epi64(sumSign, SIGN_BIT);
+    __m256i result = _mm256_or_si256(_mm256_or_si256(signBits, _mm256_slli_epi64(sumExp, EXP_BIT)),
+        _mm256_and_si256(sumMan, manMask));
+    __m256i isInf = _mm256_or_si256(sumInf, _mm256_cmpeq_epi64(sumExp, maxExpV));
+    result = select_epi64_avx2(isInf, _mm256_or_si256(signBits, _mm256_set1_epi64x(INF_BITS)), result);
+    result = select_epi64_avx2(sumNaN, _mm256_set1_epi64x(NAN_BITS), result);
+    return result;
+}
+
+__attribute__((target("avx2")))
+static __m256i multiply_kernel_avx2(__m256i a, __m256i b)
+{
+    const __m256i zero     = _mm256_setzero_si256();
+    const __m256i one      = _mm256_set1_epi64x(1);
+    const __m256i expMask  = _mm256_set1_epi64x(EXP_MASK);
+    const __m256i manMask  = _mm256_set1_epi64x(MANTISSA_MASK);
+    const __m256i implicit = _mm256_set1_epi64x(1 << MANTISSA_BITS);
+    const __m256i maxExpV  = _mm256_set1_epi64x(MAX_EXP);
+
+    __m256i aExp  = _mm256_and_si256(_mm256_srli_epi64(a, EXP_BIT), expMask);
+    __m256i bExp  = _mm256_and_si256(_mm256_srli_epi64(b, EXP_BIT), expMask);
+    __m256i aMan  = _mm256_and_si256(a, manMask);
+    __m256i bMan  = _mm256_and_si256(b, manMask);
+    __m256i prodSign = _mm256_srli_epi64(_mm256_xor_si256(a, b), SIGN_BIT);
+
+    // Inf/NaN/zero checks
+    __m256i aMaxExp = _mm256_cmpeq_epi64(aExp, maxExpV);
+    __m256i bMaxExp = _mm256_cmpeq_epi64(bExp, maxExpV);
+    __m256i aExpZero = _mm256_cmpeq_epi64(aExp, zero);
+    __m256i bExpZero = _mm256_cmpeq_epi64(bExp, zero);
+    __m256i aManZero = _mm256_cmpeq_epi64(aMan, zero);
+    __m256i bManZero = _mm256_cmpeq_epi64(bMan, zero);
+    __m256i aInf  = _mm256_and_si256(aMaxExp, aManZero);
+    __m256i bInf  = _mm256_and_si256(bMaxExp, bManZero);
+    __m256i aZero = _mm256_and_si256(aExpZero, aManZero);
+    __m256i bZero = _mm256_and_si256(bExpZero, bManZero);
+    __m256i prodInf = _mm256_or_si256(aInf, bInf);
+    __m256i prodNaN = _mm256_or_si256(
+        _mm256_or_si256(_mm256_andnot_si256(aManZero, aMaxExp), _mm256_andnot_si256(bManZero, bMaxExp)),
+        _mm256_or_si256(_mm256_and_si256(aInf, bZero), _mm256_and_si256(bInf, aZero)));
+
+    // Implicit bits and subnormal handling
+    __m256i aOp = select_epi64_avx2(aExpZero, _mm256_slli_epi64(aMan, 1), _mm256_or_si256(aMan, implicit));
+    __m256i bOp = select_epi64_avx2(bExpZero, _mm256_slli_epi64(bMan, 1), _mm256_or_si256(bMan, implicit));
+
+    // Exponent, forced to zero for zero operands
+    __m256i prodExp = _mm256_sub_epi64(_mm256_add_epi64(aExp, bExp), _mm256_set1_epi64x(BIAS - 1));
+    prodExp = _mm256_andnot_si256(_mm256_or_si256(aZero, bZero), prodExp);
+
+    // Multiply mantissas and normalize
+    __m256i prod = _mm256_mul_epu32(aOp, bOp);
+    __m256i prodZero = _mm256_cmpeq_epi64(prod, zero);
+    __m256i prodShift = _mm256_andnot_si256(prodZero,
+        _mm256_sub_epi64(_mm256_set1_epi64x(PROD_WIDTH - 1), msb_epi64_avx2(prod)));
+    prod = _mm256_sllv_epi64(prod, prodShift);
+    prodExp = _mm256_sub_epi64(prodExp, prodShift);
+
+    // Shift required to make exponent positive
+    __m256i subnormal = _mm256_cmpgt_epi64(one, prodExp);
+    __m256i roundShift = select_epi64_avx2(_mm256_cmpgt_epi64(_mm256_set1_epi64x(-FRAC_BITS), prodExp),
+        _mm256_set1_epi64x(MAX_R_SHIFT), _mm256_sub_epi64(one, prodExp));
+    roundShift = _mm256_and_si256(subnormal, roundShift);
+    prodExp = _mm256_andnot_si256(subnormal, prodExp);
+    prodExp = min_epi64_avx2(prodExp, maxExpV);
+
+    // Extract mantissa and convergent round
+    __m256i roundPos = _mm256_add_epi64(roundShift, _mm256_set1_epi64x(MANTISSA_BITS));
+    __m256i prodMan = _mm256_srlv_epi64(prod, _mm256_add_epi64(roundPos, one));
+    __m256i half    = _mm256_and_si256(_mm256_srlv_epi64(prod, roundPos), one);
+    __m256i sticky  = _mm256_and_si256(prod, _mm256_sub_epi64(_mm256_sllv_epi64(one, roundPos), one));
+    __m256i odd     = _mm256_and_si256(prodMan, one);
+    __m256i roundUp = _mm256_andnot_si256(
+        _mm256_and_si256(_mm256_cmpeq_epi64(sticky, zero), _mm256_cmpeq_epi64(odd, zero)),
+        _mm256_cmpeq_epi64(half, one));
+
+    // Mantissa wrap
+    __m256i manFull = _mm256_cmpeq_epi64(_mm256_and_si256(prodMan, manMask), manMask);
+    __m256i normTop = _mm256_or_si256(subnormal,
+        _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_srli_epi64(prodMan, MANTISSA_BITS), one), one));
+    __m256i wrap = _mm256_and_si256(_mm256_and_si256(manFull, normTop), roundUp);
+
+    // Infinity detection
+    __m256i softInf = _mm256_cmpeq_epi64(prodExp, _mm256_set1_epi64x(MAX_EXP - 1));
+    prodInf = _mm256_or_si256(prodInf, _mm256_cmpeq_epi64(prodExp, maxExpV));
+    prodInf = _mm256_or_si256(prodInf, _mm256_and_si256(wrap, softInf));
+
+    prodMan = _mm256_and_si256(_mm256_sub_epi64(prodMan, roundUp), manMask);
+    prodExp = select_epi64_avx2(wrap, _mm256_and_si256(_mm256_add_epi64(prodExp, one), expMask), prodExp);
+
+    // Pack result and handle special cases
+    __m256i signBits = _mm256_slli_epi64(prodSign, SIGN_BIT);
+    __m256i result = _mm256_or_si256(_mm256_or_si256(signBits, _mm256_slli_epi64(prodExp, EXP_BIT)), prodMan);
+    result = select_epi64_avx2(prodInf, _mm256_or_si256(signBits, _mm256_set1_epi64x(INF_BITS)), result);
+    result = select_epi64_avx2(prodNaN, _mm256_or_si256(signBits, _mm256_set1_epi64x(NAN_BITS)), result);
+    return result;
+}
+
+__attribute__((target("avx2")))
+static void add_array_avx2(float *sum, const float *a, const float *b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        store4_epi64_avx2(sum + i, add_kernel_avx2(load4_epi64_avx2(a + i), load4_epi64_avx2(b + i)));
+    }
+    add_array_scalar(sum + i, a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void multiply_array_avx2(float *prod, const float *a, const float *b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        store4_epi64_avx2(prod + i, multiply_kernel_avx2(load4_epi64_avx2(a + i), load4_epi64_avx2(b + i)));
+    }
+    multiply_array_scalar(prod + i, a + i, b + i, n - i);
+}
+
+#define AVX512_TARGET __attribute__((target("avx512f")))
+
+AVX512_TARGET
+static inline __m512i msb_epi64_avx512(__m512i x)
+{
+    const __m512i magic = _mm512_set1_epi64(DOUBLE_MAGIC);
+    __m512d d = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(x, magic)),
+        _mm512_castsi512_pd(magic));
+    __m512i e = _mm512_srli_epi64(_mm512_castpd_si512(d), 52);
+    return _mm512_sub_epi64(e, _mm512_set1_epi64(1023));
+}
+
+AVX512_TARGET
+static __m512i add_kernel_avx512(__m512i a, __m512i b)
+{
+    const __m512i zero     = _mm512_setzero_si512();
+    const __m512i one      = _mm512_set1_epi64(1);
+    const __m512i expMask  = _mm512_set1_epi64(EXP_MASK);
+    const __m512i manMask  = _mm512_set1_epi64(MANTISSA_MASK);
+    const __m512i implicit = _mm512_set1_epi64(1 << MANTISSA_BITS);
+    const __m512i maxExpV  = _mm512_set1_epi64(MAX_EXP);
+
+    __m512i aSign = _mm512_srli_epi64(a, SIGN_BIT);
+    __m512i bSign = _mm512_srli_epi64(b, SIGN_BIT);
+    __m512i aExp  = _mm512_and_si512(_mm512_srli_epi64(a, EXP_BIT), expMask);
+    __m512i bExp  = _mm512_and_si512(_mm512_srli_epi64(b, EXP_BIT), expMask);
+    __m512i aMan  = _mm512_and_si512(a, manMask);
+    __m512i bMan  = _mm512_and_si512(b, manMask);
+
+    // Inf/NaN checks
+    __mmask8 aMaxExp = _mm512_cmpeq_epi64_mask(aExp, maxExpV);
+    __mmask8 bMaxExp = _mm512_cmpeq_epi64_mask(bExp, maxExpV);
+    __mmask8 aManZero = _mm512_cmpeq_epi64_mask(aMan, zero);
+    __mmask8 bManZero = _mm512_cmpeq_epi64_mask(bMan, zero);
+    __mmask8 aInf = aMaxExp & aManZero;
+    __mmask8 bInf = bMaxExp & bManZero;
+    __mmask8 aNeg = _mm512_cmpeq_epi64_mask(aSign, one);
+    __mmask8 bNeg = _mm512_cmpeq_epi64_mask(bSign, one);
+    __mmask8 sumNaN = (aMaxExp & ~aManZero) | (bMaxExp & ~bManZero) | (aInf & bInf & (aNeg ^ bNeg));
+    __mmask8 sumInf = aInf | bInf;
+    __mmask8 infNeg = (aInf & aNeg) | (~aInf & bNeg);
+
+    // Implicit bits and subnormal handling
+    __m512i aOp = _mm512_mask_blend_epi64(_mm512_cmpeq_epi64_mask(aExp, zero),
+        _mm512_or_si512(aMan, implicit), _mm512_slli_epi64(aMan, 1));
+    __m512i bOp = _mm512_mask_blend_epi64(_mm512_cmpeq_epi64_mask(bExp, zero),
+        _mm512_or_si512(bMan, implicit), _mm512_slli_epi64(bMan, 1));
+
+    // 2's complement operands
+    aOp = _mm512_mask_sub_epi64(aOp, aNeg, zero, aOp);
+    bOp = _mm512_mask_sub_epi64(bOp, bNeg, zero, bOp);
+
+    // Minimum and maximum exponent
+    __mmask8 maxSel = _mm512_cmpgt_epi64_mask(bExp, aExp);
+    __m512i maxExp = _mm512_max_epi64(aExp, bExp);
+    __m512i minExp = _mm512_min_epi64(aExp, bExp);
+    __m512i maxOp  = _mm512_mask_blend_epi64(maxSel, aOp, bOp);
+    __m512i minOp  = _mm512_mask_blend_epi64(maxSel, bOp, aOp);
+
+    // Align and sum
+    __m512i expShift = _mm512_min_epi64(_mm512_sub_epi64(maxExp, minExp), _mm512_set1_epi64(PAD_WIDTH));
+    __m512i sum = _mm512_add_epi64(_mm512_slli_epi64(maxOp, PAD_WIDTH),
+        _mm512_sllv_epi64(minOp, _mm512_sub_epi64(_mm512_set1_epi64(PAD_WIDTH), expShift)));
+
+    // Absolute value and sign
+    __mmask8 neg = _mm512_cmplt_epi64_mask(sum, zero);
+    __m512i mag = _mm512_abs_epi64(sum);
+    __mmask8 sumNeg = (sumInf & infNeg) | (~sumInf & neg);
+
+    // Normalization shift limited by exponent
+    __m512i maxShift = _mm512_and_si512(_mm512_add_epi64(maxExp, one), expMask);
+    __mmask8 sumNonZero = _mm512_test_epi64_mask(mag, mag);
+    __m512i sumShift = _mm512_maskz_sub_epi64(sumNonZero, _mm512_set1_epi64(SUM_WIDTH - 1), msb_epi64_avx512(mag));
+    sumShift = _mm512_min_epi64(sumShift, maxShift);
+    __m512i sumExp = _mm512_maskz_and_epi64(sumNonZero, _mm512_sub_epi64(maxShift, sumShift), expMask);
+    mag = _mm512_sllv_epi64(mag, sumShift);
+
+    // Convergent round
+    __m512i sumMan = _mm512_srli_epi64(mag, PAD_WIDTH + 1);
+    __mmask8 half   = _mm512_test_epi64_mask(mag, _mm512_set1_epi64(1ll << PAD_WIDTH));
+    __mmask8 sticky = _mm512_test_epi64_mask(mag, _mm512_set1_epi64((1ll << PAD_WIDTH) - 1));
+    __mmask8 odd    = _mm512_test_epi64_mask(sumMan, one);
+    sumMan = _mm512_mask_add_epi64(sumMan, half & (sticky | odd), sumMan, one);
+
+    // Overflow in round
+    __mmask8 carry = _mm512_test_epi64_mask(sumMan, _mm512_set1_epi64(1ll << (PAD_WIDTH - 1)));
+    sumExp = _mm512_mask_and_epi64(sumExp, carry, _mm512_add_epi64(sumExp, one), expMask);
+    sumMan = _mm512_mask_srli_epi64(sumMan, carry, sumMan, 1);
+
+    // Pack result and handle special cases
+    __m512i signBits = _mm512_maskz_mov_epi64(sumNeg, _mm512_set1_epi64(1ll << SIGN_BIT));
+    __m512i result = _mm512_or_si512(_mm512_or_si512(signBits, _mm512_slli_epi64(sumExp, EXP_BIT)),
+        _mm512_and_si512(sumMan, manMask));
+    __mmask8 isInf = sumInf | _mm512_cmpeq_epi64_mask(sumExp, maxExpV);
+    result = _mm512_mask_or_epi64(result, isInf, signBits, _mm512_set1_epi64(INF_BITS));
+    result = _mm512_mask_mov_epi64(result, sumNaN, _mm512_set1_epi64(NAN_BITS));
+    return result;
+}
+
+AVX512_TARGET
+static __m512i multiply_kernel_avx512(__m512i a, __m512i b)
+{
+    const __m512i zero     = _mm512_setzero_si512();
+    const __m512i one      = _mm512_set1_epi64(1);
+    const __m512i expMask  = _mm512_set1_epi64(EXP_MASK);
+    const __m512i manMask  = _mm512_set1_epi64(MANTISSA_MASK);
+    const __m512i implicit = _mm512_set1_epi64(1 << MANTISSA_BITS);
+    const __m512i maxExpV  = _mm512_set1_epi64(MAX_EXP);
+
+    __m512i aExp  = _mm512_and_si512(_mm512_srli_epi64(a, EXP_BIT), expMask);
+    __m512i bExp  = _mm512_and_si512(_mm512_srli_epi64(b, EXP_BIT), expMask);
+    __m512i aMan  = _mm512_and_si512(a, manMask);
+    __m512i bMan  = _mm512_and_si512(b, manMask);
+    __m512i signBits = _mm512_slli_epi64(_mm512_srli_epi64(_mm512_xor_si512(a, b), SIGN_BIT), SIGN_BIT);
+
+    // Inf/NaN/zero checks
+    __mmask8 aMaxExp  = _mm512_cmpeq_epi64_mask(aExp, maxExpV);
+    __mmask8 bMaxExp  = _mm512_cmpeq_epi64_mask(bExp, maxExpV);
+    __mmask8 aExpZero = _mm512_cmpeq_epi64_mask(aExp, zero);
+    __mmask8 bExpZero = _mm512_cmpeq_epi64_mask(bExp, zero);
+    __mmask8 aManZero = _mm512_cmpeq_epi64_mask(aMan, zero);
+    __mmask8 bManZero = _mm512_cmpeq_epi64_mask(bMan, zero);
+    __mmask8 aInf  = aMaxExp & aManZero;
+    __mmask8 bInf  = bMaxExp & bManZero;
+    __mmask8 aZero = aExpZero & aManZero;
+    __mmask8 bZero = bExpZero & bManZero;
+    __mmask8 prodInf = aInf | bInf;
+    __mmask8 prodNaN = (aMaxExp & ~aManZero) | (bMaxExp & ~bManZero) | (aInf & bZero) | (bInf & aZero);
+
+    // Implicit bits and subnormal handling
+    __m512i aOp = _mm512_mask_blend_epi64(aExpZero, _mm512_or_si512(aMan, implicit), _mm512_slli_epi64(aMan, 1));
+    __m512i bOp = _mm512_mask_blend_epi64(bExpZero, _mm512_or_si512(bMan, implicit), _mm512_slli_epi64(bMan, 1));
+
+    // Exponent, forced to zero for zero operands
+    __m512i prodExp = _mm512_maskz_sub_epi64((__mmask8) ~(aZero | bZero),
+        _mm512_add_epi64(aExp, bExp), _mm512_set1_epi64(BIAS - 1));
+
+    // Multiply mantissas and normalize
+    __m512i prod = _mm512_mul_epu32(aOp, bOp);
+    __mmask8 prodNonZero = _mm512_test_epi64_mask(prod, prod);
+    __m512i prodShift = _mm512_maskz_sub_epi64(prodNonZero,
+        _mm512_set1_epi64(PROD_WIDTH - 1), msb_epi64_avx512(prod));
+    prod = _mm512_sllv_epi64(prod, prodShift);
+    prodExp = _mm512_sub_epi64(prodExp, prodShift);
+
+    // Shift required to make exponent positive
+    __mmask8 subnormal = _mm512_cmplt_epi64_mask(prodExp, one);
+    __m512i roundShift = _mm512_mask_blend_epi64(_mm512_cmplt_epi64_mask(prodExp, _mm512_set1_epi64(-FRAC_BITS)),
+        _mm512_sub_epi64(one, prodExp), _mm512_set1_epi64(MAX_R_SHIFT));
+    roundShift = _mm512_maskz_mov_epi64(subnormal, roundShift);
+    prodExp = _mm512_maskz_mov_epi64((__mmask8) ~subnormal, prodExp);
+    prodExp = _mm512_min_epi64(prodExp, maxExpV);
+
+    // Extract mantissa and convergent round
+    __m512i roundPos = _mm512_add_epi64(roundShift, _mm512_set1_epi64(MANTISSA_BITS));
+    __m512i prodMan = _mm512_srlv_epi64(prod, _mm512_add_epi64(roundPos, one));
+    __mmask8 half   = _mm512_test_epi64_mask(_mm512_srlv_epi64(prod, roundPos), one);
+    __mmask8 sticky = _mm512_test_epi64_mask(prod, _mm512_sub_epi64(_mm512_sllv_epi64(one, roundPos), one));
+    __mmask8 odd    = _mm512_test_epi64_mask(prodMan, one);
+    __mmask8 roundUp = half & (sticky | odd);
+
+    // Mantissa wrap
+    __mmask8 manFull = _mm512_cmpeq_epi64_mask(_mm512_and_si512(prodMan, manMask), manMask);
+    __mmask8 normTop = subnormal | _mm512_test_epi64_mask(prodMan, implicit);
+    __mmask8 wrap = manFull & normTop & roundUp;
+
+    // Infinity detection
+    __mmask8 softInf = _mm512_cmpeq_epi64_mask(prodExp, _mm512_set1_epi64(MAX_EXP - 1));
+    prodInf |= _mm512_cmpeq_epi64_mask(prodExp, maxExpV) | (wrap & softInf);
+
+    prodMan = _mm512_and_si512(_mm512_mask_add_epi64(prodMan, roundUp, prodMan, one), manMask);
+    prodExp = _mm512_mask_and_epi64(prodExp, wrap, _mm512_add_epi64(prodExp, one), expMask);
+
+    // Pack result and handle special cases
+    __m512i result = _mm512_or_si512(_mm512_or_si512(signBits, _mm512_slli_epi64(prodExp, EXP_BIT)), prodMan);
+    result = _mm512_mask_or_epi64(result, prodInf, signBits, _mm512_set1_epi64(INF_BITS));
+    result = _mm512_mask_or_epi64(result, prodNaN, signBits, _mm512_set1_epi64(NAN_BITS));
+    return result;
+}
+
+AVX512_TARGET
+static void add_array_avx512(float *sum, const float *a, const float *b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512i aV = _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *) (a + i)));
+        __m512i bV = _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *) (b + i)));
+        _mm256_storeu_si256((__m256i *) (sum + i), _mm512_cvtepi64_epi32(add_kernel_avx512(aV, bV)));
+    }
+    add_array_scalar(sum + i, a + i, b + i, n - i);
+}
+
+AVX512_TARGET
+static void multiply_array_avx512(float *prod, const float *a, const float *b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512i aV = _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *) (a + i)));
+        __m512i bV = _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *) (b + i)));
+        _mm256_storeu_si256((__m256i *) (prod + i), _mm512_cvtepi64_epi32(multiply_kernel_avx512(aV, bV)));
+    }
+    multiply_array_scalar(prod + i, a + i, b + i, n - i);
+}
+
+#endif
+
+int floating_point_impl_supported(floating_point_impl impl)
+{
+    switch (impl)
+    {
+        case FLOATING_POINT_SCALAR:
+            return 1;
+#ifdef FLOATING_POINT_X86
+        case FLOATING_POINT_AVX2:
+            return __builtin_cpu_supports("avx2");
+        case FLOATING_POINT_AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return 0;
+    }
+}
+
+floating_point_impl floating_point_best_impl(void)
+{
+    static int best = -1;
+    if (best < 0)
+    {
+        best = FLOATING_POINT_SCALAR;
+        for (int impl = FLOATING_POINT_SCALAR; impl < FLOATING_POINT_NUM_IMPLS; ++impl)
+        {
+            if (floating_point_impl_supported((floating_point_impl) impl))
+            {
+                best = impl;
+            }
+        }
+    }
+    return (floating_point_impl) best;
+}
+
+const char *floating_point_impl_name(floating_point_impl impl)
+{
+    switch (impl)
+    {
+        case FLOATING_POINT_SCALAR: return "scalar";
+        case FLOATING_POINT_AVX2:   return "avx2";
+        case FLOATING_POINT_AVX512: return "avx512";
+        default:                    return "unknown";
+    }
+}
+
+void floating_point_add_array_impl(floating_point_impl impl, float *sum,
+    const float *a, const float *b, size_t n)
+{
+    switch (impl)
+    {
+#ifdef FLOATING_POINT_X86
+        case FLOATING_POINT_AVX2:
+            add_array_avx2(sum, a, b, n);
+            break;
+        case FLOATING_POINT_AVX512:
+            add_array_avx512(sum, a, b, n);
+            break;
+#endif
+        default:
+            add_array_scalar(sum, a, b, n);
+            break;
+    }
+}
+
+void floating_point_multiply_array_impl(floating_point_impl impl, float *prod,
+    const float *a, const float *b, size_t n)
+{
+    switch (impl)
+    {
+#ifdef FLOATING_POINT_X86
+        case FLOATING_POINT_AVX2:
+            multiply_array_avx2(prod, a, b, n);
+            break;
+        case FLOATING_POINT_AVX512:
+            multiply_array_avx512(prod, a, b, n);
+            break;
+#endif
+        default:
+            multiply_array_scalar(prod, a, b, n);
+            break;
+    }
+}
+
+void floating_point_add_array(float *sum, const float *a, const float *b, size_t n)
+{
+    floating_point_add_array_impl(floating_point_best_impl(), sum, a, b, n);
+}
+
+void floating_point_multiply_array(float *prod, const float *a, const float *b, size_t n)
+{
+    floating_point_multiply_array_impl(floating_point_best_impl(), prod, a, b, n);
+}
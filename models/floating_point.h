@@ -0,0 +1,72 @@
+#ifndef FLOATING_POINT_H
+#define FLOATING_POINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bit-accurate models of src/floating_point_add.v and
+// src/floating_point_multiply.v (standard single precision).
+//
+// Results match the RTL bit-for-bit, including convergent rounding,
+// subnormal handling and the NaN encoding (0x7FC00000 for the adder,
+// sign | 0x7FC00000 for the multiplier).
+//
+// Build (host):  gcc -O2 -c floating_point.c
+// Build (MATLAB): mex floating_point_add.c floating_point.c
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Available kernels for the batched interface
+typedef enum
+{
+    FLOATING_POINT_SCALAR = 0,
+    FLOATING_POINT_AVX2,
+    FLOATING_POINT_AVX512,
+    FLOATING_POINT_NUM_IMPLS
+} floating_point_impl;
+
+// Scalar operations on the raw IEEE-754 bit patterns
+uint32_t floating_point_add_bits(uint32_t a, uint32_t b);
+uint32_t floating_point_multiply_bits(uint32_t a, uint32_t b);
+
+// 16-bit operands (bfloat16 and FP16) of a reduced-precision build
+// Widening to single precision matches src/floating_point_convert.v,
+// so a 16-bit product is the single precision product of the widened
+// operands (exact) and is accumulated in single precision
+uint32_t floating_point_bf16_to_fp32_bits(uint16_t a);
+uint32_t floating_point_fp16_to_fp32_bits(uint16_t a);
+uint32_t floating_point_multiply_bf16_bits(uint16_t a, uint16_t b);
+uint32_t floating_point_multiply_fp16_bits(uint16_t a, uint16_t b);
+
+// Round single precision to bfloat16/FP16 (nearest even, overflow to
+// infinity) when preparing 16-bit operands on the host
+uint16_t floating_point_fp32_to_bf16_bits(uint32_t a);
+uint16_t floating_point_fp32_to_fp16_bits(uint32_t a);
+
+// Scalar operations on floats
+float floating_point_add(float a, float b);
+float floating_point_multiply(float a, float b);
+
+// Batched operations using the fastest kernel supported by the host
+void floating_point_add_array(float *sum, const float *a, const float *b, size_t n);
+void floating_point_multiply_array(float *prod, const float *a, const float *b, size_t n);
+
+// Batched operations using an explicit kernel
+// The kernel must be supported by the host (see floating_point_impl_supported)
+void floating_point_add_array_impl(floating_point_impl impl, float *sum,
+    const float *a, const float *b, size_t n);
+void floating_point_multiply_array_impl(floating_point_impl impl, float *prod,
+    const float *a, const float *b, size_t n);
+
+// Kernel queries
+int floating_point_impl_supported(floating_point_impl impl);
+floating_point_impl floating_point_best_impl(void);
+const char *floating_point_impl_name(floating_point_impl impl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,83 @@
+#include <math.h>
+#include "integer_mac.h"
+
+// Requantized output range
+#define OUT_MAX 127
+#define OUT_MIN (-128)
+
+int32_t integer_mac_dot(const int8_t *a, const int8_t *b, size_t n, int32_t acc)
+{
+    // Unsigned arithmetic wraps like the accumulator register
+    uint32_t sum = (uint32_t) acc;
+    for (size_t i = 0; i < n; ++i)
+    {
+        sum += (uint32_t) ((int32_t) a[i] * (int32_t) b[i]);
+    }
+    return (int32_t) sum;
+}
+
+int32_t integer_requantize(int32_t acc, const integer_quant *quant)
+{
+    if (quant->mult == 0)
+    {
+        return acc;
+    }
+
+    // Full product, rounding half up, arithmetic shift. The shift keeps
+    // the 6 bits of quantShiftIn and the rounding add wraps in 64 bits,
+    // as the RTL does for INT32_MIN * INT32_MIN with a shift of 63
+    int shift = quant->shift & INTEGER_MAC_MAX_SHIFT;
+    uint64_t prod = (uint64_t) ((int64_t) acc * quant->mult);
+    uint64_t round = (shift == 0) ? 0 : ((uint64_t) 1 << (shift - 1));
+    int64_t sum = ((int64_t) (prod + round) >> shift) + quant->zero;
+    if (sum > OUT_MAX)
+    {
+        return OUT_MAX;
+    }
+    if (sum < OUT_MIN)
+    {
+        return OUT_MIN;
+    }
+    return (int32_t) sum;
+}
+
+int integer_quant_from_scale(double scale, int8_t zero, integer_quant *quant)
+{
+    if (!(scale > 0))
+    {
+        return -1;
+    }
+
+    // scale = fraction * 2^exp with fraction in [0.5, 1)
+    int exp;
+    double fraction = frexp(scale, &exp);
+    int64_t mult = llround(fraction * 2147483648.0);
+    if (mult == ((int64_t) 1 << 31))
+    {
+        mult >>= 1;
+        ++exp;
+    }
+    int shift = 31 - exp;
+    if ((shift < 0) || (shift > INTEGER_MAC_MAX_SHIFT))
+    {
+        return -1;
+    }
+    quant->mult = (int32_t) mult;
+    quant->shift = shift;
+    quant->zero = zero;
+    return 0;
+}
+
+int8_t integer_quantize(float value, float scale, int8_t zero)
+{
+    double q = round((double) value / scale) + zero;
+    if (q > OUT_MAX)
+    {
+        return OUT_MAX;
+    }
+    if (q < OUT_MIN)
+    {
+        return OUT_MIN;
+    }
+    return (int8_t) q;
+}
@@ -0,0 +1,58 @@
+#ifndef INTEGER_MAC_H
+#define INTEGER_MAC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bit-accurate models of the INT8 MAC engine of src/cnn_hw_accelerator.v
+// (MAC_STYLE = "INT8"): src/integer_multiply_and_accumulate.v and
+// src/integer_requantize.v.
+//
+// Products of signed 8-bit operands are summed into a 32-bit accumulator
+// that wraps on overflow, so the result does not depend on the summation
+// order. Requantization is per tensor:
+//
+//   out = clamp(((acc * mult) + 2^(shift-1)) >> shift + zero, -128, 127)
+//
+// with a 64-bit product, a rounding add that wraps in 64 bits and an
+// arithmetic shift by the low 6 bits of shift. mult = 0 returns the raw
+// accumulation.
+//
+// Build (host): gcc -O2 -c integer_mac.c
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largest requantization shift (6-bit quantShiftIn)
+#define INTEGER_MAC_MAX_SHIFT 63
+
+// Per-tensor requantization parameters
+typedef struct
+{
+    int32_t mult;
+    int shift;
+    int8_t zero;
+} integer_quant;
+
+// Dot product of two int8 vectors added to acc, wrapping in 32 bits
+int32_t integer_mac_dot(const int8_t *a, const int8_t *b, size_t n, int32_t acc);
+
+// Requantize one accumulation as the accelerator writes it to dataOut
+// (int8 results are sign-extended to 32 bits)
+int32_t integer_requantize(int32_t acc, const integer_quant *quant);
+
+// Fixed-point multiplier and shift closest to a positive real scale
+// (e.g. inputScale * filterScale / outputScale), mult in [2^30, 2^31)
+// Returns 0 on success, -1 if the scale is out of range
+int integer_quant_from_scale(double scale, int8_t zero, integer_quant *quant);
+
+// Quantize a real value to int8 with a per-tensor scale and zero point
+// (round to nearest, ties away from zero, saturating)
+int8_t integer_quantize(float value, float scale, int8_t zero);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
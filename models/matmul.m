@@ -0,0 +1,24 @@
+function Y = matmul(A,B)
+
+    % Cast input matrices to single precision
+    A = single(A);
+    B = single(B);
+
+    if size(A,2) ~= size(B,1)
+        error('Inner dimensions of A and B must agree');
+    end
+
+    % Initialize the output matrix
+    Y = zeros(size(A,1), size(B,2), 'single');
+
+    % Each element is one row of A against one column of B
+    % Column-major B is what the filter RAM holds in OP_GEMM mode
+    for i = 1:numel(Y)
+        % Determine Column and row index
+        rowIdx = mod(i-1, size(Y,1)) + 1;
+        colIdx = floor((i-1)/size(Y,1)) + 1;
+
+        % Perform multiply and accumulate operation
+        Y(i) = multiply_and_accumulate(A(rowIdx,:), B(:,colIdx));
+    end
+end
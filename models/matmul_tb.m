@@ -0,0 +1,32 @@
+M = 16;
+K = 40;
+N = 12;
+rng(0);
+A = randn(M, K, 'single');
+B = randn(K, N, 'single');
+Y = matmul(A,B);
+
+fid = fopen('data.txt', 'w');
+fprintf(fid, '%08X\n', size(A,2));
+fprintf(fid, '%08X\n', size(A,1));
+A = A.';  % Transpose because C indexing is reversed
+for i = 1:numel(A)
+    fprintf(fid, '%08X\n', typecast(A(i), 'uint32'));
+end
+fclose(fid);
+
+% Filter RAM holds B column-major, i.e. the rows of B.'
+fid = fopen('filt.txt', 'w');
+fprintf(fid, '%08X\n', size(B,1));
+fprintf(fid, '%08X\n', size(B,2));
+for i = 1:numel(B)
+    fprintf(fid, '%08X\n', typecast(B(i), 'uint32'));
+end
+fclose(fid);
+
+fid = fopen('output.txt', 'w');
+Y = Y.'; % Transpose because C indexing is reversed
+for i = 1:numel(Y)
+    fprintf(fid, '%08X\n', typecast(Y(i), 'uint32'));
+end
+fclose(fid);
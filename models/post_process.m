@@ -0,0 +1,80 @@
+function Y = post_process(Y,bias,act,slope,poolSize,poolAvg)
+
+    % Fused bias, activation and pooling of src/post_process.v
+    % bias = [] skips the bias add, act is 'none', 'relu' or 'leaky'
+    % poolSize 2 or 3 reduces non-overlapping windows to their maximum or,
+    % with poolAvg, their average. Outputs beyond the last whole window
+    % are dropped.
+    if nargin < 2
+        bias = [];
+    end
+    if nargin < 3
+        act = 'none';
+    end
+    if nargin < 4
+        slope = 0.125;
+    end
+    if nargin < 5
+        poolSize = 1;
+    end
+    if nargin < 6
+        poolAvg = 0;
+    end
+
+    Y = single(Y);
+
+    % Bias add
+    if ~isempty(bias)
+        Y = Y + single(bias);
+    end
+
+    % Outputs with the sign bit set (including -0) are activated
+    neg = bitget(typecast(Y(:), 'uint32'), 32) == 1;
+    neg = reshape(neg, size(Y));
+    if strcmp(act, 'relu')
+        Y(neg) = 0;
+    elseif strcmp(act, 'leaky')
+        Y(neg) = Y(neg) * single(slope);
+    end
+
+    if poolSize < 2
+        return;
+    end
+
+    % Windows reduce left to right in every row, then top to bottom
+    nRows = floor(size(Y,1)/poolSize);
+    nCols = floor(size(Y,2)/poolSize);
+    P = zeros(nRows, nCols, 'single');
+    for i = 1:nRows
+        for j = 1:nCols
+            rows = (i-1)*poolSize + (1:poolSize);
+            cols = (j-1)*poolSize + (1:poolSize);
+            for r = 1:poolSize
+                line = Y(rows(r), cols(1));
+                for c = 2:poolSize
+                    line = combine(line, Y(rows(r), cols(c)), poolAvg);
+                end
+                if r == 1
+                    window = line;
+                else
+                    window = combine(window, line, poolAvg);
+                end
+            end
+
+            % Average multiplies by the single precision reciprocal
+            if poolAvg
+                window = window * single(1/poolSize^2);
+            end
+            P(i,j) = window;
+        end
+    end
+    Y = P;
+end
+
+function c = combine(a,b,avg)
+    if avg
+        c = a + b;
+    else
+        c = max(a, b);
+    end
+end
@@ -0,0 +1,370 @@
+`timescale 1ns/1ns
+
+module cnn_accelerator_array (
+    clkIn,
+    rstIn,
+    startIn,
+    opTypeIn,
+    strideLog2In,
+    padIn,
+    dilationLog2In,
+    packIn,
+    quantMultIn,
+    quantShiftIn,
+    quantZeroIn,
+    biasEnIn,
+    biasIn,
+    actIn,
+    slopeIn,
+    poolSizeIn,
+    poolAvgIn,
+    filtRowsIn,
+    filtColsIn,
+    dataRowsIn,
+    dataColsIn,
+    channelsIn,
+    dataBaseIn,
+    filtBaseIn,
+    holdBankIn,
+    addrIn,
+    wrEnIn,
+    wrDataIn,
+    readyIn,
+    busyOut,
+    queueFullOut,
+    nextCoreOut,
+    validOut,
+    dataOut,
+    keepOut,
+    lastOut,
+    countOut,
+    perfStartIn,
+    perfStopIn,
+    perfClearIn,
+    perfSelIn,
+    perfDataOut);
+
+    // NUM_CORES copies of cnn_hw_accelerator behind one bus and job port
+    //
+    // The ports follow cnn_hw_accelerator.v. Each core has its own data
+    // and filter RAMs, mapped into consecutive windows of CORE_SPAN bytes
+    // (the data RAM followed by the filter RAM of one core):
+    //   window 0      Load bank of the core the next job is dispatched to
+    //   window 1      Load banks of every core (broadcast)
+    //   window 2 + k  Load bank of core k
+    // A host that only writes window 0 sees a single accelerator: it loads
+    // the operands of a job, waits for !busyOut and pulses startIn.
+    //
+    // Dispatcher: a job started without holdBankIn goes to nextCoreOut,
+    // after which nextCoreOut moves to the first idle core after it in
+    // round-robin order (or simply the next one if every core is busy),
+    // so independent tiles or filters spread across the cores while the
+    // host loads the next one. A job started with holdBankIn goes to the
+    // core of the previous job and reads the bank of that job. busyOut
+    // follows the busyOut of nextCoreOut, queueFullOut the queueFullOut of
+    // the core of the previous job.
+    //
+    // Output arbiter: the core of every job started is queued in start
+    // order, and dataOut drains the core at the head of that queue until
+    // its lastOut, so results leave in the order the jobs were started
+    // whichever core finishes first. Jobs must produce at least one
+    // result. countOut is the countOut of the core at the head.
+    //
+    // perfDataOut is the selected counter summed over the cores, two
+    // cycles after perfSelIn.
+
+    // Number of cores and jobs tracked by the output arbiter
+    // startIn is ignored while ORDER_DEPTH jobs have results left to read
+    parameter NUM_CORES         = 4;
+    parameter ORDER_DEPTH       = 16;
+
+    // Core configuration, see cnn_hw_accelerator.v
+    parameter BUS_ADDR_WIDTH    = 32;
+    parameter BUS_DATA_WIDTH    = 64;
+    parameter FRAC_WIDTH        = 24;
+    parameter EXP_WIDTH         = 8;
+    parameter ACC_FRAC_WIDTH    = 24;
+    parameter ACC_EXP_WIDTH     = 8;
+    parameter VECTOR_SIZE       = 8;
+    parameter MAC_STYLE         = "FLOAT";
+    parameter MAX_SIZE          = 4096;
+    parameter LINE_BUFFER       = 1;
+    parameter WINDOW_ROWS       = 16;
+    parameter PACKING           = 1;
+    parameter POST_PROCESS      = 1;
+    parameter POOL_COLS         = MAX_SIZE/4;
+    parameter OUT_DATA_WIDTH    = ACC_FRAC_WIDTH + ACC_EXP_WIDTH;
+    parameter PERF_COUNTERS     = 1;
+    parameter PERF_WIDTH        = 32;
+    parameter JOB_QUEUE         = 4;
+
+    // Derived parameters of the core ports
+    localparam BUS_WE_WIDTH     = BUS_DATA_WIDTH/8;
+    localparam CNT_WIDTH        = $clog2(MAX_SIZE);
+    localparam VECTOR_SIZE_LOG2 = $clog2(VECTOR_SIZE);
+    localparam RAM_DATA_WIDTH   = (MAC_STYLE == "INT8") ? 8 : FRAC_WIDTH + EXP_WIDTH;
+    localparam ACC_DATA_WIDTH   = ACC_FRAC_WIDTH + ACC_EXP_WIDTH;
+    localparam STRIDE_WIDTH     = 2;
+    localparam PAD_WIDTH        = 4;
+    localparam DIL_WIDTH        = $clog2(VECTOR_SIZE_LOG2+1);
+    localparam QUANT_SHIFT_WIDTH = $clog2(2*ACC_DATA_WIDTH);
+    localparam QUANT_ZERO_WIDTH  = 8;
+    localparam FIFO_DEPTH       = 512;
+    localparam OUT_LANES        = OUT_DATA_WIDTH/ACC_DATA_WIDTH;
+    localparam COUNT_WIDTH      = $clog2(FIFO_DEPTH*OUT_LANES) + 1;
+    localparam PERF_SEL_WIDTH   = 3;
+
+    // Address windows, each spans the data and filter RAM of one core
+    localparam CORE_ADDR_WIDTH  = $clog2(MAX_SIZE) + $clog2(RAM_DATA_WIDTH/8) + 1;
+    localparam CORE_SPAN        = 1 << CORE_ADDR_WIDTH;
+    localparam WIN_WIDTH        = $clog2(NUM_CORES + 2);
+    localparam WIN_NEXT         = 0;
+    localparam WIN_ALL          = 1;
+    localparam WIN_CORE         = 2;
+
+    // Derived dispatcher parameters
+    localparam CORE_WIDTH       = (NUM_CORES > 1) ? $clog2(NUM_CORES) : 1;
+    localparam ORDER_ADDR_WIDTH = (ORDER_DEPTH > 1) ? $clog2(ORDER_DEPTH) : 1;
+    localparam ORDER_CNT_WIDTH  = $clog2(ORDER_DEPTH + 1);
+
+    // Input/Output Ports
+    input clkIn;
+    input rstIn;
+
+    input startIn;
+    input opTypeIn;
+    input [STRIDE_WIDTH-1:0] strideLog2In;
+    input [   PAD_WIDTH-1:0] padIn;
+    input [   DIL_WIDTH-1:0] dilationLog2In;
+    input packIn;
+    input [   ACC_DATA_WIDTH-1:0] quantMultIn;
+    input [QUANT_SHIFT_WIDTH-1:0] quantShiftIn;
+    input [ QUANT_ZERO_WIDTH-1:0] quantZeroIn;
+    input biasEnIn;
+    input [ACC_DATA_WIDTH-1:0] biasIn;
+    input [1:0] actIn;
+    input [ACC_DATA_WIDTH-1:0] slopeIn;
+    input [1:0] poolSizeIn;
+    input poolAvgIn;
+    input [CNT_WIDTH:0] filtRowsIn;
+    input [CNT_WIDTH:0] filtColsIn;
+    input [CNT_WIDTH:0] dataRowsIn;
+    input [CNT_WIDTH:0] dataColsIn;
+    input [CNT_WIDTH:0] channelsIn;
+    input [CNT_WIDTH-1:0] dataBaseIn;
+    input [CNT_WIDTH-1:0] filtBaseIn;
+    input holdBankIn;
+
+    input [BUS_ADDR_WIDTH-1:0] addrIn;
+    input [  BUS_WE_WIDTH-1:0] wrEnIn;
+    input [BUS_DATA_WIDTH-1:0] wrDataIn;
+
+    input  readyIn;
+    output busyOut;
+    output queueFullOut;
+    output [CORE_WIDTH-1:0] nextCoreOut;
+    output validOut;
+    output [OUT_DATA_WIDTH-1:0] dataOut;
+    output [     OUT_LANES-1:0] keepOut;
+    output lastOut;
+    output [   COUNT_WIDTH-1:0] countOut;
+
+    input  perfStartIn;
+    input  perfStopIn;
+    input  perfClearIn;
+    input  [PERF_SEL_WIDTH-1:0] perfSelIn;
+    output [    PERF_WIDTH-1:0] perfDataOut;
+
+    // Per-core control and outputs
+    wire [NUM_CORES-1:0] coreStart;
+    wire [NUM_CORES-1:0] coreWrSel;
+    wire [NUM_CORES-1:0] coreReady;
+    wire [NUM_CORES-1:0] coreBusy;
+    wire [NUM_CORES-1:0] coreQueueFull;
+    wire [NUM_CORES-1:0] coreValid;
+    wire [NUM_CORES-1:0] coreLast;
+    wire [NUM_CORES*OUT_DATA_WIDTH-1:0] coreData;
+    wire [NUM_CORES*OUT_LANES-1:0] coreKeep;
+    wire [NUM_CORES*COUNT_WIDTH-1:0] coreCount;
+    wire [NUM_CORES*PERF_WIDTH-1:0] corePerf;
+
+    // Dispatcher registers
+    reg [CORE_WIDTH-1:0] nextCoreR;
+    reg [CORE_WIDTH-1:0] lastCoreR;
+    reg [CORE_WIDTH-1:0] pickVar;
+    reg [CORE_WIDTH:0] idxVar;
+
+    // Order of the cores of the jobs with results left to read
+    reg [CORE_WIDTH-1:0] orderR [0:ORDER_DEPTH-1];
+    reg [ORDER_ADDR_WIDTH-1:0] orderWrPtrR;
+    reg [ORDER_ADDR_WIDTH-1:0] orderRdPtrR;
+    reg [ORDER_CNT_WIDTH-1:0] orderCntR;
+
+    wire [WIN_WIDTH-1:0] window;
+    wire [CORE_WIDTH-1:0] startCore;
+    wire [CORE_WIDTH-1:0] headCore;
+    wire orderFull;
+    wire orderPush;
+    wire orderPop;
+
+    integer j;
+
+    // Bus writes go to the cores selected by the window
+    assign window = addrIn[CORE_ADDR_WIDTH+:WIN_WIDTH];
+
+    // A job is accepted while the arbiter can track it and its core has
+    // room in its job queue
+    assign startCore = holdBankIn ? lastCoreR : nextCoreR;
+    assign orderFull = (orderCntR == ORDER_DEPTH);
+    assign orderPush = startIn & !orderFull & !coreQueueFull[startCore];
+
+    // Dispatcher Process
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            nextCoreR   <= 0;
+            lastCoreR   <= 0;
+        end else if (orderPush) begin
+            lastCoreR   <= startCore;
+
+            // First idle core after this one, or the next one
+            if (!holdBankIn) begin
+                idxVar  = nextCoreR + 1;
+                pickVar = (idxVar >= NUM_CORES) ? idxVar - NUM_CORES : idxVar;
+                for (j = NUM_CORES - 1; j > 0; j = j - 1) begin
+                    idxVar  = nextCoreR + j;
+                    if (idxVar >= NUM_CORES) begin
+                        idxVar  = idxVar - NUM_CORES;
+                    end
+                    if (!coreBusy[idxVar]) begin
+                        pickVar = idxVar;
+                    end
+                end
+                nextCoreR   <= pickVar;
+            end
+        end
+    end
+
+    // Order Queue Process
+    always @(posedge clkIn) begin
+        if (orderPush) begin
+            orderR[orderWrPtrR] <= startCore;
+        end
+        if (rstIn) begin
+            orderWrPtrR     <= 0;
+            orderRdPtrR     <= 0;
+            orderCntR       <= 0;
+        end else begin
+            if (orderPush) begin
+                orderWrPtrR     <= (orderWrPtrR == ORDER_DEPTH - 1) ? 0 : orderWrPtrR + 1;
+            end
+            if (orderPop) begin
+                orderRdPtrR     <= (orderRdPtrR == ORDER_DEPTH - 1) ? 0 : orderRdPtrR + 1;
+            end
+            orderCntR       <= orderCntR + orderPush - orderPop;
+        end
+    end
+
+    // The head job is done with the last word of its core
+    assign headCore = orderR[orderRdPtrR];
+    assign orderPop = validOut & readyIn & lastOut;
+
+    // Cores
+    genvar i;
+    generate
+        for (i = 0; i < NUM_CORES; i = i + 1) begin : core
+
+            assign coreStart[i] = orderPush && (startCore == i);
+            assign coreWrSel[i] = (window == WIN_ALL) || (window == WIN_CORE + i) ||
+                                  ((window == WIN_NEXT) && (nextCoreR == i));
+            assign coreReady[i] = readyIn && (orderCntR != 0) && (headCore == i);
+
+            cnn_hw_accelerator #(
+                .BUS_ADDR_WIDTH(BUS_ADDR_WIDTH),
+                .BUS_DATA_WIDTH(BUS_DATA_WIDTH),
+                .FRAC_WIDTH(FRAC_WIDTH),
+                .EXP_WIDTH(EXP_WIDTH),
+                .ACC_FRAC_WIDTH(ACC_FRAC_WIDTH),
+                .ACC_EXP_WIDTH(ACC_EXP_WIDTH),
+                .VECTOR_SIZE(VECTOR_SIZE),
+                .MAC_STYLE(MAC_STYLE),
+                .MAX_SIZE(MAX_SIZE),
+                .LINE_BUFFER(LINE_BUFFER),
+                .WINDOW_ROWS(WINDOW_ROWS),
+                .PACKING(PACKING),
+                .POST_PROCESS(POST_PROCESS),
+                .POOL_COLS(POOL_COLS),
+                .OUT_DATA_WIDTH(OUT_DATA_WIDTH),
+                .PERF_COUNTERS(PERF_COUNTERS),
+                .PERF_WIDTH(PERF_WIDTH),
+                .JOB_QUEUE(JOB_QUEUE)) accel (
+                .clkIn(clkIn),
+                .rstIn(rstIn),
+                .startIn(coreStart[i]),
+                .opTypeIn(opTypeIn),
+                .strideLog2In(strideLog2In),
+                .padIn(padIn),
+                .dilationLog2In(dilationLog2In),
+                .packIn(packIn),
+                .quantMultIn(quantMultIn),
+                .quantShiftIn(quantShiftIn),
+                .quantZeroIn(quantZeroIn),
+                .biasEnIn(biasEnIn),
+                .biasIn(biasIn),
+                .actIn(actIn),
+                .slopeIn(slopeIn),
+                .poolSizeIn(poolSizeIn),
+                .poolAvgIn(poolAvgIn),
+                .filtRowsIn(filtRowsIn),
+                .filtColsIn(filtColsIn),
+                .dataRowsIn(dataRowsIn),
+                .dataColsIn(dataColsIn),
+                .channelsIn(channelsIn),
+                .dataBaseIn(dataBaseIn),
+                .filtBaseIn(filtBaseIn),
+                .holdBankIn(holdBankIn),
+                .addrIn(addrIn),
+                .wrEnIn(coreWrSel[i] ? wrEnIn : {BUS_WE_WIDTH{1'b0}}),
+                .wrDataIn(wrDataIn),
+                .readyIn(coreReady[i]),
+                .busyOut(coreBusy[i]),
+                .queueFullOut(coreQueueFull[i]),
+                .validOut(coreValid[i]),
+                .dataOut(coreData[i*OUT_DATA_WIDTH+:OUT_DATA_WIDTH]),
+                .keepOut(coreKeep[i*OUT_LANES+:OUT_LANES]),
+                .lastOut(coreLast[i]),
+                .countOut(coreCount[i*COUNT_WIDTH+:COUNT_WIDTH]),
+                .perfStartIn(perfStartIn),
+                .perfStopIn(perfStopIn),
+                .perfClearIn(perfClearIn),
+                .perfSelIn(perfSelIn),
+                .perfDataOut(corePerf[i*PERF_WIDTH+:PERF_WIDTH]));
+        end
+    endgenerate
+
+    // Output Arbiter, results of the core at the head of the order queue
+    assign validOut     = (orderCntR != 0) & coreValid[headCore];
+    assign dataOut      = coreData[headCore*OUT_DATA_WIDTH+:OUT_DATA_WIDTH];
+    assign keepOut      = coreKeep[headCore*OUT_LANES+:OUT_LANES];
+    assign lastOut      = coreLast[headCore];
+    assign countOut     = (orderCntR != 0) ? coreCount[headCore*COUNT_WIDTH+:COUNT_WIDTH] : 0;
+
+    // The next job waits on its core, or on room in the order queue
+    assign busyOut      = coreBusy[nextCoreR] | orderFull;
+    assign queueFullOut = coreQueueFull[lastCoreR] | orderFull;
+    assign nextCoreOut  = nextCoreR;
+
+    // Counters summed over the cores
+    reg [PERF_WIDTH-1:0] perfDataR;
+    reg [PERF_WIDTH-1:0] perfSumVar;
+
+    always @(posedge clkIn) begin
+        perfSumVar = 0;
+        for (j = 0; j < NUM_CORES; j = j + 1) begin
+            perfSumVar = perfSumVar + corePerf[j*PERF_WIDTH+:PERF_WIDTH];
+        end
+        perfDataR <= perfSumVar;
+    end
+
+    assign perfDataOut = perfDataR;
+
+endmodule
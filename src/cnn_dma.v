@@ -0,0 +1,482 @@
+`timescale 1ns/1ns
+
+module cnn_dma (
+    clkIn,
+    rstIn,
+    startIn,
+    descAddrIn,
+    busyOut,
+    doneOut,
+    memReqValidOut,
+    memReqReadyIn,
+    memReqWrOut,
+    memReqAddrOut,
+    memReqWrEnOut,
+    memReqDataOut,
+    memRspValidIn,
+    memRspDataIn,
+    accStartOut,
+    accOpTypeOut,
+    accStrideLog2Out,
+    accPadOut,
+    accDilationLog2Out,
+    accFiltRowsOut,
+    accFiltColsOut,
+    accDataRowsOut,
+    accDataColsOut,
+    accAddrOut,
+    accWrEnOut,
+    accWrDataOut,
+    accBusyIn,
+    accValidIn,
+    accDataIn,
+    accReadyOut);
+
+    // Descriptor-driven DMA between main memory and cnn_hw_accelerator
+    //
+    // A descriptor list starts at descAddrIn and is processed in order once
+    // startIn is pulsed. Each descriptor is two 64-bit words:
+    //   word 0 [31: 0] Address of the first element (4-byte aligned)
+    //          [63:32] Stride between rows in bytes (4-byte aligned)
+    //   word 1 [15: 0] Rows
+    //          [31:16] Columns
+    //          [33:32] Type (DESC_DATA, DESC_FILT, DESC_RUN)
+    //          [   34] Operation type of DESC_RUN (0 = conv, 1 = gemm)
+    //          [   35] Last descriptor of the list
+    //          [37:36] Log2 of convolution stride of DESC_RUN
+    //          [41:38] Convolution zero padding of DESC_RUN
+    //          [43:42] Log2 of convolution dilation of DESC_RUN
+    //
+    // DESC_DATA/DESC_FILT copy a rows x cols tile into the data/filter RAM
+    // and set the matching accelerator dimensions. DESC_RUN waits for the
+    // accelerator to be idle, starts it and writes rows x cols results to
+    // memory. The memory bus is valid/ready for requests, read responses
+    // return in order and writes are posted.
+
+    // Configuration of RISCV bus interface
+    // Element packing assumes two elements per bus word
+    parameter BUS_ADDR_WIDTH    = 32;
+    parameter BUS_DATA_WIDTH    = 64;
+
+    // Floating-point hardware accelerator configuration
+    parameter FRAC_WIDTH        = 24;
+    parameter EXP_WIDTH         = 8;
+
+    // Maximum size of input matrices
+    parameter MAX_SIZE          = 4096;
+
+    // Derived parameters
+    localparam BUS_WE_WIDTH     = BUS_DATA_WIDTH/8;
+    localparam DATA_WIDTH       = FRAC_WIDTH + EXP_WIDTH;
+    localparam DIM_WIDTH        = $clog2(MAX_SIZE) + 1;
+    localparam DESC_DIM_WIDTH   = 16;
+    localparam STRIDE_WIDTH     = 2;
+    localparam PAD_WIDTH        = 4;
+    localparam DIL_WIDTH        = 2;
+    localparam WORD_LO          = $clog2(BUS_WE_WIDTH);
+
+    // Accelerator address map
+    localparam ACC_DATA_ADDR    = 0;
+    localparam ACC_FILT_ADDR    = 1 << ($clog2(MAX_SIZE) + $clog2(DATA_WIDTH/8));
+
+    // Descriptor types
+    localparam DESC_DATA        = 0;
+    localparam DESC_FILT        = 1;
+    localparam DESC_RUN         = 2;
+
+    // State Definitions
+    localparam IDLE             = 0;
+    localparam FETCH            = 1;
+    localparam DESC             = 2;
+    localparam LOAD             = 3;
+    localparam WAIT             = 4;
+    localparam STORE            = 5;
+
+    // Write enables of a bus word
+    localparam WE_LO            = {{(BUS_WE_WIDTH/2){1'b0}}, {(BUS_WE_WIDTH/2){1'b1}}};
+    localparam WE_HI            = {{(BUS_WE_WIDTH/2){1'b1}}, {(BUS_WE_WIDTH/2){1'b0}}};
+    localparam WE_ALL           = {BUS_WE_WIDTH{1'b1}};
+
+    // Input/Output Ports
+    input clkIn;
+    input rstIn;
+
+    input startIn;
+    input [BUS_ADDR_WIDTH-1:0] descAddrIn;
+    output busyOut;
+    output doneOut;
+
+    output memReqValidOut;
+    input  memReqReadyIn;
+    output memReqWrOut;
+    output [BUS_ADDR_WIDTH-1:0] memReqAddrOut;
+    output [  BUS_WE_WIDTH-1:0] memReqWrEnOut;
+    output [BUS_DATA_WIDTH-1:0] memReqDataOut;
+    input  memRspValidIn;
+    input  [BUS_DATA_WIDTH-1:0] memRspDataIn;
+
+    output accStartOut;
+    output accOpTypeOut;
+    output [STRIDE_WIDTH-1:0] accStrideLog2Out;
+    output [   PAD_WIDTH-1:0] accPadOut;
+    output [   DIL_WIDTH-1:0] accDilationLog2Out;
+    output [DIM_WIDTH-1:0] accFiltRowsOut;
+    output [DIM_WIDTH-1:0] accFiltColsOut;
+    output [DIM_WIDTH-1:0] accDataRowsOut;
+    output [DIM_WIDTH-1:0] accDataColsOut;
+    output [BUS_ADDR_WIDTH-1:0] accAddrOut;
+    output [  BUS_WE_WIDTH-1:0] accWrEnOut;
+    output [BUS_DATA_WIDTH-1:0] accWrDataOut;
+    input  accBusyIn;
+    input  accValidIn;
+    input  [DATA_WIDTH-1:0] accDataIn;
+    output accReadyOut;
+
+    // FSM registers
+    reg [2:0] stateR;
+    reg doneR;
+    reg [BUS_ADDR_WIDTH-1:0] descAddrR;
+    reg descReqCntR;
+    reg descRspCntR;
+    reg [BUS_DATA_WIDTH-1:0] descWord0R;
+
+    // Current descriptor
+    reg [BUS_ADDR_WIDTH-1:0] strideR;
+    reg [DESC_DIM_WIDTH-1:0] rowsR;
+    reg [DESC_DIM_WIDTH-1:0] colsR;
+    reg [BUS_ADDR_WIDTH-1:0] colBytesR;
+    reg descLastR;
+
+    // Accelerator configuration
+    reg accStartR;
+    reg accOpTypeR;
+    reg [STRIDE_WIDTH-1:0] accStrideR;
+    reg [   PAD_WIDTH-1:0] accPadR;
+    reg [   DIL_WIDTH-1:0] accDilR;
+    reg [DIM_WIDTH-1:0] filtRowsR;
+    reg [DIM_WIDTH-1:0] filtColsR;
+    reg [DIM_WIDTH-1:0] dataRowsR;
+    reg [DIM_WIDTH-1:0] dataColsR;
+
+    // Memory request register
+    reg memReqValidR;
+    reg memReqWrR;
+    reg [BUS_ADDR_WIDTH-1:0] memReqAddrR;
+    reg [  BUS_WE_WIDTH-1:0] memReqWrEnR;
+    reg [BUS_DATA_WIDTH-1:0] memReqDataR;
+
+    // Tile read requests
+    reg [DESC_DIM_WIDTH-1:0] reqRowR;
+    reg [BUS_ADDR_WIDTH-1:0] reqRowAddrR;
+    reg [BUS_ADDR_WIDTH-1:0] reqWordR;
+    reg [BUS_ADDR_WIDTH-1:0] reqEndR;
+
+    // Tile read responses
+    reg [DESC_DIM_WIDTH-1:0] rspRowR;
+    reg [DESC_DIM_WIDTH-1:0] rspColR;
+    reg [BUS_ADDR_WIDTH-1:0] rspRowAddrR;
+
+    // Accelerator write packing
+    reg pendR;
+    reg [DATA_WIDTH-1:0] pendDataR;
+    reg [BUS_ADDR_WIDTH-1:0] accWordR;
+    reg [BUS_ADDR_WIDTH-1:0] accAddrR;
+    reg [  BUS_WE_WIDTH-1:0] accWrEnR;
+    reg [BUS_DATA_WIDTH-1:0] accWrDataR;
+
+    // Result stores
+    reg [DESC_DIM_WIDTH-1:0] outRowR;
+    reg [DESC_DIM_WIDTH-1:0] outColR;
+    reg [BUS_ADDR_WIDTH-1:0] outRowAddrR;
+    reg outPendR;
+    reg [DATA_WIDTH-1:0] outPendDataR;
+
+    // Temporaries
+    reg [BUS_ADDR_WIDTH-1:0] rowAddrVar;
+    reg [BUS_ADDR_WIDTH-1:0] elemAddrVar;
+    reg [DESC_DIM_WIDTH-1:0] numElemVar;
+    reg [DESC_DIM_WIDTH-1:0] rowsVar;
+    reg [DESC_DIM_WIDTH-1:0] colsVar;
+    reg [DATA_WIDTH-1:0] elemLoVar;
+    reg [DATA_WIDTH-1:0] elemHiVar;
+
+    // Request register is free when empty or being accepted
+    wire reqFree;
+    wire outReady;
+    wire outAccept;
+
+    assign reqFree      = !memReqValidR | memReqReadyIn;
+    assign outReady     = (stateR == STORE) & (outRowR != rowsR) & reqFree;
+    assign outAccept    = outReady & accValidIn;
+
+    // DMA state machine
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            stateR          <= IDLE;
+            doneR           <= 0;
+            descAddrR       <= 0;
+            descReqCntR     <= 0;
+            descRspCntR     <= 0;
+            accStartR       <= 0;
+            accOpTypeR      <= 0;
+            accStrideR      <= 0;
+            accPadR         <= 0;
+            accDilR         <= 0;
+            filtRowsR       <= 0;
+            filtColsR       <= 0;
+            dataRowsR       <= 0;
+            dataColsR       <= 0;
+            memReqValidR    <= 0;
+            accWrEnR        <= 0;
+            pendR           <= 0;
+            outPendR        <= 0;
+        end else begin
+            doneR           <= 0;
+            accStartR       <= 0;
+            accWrEnR        <= 0;
+            if (memReqReadyIn) begin
+                memReqValidR    <= 0;
+            end
+
+            case (stateR)
+                IDLE : begin
+                    descAddrR       <= descAddrIn;
+                    descReqCntR     <= 0;
+                    descRspCntR     <= 0;
+                    if (startIn) begin
+                        stateR      <= FETCH;
+                    end
+                end
+
+                // Read both words of the next descriptor
+                FETCH : begin
+                    if (reqFree) begin
+                        memReqValidR    <= 1;
+                        memReqWrR       <= 0;
+                        memReqAddrR     <= descAddrR + (descReqCntR << WORD_LO);
+                        descReqCntR     <= 1;
+                        if (descReqCntR) begin
+                            stateR      <= DESC;
+                        end
+                    end
+                end
+
+                // Decode descriptor when its second word returns
+                DESC : begin
+                    if (memRspValidIn && descRspCntR) begin
+                        rowsVar         = memRspDataIn[15:0];
+                        colsVar         = memRspDataIn[31:16];
+                        rowAddrVar      = descWord0R[31:0];
+                        strideR         <= descWord0R[63:32];
+                        rowsR           <= rowsVar;
+                        colsR           <= colsVar;
+                        colBytesR       <= colsVar << 2;
+                        descLastR       <= memRspDataIn[35];
+
+                        // Tile loads
+                        reqRowR         <= 0;
+                        reqRowAddrR     <= rowAddrVar;
+                        reqWordR        <= rowAddrVar >> WORD_LO << WORD_LO;
+                        reqEndR         <= (rowAddrVar + (colsVar << 2) - 1) >> WORD_LO << WORD_LO;
+                        rspRowR         <= 0;
+                        rspColR         <= 0;
+                        rspRowAddrR     <= rowAddrVar;
+                        accWordR        <= (memRspDataIn[33:32] == DESC_FILT) ? ACC_FILT_ADDR : ACC_DATA_ADDR;
+
+                        // Result stores
+                        outRowR         <= 0;
+                        outColR         <= 0;
+                        outRowAddrR     <= rowAddrVar;
+
+                        case (memRspDataIn[33:32])
+                            DESC_DATA : begin
+                                dataRowsR   <= rowsVar;
+                                dataColsR   <= colsVar;
+                                stateR      <= LOAD;
+                            end
+                            DESC_FILT : begin
+                                filtRowsR   <= rowsVar;
+                                filtColsR   <= colsVar;
+                                stateR      <= LOAD;
+                            end
+                            default : begin
+                                accOpTypeR  <= memRspDataIn[34];
+                                accStrideR  <= memRspDataIn[37:36];
+                                accPadR     <= memRspDataIn[41:38];
+                                accDilR     <= memRspDataIn[43:42];
+                                stateR      <= WAIT;
+                            end
+                        endcase
+                    end
+                end
+
+                // Copy a tile into the accelerator RAM
+                LOAD : begin
+
+                    // Read every bus word that holds part of a row
+                    if ((reqRowR != rowsR) && reqFree) begin
+                        memReqValidR    <= 1;
+                        memReqWrR       <= 0;
+                        memReqAddrR     <= reqWordR;
+                        if (reqWordR == reqEndR) begin
+                            rowAddrVar  = reqRowAddrR + strideR;
+                            reqRowR     <= reqRowR + 1;
+                            reqRowAddrR <= rowAddrVar;
+                            reqWordR    <= rowAddrVar >> WORD_LO << WORD_LO;
+                            reqEndR     <= (rowAddrVar + colBytesR - 1) >> WORD_LO << WORD_LO;
+                        end else begin
+                            reqWordR    <= reqWordR + BUS_WE_WIDTH;
+                        end
+                    end
+
+                    // Extract one or two row elements from each response
+                    if (memRspValidIn) begin
+                        elemAddrVar     = rspRowAddrR + (rspColR << 2);
+                        elemLoVar       = memRspDataIn[0+:DATA_WIDTH];
+                        elemHiVar       = memRspDataIn[DATA_WIDTH+:DATA_WIDTH];
+                        if (elemAddrVar[2]) begin
+                            numElemVar  = 1;
+                            elemLoVar   = elemHiVar;
+                        end else if (rspColR + 1 < colsR) begin
+                            numElemVar  = 2;
+                        end else begin
+                            numElemVar  = 1;
+                        end
+
+                        // Pack elements into consecutive accelerator words
+                        if ((numElemVar == 2) || pendR) begin
+                            accAddrR    <= accWordR;
+                            accWordR    <= accWordR + BUS_WE_WIDTH;
+                        end
+                        if (numElemVar == 2) begin
+                            accWrEnR    <= WE_ALL;
+                            accWrDataR  <= pendR ? {elemLoVar, pendDataR} : {elemHiVar, elemLoVar};
+                            pendDataR   <= elemHiVar;
+                        end else if (pendR) begin
+                            accWrEnR    <= WE_ALL;
+                            accWrDataR  <= {elemLoVar, pendDataR};
+                            pendR       <= 0;
+                        end else begin
+                            pendDataR   <= elemLoVar;
+                            pendR       <= 1;
+                        end
+
+                        // Advance to next row
+                        if (rspColR + numElemVar == colsR) begin
+                            rspRowR     <= rspRowR + 1;
+                            rspColR     <= 0;
+                            rspRowAddrR <= rspRowAddrR + strideR;
+                        end else begin
+                            rspColR     <= rspColR + numElemVar;
+                        end
+
+                    // Flush odd element, then move to next descriptor
+                    end else if (rspRowR == rowsR) begin
+                        if (pendR) begin
+                            accAddrR    <= accWordR;
+                            accWrEnR    <= WE_LO;
+                            accWrDataR  <= {{DATA_WIDTH{1'b0}}, pendDataR};
+                            pendR       <= 0;
+                        end else begin
+                            descAddrR   <= descAddrR + 2*BUS_WE_WIDTH;
+                            descReqCntR <= 0;
+                            descRspCntR <= 0;
+                            if (descLastR) begin
+                                doneR   <= 1;
+                                stateR  <= IDLE;
+                            end else begin
+                                stateR  <= FETCH;
+                            end
+                        end
+                    end
+                end
+
+                // Start the accelerator once the previous job released its banks
+                WAIT : begin
+                    if (!accBusyIn) begin
+                        accStartR   <= 1;
+                        stateR      <= STORE;
+                    end
+                end
+
+                // Write results, pairing elements that share a bus word
+                STORE : begin
+                    if (outAccept) begin
+                        elemAddrVar     = outRowAddrR + (outColR << 2);
+                        memReqWrR       <= 1;
+                        memReqAddrR     <= elemAddrVar >> WORD_LO << WORD_LO;
+                        if (outPendR) begin
+                            memReqValidR    <= 1;
+                            memReqWrEnR     <= WE_ALL;
+                            memReqDataR     <= {accDataIn, outPendDataR};
+                            outPendR        <= 0;
+                        end else if (!elemAddrVar[2] && (outColR + 1 < colsR)) begin
+                            outPendDataR    <= accDataIn;
+                            outPendR        <= 1;
+                        end else if (!elemAddrVar[2]) begin
+                            memReqValidR    <= 1;
+                            memReqWrEnR     <= WE_LO;
+                            memReqDataR     <= {{DATA_WIDTH{1'b0}}, accDataIn};
+                        end else begin
+                            memReqValidR    <= 1;
+                            memReqWrEnR     <= WE_HI;
+                            memReqDataR     <= {accDataIn, {DATA_WIDTH{1'b0}}};
+                        end
+
+                        // Advance to next row
+                        if (outColR + 1 == colsR) begin
+                            outRowR     <= outRowR + 1;
+                            outColR     <= 0;
+                            outRowAddrR <= outRowAddrR + strideR;
+                        end else begin
+                            outColR     <= outColR + 1;
+                        end
+
+                    // Last write accepted, move to next descriptor
+                    end else if ((outRowR == rowsR) && reqFree) begin
+                        descAddrR   <= descAddrR + 2*BUS_WE_WIDTH;
+                        descReqCntR <= 0;
+                        descRspCntR <= 0;
+                        if (descLastR) begin
+                            doneR   <= 1;
+                            stateR  <= IDLE;
+                        end else begin
+                            stateR  <= FETCH;
+                        end
+                    end
+                end
+            endcase
+
+            // First descriptor word may return before the second is requested
+            if (memRspValidIn && ((stateR == FETCH) || (stateR == DESC)) && !descRspCntR) begin
+                descWord0R  <= memRspDataIn;
+                descRspCntR <= 1;
+            end
+        end
+    end
+
+    // Outputs
+    assign busyOut          = (stateR != IDLE);
+    assign doneOut          = doneR;
+
+    assign memReqValidOut   = memReqValidR;
+    assign memReqWrOut      = memReqWrR;
+    assign memReqAddrOut    = memReqAddrR;
+    assign memReqWrEnOut    = memReqWrEnR;
+    assign memReqDataOut    = memReqDataR;
+
+    assign accStartOut      = accStartR;
+    assign accOpTypeOut     = accOpTypeR;
+    assign accStrideLog2Out = accStrideR;
+    assign accPadOut        = accPadR;
+    assign accDilationLog2Out = accDilR;
+    assign accFiltRowsOut   = filtRowsR;
+    assign accFiltColsOut   = filtColsR;
+    assign accDataRowsOut   = dataRowsR;
+    assign accDataColsOut   = dataColsR;
+    assign accAddrOut       = accAddrR;
+    assign accWrEnOut       = accWrEnR;
+    assign accWrDataOut     = accWrDataR;
+    assign accReadyOut      = outReady;
+
+endmodule
@@ -2,16 +2,44 @@ module cnn_hw_accelerator (
     clkIn,
     rstIn,
     startIn,
+    opTypeIn,
+    strideLog2In,
+    padIn,
+    dilationLog2In,
+    packIn,
+    quantMultIn,
+    quantShiftIn,
+    quantZeroIn,
+    biasEnIn,
+    biasIn,
+    actIn,
+    slopeIn,
+    poolSizeIn,
+    poolAvgIn,
     filtRowsIn,
     filtColsIn,
     dataRowsIn,
     dataColsIn,
+    channelsIn,
+    dataBaseIn,
+    filtBaseIn,
+    holdBankIn,
     addrIn,
     wrEnIn,
     wrDataIn,
     readyIn,
+    busyOut,
+    queueFullOut,
     validOut,
-    dataOut);
+    dataOut,
+    keepOut,
+    lastOut,
+    countOut,
+    perfStartIn,
+    perfStopIn,
+    perfClearIn,
+    perfSelIn,
+    perfDataOut);
 
     // Configuration of RISCV bus interface
     parameter BUS_ADDR_WIDTH    = 32;
@@ -22,12 +50,99 @@ module cnn_hw_accelerator (
     parameter FRAC_WIDTH        = 24;
     parameter EXP_WIDTH         = 8;
     
+    // Accumulation type of the MAC and type of dataOut
+    // 16-bit operand types (bfloat16: FRAC_WIDTH = 8, EXP_WIDTH = 8, FP16:
+    // FRAC_WIDTH = 11, EXP_WIDTH = 5) are widened to this type before the
+    // multipliers, so products are exact and sums keep single precision.
+    // A 16-bit build with VECTOR_SIZE = 16 stores two elements in each
+    // 32 bits of RAM and bus word, doubling the MACs per beat for the same
+    // RAM width and halving the load traffic.
+    parameter ACC_FRAC_WIDTH    = 24;
+    parameter ACC_EXP_WIDTH     = 8;
+    
     // Multiply and accumulate input width
     parameter VECTOR_SIZE       = 8;
     
+    // MAC engine
+    // "FLOAT": floating-point operands of FRAC_WIDTH/EXP_WIDTH
+    // "INT8":  signed 8-bit operands, integer adder tree and accumulator of
+    //          ACC_FRAC_WIDTH + ACC_EXP_WIDTH bits, outputs requantized per
+    //          job by quantMultIn/quantShiftIn/quantZeroIn
+    //          (see integer_requantize.v). VECTOR_SIZE = 32 stores four
+    //          operands in every 32 bits of RAM.
+    parameter MAC_STYLE         = "FLOAT";
+    
     // Maximum size of input matrices
     // < Max Rows > * < Max Cols >
     parameter MAX_SIZE          = 4096;
+    
+    // Sliding-window line buffer
+    // Convolutions with filtColsIn <= VECTOR_SIZE, no dilation and at most
+    // WINDOW_ROWS filter rows keep the window of every filter row and only
+    // read the columns entering it when moving to the next output column
+    parameter LINE_BUFFER       = 1;
+    parameter WINDOW_ROWS       = 16;
+    
+    // Filter row packing
+    // With packIn set, convolutions without dilation fill every beat with
+    // VECTOR_SIZE consecutive elements of the row-major filter window, so
+    // a 3x3 window takes 2 beats instead of 3. The data matrix must then be
+    // written with a row pitch of dataColsIn rounded up to the next value
+    // congruent to filtColsIn modulo VECTOR_SIZE, which keeps the lanes of a
+    // packed beat in distinct RAM banks. The line buffer is not used.
+    parameter PACKING           = 1;
+    
+    // Fused post-processing of the outputs (see post_process.v)
+    // Per job: biasIn is added when biasEnIn is set, actIn selects no
+    // activation (0), ReLU (1) or leaky ReLU with slope slopeIn (2), and
+    // poolSizeIn = 2 or 3 reduces non-overlapping windows of the output
+    // matrix to their maximum, or average with poolAvgIn, cutting the
+    // results read from dataOut by 4x or 9x. Pooled rows hold at most
+    // POOL_COLS outputs. INT8 builds add the integer bias and apply ReLU
+    // when requantizing, leaky ReLU is treated as ReLU.
+    // With POST_PROCESS = 0 only the INT8 bias and ReLU remain.
+    parameter POST_PROCESS      = 1;
+    parameter POOL_COLS         = MAX_SIZE/4;
+    
+    // Width of dataOut, a multiple of ACC_DATA_WIDTH
+    // Results are packed into the lanes of each word from the least
+    // significant lane, the last word of a job may be partial (keepOut
+    // marks the lanes holding results, lastOut the last word). With
+    // OUT_DATA_WIDTH = BUS_DATA_WIDTH results drain in bus-width words,
+    // one per readyIn cycle. countOut is the number of results buffered,
+    // so whole output rows can be read in one burst once available.
+    parameter OUT_DATA_WIDTH    = ACC_DATA_WIDTH;
+    
+    // Performance counters (see perf_counters.v)
+    // While running (perfStartIn to perfStopIn) the counters selected by
+    // perfSelIn count:
+    //   0: busy cycles (busyOut)
+    //   1: cycles stalled by throttleR because no output FIFO credits remain
+    //   2: masked MAC lanes (lanes left idle in the beats issued)
+    //   3: data RAM reads
+    //   4: filter RAM reads
+    //   5: MAC beats
+    //   6: results written to the output FIFO
+    //   7: cycles dataOut is valid but readyIn is low
+    // perfClearIn zeroes them, perfDataOut follows perfSelIn one cycle
+    // later. Pulsing perfClearIn and perfStartIn with startIn and
+    // perfStopIn once the last result is read counts a single job.
+    // PERF_COUNTERS = 0 removes the counters.
+    parameter PERF_COUNTERS     = 1;
+    parameter PERF_WIDTH        = 32;
+    
+    // Job queue
+    // startIn pushes the job on the ports into a queue of JOB_QUEUE
+    // descriptors, so later jobs may be started while one computes. The
+    // counters move to the next queued job one cycle after the last beat
+    // of the previous one, while its results are still in the MAC and
+    // post_process.v, and lastOut keeps the results of the jobs apart.
+    // dataBaseIn and filtBaseIn are element offsets of the matrices of a
+    // job within its bank. holdBankIn computes from the same bank as the
+    // previous job instead of swapping banks, so several small jobs can be
+    // loaded into one bank at different offsets and queued together.
+    // startIn is ignored while queueFullOut is high.
+    parameter JOB_QUEUE         = 4;
 
     // Derived RISCV bus parameters
     localparam BUS_WE_WIDTH     = BUS_DATA_WIDTH/8;
@@ -41,28 +156,150 @@ module cnn_hw_accelerator (
     // Derived RAM parameters
     localparam RAM_DEPTH        = MAX_SIZE/VECTOR_SIZE;
     localparam RAM_ADDR_WIDTH   = $clog2(RAM_DEPTH);
-    localparam RAM_DATA_WIDTH   = FRAC_WIDTH + EXP_WIDTH;
+    localparam RAM_DATA_WIDTH   = (MAC_STYLE == "INT8") ? 8 : FRAC_WIDTH + EXP_WIDTH;
     localparam RAM_WE_WIDTH     = RAM_DATA_WIDTH/8;
+    
+    // Derived accumulation parameters
+    localparam ACC_DATA_WIDTH   = ACC_FRAC_WIDTH + ACC_EXP_WIDTH;
+    
+    // Ping-pong buffering: each RAM holds two banks of RAM_DEPTH words
+    // Bus writes fill the load bank while a job reads the compute bank,
+    // the banks swap when startIn queues a job without holdBankIn
+    localparam NUM_BANKS        = 2;
+    localparam BANK_DEPTH       = RAM_DEPTH*NUM_BANKS;
+    
+    // Operation types
+    // OP_CONV: 2D convolution of data matrix with filter matrix
+    // OP_GEMM: matrix multiply, data RAM holds A (M x K, row-major) and
+    //          filter RAM holds B column-major (N x K), dataOut is C = A * B
+    //          row-major, dims are dataRowsIn = M, dataColsIn = filtColsIn = K
+    //          and filtRowsIn = N
+    localparam OP_CONV          = 0;
+    localparam OP_GEMM          = 1;
+    
+    // Convolution geometry (ignored for OP_GEMM)
+    // Stride and dilation are powers of two given as log2, padding adds
+    // padIn zero rows/columns on every side of the data matrix
+    // Dilated filters read VECTOR_SIZE >> dilationLog2In columns per beat
+    localparam STRIDE_WIDTH     = 2;
+    localparam PAD_WIDTH        = 4;
+    localparam DIL_WIDTH        = $clog2(VECTOR_SIZE_LOG2+1);
+    
+    // Signed data positions, padding makes them negative
+    localparam POS_WIDTH        = CNT_WIDTH + 2;
+    
+    // Derived line buffer parameters
+    localparam WIN_ROW_WIDTH    = (WINDOW_ROWS > 1) ? $clog2(WINDOW_ROWS) : 1;
+    
+    // Filter rows spanned by the lanes of a packed beat
+    localparam LANE_ROW_WIDTH   = VECTOR_SIZE_LOG2 + 1;
+    
+    // Requantization of INT8 accumulations
+    localparam QUANT_SHIFT_WIDTH = $clog2(2*ACC_DATA_WIDTH);
+    localparam QUANT_ZERO_WIDTH  = 8;
+    
+    // Activation types
+    localparam ACT_NONE         = 0;
+    localparam ACT_RELU         = 1;
+    localparam ACT_LEAKY        = 2;
+    
+    // Output FIFO depth in words
+    localparam FIFO_DEPTH       = 512;
+    
+    // Derived output parameters
+    localparam OUT_LANES        = OUT_DATA_WIDTH/ACC_DATA_WIDTH;
+    localparam COUNT_WIDTH      = $clog2(FIFO_DEPTH*OUT_LANES) + 1;
+    
+    // Credit-based flow control of the output FIFO
+    // Outputs whose last beat has been issued but whose result has not
+    // left post_process.v are counted in flight, one FIFO word each, until
+    // they reach the packer or are pooled away. A new output starts while
+    // the words in the FIFO, the outputs in flight and CREDIT_RESERVE fit
+    // in FIFO_DEPTH. The reserve covers a partial word and the register of
+    // output_packer.v and the outputs issued in the three cycles the
+    // credit check lags, 8 words (9 with OUT_LANES > 1) of the FIFO.
+    localparam CREDIT_RESERVE   = ((OUT_LANES > 1) ? 1 : 0) + 8;
+    localparam CREDIT_WIDTH     = $clog2(FIFO_DEPTH) + 2;
+    
+    // Performance counter parameters
+    localparam PERF_EVENTS      = 8;
+    localparam PERF_SEL_WIDTH   = $clog2(PERF_EVENTS);
+    localparam PERF_EVENT_WIDTH = VECTOR_SIZE_LOG2 + 1;
+    
+    // Job queue parameters
+    // JOB_DEPTH jobs may be past the counters with results still in the
+    // MAC, the depth of the job queue of post_process.v. Each of them
+    // tags its beats with a slot selecting its requantization.
+    localparam JOB_DEPTH        = 4;
+    localparam SLOT_WIDTH       = $clog2(JOB_DEPTH);
+    localparam QUEUE_ADDR_WIDTH = (JOB_QUEUE > 1) ? $clog2(JOB_QUEUE) : 1;
+    localparam QUEUE_CNT_WIDTH  = $clog2(JOB_QUEUE + 1);
+    localparam JOB_WIDTH        = 3*ACC_DATA_WIDTH + QUANT_SHIFT_WIDTH + QUANT_ZERO_WIDTH + STRIDE_WIDTH +
+                                  PAD_WIDTH + DIL_WIDTH + 7*CNT_WIDTH + 14;
       
     // Input/Output Ports
     input clkIn;
     input rstIn;
     
     input startIn;
+    input opTypeIn;
+    input [STRIDE_WIDTH-1:0] strideLog2In;
+    input [   PAD_WIDTH-1:0] padIn;
+    input [   DIL_WIDTH-1:0] dilationLog2In;
+    input packIn;
+    input [   ACC_DATA_WIDTH-1:0] quantMultIn;
+    input [QUANT_SHIFT_WIDTH-1:0] quantShiftIn;
+    input [ QUANT_ZERO_WIDTH-1:0] quantZeroIn;
+    input biasEnIn;
+    input [ACC_DATA_WIDTH-1:0] biasIn;
+    input [1:0] actIn;
+    input [ACC_DATA_WIDTH-1:0] slopeIn;
+    input [1:0] poolSizeIn;
+    input poolAvgIn;
     input [CNT_WIDTH:0] filtRowsIn;
     input [CNT_WIDTH:0] filtColsIn;
     input [CNT_WIDTH:0] dataRowsIn;
     input [CNT_WIDTH:0] dataColsIn;
     
+    // Input channels
+    // A convolution of channelsIn channels reads a stack of data planes of
+    // dataRowsIn rows (at the row pitch of the job) and a stack of filter
+    // planes of filtRowsIn x filtColsIn, both stored plane after plane from
+    // dataBaseIn and filtBaseIn. Every output accumulates its window over
+    // all planes before it leaves the MAC, so one job computes one output
+    // plane of a layer. 0 counts as a single channel, both stacks must fit
+    // in MAX_SIZE elements and the line buffer is not used. Matrix
+    // multiplies ignore it.
+    input [CNT_WIDTH:0] channelsIn;
+    input [CNT_WIDTH-1:0] dataBaseIn;
+    input [CNT_WIDTH-1:0] filtBaseIn;
+    input holdBankIn;
+    
     input [BUS_ADDR_WIDTH-1:0] addrIn;
     input [  BUS_WE_WIDTH-1:0] wrEnIn;
     input [BUS_DATA_WIDTH-1:0] wrDataIn;
     
     input  readyIn;
+    output busyOut;
+    output queueFullOut;
     output validOut;
-    output [RAM_DATA_WIDTH-1:0] dataOut;
+    output [OUT_DATA_WIDTH-1:0] dataOut;
+    output [     OUT_LANES-1:0] keepOut;
+    output lastOut;
+    output [   COUNT_WIDTH-1:0] countOut;
+    
+    input  perfStartIn;
+    input  perfStopIn;
+    input  perfClearIn;
+    input  [PERF_SEL_WIDTH-1:0] perfSelIn;
+    output [    PERF_WIDTH-1:0] perfDataOut;
+    
+    // Ping-pong bank selects
+    reg loadBankR;
+    reg computeBankR;
     
     // Bus write registers
+    reg busBankR;
     reg [RAM_ADDR_WIDTH-1:0] busAddrR;
     reg [RAM_DATA_WIDTH-1:0] busWrDataR [0:VECTOR_SIZE-1];
     reg [  RAM_WE_WIDTH-1:0] busWrEnR [0:1][0:VECTOR_SIZE-1];
@@ -128,33 +365,128 @@ module cnn_hw_accelerator (
         
         // Select only required bits of address
         always @(posedge clkIn) begin
+            busBankR <= loadBankR;
             busAddrR <= busAddr[RAM_ADDR_WIDTH-1:0];
         end        
     endgenerate
     
     // State Definitions
-    localparam IDLE = 0;
-    localparam CALC = 1;
+    // START clears the counters with the end values of the job just taken
+    // from the queue
+    localparam IDLE  = 0;
+    localparam START = 1;
+    localparam CALC  = 2;
     
     // Parameters for selecting subregions of column counts
-    localparam FILT_COL_CNT_WIDTH = CNT_WIDTH - VECTOR_SIZE_LOG2;
-    localparam FILT_COL_CNT_LO    = VECTOR_SIZE_LOG2;
-    localparam FILT_COL_CNT_HI    = CNT_WIDTH - 1;
+    // Filter columns are counted in beats of VECTOR_SIZE >> dilation
+    localparam FILT_COL_CNT_WIDTH = CNT_WIDTH;
+    
+    // Job queue, every descriptor holds the ports sampled with startIn and
+    // the bank the job computes from
+    reg [JOB_WIDTH-1:0] jobQueueR [0:JOB_QUEUE-1];
+    reg [QUEUE_ADDR_WIDTH-1:0] queueWrPtrR;
+    reg [QUEUE_ADDR_WIDTH-1:0] queueRdPtrR;
+    reg [QUEUE_CNT_WIDTH-1:0] queueCntR;
+    
+    // Jobs taken from the queue whose last result has not left the MAC
+    reg [SLOT_WIDTH:0] inFlightR;
+    
+    // Output FIFO credits, high while another output may be issued
+    reg creditReadyR;
+    
+    wire queueFull;
+    wire jobPush;
+    wire jobPop;
+    
+    // Job at the head of the queue
+    wire jobBank;
+    wire jobOpType;
+    wire [STRIDE_WIDTH-1:0] jobStrideLog2;
+    wire [   PAD_WIDTH-1:0] jobPad;
+    wire [   DIL_WIDTH-1:0] jobDilationLog2;
+    wire jobPack;
+    wire [   ACC_DATA_WIDTH-1:0] jobQuantMult;
+    wire [QUANT_SHIFT_WIDTH-1:0] jobQuantShift;
+    wire [ QUANT_ZERO_WIDTH-1:0] jobQuantZero;
+    wire jobBiasEn;
+    wire [ACC_DATA_WIDTH-1:0] jobBias;
+    wire [1:0] jobAct;
+    wire [ACC_DATA_WIDTH-1:0] jobSlope;
+    wire [1:0] jobPoolSize;
+    wire jobPoolAvg;
+    wire [CNT_WIDTH:0] jobFiltRows;
+    wire [CNT_WIDTH:0] jobFiltCols;
+    wire [CNT_WIDTH:0] jobDataRows;
+    wire [CNT_WIDTH:0] jobDataCols;
+    wire [CNT_WIDTH:0] jobChannels;
+    wire [CNT_WIDTH-1:0] jobDataBase;
+    wire [CNT_WIDTH-1:0] jobFiltBase;
+    
+    assign {jobBank, jobOpType, jobStrideLog2, jobPad, jobDilationLog2, jobPack, jobQuantMult, jobQuantShift,
+            jobQuantZero, jobBiasEn, jobBias, jobAct, jobSlope, jobPoolSize, jobPoolAvg, jobFiltRows, jobFiltCols,
+            jobDataRows, jobDataCols, jobChannels, jobDataBase, jobFiltBase} = jobQueueR[queueRdPtrR];
     
     // FSM registers
-    reg stateR;
+    reg [1:0] stateR;
     reg validR;
+    reg opTypeR;
+    reg [STRIDE_WIDTH-1:0] strideR;
+    reg [   PAD_WIDTH-1:0] padR;
+    reg [   DIL_WIDTH-1:0] dilR;
+    reg [   DIL_WIDTH-1:0] dilVar;
+    reg windowR;
+    reg packR;
+    reg packVar;
     
     reg [VECTOR_SIZE_LOG2-1:0] lastRdCntR;
     
     reg [CNT_WIDTH-1:0] maxFiltColCntVar;
+    reg [CNT_WIDTH-1:0] maxBeatCntVar;
     reg [FILT_COL_CNT_WIDTH-1:0] maxFiltColCntR;
     reg [CNT_WIDTH-1:0] maxFiltRowCntR;
+    reg [CNT_WIDTH-1:0] maxChanCntR;
     reg [CNT_WIDTH-1:0] maxDataColCntR;
     reg [CNT_WIDTH-1:0] maxDataRowCntR;
     
     reg [CNT_WIDTH:0] filtColsR;
     reg [CNT_WIDTH:0] dataColsR;
+    reg [CNT_WIDTH:0] dataRowsR;
+    reg [CNT_WIDTH:0] dataPitchR;
+    reg [CNT_WIDTH-1:0] dataBaseR;
+    reg [CNT_WIDTH-1:0] filtBaseR;
+    
+    // Elements between the planes of the channel stacks
+    reg [CNT_WIDTH-1:0] dataPlaneR;
+    reg [CNT_WIDTH-1:0] filtPlaneR;
+    reg [CNT_WIDTH:0] dataPitchVar;
+    
+    // Packed beat step in filter rows and columns (VECTOR_SIZE elements)
+    reg [CNT_WIDTH-1:0] packGapR;
+    reg [LANE_ROW_WIDTH-1:0] packRowStepR;
+    reg [CNT_WIDTH:0] packColStepR;
+    reg [LANE_ROW_WIDTH-1:0] packRowStepVar;
+    reg [CNT_WIDTH:0] packColStepVar;
+    
+    // Requantization of the jobs in flight
+    // Results are tagged with the slot of their job, so the next job may
+    // start while the previous ones drain
+    reg [SLOT_WIDTH-1:0] slotR;
+    reg [   ACC_DATA_WIDTH-1:0] quantMultR  [0:JOB_DEPTH-1];
+    reg [QUANT_SHIFT_WIDTH-1:0] quantShiftR [0:JOB_DEPTH-1];
+    reg [ QUANT_ZERO_WIDTH-1:0] quantZeroR  [0:JOB_DEPTH-1];
+    reg [   ACC_DATA_WIDTH-1:0] quantBiasR  [0:JOB_DEPTH-1];
+    reg quantReluR [0:JOB_DEPTH-1];
+    
+    // Post-processing of the job just started, queued by post_process.v
+    // the cycle after it leaves the queue together with its output
+    // dimensions
+    reg postJobR;
+    reg postBiasEnR;
+    reg [ACC_DATA_WIDTH-1:0] postBiasR;
+    reg [1:0] postActR;
+    reg [ACC_DATA_WIDTH-1:0] postSlopeR;
+    reg [1:0] postPoolSizeR;
+    reg postPoolAvgR;
     
     // Filter Column Counter
     wire filtColAdv;
@@ -168,6 +500,12 @@ module cnn_hw_accelerator (
     wire filtRowDoneR;
     wire [CNT_WIDTH-1:0] filtRowCntR;
     
+    // Channel Counter
+    wire chanAdv;
+    wire chanClr;
+    wire chanDoneR;
+    wire [CNT_WIDTH-1:0] chanCntR;
+    
     // Data Column Counter
     wire dataColAdv;
     wire dataColClr;
@@ -180,58 +518,222 @@ module cnn_hw_accelerator (
     wire dataRowDoneR;
     wire [CNT_WIDTH-1:0] dataRowCntR;
     
+    // Last beat of an output and stall of the counters on it while no
+    // output FIFO credits remain
+    wire outDone;
+    wire outStall;
+    
     // Done signal
     wire done;
     
+    // A job is pushed unless the queue is full and taken from it once the
+    // previous job is done, as long as fewer than JOB_DEPTH are in flight
+    assign queueFull = (queueCntR == JOB_QUEUE);
+    assign jobPush   = startIn & !queueFull;
+    assign jobPop    = (queueCntR != 0) && (inFlightR != JOB_DEPTH) &&
+                       ((stateR == IDLE) || ((stateR == CALC) && done));
+    
+    // Job Queue Process
+    always @(posedge clkIn) begin
+        if (jobPush) begin
+            jobQueueR[queueWrPtrR] <= {holdBankIn ? !loadBankR : loadBankR, opTypeIn, strideLog2In, padIn,
+                                       dilationLog2In, packIn, quantMultIn, quantShiftIn, quantZeroIn, biasEnIn,
+                                       biasIn, actIn, slopeIn, poolSizeIn, poolAvgIn, filtRowsIn, filtColsIn,
+                                       dataRowsIn, dataColsIn, channelsIn, dataBaseIn, filtBaseIn};
+        end
+    end
+    
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            loadBankR       <= 0;
+            queueWrPtrR     <= 0;
+            queueRdPtrR     <= 0;
+            queueCntR       <= 0;
+        end else begin
+            if (jobPush) begin
+                queueWrPtrR     <= (queueWrPtrR == JOB_QUEUE - 1) ? 0 : queueWrPtrR + 1;
+                
+                // Later loads go to the other bank unless the job holds
+                // the bank of the previous one
+                if (!holdBankIn) begin
+                    loadBankR       <= !loadBankR;
+                end
+            end
+            if (jobPop) begin
+                queueRdPtrR     <= (queueRdPtrR == JOB_QUEUE - 1) ? 0 : queueRdPtrR + 1;
+            end
+            queueCntR       <= queueCntR + jobPush - jobPop;
+        end
+    end
+    
     // Read state machine
     always @(posedge clkIn) begin
         if (rstIn) begin
             stateR          <= IDLE;
             validR          <= 0;
+            computeBankR    <= 0;
+            slotR           <= 0;
+            opTypeR         <= OP_CONV;
+            strideR         <= 0;
+            padR            <= 0;
+            dilR            <= 0;
+            windowR         <= 0;
+            packR           <= 0;
             lastRdCntR      <= 0;
             maxFiltColCntR  <= 0;
             maxFiltRowCntR  <= 0;
+            maxChanCntR     <= 0;
             maxDataColCntR  <= 0;
             maxDataRowCntR  <= 0;
             filtColsR       <= 0;
             dataColsR       <= 0;
+            dataRowsR       <= 0;
+            dataPitchR      <= 0;
+            dataBaseR       <= 0;
+            filtBaseR       <= 0;
+            dataPlaneR      <= 0;
+            filtPlaneR      <= 0;
+            packGapR        <= 0;
+            packRowStepR    <= 0;
+            packColStepR    <= 0;
+            postJobR        <= 0;
         end else begin
+            postJobR        <= 0;
             case (stateR)
                 IDLE : begin
-                    maxFiltColCntVar = filtColsIn - 1;
-                    lastRdCntR      <= maxFiltColCntVar[FILT_COL_CNT_LO-1:0];
-                    maxFiltColCntR  <= maxFiltColCntVar[FILT_COL_CNT_HI:FILT_COL_CNT_LO];
-                    maxFiltRowCntR  <= filtRowsIn - 1;
-                    maxDataColCntR  <= dataColsIn - filtColsIn;
-                    maxDataRowCntR  <= dataRowsIn - filtRowsIn;
-                    filtColsR       <= filtColsIn;
-                    dataColsR       <= dataColsIn;
-                    if (startIn) begin
+                    if (jobPop) begin
+                        stateR      <= START;
+                    end
+                end
+                START : begin
+                    // Counters clear with the new end values
+                    if (creditReadyR) begin
                         validR      <= 1;
                         stateR      <= CALC;
                     end
                 end
                 CALC : begin
+                    // Move straight to the next queued job, the results
+                    // of this one drain behind it
                     if (done) begin
                         validR      <= 0;
-                        stateR      <= IDLE;
+                        stateR      <= jobPop ? START : IDLE;
                     end
                 end
             endcase
+            
+            // Latch the job at the head of the queue
+            if (jobPop) begin
+                dilVar           = (jobOpType == OP_GEMM) ? 0 : jobDilationLog2;
+                packVar          = PACKING && jobPack && (jobOpType == OP_CONV) && (jobDilationLog2 == 0);
+                maxFiltColCntVar = jobFiltCols - 1;
+                
+                // A packed filter is walked as a single row of
+                // jobFiltRows * jobFiltCols elements
+                maxBeatCntVar    = packVar ? (jobFiltRows * jobFiltCols - 1) : maxFiltColCntVar;
+                opTypeR         <= jobOpType;
+                dilR            <= dilVar;
+                packR           <= packVar;
+                lastRdCntR      <= maxBeatCntVar & ((VECTOR_SIZE >> dilVar) - 1);
+                maxFiltColCntR  <= maxBeatCntVar >> (VECTOR_SIZE_LOG2 - dilVar);
+                if (jobOpType == OP_GEMM) begin
+                    // One row of A against one column of B per output
+                    // Data column counter walks the columns of B
+                    strideR         <= 0;
+                    padR            <= 0;
+                    maxFiltRowCntR  <= 0;
+                    maxChanCntR     <= 0;
+                    maxDataColCntR  <= jobFiltRows - 1;
+                    maxDataRowCntR  <= jobDataRows - 1;
+                end else begin
+                    // Last output position of the padded data matrix
+                    strideR         <= jobStrideLog2;
+                    padR            <= jobPad;
+                    maxFiltRowCntR  <= packVar ? 0 : jobFiltRows - 1;
+                    maxChanCntR     <= (jobChannels == 0) ? 0 : jobChannels - 1;
+                    maxDataColCntR  <= (jobDataCols + 2*jobPad - (maxFiltColCntVar << dilVar) - 1) >> jobStrideLog2;
+                    maxDataRowCntR  <= (jobDataRows + 2*jobPad - ((jobFiltRows - 1) << dilVar) - 1) >> jobStrideLog2;
+                end
+                filtColsR       <= jobFiltCols;
+                dataColsR       <= jobDataCols;
+                dataRowsR       <= jobDataRows;
+                dataBaseR       <= jobDataBase;
+                filtBaseR       <= jobFiltBase;
+                
+                // Window of each filter row fits in one beat, and stays
+                // in the line buffer as long as a single channel is read
+                windowR         <= LINE_BUFFER && !packVar && (jobOpType == OP_CONV) && (jobDilationLog2 == 0) &&
+                                   (jobFiltCols <= VECTOR_SIZE) && (jobFiltRows <= WINDOW_ROWS) &&
+                                   (jobChannels <= 1);
+                
+                // Packed rows are pitched so that the gap between the end
+                // of a filter row and the start of the next one in the
+                // data RAM is a multiple of VECTOR_SIZE
+                if (packVar) begin
+                    dataPitchVar = jobDataCols + ((jobFiltCols - jobDataCols) & (VECTOR_SIZE - 1));
+                    packGapR    <= dataPitchVar - jobFiltCols;
+                end else begin
+                    dataPitchVar = jobDataCols;
+                    packGapR    <= 0;
+                end
+                dataPitchR      <= dataPitchVar;
+
+                // Planes of the channel stacks follow each other
+                dataPlaneR      <= jobDataRows * dataPitchVar;
+                filtPlaneR      <= jobFiltRows * jobFiltCols;
+                
+                // VECTOR_SIZE = packRowStep * jobFiltCols + packColStep
+                packRowStepVar = 0;
+                packColStepVar = VECTOR_SIZE;
+                for (j = 0; j < VECTOR_SIZE; j = j + 1) begin
+                    if (packColStepVar >= jobFiltCols) begin
+                        packColStepVar = packColStepVar - jobFiltCols;
+                        packRowStepVar = packRowStepVar + 1;
+                    end
+                end
+                packRowStepR    <= packRowStepVar;
+                packColStepR    <= packColStepVar;
+                
+                // Compute from the bank of the job, with its
+                // requantization in the next slot
+                computeBankR    <= jobBank;
+                slotR           <= slotR + 1;
+                quantMultR [slotR] <= jobQuantMult;
+                quantShiftR[slotR] <= jobQuantShift;
+                quantZeroR [slotR] <= jobQuantZero;
+                quantBiasR [slotR] <= jobBiasEn ? jobBias : 0;
+                quantReluR [slotR] <= (jobAct != ACT_NONE);
+                postJobR        <= 1;
+                postBiasEnR     <= jobBiasEn;
+                postBiasR       <= jobBias;
+                postActR        <= jobAct;
+                postSlopeR      <= jobSlope;
+                postPoolSizeR   <= jobPoolSize;
+                postPoolAvgR    <= jobPoolAvg;
+            end
         end
     end
     
     // Counter control signals
-    assign dataRowAdv = filtColDoneR & filtRowDoneR & dataColDoneR & fifoWrReady;
-    assign dataRowClr = !validR & fifoWrReady;
+    // Filter columns, filter rows and channels walk the window of one
+    // output. The counters hold on its last beat until a credit moves
+    // them to the next output, instead of walking the last row again.
+    assign outDone    = filtColDoneR & filtRowDoneR & chanDoneR;
+    assign outStall   = outDone & !creditReadyR;
     
-    assign dataColAdv = filtColDoneR & filtRowDoneR & fifoWrReady;
+    assign dataRowAdv = outDone & dataColDoneR & creditReadyR;
+    assign dataRowClr = !validR & creditReadyR;
+    
+    assign dataColAdv = outDone & creditReadyR;
     assign dataColClr = dataRowClr | dataRowAdv;
     
-    assign filtRowAdv = filtColDoneR;
-    assign filtRowClr = dataColClr | dataColAdv;
+    assign chanAdv    = filtColDoneR & filtRowDoneR & !outStall;
+    assign chanClr    = dataColClr | dataColAdv;
+    
+    assign filtRowAdv = filtColDoneR & !outStall;
+    assign filtRowClr = chanClr | (chanAdv & !chanClr);
     
-    assign filtColAdv = 1;
+    assign filtColAdv = !outStall;
     assign filtColClr = filtRowClr | (filtRowAdv & !filtRowClr);
        
     // Filter Column Index Counter
@@ -255,6 +757,17 @@ module cnn_hw_accelerator (
         .endValIn(maxFiltRowCntR),
         .cntOut(filtRowCntR),
         .doneOut(filtRowDoneR));
+    
+    // Channel Index Counter
+    counter #(
+        .CNT_WIDTH(CNT_WIDTH)) chan_cnt (
+        .clkIn(clkIn),
+        .rstIn(1'b0),
+        .clrIn(chanClr),
+        .advIn(chanAdv),
+        .endValIn(maxChanCntR),
+        .cntOut(chanCntR),
+        .doneOut(chanDoneR));
         
     // Data Column Index Counter
     counter #(
@@ -279,29 +792,107 @@ module cnn_hw_accelerator (
         .doneOut(dataRowDoneR));
         
     // Done signal for 2D Convolution 
-    assign done = filtColDoneR & filtRowDoneR & dataColDoneR & dataRowDoneR;
+    assign done = outDone & dataColDoneR & dataRowDoneR;
+    
+    // Offsets of the data and filter planes of the channel
+    // Follow the channel counter
+    reg [CNT_WIDTH-1:0] chanDataOffR;
+    reg [CNT_WIDTH-1:0] chanFiltOffR;
+    
+    always @(posedge clkIn) begin
+        if (chanClr) begin
+            chanDataOffR    <= 0;
+            chanFiltOffR    <= 0;
+        end else if (chanAdv && !chanDoneR) begin
+            chanDataOffR    <= chanDataOffR + dataPlaneR;
+            chanFiltOffR    <= chanFiltOffR + filtPlaneR;
+        end
+    end
+    
+    // Filter row and column of the first lane of a packed beat
+    // Follows the filter column counter
+    reg [CNT_WIDTH-1:0] packRowR;
+    reg [CNT_WIDTH:0] packColR;
+    reg [CNT_WIDTH-1:0] packRowVar;
+    reg [CNT_WIDTH:0] packColVar;
+    
+    always @(posedge clkIn) begin
+        if (filtColClr) begin
+            packRowR    <= 0;
+            packColR    <= 0;
+        end else if (filtColAdv && !filtColDoneR) begin
+            packRowVar  = packRowR + packRowStepR;
+            packColVar  = packColR + packColStepR;
+            if (packColVar >= filtColsR) begin
+                packColVar  = packColVar - filtColsR;
+                packRowVar  = packRowVar + 1;
+            end
+            packRowR    <= packRowVar;
+            packColR    <= packColVar;
+        end
+    end
     
     // Pipeline #2
+    reg bank2R;
+    reg [SLOT_WIDTH-1:0] slot2R;
     reg last2R;
+    reg [DIL_WIDTH-1:0] dil2R;
+    reg win2R;
+    reg [WIN_ROW_WIDTH-1:0] winRow2R;
+    reg [STRIDE_WIDTH-1:0] stride2R;
     reg [CNT_WIDTH:0] dataCols2R;
-    reg [CNT_WIDTH-1:0] dataRowCnt2R;
-    reg [CNT_WIDTH-1:0] dataColCnt2R;
+    reg [CNT_WIDTH:0] dataRows2R;
+    reg [CNT_WIDTH:0] dataPitch2R;
+    reg [CNT_WIDTH-1:0] dataBase2R;
+    reg [CNT_WIDTH-1:0] packGap2R;
+    reg [LANE_ROW_WIDTH-1:0] laneRow2R [0:VECTOR_SIZE-1];
+    reg signed [POS_WIDTH-1:0] laneCol2R [0:VECTOR_SIZE-1];
+    reg [LANE_ROW_WIDTH-1:0] laneRowVar;
+    reg signed [POS_WIDTH-1:0] laneColVar;
+    reg [CNT_WIDTH:0] laneFiltColVar;
+    reg signed [POS_WIDTH-1:0] dataRowPos2R;
+    reg signed [POS_WIDTH-1:0] dataColPos2R;
     reg [CNT_WIDTH-1:0] filtRowAddr2R;
     reg [CNT_WIDTH-1:0] filtColAddr2R;
     
     // Pipeline #3
+    reg bank3R;
+    reg [SLOT_WIDTH-1:0] slot3R;
     reg last3R;
+    reg [DIL_WIDTH-1:0] dil3R;
+    reg win3R;
+    reg [WIN_ROW_WIDTH-1:0] winRow3R;
+    reg [STRIDE_WIDTH-1:0] stride3R;
     reg [CNT_WIDTH-1:0] dataRowAddr3R;
     reg [CNT_WIDTH-1:0] dataColAddr3R;
     reg [CNT_WIDTH-1:0] filtAddr3R;
+    reg [VECTOR_SIZE-1:0] pad3R;
+    reg signed [POS_WIDTH-1:0] dataColPosVar;
+    reg signed [POS_WIDTH-1:0] dataRowPosVar;
+    reg [CNT_WIDTH-1:0] laneOff3R [0:VECTOR_SIZE-1];
     
     // Pipeline #4
+    reg bank4R;
+    reg [SLOT_WIDTH-1:0] slot4R;
     reg last4R;
+    reg [DIL_WIDTH-1:0] dil4R;
+    reg win4R;
+    reg [WIN_ROW_WIDTH-1:0] winRow4R;
+    reg [STRIDE_WIDTH-1:0] stride4R;
     reg [CNT_WIDTH-1:0] dataAddr4R;
     reg [CNT_WIDTH-1:0] filtAddr4R;
+    reg [VECTOR_SIZE-1:0] pad4R;
+    reg [CNT_WIDTH-1:0] laneOff4R [0:VECTOR_SIZE-1];
     
     // Pipeline #5
+    reg bank5R;
+    reg [SLOT_WIDTH-1:0] slot5R;
     reg last5R;
+    reg [DIL_WIDTH-1:0] dil5R;
+    reg win5R;
+    reg [WIN_ROW_WIDTH-1:0] winRow5R;
+    reg [STRIDE_WIDTH-1:0] stride5R;
+    reg [VECTOR_SIZE-1:0] pad5R;
     reg [VECTOR_SIZE_LOG2-1:0] dataShift5R;
     reg [VECTOR_SIZE_LOG2-1:0] filtShift5R;
     reg [CNT_WIDTH-1:0] dataAddrVar;
@@ -310,7 +901,13 @@ module cnn_hw_accelerator (
     reg [RAM_ADDR_WIDTH*VECTOR_SIZE-1:0] filtAddr5R;
     
     // Pipeline #6
+    reg bank6R;
+    reg [SLOT_WIDTH-1:0] slot6R;
     reg last6R;
+    reg [DIL_WIDTH-1:0] dil6R;
+    reg win6R;
+    reg [WIN_ROW_WIDTH-1:0] winRow6R;
+    reg [STRIDE_WIDTH-1:0] stride6R;
     reg [VECTOR_SIZE_LOG2-1:0] dataShift6R;
     reg [VECTOR_SIZE_LOG2-1:0] filtShift6R;
     reg [RAM_ADDR_WIDTH*VECTOR_SIZE-1:0] dataAddr6R;
@@ -320,26 +917,107 @@ module cnn_hw_accelerator (
     always @(posedge clkIn) begin
     
         // Pipeline #2
-        last2R        <= filtColDoneR & filtRowDoneR;
+        bank2R        <= computeBankR;
+        slot2R        <= slotR - 1;     // slotR is the slot of the next job
+        last2R        <= outDone;
+        dil2R         <= dilR;
+        win2R         <= windowR;
+        winRow2R      <= filtRowCntR[WIN_ROW_WIDTH-1:0];
+        stride2R      <= strideR;
         dataCols2R    <= dataColsR;
-        dataRowCnt2R  <= dataRowCntR + filtRowCntR;
-        dataColCnt2R  <= dataColCntR + {filtColCntR, {FILT_COL_CNT_LO{1'b0}}};
-        filtRowAddr2R <= filtRowCntR * filtColsR;
-        filtColAddr2R <= {filtColCntR, {FILT_COL_CNT_LO{1'b0}}};
+        dataRows2R    <= dataRowsR;
+        dataPitch2R   <= dataPitchR;
+        dataBase2R    <= dataBaseR + chanDataOffR;
+        packGap2R     <= packGapR;
+        
+        // Filter row and column offset of every lane from the first lane
+        // Packed lanes wrap to the next filter row after filtColsR columns,
+        // otherwise lane j is column j << dilation of the same row
+        laneRowVar      = 0;
+        laneColVar      = 0;
+        laneFiltColVar  = packColR;
+        for (j = 0; j < VECTOR_SIZE; j = j + 1) begin
+            if (packR) begin
+                laneRow2R[j]    <= laneRowVar;
+                laneCol2R[j]    <= laneColVar;
+            end else begin
+                laneRow2R[j]    <= 0;
+                laneCol2R[j]    <= j << dilR;
+            end
+            laneColVar      = laneColVar + 1;
+            laneFiltColVar  = laneFiltColVar + 1;
+            if (laneFiltColVar == filtColsR) begin
+                laneFiltColVar  = 0;
+                laneRowVar      = laneRowVar + 1;
+                laneColVar      = laneColVar - filtColsR;
+            end
+        end
+        
+        // A beat covers VECTOR_SIZE >> dilation filter columns, which are
+        // spread over VECTOR_SIZE data columns
+        filtColAddr2R <= filtColCntR << (VECTOR_SIZE_LOG2 - dilR);
+        
+        // Matrix multiply reads row dataRowCnt of A and row dataColCnt of
+        // column-major B, filter row count is always zero
+        // Addresses are offset by the bases of the job within its bank
+        if (opTypeR == OP_GEMM) begin
+            dataRowPos2R  <= dataRowCntR;
+            dataColPos2R  <= filtColCntR << VECTOR_SIZE_LOG2;
+            filtRowAddr2R <= dataColCntR * filtColsR + filtBaseR;
+        end else begin
+            dataRowPos2R  <= (dataRowCntR << strideR) + (filtRowCntR << dilR) + (packR ? packRowR : 0) - padR;
+            dataColPos2R  <= (dataColCntR << strideR) + (packR ? packColR : (filtColCntR << VECTOR_SIZE_LOG2)) - padR;
+            filtRowAddr2R <= filtRowCntR * filtColsR + filtBaseR + chanFiltOffR;
+        end
         
         // Pipeline #3
+        bank3R        <= bank2R;
+        slot3R        <= slot2R;
         last3R        <= last2R;
-        dataRowAddr3R <= dataRowCnt2R * dataCols2R;
-        dataColAddr3R <= dataColCnt2R;
+        dil3R         <= dil2R;
+        win3R         <= win2R;
+        winRow3R      <= winRow2R;
+        stride3R      <= stride2R;
+        dataRowAddr3R <= dataRowPos2R[CNT_WIDTH-1:0] * dataPitch2R + dataBase2R;
+        dataColAddr3R <= dataColPos2R[CNT_WIDTH-1:0];
         filtAddr3R    <= filtRowAddr2R + filtColAddr2R;
         
+        // Lanes outside the data matrix are padding
+        for (j = 0; j < VECTOR_SIZE; j = j + 1) begin
+            dataRowPosVar = dataRowPos2R + $signed({1'b0, laneRow2R[j]});
+            dataColPosVar = dataColPos2R + laneCol2R[j];
+            pad3R[j]      <= (dataRowPosVar < 0) || (dataRowPosVar >= $signed({1'b0, dataRows2R})) ||
+                             (dataColPosVar < 0) || (dataColPosVar >= $signed({1'b0, dataCols2R}));
+            
+            // Lanes of later filter rows skip the pitch gap, which keeps
+            // every lane in the bank it would have without packing
+            laneOff3R[j]  <= j + laneRow2R[j] * packGap2R;
+        end
+        
         // Pipeline #4
+        bank4R        <= bank3R;
+        slot4R        <= slot3R;
         last4R        <= last3R;
+        dil4R         <= dil3R;
+        win4R         <= win3R;
+        winRow4R      <= winRow3R;
+        stride4R      <= stride3R;
+        pad4R         <= pad3R;
+        for (j = 0; j < VECTOR_SIZE; j = j + 1) begin
+            laneOff4R[j]  <= laneOff3R[j];
+        end
         dataAddr4R    <= dataRowAddr3R + dataColAddr3R;
         filtAddr4R    <= filtAddr3R;
         
         // Pipeline #5
+        bank5R        <= bank4R;
+        slot5R        <= slot4R;
         last5R        <= last4R;
+        dil5R         <= dil4R;
+        win5R         <= win4R;
+        winRow5R      <= winRow4R;
+        stride5R      <= stride4R;
+        pad5R         <= pad4R;
 
         // Determine shift required to access correct RAM bank
         dataShift5R   <= dataAddr4R[(VECTOR_SIZE_LOG2-1):0];
@@ -347,7 +1025,7 @@ module cnn_hw_accelerator (
         
         // Determine addresses for each RAM bank
         for (j = 0; j < VECTOR_SIZE; j = j + 1) begin
-            dataAddrVar  = dataAddr4R + j;
+            dataAddrVar  = dataAddr4R + laneOff4R[j];
             filtAddrVar  = filtAddr4R + j;
             
             dataAddr5R[(j*RAM_ADDR_WIDTH)+:RAM_ADDR_WIDTH] <= dataAddrVar[VECTOR_SIZE_LOG2+:RAM_ADDR_WIDTH];            
@@ -355,7 +1033,13 @@ module cnn_hw_accelerator (
         end
         
         // Pipeline #6
+        bank6R      <= bank5R;
+        slot6R      <= slot5R;
         last6R      <= last5R;
+        dil6R       <= dil5R;
+        win6R       <= win5R;
+        winRow6R    <= winRow5R;
+        stride6R    <= stride5R;
         dataShift6R <= dataShift5R;
         filtShift6R <= filtShift5R;
         
@@ -370,18 +1054,27 @@ module cnn_hw_accelerator (
     reg [VECTOR_SIZE-1:0] rdEn2R;
     reg valid2R;
     
+    reg [VECTOR_SIZE-1:0] reuse2R;
+    
     // Pipeline #3
     reg [VECTOR_SIZE-1:0] rdEn3R;
+    reg [VECTOR_SIZE-1:0] reuse3R;
     
     // Pipeline #4
     reg [VECTOR_SIZE-1:0] rdEn4R;
+    reg [VECTOR_SIZE-1:0] reuse4R;
     
     // Pipeline #5
     reg [VECTOR_SIZE-1:0] rdEn5R;
+    reg [VECTOR_SIZE-1:0] reuse5R;
     
     // Pipeline #6
+    reg [VECTOR_SIZE-1:0] dataRdEnVar;
     reg [VECTOR_SIZE-1:0] dataRdEn6R;
     reg [VECTOR_SIZE-1:0] filtRdEn6R;
+    reg [VECTOR_SIZE-1:0] laneValid6R;
+    reg [VECTOR_SIZE-1:0] laneZero6R;
+    reg [VECTOR_SIZE-1:0] laneReuse6R;
     
     // Read Enable Process
     always @(posedge clkIn) begin
@@ -389,22 +1082,32 @@ module cnn_hw_accelerator (
             throttleR   <= 0;
             valid2R     <= 0;
             rdEn2R      <= 0;
+            reuse2R     <= 0;
             rdEn3R      <= 0;
+            reuse3R     <= 0;
             rdEn4R      <= 0;
+            reuse4R     <= 0;
             rdEn5R      <= 0;
+            reuse5R     <= 0;
             dataRdEn6R  <= 0;
             filtRdEn6R  <= 0;
+            laneValid6R <= 0;
+            laneZero6R  <= 0;
+            laneReuse6R <= 0;
         end else begin
         
             // Pipeline #1
-            throttleR   <= filtColDoneR & filtRowDoneR & !fifoWrReady;
+            throttleR   <= outStall;
 	    
             // Pipeline #2
             valid2R     <= validR & !throttleR;
             
             // Determine which bits of read enable are high
+            // Bit j enables filter column j of the beat
             for (j = 0; j < VECTOR_SIZE; j = j + 1) begin
-                if (filtColDoneR) begin
+                if (j >= (VECTOR_SIZE >> dilR)) begin
+                    rdEn2R[j] <= 0;
+                end else if (filtColDoneR) begin
                     if (j <= lastRdCntR) begin
                         rdEn2R[j] <= 1;
                     end else begin
@@ -413,6 +1116,10 @@ module cnn_hw_accelerator (
                 end else begin
                     rdEn2R[j] <= 1;
                 end
+                
+                // After the first output of a row, the line buffer already
+                // holds all but the last (1 << stride) columns of the window
+                reuse2R[j] <= windowR && (dataColCntR != 0) && (j + (1 << strideR) < filtColsR);
             end
             
             // Pipeline #3
@@ -421,20 +1128,43 @@ module cnn_hw_accelerator (
             end else begin
                 rdEn3R  <= 0;
             end
+            reuse3R     <= reuse2R;
             
             // Pipeline #4
             rdEn4R      <= rdEn3R;
+            reuse4R     <= reuse3R;
             
             // Pipeline #5
             rdEn5R      <= rdEn4R;
+            reuse5R     <= reuse4R;
             
             // Pipeline #6
+            // Filter column j reads data column j << dilation
+            // Padding and line buffer lanes are not read from RAM
+            for (j = 0; j < VECTOR_SIZE; j = j + 1) begin
+                dataRdEnVar[j] = ((j & ((1 << dil5R) - 1)) == 0) && rdEn5R[j >> dil5R] &&
+                                 !pad5R[j >> dil5R] && !reuse5R[j >> dil5R];
+            end
+            
             // Circular shift
-            dataRdEn6R  <= (rdEn5R << dataShift5R) | (rdEn5R >> (VECTOR_SIZE - dataShift5R));
+            dataRdEn6R  <= (dataRdEnVar << dataShift5R) | (dataRdEnVar >> (VECTOR_SIZE - dataShift5R));
             filtRdEn6R  <= (rdEn5R << filtShift5R) | (rdEn5R >> (VECTOR_SIZE - filtShift5R));
+            
+            // Lanes seen by the multipliers, padding lanes are zero
+            laneValid6R <= rdEn5R;
+            laneZero6R  <= pad5R;
+            laneReuse6R <= reuse5R;
         end
     end
     
+    // Busy until the last read of the queued jobs has been issued
+    // The host must not start a job swapping banks while busy, as its next
+    // loads go to the bank that is still being read. Jobs holding the bank
+    // only need room in the queue.
+    assign busyOut      = (queueCntR != 0) | (stateR != IDLE) | valid2R | (|rdEn3R) | (|rdEn4R) | (|rdEn5R) |
+                          (|dataRdEn6R);
+    assign queueFullOut = queueFull;
+    
     // RAM constants
     localparam WREN_ZERO  = {  RAM_WE_WIDTH{1'b0}};
     localparam DATA_ZERO  = {RAM_DATA_WIDTH{1'b0}};
@@ -450,23 +1180,33 @@ module cnn_hw_accelerator (
     
     // Common RAM signals
     wire [VECTOR_SIZE-1:0] ramValid;
+    wire [VECTOR_SIZE-1:0] ramZero;
+    wire [DIL_WIDTH-1:0] ramDil;
+    wire [VECTOR_SIZE-1:0] ramReuse;
+    wire ramWin;
+    wire [WIN_ROW_WIDTH-1:0] ramWinRow;
+    wire [STRIDE_WIDTH-1:0] ramStride;
     wire ramLast;
+    wire [SLOT_WIDTH-1:0] ramSlot;
     
     // Generate Data RAM for each vector element
     generate
         for (i = 0; i < VECTOR_SIZE; i = i + 1) begin
         
-            wire [RAM_ADDR_WIDTH-1:0] rdAddr;
+            wire [RAM_ADDR_WIDTH:0] wrAddr;
+            wire [RAM_ADDR_WIDTH:0] rdAddr;
             wire [RAM_DATA_WIDTH-1:0] rdData;
             
-            assign rdAddr = dataAddr6R[i*RAM_ADDR_WIDTH+:RAM_ADDR_WIDTH];
+            // Bank select is the most significant address bit
+            assign wrAddr = {busBankR, busAddrR};
+            assign rdAddr = {bank6R, dataAddr6R[i*RAM_ADDR_WIDTH+:RAM_ADDR_WIDTH]};
             
             dp_ram #(
                 .DATA_WIDTH(RAM_DATA_WIDTH),
-                .RAM_DEPTH(RAM_DEPTH)) data_ram (
+                .RAM_DEPTH(BANK_DEPTH)) data_ram (
                 .clkIn(clkIn),
                 .rstIn(rstIn),
-                .addrAIn(busAddrR),
+                .addrAIn(wrAddr),
                 .wrEnAIn(busWrEnR[0][i]),
                 .wrDataAIn(busWrDataR[i]),
                 .rdEnAIn(1'b0),
@@ -475,7 +1215,7 @@ module cnn_hw_accelerator (
                 .wrDataBIn(DATA_ZERO),
                 .rdEnBIn(dataRdEn6R[i]),
                 .rdDataBOut(rdData),
-                .rdAckBOut(ramValid[i]));
+                .rdAckBOut());
                 
             assign dataA[RAM_DATA_WIDTH*i+:RAM_DATA_WIDTH] = rdData;
             
@@ -494,24 +1234,27 @@ module cnn_hw_accelerator (
     generate
         for (i = 0; i < VECTOR_SIZE; i = i + 1) begin
         
-            wire [RAM_ADDR_WIDTH-1:0] rdAddr;
+            wire [RAM_ADDR_WIDTH:0] wrAddr;
+            wire [RAM_ADDR_WIDTH:0] rdAddr;
             wire [RAM_DATA_WIDTH-1:0] rdData;
             
-            assign rdAddr = filtAddr6R[i*RAM_ADDR_WIDTH+:RAM_ADDR_WIDTH];
+            // Bank select is the most significant address bit
+            assign wrAddr = {busBankR, busAddrR};
+            assign rdAddr = {bank6R, filtAddr6R[i*RAM_ADDR_WIDTH+:RAM_ADDR_WIDTH]};
             
             dp_ram #(
                 .DATA_WIDTH(RAM_DATA_WIDTH),
-                .RAM_DEPTH(RAM_DEPTH)) filt_ram (
+                .RAM_DEPTH(BANK_DEPTH)) filt_ram (
                 .clkIn(clkIn),
                 .rstIn(rstIn),
-                .addrAIn(busAddrR),
+                .addrAIn(wrAddr),
                 .wrEnAIn(busWrEnR[1][i]),
                 .wrDataAIn(busWrDataR[i]),
                 .rdEnAIn(1'b0),
                 .addrBIn(rdAddr),
                 .wrEnBIn(WREN_ZERO),
                 .wrDataBIn(DATA_ZERO),
-                .rdEnBIn(dataRdEn6R[i]),
+                .rdEnBIn(filtRdEn6R[i]),
                 .rdDataBOut(rdData));
                 
             assign dataB[RAM_DATA_WIDTH*i+:RAM_DATA_WIDTH] = rdData;
@@ -527,67 +1270,372 @@ module cnn_hw_accelerator (
             .dataOut(dataBShift)); 
     endgenerate
     
-    // Delay last signal to match reads from RAM
+    // Delay last signal and job slot to match reads from RAM
     delay #(
         .LATENCY(RD_LATENCY),
-        .DATA_WIDTH(1)) last_delay (
+        .DATA_WIDTH(SLOT_WIDTH+1)) last_delay (
         .clkIn(clkIn),
         .rstIn(1'b0),
-        .dataIn(last6R),
-        .dataOut(ramLast));
+        .dataIn({slot6R, last6R}),
+        .dataOut({ramSlot, ramLast}));
+    
+    // Delay lane masks and dilation to match reads from RAM
+    delay #(
+        .LATENCY(RD_LATENCY),
+        .DATA_WIDTH(2*VECTOR_SIZE+DIL_WIDTH)) lane_delay (
+        .clkIn(clkIn),
+        .rstIn(rstIn),
+        .dataIn({dil6R, laneZero6R, laneValid6R}),
+        .dataOut({ramDil, ramZero, ramValid}));
+    
+    // Delay line buffer controls to match reads from RAM
+    delay #(
+        .LATENCY(RD_LATENCY),
+        .DATA_WIDTH(VECTOR_SIZE+1+WIN_ROW_WIDTH+STRIDE_WIDTH)) window_delay (
+        .clkIn(clkIn),
+        .rstIn(rstIn),
+        .dataIn({stride6R, winRow6R, win6R, laneReuse6R}),
+        .dataOut({ramStride, ramWinRow, ramWin, ramReuse}));
     
     // RAM Output Pipeline Stage
     reg ramLastR;
+    reg [SLOT_WIDTH-1:0] ramSlotR;
     reg [VECTOR_SIZE-1:0] ramValidR;
     reg [RAM_DATA_WIDTH*VECTOR_SIZE-1:0] dataAR;
     reg [RAM_DATA_WIDTH*VECTOR_SIZE-1:0] dataBR;
+    reg [RAM_DATA_WIDTH*VECTOR_SIZE-1:0] dataAVar;
+    reg [RAM_DATA_WIDTH*VECTOR_SIZE-1:0] dataAGatherVar;
+    reg [RAM_DATA_WIDTH*VECTOR_SIZE-1:0] windowVar;
+    
+    // Line buffer, last window of each filter row
+    reg [RAM_DATA_WIDTH*VECTOR_SIZE-1:0] lineBufR [0:WINDOW_ROWS-1];
     
     // Valid Process
     always @(posedge clkIn) begin
         if (rstIn) begin
             ramValidR  <= 0;
         end else begin
-            // Circular shift
-            ramValidR  <= (ramValid >> dataAShift) | (ramValid << (VECTOR_SIZE - dataAShift));            
+            ramValidR  <= ramValid;
         end
     end
     
     // Data Process
     always @(posedge clkIn) begin
         ramLastR    <= ramLast;
+        ramSlotR    <= ramSlot;
         // Circular shift
-        dataAR      <= (dataA >> (dataAShift*RAM_DATA_WIDTH)) | (dataA << ((VECTOR_SIZE - dataAShift)*RAM_DATA_WIDTH));
+        dataAVar     = (dataA >> (dataAShift*RAM_DATA_WIDTH)) | (dataA << ((VECTOR_SIZE - dataAShift)*RAM_DATA_WIDTH));
         dataBR      <= (dataB >> (dataBShift*RAM_DATA_WIDTH)) | (dataB << ((VECTOR_SIZE - dataBShift)*RAM_DATA_WIDTH));
+        
+        // Gather dilated columns into the first lanes and zero padding
+        for (j = 0; j < VECTOR_SIZE; j = j + 1) begin
+            if (ramZero[j]) begin
+                dataAGatherVar[RAM_DATA_WIDTH*j+:RAM_DATA_WIDTH] = DATA_ZERO;
+            end else begin
+                dataAGatherVar[RAM_DATA_WIDTH*j+:RAM_DATA_WIDTH] = dataAVar[RAM_DATA_WIDTH*((j << ramDil) % VECTOR_SIZE)+:RAM_DATA_WIDTH];
+            end
+        end
+        
+        // Shift the window of this filter row by the stride and append
+        // the columns read from RAM
+        for (j = 0; j < VECTOR_SIZE; j = j + 1) begin
+            if (ramReuse[j]) begin
+                windowVar[RAM_DATA_WIDTH*j+:RAM_DATA_WIDTH] = lineBufR[ramWinRow][RAM_DATA_WIDTH*((j + (1 << ramStride)) % VECTOR_SIZE)+:RAM_DATA_WIDTH];
+            end else begin
+                windowVar[RAM_DATA_WIDTH*j+:RAM_DATA_WIDTH] = dataAGatherVar[RAM_DATA_WIDTH*j+:RAM_DATA_WIDTH];
+            end
+        end
+        
+        if (ramWin) begin
+            dataAR  <= windowVar;
+            if (|ramValid) begin
+                lineBufR[ramWinRow] <= windowVar;
+            end
+        end else begin
+            dataAR  <= dataAGatherVar;
+        end
     end
     
     // Multiply and accumulate results
-    wire [RAM_DATA_WIDTH-1:0] macData;
+    wire [ACC_DATA_WIDTH-1:0] macData;
     wire macValid;
     
-    // Multiply and Accumulate
-    multiply_and_accumulate #(
-        .FRAC_WIDTH(FRAC_WIDTH),
-        .EXP_WIDTH(EXP_WIDTH)) mac(
+    // Validate MAC engine
+    initial begin
+        if ((MAC_STYLE != "FLOAT") && (MAC_STYLE != "INT8")) begin
+            $error("Unsupported MAC style \"%s\". Must be either \"FLOAT\" or \"INT8\"", MAC_STYLE);
+        end
+    end
+    
+    generate
+        if (MAC_STYLE == "INT8") begin
+        
+            // Integer accumulations and the slot of their job
+            wire [ACC_DATA_WIDTH-1:0] accumData;
+            wire accumValid;
+            wire [SLOT_WIDTH-1:0] accumSlot;
+            
+            // Integer Multiply and Accumulate
+            integer_multiply_and_accumulate #(
+                .DATA_WIDTH(RAM_DATA_WIDTH),
+                .ACC_WIDTH(ACC_DATA_WIDTH),
+                .VECTOR_SIZE(VECTOR_SIZE),
+                .TAG_WIDTH(SLOT_WIDTH)) mac(
+                .clkIn(clkIn),
+                .rstIn(rstIn),
+                .dataAIn(dataAR),
+                .dataBIn(dataBR),
+                .validIn(ramValidR),
+                .lastIn(ramLastR),
+                .tagIn(ramSlotR),
+                .dataOut(accumData),
+                .validOut(accumValid),
+                .tagOut(accumSlot));
+                
+            // Requantize with the parameters of the job
+            integer_requantize #(
+                .ACC_WIDTH(ACC_DATA_WIDTH),
+                .OUT_WIDTH(RAM_DATA_WIDTH)) requant(
+                .clkIn(clkIn),
+                .rstIn(rstIn),
+                .dataIn(accumData),
+                .validIn(accumValid),
+                .biasIn(quantBiasR[accumSlot]),
+                .reluIn(quantReluR[accumSlot]),
+                .multIn(quantMultR[accumSlot]),
+                .shiftIn(quantShiftR[accumSlot]),
+                .zeroIn(quantZeroR[accumSlot]),
+                .dataOut(macData),
+                .validOut(macValid));
+                
+        end else begin
+        
+            // Multiply and Accumulate
+            multiply_and_accumulate #(
+                .FRAC_WIDTH(ACC_FRAC_WIDTH),
+                .EXP_WIDTH(ACC_EXP_WIDTH),
+                .IN_FRAC_WIDTH(FRAC_WIDTH),
+                .IN_EXP_WIDTH(EXP_WIDTH),
+                .VECTOR_SIZE(VECTOR_SIZE)) mac(
+                .clkIn(clkIn),
+                .rstIn(rstIn),
+                .dataAIn(dataAR),
+                .dataBIn(dataBR),
+                .validIn(ramValidR),
+                .lastIn(ramLastR),
+                .dataOut(macData),
+                .validOut(macValid));
+        end
+    endgenerate
+       
+    // Output dimensions of the jobs in flight, queued with postJobR and
+    // walked as their results leave the MAC
+    reg [CNT_WIDTH-1:0] jobMaxRowR [0:JOB_DEPTH-1];
+    reg [CNT_WIDTH-1:0] jobMaxColR [0:JOB_DEPTH-1];
+    reg [SLOT_WIDTH-1:0] jobWrPtrR;
+    reg [SLOT_WIDTH-1:0] jobRdPtrR;
+    reg [CNT_WIDTH-1:0] outRowR;
+    reg [CNT_WIDTH-1:0] outColR;
+    
+    // Last MAC result of a job
+    wire macLast;
+    
+    always @(posedge clkIn) begin
+        if (postJobR) begin
+            jobMaxRowR[jobWrPtrR] <= maxDataRowCntR;
+            jobMaxColR[jobWrPtrR] <= maxDataColCntR;
+        end
+    end
+    
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            jobWrPtrR   <= 0;
+            jobRdPtrR   <= 0;
+            outRowR     <= 0;
+            outColR     <= 0;
+            inFlightR   <= 0;
+        end else begin
+            if (postJobR) begin
+                jobWrPtrR   <= jobWrPtrR + 1;
+            end
+            if (macValid) begin
+                if (outColR == jobMaxColR[jobRdPtrR]) begin
+                    outColR     <= 0;
+                    if (outRowR == jobMaxRowR[jobRdPtrR]) begin
+                        outRowR     <= 0;
+                        jobRdPtrR   <= jobRdPtrR + 1;
+                    end else begin
+                        outRowR     <= outRowR + 1;
+                    end
+                end else begin
+                    outColR     <= outColR + 1;
+                end
+            end
+            
+            // A job leaves the MAC with its last result
+            inFlightR   <= inFlightR + jobPop - (macValid & macLast);
+        end
+    end
+    
+    assign macLast = (outColR == jobMaxColR[jobRdPtrR]) && (outRowR == jobMaxRowR[jobRdPtrR]);
+       
+    // Post-processed results, postLast marks the last result of a job
+    wire [ACC_DATA_WIDTH-1:0] postData;
+    wire postLast;
+    wire postValid;
+    wire [1:0] postDrop;
+    
+    generate
+        if (POST_PROCESS) begin
+        
+            // Bias, activation and pooling
+            post_process #(
+                .FRAC_WIDTH(ACC_FRAC_WIDTH),
+                .EXP_WIDTH(ACC_EXP_WIDTH),
+                .MAC_STYLE(MAC_STYLE),
+                .CNT_WIDTH(CNT_WIDTH),
+                .POOL_COLS(POOL_COLS)) post (
+                .clkIn(clkIn),
+                .rstIn(rstIn),
+                .jobValidIn(postJobR),
+                .biasEnIn(postBiasEnR),
+                .biasIn(postBiasR),
+                .actIn(postActR),
+                .slopeIn(postSlopeR),
+                .poolSizeIn(postPoolSizeR),
+                .poolAvgIn(postPoolAvgR),
+                .maxRowIn(maxDataRowCntR),
+                .maxColIn(maxDataColCntR),
+                .dataIn(macData),
+                .validIn(macValid),
+                .dataOut(postData),
+                .lastOut(postLast),
+                .validOut(postValid),
+                .dropOut(postDrop));
+                
+        end else begin
+            assign postData  = macData;
+            assign postLast  = macLast;
+            assign postValid = macValid;
+            assign postDrop  = 2'd0;
+        end
+    endgenerate
+    
+    // Results packed into output words
+    wire [OUT_DATA_WIDTH-1:0] packData;
+    wire [     OUT_LANES-1:0] packKeep;
+    wire packLast;
+    wire packValid;
+    
+    output_packer #(
+        .DATA_WIDTH(ACC_DATA_WIDTH),
+        .OUT_WIDTH(OUT_DATA_WIDTH)) packer (
         .clkIn(clkIn),
         .rstIn(rstIn),
-        .dataAIn(dataAR),
-        .dataBIn(dataBR),
-        .validIn(ramValidR),
-        .lastIn(ramLastR),
-        .dataOut(macData),
-        .validOut(macValid));
+        .dataIn(postData),
+        .validIn(postValid),
+        .lastIn(postLast),
+        .dataOut(packData),
+        .keepOut(packKeep),
+        .lastOut(packLast),
+        .validOut(packValid));
        
-    // Output FIFO
+    // Output FIFO, never written beyond its depth as outputs are only
+    // issued against credits
     fifo #(
-        .DATA_WIDTH(RAM_DATA_WIDTH),
-        .FIFO_SKID(128)) fifo_i(
+        .DATA_WIDTH(OUT_DATA_WIDTH+OUT_LANES+1),
+        .FIFO_DEPTH(FIFO_DEPTH)) fifo_i(
         .clkIn(clkIn),
         .rstIn(rstIn),
-        .wrDataIn(macData),
-        .wrValidIn(macValid),
-        .wrReadyOut(fifoWrReady),
-        .rdDataOut(dataOut),
+        .wrDataIn({packLast, packKeep, packData}),
+        .wrValidIn(packValid),
+        .wrReadyOut(),
+        .rdDataOut({lastOut, keepOut, dataOut}),
         .rdValidOut(validOut),
         .rdReadyIn(readyIn));
     
+    // Results in the packer and the FIFO
+    reg [COUNT_WIDTH-1:0] countR;
+    reg [COUNT_WIDTH-1:0] readCntVar;
+    
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            countR      <= 0;
+        end else begin
+            readCntVar  = 0;
+            for (j = 0; j < OUT_LANES; j = j + 1) begin
+                readCntVar = readCntVar + (validOut & readyIn & keepOut[j]);
+            end
+            countR      <= countR + postValid - readCntVar;
+        end
+    end
+    
+    // Words in the output FIFO and outputs issued whose result has not
+    // left post-processing, the last beat of every output yields one MAC
+    // result, which post_process.v passes on or pools away
+    reg [CREDIT_WIDTH-1:0] fifoWordsR;
+    reg [CREDIT_WIDTH-1:0] outPendR;
+    
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            fifoWordsR   <= 0;
+            outPendR     <= 0;
+            creditReadyR <= 0;
+        end else begin
+            fifoWordsR   <= fifoWordsR + packValid - (validOut & readyIn);
+            outPendR     <= outPendR + (valid2R & last2R) - postValid - postDrop;
+            creditReadyR <= (fifoWordsR + outPendR + CREDIT_RESERVE < FIFO_DEPTH);
+        end
+    end
+    
+    assign countOut = countR;
+    
+    // Performance counter events, registered
+    reg [PERF_EVENTS*PERF_EVENT_WIDTH-1:0] perfEventsR;
+    reg [PERF_EVENT_WIDTH-1:0] maskedVar;
+    reg [PERF_EVENT_WIDTH-1:0] dataReadsVar;
+    reg [PERF_EVENT_WIDTH-1:0] filtReadsVar;
+    
+    generate
+        if (PERF_COUNTERS) begin
+        
+            always @(posedge clkIn) begin
+                maskedVar    = 0;
+                dataReadsVar = 0;
+                filtReadsVar = 0;
+                for (j = 0; j < VECTOR_SIZE; j = j + 1) begin
+                    maskedVar    = maskedVar + ((|laneValid6R) & !laneValid6R[j]);
+                    dataReadsVar = dataReadsVar + dataRdEn6R[j];
+                    filtReadsVar = filtReadsVar + filtRdEn6R[j];
+                end
+                perfEventsR <= {
+                    {{(PERF_EVENT_WIDTH-1){1'b0}}, validOut & !readyIn},
+                    {{(PERF_EVENT_WIDTH-1){1'b0}}, postValid},
+                    {{(PERF_EVENT_WIDTH-1){1'b0}}, |laneValid6R},
+                    filtReadsVar,
+                    dataReadsVar,
+                    maskedVar,
+                    {{(PERF_EVENT_WIDTH-1){1'b0}}, throttleR & validR},
+                    {{(PERF_EVENT_WIDTH-1){1'b0}}, busyOut}};
+            end
+            
+            perf_counters #(
+                .NUM_EVENTS(PERF_EVENTS),
+                .EVENT_WIDTH(PERF_EVENT_WIDTH),
+                .COUNT_WIDTH(PERF_WIDTH)) perf (
+                .clkIn(clkIn),
+                .rstIn(rstIn),
+                .startIn(perfStartIn),
+                .stopIn(perfStopIn),
+                .clearIn(perfClearIn),
+                .eventsIn(perfEventsR),
+                .selIn(perfSelIn),
+                .runningOut(),
+                .dataOut(perfDataOut));
+                
+        end else begin
+            assign perfDataOut = 0;
+        end
+    endgenerate
+    
 endmodule
\ No newline at end of file
@@ -0,0 +1,473 @@
+`timescale 1ns/1ns
+
+module cnn_hw_accelerator_dual_clock (
+    busClkIn,
+    coreClkIn,
+    rstIn,
+    startIn,
+    opTypeIn,
+    strideLog2In,
+    padIn,
+    dilationLog2In,
+    packIn,
+    quantMultIn,
+    quantShiftIn,
+    quantZeroIn,
+    biasEnIn,
+    biasIn,
+    actIn,
+    slopeIn,
+    poolSizeIn,
+    poolAvgIn,
+    filtRowsIn,
+    filtColsIn,
+    dataRowsIn,
+    dataColsIn,
+    channelsIn,
+    dataBaseIn,
+    filtBaseIn,
+    holdBankIn,
+    addrIn,
+    wrEnIn,
+    wrDataIn,
+    wrReadyOut,
+    readyIn,
+    busyOut,
+    queueFullOut,
+    validOut,
+    dataOut,
+    keepOut,
+    lastOut,
+    countOut,
+    perfStartIn,
+    perfStopIn,
+    perfClearIn,
+    perfSelIn,
+    perfDataOut);
+
+    // cnn_hw_accelerator with its bus interface and compute core on
+    // separate clocks
+    //
+    // The ports follow cnn_hw_accelerator.v and, except for coreClkIn, are
+    // synchronous to busClkIn (rstIn included). The accelerator itself,
+    // with its address pipeline, RAM read side, MAC and output FIFO, runs
+    // on coreClkIn, which may be faster or slower than busClkIn and
+    // unrelated to it.
+    //
+    // Bus to core: bus writes, startIn with its job ports and the counter
+    // controls (perfStartIn, perfStopIn, perfClearIn) are pushed as one
+    // command per bus cycle into a Gray-code fifo_async of CMD_DEPTH
+    // entries and replayed to the accelerator in the same order, one per
+    // core cycle, so a job never overtakes the writes loading it. Commands
+    // are taken while wrReadyOut is high, which only drops when the core
+    // clock is slower than bursts of bus writes.
+    //
+    // Core to bus: results cross in a fifo_async of RESULT_DEPTH words,
+    // whose free space is the readyIn of the accelerator. Its status
+    // (busyOut, queueFullOut, the results produced, the jobs started and
+    // the selected counter) is captured in one register and handed to the
+    // bus clock with a toggle handshake, so the fields always belong to
+    // the same core cycle. A start is in flight from the bus cycle it is
+    // taken until a snapshot counts it; busyOut and queueFullOut stay high
+    // meanwhile, so at most one start crosses at a time and startIn keeps
+    // its meaning. countOut is the results produced in the last snapshot
+    // less those read, it never exceeds the results available.
+    // perfDataOut follows perfSelIn after a few cycles of both clocks.
+
+    // Clock domain crossing configuration
+    parameter CMD_DEPTH         = 16;
+    parameter RESULT_DEPTH      = 16;
+    parameter SYNC_STAGES       = 2;
+
+    // Core configuration, see cnn_hw_accelerator.v
+    parameter BUS_ADDR_WIDTH    = 32;
+    parameter BUS_DATA_WIDTH    = 64;
+    parameter FRAC_WIDTH        = 24;
+    parameter EXP_WIDTH         = 8;
+    parameter ACC_FRAC_WIDTH    = 24;
+    parameter ACC_EXP_WIDTH     = 8;
+    parameter VECTOR_SIZE       = 8;
+    parameter MAC_STYLE         = "FLOAT";
+    parameter MAX_SIZE          = 4096;
+    parameter LINE_BUFFER       = 1;
+    parameter WINDOW_ROWS       = 16;
+    parameter PACKING           = 1;
+    parameter POST_PROCESS      = 1;
+    parameter POOL_COLS         = MAX_SIZE/4;
+    parameter OUT_DATA_WIDTH    = ACC_FRAC_WIDTH + ACC_EXP_WIDTH;
+    parameter PERF_COUNTERS     = 1;
+    parameter PERF_WIDTH        = 32;
+    parameter JOB_QUEUE         = 4;
+
+    // Derived parameters of the core ports
+    localparam BUS_WE_WIDTH     = BUS_DATA_WIDTH/8;
+    localparam CNT_WIDTH        = $clog2(MAX_SIZE);
+    localparam VECTOR_SIZE_LOG2 = $clog2(VECTOR_SIZE);
+    localparam ACC_DATA_WIDTH   = ACC_FRAC_WIDTH + ACC_EXP_WIDTH;
+    localparam STRIDE_WIDTH     = 2;
+    localparam PAD_WIDTH        = 4;
+    localparam DIL_WIDTH        = $clog2(VECTOR_SIZE_LOG2+1);
+    localparam QUANT_SHIFT_WIDTH = $clog2(2*ACC_DATA_WIDTH);
+    localparam QUANT_ZERO_WIDTH  = 8;
+    localparam FIFO_DEPTH       = 512;
+    localparam OUT_LANES        = OUT_DATA_WIDTH/ACC_DATA_WIDTH;
+    localparam COUNT_WIDTH      = $clog2(FIFO_DEPTH*OUT_LANES) + 1;
+    localparam PERF_SEL_WIDTH   = 3;
+
+    // Command word: {start, perfStart, perfStop, perfClear, job, write}
+    localparam JOB_WIDTH        = 1 + STRIDE_WIDTH + PAD_WIDTH + DIL_WIDTH + 1 + 3*ACC_DATA_WIDTH +
+                                  QUANT_SHIFT_WIDTH + QUANT_ZERO_WIDTH + 1 + 2 + 2 + 1 + 5*(CNT_WIDTH+1) +
+                                  2*CNT_WIDTH + 1;
+    localparam WRITE_WIDTH      = BUS_ADDR_WIDTH + BUS_WE_WIDTH + BUS_DATA_WIDTH;
+    localparam CMD_WIDTH        = 4 + JOB_WIDTH + WRITE_WIDTH;
+
+    // Result word: {lastOut, keepOut, dataOut}
+    localparam RESULT_WIDTH     = OUT_DATA_WIDTH + OUT_LANES + 1;
+
+    // Status snapshot: {busy, queueFull, starts, results produced, counter}
+    // Results are counted modulo 2^PROD_WIDTH, twice the FIFO capacity
+    localparam STARTS_WIDTH     = 4;
+    localparam PROD_WIDTH       = COUNT_WIDTH + 1;
+    localparam STAT_WIDTH       = 2 + STARTS_WIDTH + PROD_WIDTH + PERF_WIDTH;
+
+    // Input/Output Ports
+    input busClkIn;
+    input coreClkIn;
+    input rstIn;
+
+    input startIn;
+    input opTypeIn;
+    input [STRIDE_WIDTH-1:0] strideLog2In;
+    input [   PAD_WIDTH-1:0] padIn;
+    input [   DIL_WIDTH-1:0] dilationLog2In;
+    input packIn;
+    input [   ACC_DATA_WIDTH-1:0] quantMultIn;
+    input [QUANT_SHIFT_WIDTH-1:0] quantShiftIn;
+    input [ QUANT_ZERO_WIDTH-1:0] quantZeroIn;
+    input biasEnIn;
+    input [ACC_DATA_WIDTH-1:0] biasIn;
+    input [1:0] actIn;
+    input [ACC_DATA_WIDTH-1:0] slopeIn;
+    input [1:0] poolSizeIn;
+    input poolAvgIn;
+    input [CNT_WIDTH:0] filtRowsIn;
+    input [CNT_WIDTH:0] filtColsIn;
+    input [CNT_WIDTH:0] dataRowsIn;
+    input [CNT_WIDTH:0] dataColsIn;
+    input [CNT_WIDTH:0] channelsIn;
+    input [CNT_WIDTH-1:0] dataBaseIn;
+    input [CNT_WIDTH-1:0] filtBaseIn;
+    input holdBankIn;
+
+    input  [BUS_ADDR_WIDTH-1:0] addrIn;
+    input  [  BUS_WE_WIDTH-1:0] wrEnIn;
+    input  [BUS_DATA_WIDTH-1:0] wrDataIn;
+    output wrReadyOut;
+
+    input  readyIn;
+    output busyOut;
+    output queueFullOut;
+    output validOut;
+    output [OUT_DATA_WIDTH-1:0] dataOut;
+    output [     OUT_LANES-1:0] keepOut;
+    output lastOut;
+    output [   COUNT_WIDTH-1:0] countOut;
+
+    input  perfStartIn;
+    input  perfStopIn;
+    input  perfClearIn;
+    input  [PERF_SEL_WIDTH-1:0] perfSelIn;
+    output [    PERF_WIDTH-1:0] perfDataOut;
+
+    integer j;
+
+    // Status snapshot, written on coreClkIn and read on busClkIn while its
+    // request and acknowledge toggles differ
+    reg [STAT_WIDTH-1:0] statR;
+    reg statReqR;
+    reg statAckR;
+    reg [SYNC_STAGES-1:0] statReqSyncR;
+    reg [SYNC_STAGES-1:0] statAckSyncR;
+
+    // Bus clock: status of the core from the last snapshot
+    reg statBusyR;
+    reg statQueueFullR;
+    reg [STARTS_WIDTH-1:0] statStartsR;
+    reg [  PROD_WIDTH-1:0] statProducedR;
+    reg [  PERF_WIDTH-1:0] statPerfR;
+
+    // Jobs started and results read on the bus side
+    reg [STARTS_WIDTH-1:0] busStartsR;
+    reg [  PROD_WIDTH-1:0] busReadR;
+    reg [  PROD_WIDTH-1:0] readCntVar;
+    reg [  PROD_WIDTH-1:0] availVar;
+
+    wire startInFlight;
+    wire startTaken;
+    wire cmdPush;
+    wire [CMD_WIDTH-1:0] cmdData;
+
+    // A start is taken with room in the queue of the last snapshot and no
+    // other start in flight
+    assign startInFlight = (busStartsR != statStartsR);
+    assign startTaken    = startIn & !queueFullOut & wrReadyOut;
+    assign cmdPush       = startTaken | perfStartIn | perfStopIn | perfClearIn | (|wrEnIn);
+
+    assign cmdData = {startTaken, perfStartIn, perfStopIn, perfClearIn,
+                      opTypeIn, strideLog2In, padIn, dilationLog2In, packIn, quantMultIn, quantShiftIn,
+                      quantZeroIn, biasEnIn, biasIn, actIn, slopeIn, poolSizeIn, poolAvgIn, filtRowsIn,
+                      filtColsIn, dataRowsIn, dataColsIn, channelsIn, dataBaseIn, filtBaseIn, holdBankIn,
+                      addrIn, wrEnIn, wrDataIn};
+
+    // Status Process
+    always @(posedge busClkIn) begin
+        if (rstIn) begin
+            statBusyR       <= 0;
+            statQueueFullR  <= 0;
+            statStartsR     <= 0;
+            statProducedR   <= 0;
+            statPerfR       <= 0;
+            busStartsR      <= 0;
+            busReadR        <= 0;
+            statReqSyncR    <= 0;
+            statAckR        <= 0;
+        end else begin
+            busStartsR      <= busStartsR + startTaken;
+
+            // Results read, one per lane kept
+            readCntVar = 0;
+            for (j = 0; j < OUT_LANES; j = j + 1) begin
+                readCntVar = readCntVar + (validOut & readyIn & keepOut[j]);
+            end
+            busReadR        <= busReadR + readCntVar;
+
+            // Take a new snapshot once its request toggles, it is stable
+            // until acknowledged
+            statReqSyncR    <= {statReqSyncR, statReqR};
+            if (statReqSyncR[SYNC_STAGES-1] != statAckR) begin
+                {statBusyR, statQueueFullR, statStartsR, statProducedR, statPerfR} <= statR;
+                statAckR        <= ~statAckR;
+            end
+        end
+    end
+
+    // Results the last snapshot counts beyond those read, or none while
+    // reads are ahead of it
+    always @(*) begin
+        availVar = statProducedR - busReadR;
+        if (availVar[PROD_WIDTH-1]) begin
+            availVar = 0;
+        end
+    end
+
+    assign busyOut      = statBusyR | startInFlight;
+    assign queueFullOut = statQueueFullR | startInFlight;
+    assign countOut     = availVar[COUNT_WIDTH-1:0];
+    assign perfDataOut  = statPerfR;
+
+    // Core reset, released SYNC_STAGES core cycles after rstIn
+    reg [SYNC_STAGES-1:0] coreRstR;
+
+    always @(posedge coreClkIn) begin
+        coreRstR <= {coreRstR, rstIn};
+    end
+
+    wire coreRst;
+    assign coreRst = coreRstR[SYNC_STAGES-1];
+
+    // Commands
+    wire [CMD_WIDTH-1:0] coreCmd;
+    wire coreCmdValid;
+
+    fifo_async #(
+        .DATA_WIDTH(CMD_WIDTH),
+        .FIFO_DEPTH(CMD_DEPTH),
+        .SYNC_STAGES(SYNC_STAGES)) cmd_fifo (
+        .wrClkIn(busClkIn),
+        .wrRstIn(rstIn),
+        .wrDataIn(cmdData),
+        .wrValidIn(cmdPush),
+        .wrReadyOut(wrReadyOut),
+        .rdClkIn(coreClkIn),
+        .rdRstIn(coreRst),
+        .rdDataOut(coreCmd),
+        .rdValidOut(coreCmdValid),
+        .rdReadyIn(1'b1));
+
+    // Results
+    wire coreReady;
+    wire coreValid;
+    wire [OUT_DATA_WIDTH-1:0] coreData;
+    wire [     OUT_LANES-1:0] coreKeep;
+    wire coreLast;
+
+    fifo_async #(
+        .DATA_WIDTH(RESULT_WIDTH),
+        .FIFO_DEPTH(RESULT_DEPTH),
+        .SYNC_STAGES(SYNC_STAGES)) result_fifo (
+        .wrClkIn(coreClkIn),
+        .wrRstIn(coreRst),
+        .wrDataIn({coreLast, coreKeep, coreData}),
+        .wrValidIn(coreValid),
+        .wrReadyOut(coreReady),
+        .rdClkIn(busClkIn),
+        .rdRstIn(rstIn),
+        .rdDataOut({lastOut, keepOut, dataOut}),
+        .rdValidOut(validOut),
+        .rdReadyIn(readyIn));
+
+    // Core clock: command replayed to the accelerator
+    reg cmdValidR;
+    reg [CMD_WIDTH-1:0] cmdR;
+
+    // Fields of the command
+    wire cmdStart;
+    wire cmdPerfStart;
+    wire cmdPerfStop;
+    wire cmdPerfClear;
+    wire cmdOpType;
+    wire [STRIDE_WIDTH-1:0] cmdStrideLog2;
+    wire [   PAD_WIDTH-1:0] cmdPad;
+    wire [   DIL_WIDTH-1:0] cmdDilationLog2;
+    wire cmdPack;
+    wire [   ACC_DATA_WIDTH-1:0] cmdQuantMult;
+    wire [QUANT_SHIFT_WIDTH-1:0] cmdQuantShift;
+    wire [ QUANT_ZERO_WIDTH-1:0] cmdQuantZero;
+    wire cmdBiasEn;
+    wire [ACC_DATA_WIDTH-1:0] cmdBias;
+    wire [1:0] cmdAct;
+    wire [ACC_DATA_WIDTH-1:0] cmdSlope;
+    wire [1:0] cmdPoolSize;
+    wire cmdPoolAvg;
+    wire [CNT_WIDTH:0] cmdFiltRows;
+    wire [CNT_WIDTH:0] cmdFiltCols;
+    wire [CNT_WIDTH:0] cmdDataRows;
+    wire [CNT_WIDTH:0] cmdDataCols;
+    wire [CNT_WIDTH:0] cmdChannels;
+    wire [CNT_WIDTH-1:0] cmdDataBase;
+    wire [CNT_WIDTH-1:0] cmdFiltBase;
+    wire cmdHoldBank;
+    wire [BUS_ADDR_WIDTH-1:0] cmdAddr;
+    wire [  BUS_WE_WIDTH-1:0] cmdWrEn;
+    wire [BUS_DATA_WIDTH-1:0] cmdWrData;
+
+    assign {cmdStart, cmdPerfStart, cmdPerfStop, cmdPerfClear,
+            cmdOpType, cmdStrideLog2, cmdPad, cmdDilationLog2, cmdPack, cmdQuantMult, cmdQuantShift,
+            cmdQuantZero, cmdBiasEn, cmdBias, cmdAct, cmdSlope, cmdPoolSize, cmdPoolAvg, cmdFiltRows,
+            cmdFiltCols, cmdDataRows, cmdDataCols, cmdChannels, cmdDataBase, cmdFiltBase, cmdHoldBank,
+            cmdAddr, cmdWrEn, cmdWrData} = cmdR;
+
+    // Counter select, held by the host while reading
+    reg [PERF_SEL_WIDTH*SYNC_STAGES-1:0] perfSelSyncR;
+
+    // Accelerator status
+    wire coreBusy;
+    wire coreQueueFull;
+    wire [COUNT_WIDTH-1:0] coreCount;
+    wire [ PERF_WIDTH-1:0] corePerf;
+
+    // Jobs started and results taken from the accelerator
+    reg [STARTS_WIDTH-1:0] coreStartsR;
+    reg [  PROD_WIDTH-1:0] coreReadR;
+    reg [  PROD_WIDTH-1:0] coreReadVar;
+
+    // Command Process
+    always @(posedge coreClkIn) begin
+        cmdR            <= coreCmd;
+        perfSelSyncR    <= {perfSelSyncR, perfSelIn};
+        if (coreRst) begin
+            cmdValidR       <= 0;
+        end else begin
+            cmdValidR       <= coreCmdValid;
+        end
+    end
+
+    // Snapshot Process
+    // A start counts once the accelerator has taken it (the edge it
+    // samples startIn), so busy and queue full of the same snapshot
+    // include it
+    always @(posedge coreClkIn) begin
+        if (coreRst) begin
+            coreStartsR     <= 0;
+            coreReadR       <= 0;
+            statR           <= 0;
+            statReqR        <= 0;
+            statAckSyncR    <= 0;
+        end else begin
+            coreStartsR     <= coreStartsR + (cmdValidR & cmdStart);
+            coreReadVar = 0;
+            for (j = 0; j < OUT_LANES; j = j + 1) begin
+                coreReadVar = coreReadVar + (coreValid & coreReady & coreKeep[j]);
+            end
+            coreReadR       <= coreReadR + coreReadVar;
+
+            statAckSyncR    <= {statAckSyncR, statAckR};
+            if (statReqR == statAckSyncR[SYNC_STAGES-1]) begin
+                statR           <= {coreBusy, coreQueueFull, coreStartsR, coreReadR + coreCount, corePerf};
+                statReqR        <= ~statReqR;
+            end
+        end
+    end
+
+    cnn_hw_accelerator #(
+        .BUS_ADDR_WIDTH(BUS_ADDR_WIDTH),
+        .BUS_DATA_WIDTH(BUS_DATA_WIDTH),
+        .FRAC_WIDTH(FRAC_WIDTH),
+        .EXP_WIDTH(EXP_WIDTH),
+        .ACC_FRAC_WIDTH(ACC_FRAC_WIDTH),
+        .ACC_EXP_WIDTH(ACC_EXP_WIDTH),
+        .VECTOR_SIZE(VECTOR_SIZE),
+        .MAC_STYLE(MAC_STYLE),
+        .MAX_SIZE(MAX_SIZE),
+        .LINE_BUFFER(LINE_BUFFER),
+        .WINDOW_ROWS(WINDOW_ROWS),
+        .PACKING(PACKING),
+        .POST_PROCESS(POST_PROCESS),
+        .POOL_COLS(POOL_COLS),
+        .OUT_DATA_WIDTH(OUT_DATA_WIDTH),
+        .PERF_COUNTERS(PERF_COUNTERS),
+        .PERF_WIDTH(PERF_WIDTH),
+        .JOB_QUEUE(JOB_QUEUE)) accel (
+        .clkIn(coreClkIn),
+        .rstIn(coreRst),
+        .startIn(cmdValidR & cmdStart),
+        .opTypeIn(cmdOpType),
+        .strideLog2In(cmdStrideLog2),
+        .padIn(cmdPad),
+        .dilationLog2In(cmdDilationLog2),
+        .packIn(cmdPack),
+        .quantMultIn(cmdQuantMult),
+        .quantShiftIn(cmdQuantShift),
+        .quantZeroIn(cmdQuantZero),
+        .biasEnIn(cmdBiasEn),
+        .biasIn(cmdBias),
+        .actIn(cmdAct),
+        .slopeIn(cmdSlope),
+        .poolSizeIn(cmdPoolSize),
+        .poolAvgIn(cmdPoolAvg),
+        .filtRowsIn(cmdFiltRows),
+        .filtColsIn(cmdFiltCols),
+        .dataRowsIn(cmdDataRows),
+        .dataColsIn(cmdDataCols),
+        .channelsIn(cmdChannels),
+        .dataBaseIn(cmdDataBase),
+        .filtBaseIn(cmdFiltBase),
+        .holdBankIn(cmdHoldBank),
+        .addrIn(cmdAddr),
+        .wrEnIn(cmdValidR ? cmdWrEn : {BUS_WE_WIDTH{1'b0}}),
+        .wrDataIn(cmdWrData),
+        .readyIn(coreReady),
+        .busyOut(coreBusy),
+        .queueFullOut(coreQueueFull),
+        .validOut(coreValid),
+        .dataOut(coreData),
+        .keepOut(coreKeep),
+        .lastOut(coreLast),
+        .countOut(coreCount),
+        .perfStartIn(cmdValidR & cmdPerfStart),
+        .perfStopIn(cmdValidR & cmdPerfStop),
+        .perfClearIn(cmdValidR & cmdPerfClear),
+        .perfSelIn(perfSelSyncR[PERF_SEL_WIDTH*SYNC_STAGES-1-:PERF_SEL_WIDTH]),
+        .perfDataOut(corePerf));
+
+endmodule
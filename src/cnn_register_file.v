@@ -0,0 +1,467 @@
+`timescale 1ns/1ns
+
+module cnn_register_file (
+    clkIn,
+    rstIn,
+    addrIn,
+    wrEnIn,
+    wrDataIn,
+    rdEnIn,
+    rdDataOut,
+    rdValidOut,
+    irqOut,
+    accStartOut,
+    accOpTypeOut,
+    accStrideLog2Out,
+    accPadOut,
+    accDilationLog2Out,
+    accPackOut,
+    accQuantMultOut,
+    accQuantShiftOut,
+    accQuantZeroOut,
+    accBiasEnOut,
+    accBiasOut,
+    accActOut,
+    accSlopeOut,
+    accPoolSizeOut,
+    accPoolAvgOut,
+    accFiltRowsOut,
+    accFiltColsOut,
+    accDataRowsOut,
+    accDataColsOut,
+    accChannelsOut,
+    accDataBaseOut,
+    accFiltBaseOut,
+    accHoldBankOut,
+    accAddrOut,
+    accWrEnOut,
+    accWrDataOut,
+    accBusyIn,
+    accQueueFullIn,
+    accValidIn,
+    accDataIn,
+    accLastIn,
+    accCountIn,
+    accReadyOut,
+    accPerfStartOut,
+    accPerfStopOut,
+    accPerfClearOut,
+    accPerfSelOut,
+    accPerfDataIn);
+
+    // Memory-mapped register file of cnn_hw_accelerator
+    //
+    // Bus writes below REG_ADDR go straight to the accelerator RAMs, the
+    // REG_ADDR window holds 32-bit registers (byte offsets):
+    //   0x00 CONTROL    W   [0] start a job with the configuration below
+    //   0x04 STATUS     R   [0] busy, [1] done, [2] error, [3] result ready,
+    //                       [7:4] jobs started whose last result is unread,
+    //                       [8] job queue full,
+    //                       [31:16] results buffered (countOut)
+    //                   W   writing 1 to [1] clears done
+    //   0x08 IRQ_ENABLE RW  [0] interrupt on done, [1] interrupt on error
+    //   0x0C OP         RW  [0] opType, [3:2] strideLog2, [7:4] pad,
+    //                       [9:8] dilationLog2, [10] pack, [11] hold bank
+    //   0x10 FILT_DIMS  RW  [15:0] filtRows, [31:16] filtCols
+    //   0x14 DATA_DIMS  RW  [15:0] dataRows, [31:16] dataCols
+    //   0x18 QUANT_MULT RW  quantMult
+    //   0x1C QUANT      RW  [5:0] quantShift, [15:8] quantZero
+    //   0x20 BIAS       RW  bias
+    //   0x24 POST       RW  [0] biasEn, [2:1] act, [4:3] poolSize,
+    //                       [5] poolAvg
+    //   0x28 SLOPE      RW  slope
+    //   0x2C RESULT     R   next result, removed from the output FIFO
+    //   0x30 PERF_CTRL  W   [0] start, [1] stop, [2] clear the counters
+    //   0x34 PERF_SEL   RW  counter read through PERF_DATA
+    //   0x38 PERF_DATA  R   selected performance counter, two cycles after
+    //                       PERF_SEL is written
+    //   0x3C ERROR      R   [0] start refused while busy, [1] start refused
+    //                       for dimensions outside 1..MAX_SIZE elements or
+    //                       a filter larger than the padded data,
+    //                       [2] RESULT read while empty
+    //                   W   writing 1 clears the bit
+    //   0x40 BASE       RW  [15:0] dataBase, [31:16] filtBase
+    //   0x44 CHANNELS   RW  [15:0] input channels (0 counts as 1)
+    //
+    // Started jobs are queued by the accelerator. A job holding the bank
+    // of the previous one is only refused while the job queue is full,
+    // any other start while busy, and the matrices of a job must fit in
+    // MAX_SIZE elements from their base, all channels of their stack. Data
+    // planes are counted at the row pitch the accelerator reads them with,
+    // the padded pitch of packed convolutions. GEMM jobs have a single
+    // channel. The dilated filter of a convolution must fit in the padded
+    // data, otherwise the accelerator has no output position to walk.
+    // Each RESULT read removes one result, so the accelerator is built with
+    // OUT_DATA_WIDTH = DATA_WIDTH; bus-width packing only applies to its
+    // streaming dataOut port. A job is done once its last result has
+    // been read. Done and error are sticky, irqOut is high while an enabled
+    // one is set. Reads return the register in every 32-bit lane of
+    // rdDataOut one cycle after rdEnIn.
+
+    // Configuration of RISCV bus interface
+    parameter BUS_ADDR_WIDTH    = 32;
+    parameter BUS_DATA_WIDTH    = 64;
+
+    // Maximum size of input matrices and width of the results
+    parameter MAX_SIZE          = 4096;
+    parameter DATA_WIDTH        = 32;
+
+    // Base of the register window, above the data and filter RAMs
+    parameter REG_ADDR          = 2 << ($clog2(MAX_SIZE) + 2);
+
+    // Accelerator build (see cnn_hw_accelerator.v), packed jobs pad the
+    // data rows to a pitch that depends on VECTOR_SIZE
+    parameter VECTOR_SIZE       = 8;
+    parameter PACKING           = 1;
+
+    // Accelerator port widths (see cnn_hw_accelerator.v)
+    parameter COUNT_WIDTH       = 10;
+    parameter PERF_SEL_WIDTH    = 3;
+    parameter PERF_WIDTH        = 32;
+
+    // Derived parameters
+    localparam BUS_WE_WIDTH     = BUS_DATA_WIDTH/8;
+    localparam DIM_WIDTH        = $clog2(MAX_SIZE) + 1;
+    localparam REG_WIDTH        = 32;
+    localparam REG_LANES        = BUS_DATA_WIDTH/REG_WIDTH;
+    localparam LANE_WIDTH       = (REG_LANES > 1) ? $clog2(REG_LANES) : 1;
+    localparam WINDOW_LO        = 7;
+    localparam STRIDE_WIDTH     = 2;
+    localparam PAD_WIDTH        = 4;
+    localparam DIL_WIDTH        = 2;
+    localparam SHIFT_WIDTH      = 6;
+    localparam ZERO_WIDTH       = 8;
+    localparam JOB_WIDTH        = 4;
+    localparam OP_WIDTH         = 12;
+    localparam OP_HOLD          = 11;
+
+    // Widths of a stack size (three 16-bit factors) plus its base, and of
+    // a dilated filter extent or padded data extent
+    localparam SIZE_WIDTH       = 3*16 + 1;
+    localparam SPAN_WIDTH       = 16 + (1 << DIL_WIDTH);
+
+    // Register offsets
+    localparam REG_CONTROL      = 5'h00;
+    localparam REG_STATUS       = 5'h01;
+    localparam REG_IRQ_ENABLE   = 5'h02;
+    localparam REG_OP           = 5'h03;
+    localparam REG_FILT_DIMS    = 5'h04;
+    localparam REG_DATA_DIMS    = 5'h05;
+    localparam REG_QUANT_MULT   = 5'h06;
+    localparam REG_QUANT        = 5'h07;
+    localparam REG_BIAS         = 5'h08;
+    localparam REG_POST         = 5'h09;
+    localparam REG_SLOPE        = 5'h0A;
+    localparam REG_RESULT       = 5'h0B;
+    localparam REG_PERF_CTRL    = 5'h0C;
+    localparam REG_PERF_SEL     = 5'h0D;
+    localparam REG_PERF_DATA    = 5'h0E;
+    localparam REG_ERROR        = 5'h0F;
+    localparam REG_BASE         = 5'h10;
+    localparam REG_CHANNELS     = 5'h11;
+
+    // Error bits
+    localparam ERR_BUSY         = 0;
+    localparam ERR_DIMS         = 1;
+    localparam ERR_EMPTY        = 2;
+
+    // Input/Output Ports
+    input clkIn;
+    input rstIn;
+
+    input  [BUS_ADDR_WIDTH-1:0] addrIn;
+    input  [  BUS_WE_WIDTH-1:0] wrEnIn;
+    input  [BUS_DATA_WIDTH-1:0] wrDataIn;
+    input  rdEnIn;
+    output [BUS_DATA_WIDTH-1:0] rdDataOut;
+    output rdValidOut;
+    output irqOut;
+
+    output accStartOut;
+    output accOpTypeOut;
+    output [STRIDE_WIDTH-1:0] accStrideLog2Out;
+    output [   PAD_WIDTH-1:0] accPadOut;
+    output [   DIL_WIDTH-1:0] accDilationLog2Out;
+    output accPackOut;
+    output [  DATA_WIDTH-1:0] accQuantMultOut;
+    output [ SHIFT_WIDTH-1:0] accQuantShiftOut;
+    output [  ZERO_WIDTH-1:0] accQuantZeroOut;
+    output accBiasEnOut;
+    output [  DATA_WIDTH-1:0] accBiasOut;
+    output [1:0] accActOut;
+    output [  DATA_WIDTH-1:0] accSlopeOut;
+    output [1:0] accPoolSizeOut;
+    output accPoolAvgOut;
+    output [DIM_WIDTH-1:0] accFiltRowsOut;
+    output [DIM_WIDTH-1:0] accFiltColsOut;
+    output [DIM_WIDTH-1:0] accDataRowsOut;
+    output [DIM_WIDTH-1:0] accDataColsOut;
+    output [DIM_WIDTH-1:0] accChannelsOut;
+    output [DIM_WIDTH-2:0] accDataBaseOut;
+    output [DIM_WIDTH-2:0] accFiltBaseOut;
+    output accHoldBankOut;
+    output [BUS_ADDR_WIDTH-1:0] accAddrOut;
+    output [  BUS_WE_WIDTH-1:0] accWrEnOut;
+    output [BUS_DATA_WIDTH-1:0] accWrDataOut;
+    input  accBusyIn;
+    input  accQueueFullIn;
+    input  accValidIn;
+    input  [ DATA_WIDTH-1:0] accDataIn;
+    input  accLastIn;
+    input  [COUNT_WIDTH-1:0] accCountIn;
+    output accReadyOut;
+    output accPerfStartOut;
+    output accPerfStopOut;
+    output accPerfClearOut;
+    output [PERF_SEL_WIDTH-1:0] accPerfSelOut;
+    input  [    PERF_WIDTH-1:0] accPerfDataIn;
+
+    // Bus decode
+    wire regSel;
+    wire [4:0] regIdx;
+    wire [LANE_WIDTH-1:0] regLane;
+    wire regWr;
+    wire [REG_WIDTH-1:0] regWrData;
+
+    assign regSel    = (addrIn >> WINDOW_LO) == (REG_ADDR >> WINDOW_LO);
+    assign regIdx    = addrIn[WINDOW_LO-1:2];
+    assign regLane   = (REG_LANES > 1) ? addrIn[2+:LANE_WIDTH] : 0;
+    assign regWr     = regSel && (|wrEnIn[regLane*4+:4]);
+    assign regWrData = wrDataIn[regLane*REG_WIDTH+:REG_WIDTH];
+
+    // RAM writes pass through
+    assign accAddrOut   = addrIn;
+    assign accWrEnOut   = regSel ? {BUS_WE_WIDTH{1'b0}} : wrEnIn;
+    assign accWrDataOut = wrDataIn;
+
+    // Configuration registers
+    reg [1:0] irqEnR;
+    reg [OP_WIDTH-1:0] opR;
+    reg [REG_WIDTH-1:0] filtDimsR;
+    reg [REG_WIDTH-1:0] dataDimsR;
+    reg [DATA_WIDTH-1:0] quantMultR;
+    reg [15:0] quantR;
+    reg [DATA_WIDTH-1:0] biasR;
+    reg [5:0] postR;
+    reg [DATA_WIDTH-1:0] slopeR;
+    reg [REG_WIDTH-1:0] baseR;
+    reg [15:0] channelsR;
+    reg [PERF_SEL_WIDTH-1:0] perfSelR;
+
+    // Status registers
+    reg startR;
+    reg doneR;
+    reg [2:0] errorR;
+    reg [JOB_WIDTH-1:0] jobsR;
+    reg [2:0] perfCtrlR;
+    reg irqR;
+
+    // Read registers
+    reg [REG_WIDTH-1:0] rdDataR;
+    reg rdValidR;
+    reg [REG_WIDTH-1:0] rdVar;
+
+    // Dimensions of the next job
+    wire [15:0] filtRows;
+    wire [15:0] filtCols;
+    wire [15:0] dataRows;
+    wire [15:0] dataCols;
+    wire [15:0] dataBase;
+    wire [15:0] filtBase;
+    wire [15:0] channels;
+    wire packed;
+    wire [15:0] dataPitch;
+    wire [SIZE_WIDTH-1:0] filtSize;
+    wire [SIZE_WIDTH-1:0] dataSize;
+    wire [SPAN_WIDTH-1:0] filtColSpan;
+    wire [SPAN_WIDTH-1:0] filtRowSpan;
+    wire [SPAN_WIDTH-1:0] dataColSpan;
+    wire [SPAN_WIDTH-1:0] dataRowSpan;
+    wire geometryValid;
+    wire dimsValid;
+    wire busy;
+    wire refused;
+    wire resultRd;
+
+    assign filtRows  = filtDimsR[15:0];
+    assign filtCols  = filtDimsR[31:16];
+    assign dataRows  = dataDimsR[15:0];
+    assign dataCols  = dataDimsR[31:16];
+    assign dataBase  = baseR[15:0];
+    assign filtBase  = baseR[31:16];
+    assign channels  = ((channelsR == 0) || opR[0]) ? 1 : channelsR;
+    assign packed    = PACKING && opR[10] && !opR[0] && (opR[9:8] == 0);
+    assign dataPitch = packed ? dataCols + ((filtCols - dataCols) & (VECTOR_SIZE - 1)) : dataCols;
+
+    // Stack sizes in full width, so no product of the 16-bit fields wraps
+    assign filtSize  = channels * filtRows * filtCols;
+    assign dataSize  = channels * dataRows * dataPitch;
+
+    // Extent of the dilated filter against the padded data
+    assign filtColSpan   = ((filtCols - 1) << opR[9:8]) + 1;
+    assign filtRowSpan   = ((filtRows - 1) << opR[9:8]) + 1;
+    assign dataColSpan   = dataCols + 2*opR[7:4];
+    assign dataRowSpan   = dataRows + 2*opR[7:4];
+    assign geometryValid = opR[0] || ((filtColSpan <= dataColSpan) && (filtRowSpan <= dataRowSpan));
+
+    assign dimsValid = (filtRows != 0) && (filtCols != 0) && (dataRows != 0) && (dataCols != 0) &&
+                       (filtBase + filtSize <= MAX_SIZE) && (dataBase + dataSize <= MAX_SIZE) &&
+                       geometryValid;
+
+    // Started jobs are busy until the accelerator reports it, jobs holding
+    // the bank only wait for room in the queue
+    assign busy      = accBusyIn | startR;
+    assign refused   = opR[OP_HOLD] ? (accQueueFullIn | startR) : busy;
+    assign resultRd  = rdEnIn && regSel && (regIdx == REG_RESULT);
+
+    // Write Process
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            irqEnR      <= 0;
+            opR         <= 0;
+            filtDimsR   <= 0;
+            dataDimsR   <= 0;
+            quantMultR  <= 0;
+            quantR      <= 0;
+            biasR       <= 0;
+            postR       <= 0;
+            slopeR      <= 0;
+            baseR       <= 0;
+            channelsR   <= 0;
+            perfSelR    <= 0;
+            startR      <= 0;
+            doneR       <= 0;
+            errorR      <= 0;
+            jobsR       <= 0;
+            perfCtrlR   <= 0;
+            irqR        <= 0;
+        end else begin
+            startR      <= 0;
+            perfCtrlR   <= 0;
+
+            // The last result of a job completes it
+            if (resultRd && accValidIn && accLastIn) begin
+                doneR       <= 1;
+            end
+            if (resultRd && !accValidIn) begin
+                errorR[ERR_EMPTY] <= 1;
+            end
+            jobsR       <= jobsR + startR - (resultRd && accValidIn && accLastIn);
+
+            if (regWr) begin
+                case (regIdx)
+                    REG_CONTROL : begin
+                        if (regWrData[0]) begin
+                            if (refused) begin
+                                errorR[ERR_BUSY] <= 1;
+                            end else if (!dimsValid) begin
+                                errorR[ERR_DIMS] <= 1;
+                            end else begin
+                                startR  <= 1;
+                            end
+                        end
+                    end
+                    REG_STATUS : begin
+                        if (regWrData[1]) begin
+                            doneR   <= 0;
+                        end
+                    end
+                    REG_IRQ_ENABLE  : irqEnR     <= regWrData[1:0];
+                    REG_OP          : opR        <= regWrData[OP_WIDTH-1:0];
+                    REG_FILT_DIMS   : filtDimsR  <= regWrData;
+                    REG_DATA_DIMS   : dataDimsR  <= regWrData;
+                    REG_QUANT_MULT  : quantMultR <= regWrData[DATA_WIDTH-1:0];
+                    REG_QUANT       : quantR     <= regWrData[15:0];
+                    REG_BIAS        : biasR      <= regWrData[DATA_WIDTH-1:0];
+                    REG_POST        : postR      <= regWrData[5:0];
+                    REG_SLOPE       : slopeR     <= regWrData[DATA_WIDTH-1:0];
+                    REG_PERF_CTRL   : perfCtrlR  <= regWrData[2:0];
+                    REG_PERF_SEL    : perfSelR   <= regWrData[PERF_SEL_WIDTH-1:0];
+                    REG_ERROR       : errorR     <= errorR & ~regWrData[2:0];
+                    REG_BASE        : baseR      <= regWrData;
+                    REG_CHANNELS    : channelsR  <= regWrData[15:0];
+                    default : begin
+                    end
+                endcase
+            end
+
+            irqR        <= (irqEnR[0] & doneR) | (irqEnR[1] & (|errorR));
+        end
+    end
+
+    // Read Process
+    always @(posedge clkIn) begin
+        rdVar = 0;
+        case (regIdx)
+            REG_STATUS : begin
+                rdVar[3:0]  = {accValidIn, |errorR, doneR, busy};
+                rdVar[7:4]  = jobsR;
+                rdVar[8]    = accQueueFullIn;
+                rdVar[31:16] = accCountIn;
+            end
+            REG_IRQ_ENABLE  : rdVar = irqEnR;
+            REG_OP          : rdVar = opR;
+            REG_FILT_DIMS   : rdVar = filtDimsR;
+            REG_DATA_DIMS   : rdVar = dataDimsR;
+            REG_QUANT_MULT  : rdVar = quantMultR;
+            REG_QUANT       : rdVar = quantR;
+            REG_BIAS        : rdVar = biasR;
+            REG_POST        : rdVar = postR;
+            REG_SLOPE       : rdVar = slopeR;
+            REG_RESULT      : rdVar = accValidIn ? accDataIn : 0;
+            REG_PERF_SEL    : rdVar = perfSelR;
+            REG_PERF_DATA   : rdVar = accPerfDataIn;
+            REG_ERROR       : rdVar = errorR;
+            REG_BASE        : rdVar = baseR;
+            REG_CHANNELS    : rdVar = channelsR;
+            default : begin
+            end
+        endcase
+        rdDataR     <= rdVar;
+    end
+
+    // Valid Process
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            rdValidR    <= 0;
+        end else begin
+            rdValidR    <= rdEnIn && regSel;
+        end
+    end
+
+    assign rdDataOut          = {REG_LANES{rdDataR}};
+    assign rdValidOut         = rdValidR;
+    assign irqOut             = irqR;
+
+    // Results are removed as they are read
+    assign accReadyOut        = resultRd;
+
+    assign accStartOut        = startR;
+    assign accOpTypeOut       = opR[0];
+    assign accStrideLog2Out   = opR[3:2];
+    assign accPadOut          = opR[7:4];
+    assign accDilationLog2Out = opR[9:8];
+    assign accPackOut         = opR[10];
+    assign accQuantMultOut    = quantMultR;
+    assign accQuantShiftOut   = quantR[SHIFT_WIDTH-1:0];
+    assign accQuantZeroOut    = quantR[8+:ZERO_WIDTH];
+    assign accBiasEnOut       = postR[0];
+    assign accBiasOut         = biasR;
+    assign accActOut          = postR[2:1];
+    assign accSlopeOut        = slopeR;
+    assign accPoolSizeOut     = postR[4:3];
+    assign accPoolAvgOut      = postR[5];
+    assign accFiltRowsOut     = filtRows[DIM_WIDTH-1:0];
+    assign accFiltColsOut     = filtCols[DIM_WIDTH-1:0];
+    assign accDataRowsOut     = dataRows[DIM_WIDTH-1:0];
+    assign accDataColsOut     = dataCols[DIM_WIDTH-1:0];
+    assign accChannelsOut     = channelsR[DIM_WIDTH-1:0];
+    assign accDataBaseOut     = dataBase[DIM_WIDTH-2:0];
+    assign accFiltBaseOut     = filtBase[DIM_WIDTH-2:0];
+    assign accHoldBankOut     = opR[OP_HOLD];
+    assign accPerfStartOut    = perfCtrlR[0];
+    assign accPerfStopOut     = perfCtrlR[1];
+    assign accPerfClearOut    = perfCtrlR[2];
+    assign accPerfSelOut      = perfSelR;
+
+endmodule
@@ -0,0 +1,144 @@
+`timescale 1ns/1ns
+
+module fifo_async (
+    wrClkIn,
+    wrRstIn,
+    wrDataIn,
+    wrValidIn,
+    wrReadyOut,
+    rdClkIn,
+    rdRstIn,
+    rdDataOut,
+    rdValidOut,
+    rdReadyIn);
+
+    // FIFO between two asynchronous clock domains
+    //
+    // The write and read pointers count in Gray code, so only one bit
+    // changes per word and each pointer can be passed to the other domain
+    // through a chain of SYNC_STAGES flip-flops. The write side compares
+    // its pointer with the synchronized read pointer for full, the read
+    // side its pointer with the synchronized write pointer for empty. Both
+    // flags are pessimistic while a pointer crosses: a word written is
+    // visible to the read side SYNC_STAGES + 1 read clocks later, and a
+    // word read frees its entry SYNC_STAGES + 1 write clocks later.
+    //
+    // The ports follow fifo.v: a word is written when wrValidIn and
+    // wrReadyOut are high and read when rdValidOut and rdReadyIn are high,
+    // rdDataOut holds the oldest word (first word fall through). The
+    // entries are read asynchronously (distributed RAM). wrRstIn and
+    // rdRstIn must overlap and be synchronous to their own clock.
+
+    // FIFO parameters
+    // FIFO_DEPTH must be a power of two of at least 4
+    parameter DATA_WIDTH  = 32;
+    parameter FIFO_DEPTH  = 16;
+    parameter SYNC_STAGES = 2;
+
+    // Derived FIFO parameters
+    localparam ADDR_WIDTH = $clog2(FIFO_DEPTH);
+    localparam PTR_WIDTH  = ADDR_WIDTH + 1;
+
+    // Inputs and Outputs
+    input  wrClkIn;
+    input  wrRstIn;
+    input  [DATA_WIDTH-1:0] wrDataIn;
+    input  wrValidIn;
+    output wrReadyOut;
+
+    input  rdClkIn;
+    input  rdRstIn;
+    output [DATA_WIDTH-1:0] rdDataOut;
+    output rdValidOut;
+    input  rdReadyIn;
+
+    // Validate FIFO depth
+    initial begin
+        if ((FIFO_DEPTH < 4) || (FIFO_DEPTH != (1 << ADDR_WIDTH))) begin
+            $error("Unsupported FIFO depth %0d. Must be a power of two of at least 4", FIFO_DEPTH);
+        end
+    end
+
+    // Entries
+    reg [DATA_WIDTH-1:0] ram [0:FIFO_DEPTH-1];
+
+    // Write domain
+    reg [PTR_WIDTH-1:0] wrBinR;
+    reg [PTR_WIDTH-1:0] wrGrayR;
+    reg [SYNC_STAGES*PTR_WIDTH-1:0] rdGraySyncR;
+    reg fullR;
+
+    wire [PTR_WIDTH-1:0] wrBinNext;
+    wire [PTR_WIDTH-1:0] wrGrayNext;
+    wire [PTR_WIDTH-1:0] rdGrayWr;
+    wire wrEn;
+
+    // Read domain
+    reg [PTR_WIDTH-1:0] rdBinR;
+    reg [PTR_WIDTH-1:0] rdGrayR;
+    reg [SYNC_STAGES*PTR_WIDTH-1:0] wrGraySyncR;
+    reg emptyR;
+
+    wire [PTR_WIDTH-1:0] rdBinNext;
+    wire [PTR_WIDTH-1:0] rdGrayNext;
+    wire [PTR_WIDTH-1:0] wrGrayRd;
+    wire rdEn;
+
+    // Only write when there will be no overflows
+    assign wrEn       = wrValidIn & !fullR;
+    assign wrBinNext  = wrBinR + wrEn;
+    assign wrGrayNext = (wrBinNext >> 1) ^ wrBinNext;
+
+    // Read pointer after the synchronizer
+    assign rdGrayWr   = rdGraySyncR[SYNC_STAGES*PTR_WIDTH-1-:PTR_WIDTH];
+
+    // Write Process
+    always @(posedge wrClkIn) begin
+        if (wrEn) begin
+            ram[wrBinR[ADDR_WIDTH-1:0]] <= wrDataIn;
+        end
+        if (wrRstIn) begin
+            wrBinR      <= 0;
+            wrGrayR     <= 0;
+            rdGraySyncR <= 0;
+            fullR       <= 0;
+        end else begin
+            wrBinR      <= wrBinNext;
+            wrGrayR     <= wrGrayNext;
+            rdGraySyncR <= {rdGraySyncR, rdGrayR};
+
+            // Full when the write pointer is one lap ahead of the read
+            // pointer, in Gray code the two top bits differ
+            fullR       <= (wrGrayNext == {~rdGrayWr[PTR_WIDTH-1:PTR_WIDTH-2], rdGrayWr[PTR_WIDTH-3:0]});
+        end
+    end
+
+    // Only read when the data is valid
+    assign rdEn       = rdReadyIn & !emptyR;
+    assign rdBinNext  = rdBinR + rdEn;
+    assign rdGrayNext = (rdBinNext >> 1) ^ rdBinNext;
+
+    // Write pointer after the synchronizer
+    assign wrGrayRd   = wrGraySyncR[SYNC_STAGES*PTR_WIDTH-1-:PTR_WIDTH];
+
+    // Read Process
+    always @(posedge rdClkIn) begin
+        if (rdRstIn) begin
+            rdBinR      <= 0;
+            rdGrayR     <= 0;
+            wrGraySyncR <= 0;
+            emptyR      <= 1;
+        end else begin
+            rdBinR      <= rdBinNext;
+            rdGrayR     <= rdGrayNext;
+            wrGraySyncR <= {wrGraySyncR, wrGrayR};
+            emptyR      <= (rdGrayNext == wrGrayRd);
+        end
+    end
+
+    // Assign outputs
+    assign wrReadyOut = !fullR;
+    assign rdDataOut  = ram[rdBinR[ADDR_WIDTH-1:0]];
+    assign rdValidOut = !emptyR;
+
+endmodule
@@ -0,0 +1,124 @@
+`timescale 1ns / 1ns
+
+module floating_point_convert (
+     clkIn,
+     rstIn,
+     dataIn,
+     validIn,
+     dataOut,
+     validOut
+);
+
+    // Widening conversion between floating-point types, e.g. bfloat16
+    // (FRAC_WIDTH = 8, EXP_WIDTH = 8) or FP16 (FRAC_WIDTH = 11,
+    // EXP_WIDTH = 5) to single precision. Every input is exactly
+    // representable in the output type, so no rounding is needed.
+    // Subnormal inputs are normalized when the output exponent is wider,
+    // which assumes OUT_BIAS - IN_BIAS >= IN_MANTISSA_WIDTH.
+    // NaN payloads are kept in the upper mantissa bits.
+
+    // Parameters to define floating-point types
+    parameter IN_FRAC_WIDTH         = 8;
+    parameter IN_EXP_WIDTH          = 8;
+    parameter OUT_FRAC_WIDTH        = 24;
+    parameter OUT_EXP_WIDTH         = 8;
+
+    // Derived parameters for floating-point types
+    localparam IN_DATA_WIDTH        = IN_FRAC_WIDTH + IN_EXP_WIDTH;
+    localparam OUT_DATA_WIDTH       = OUT_FRAC_WIDTH + OUT_EXP_WIDTH;
+    localparam IN_MANTISSA_WIDTH    = IN_FRAC_WIDTH - 1;
+    localparam OUT_MANTISSA_WIDTH   = OUT_FRAC_WIDTH - 1;
+    localparam MANTISSA_SHIFT       = OUT_MANTISSA_WIDTH - IN_MANTISSA_WIDTH;
+
+    // Parameters to select sub-regions of the input float
+    localparam MANTISSA_LO          = 0;
+    localparam MANTISSA_HI          = MANTISSA_LO + IN_MANTISSA_WIDTH - 1;
+    localparam EXP_LO               = MANTISSA_HI + 1;
+    localparam EXP_HI               = EXP_LO + IN_EXP_WIDTH - 1;
+    localparam SIGN_IDX             = EXP_HI + 1;
+
+    // Maximum exponent values and biases
+    localparam IN_MAX_EXP           = 2**IN_EXP_WIDTH - 1;
+    localparam OUT_MAX_EXP          = 2**OUT_EXP_WIDTH - 1;
+    localparam IN_BIAS              = 2**(IN_EXP_WIDTH - 1) - 1;
+    localparam OUT_BIAS             = 2**(OUT_EXP_WIDTH - 1) - 1;
+
+    // Latency of module
+    localparam LATENCY              = 1;
+
+    input clkIn, rstIn;
+    input [IN_DATA_WIDTH-1:0] dataIn;
+    input validIn;
+
+    output [OUT_DATA_WIDTH-1:0] dataOut;
+    output validOut;
+
+    // Input fields
+    wire inSign;
+    wire [   IN_EXP_WIDTH-1:0] inExp;
+    wire [IN_MANTISSA_WIDTH-1:0] inMantissa;
+
+    assign inSign       = dataIn[SIGN_IDX];
+    assign inExp        = dataIn[EXP_HI:EXP_LO];
+    assign inMantissa   = dataIn[MANTISSA_HI:MANTISSA_LO];
+
+    // Pipeline #1
+    reg validR;
+    reg outSignR;
+    reg [    OUT_EXP_WIDTH-1:0] outExpR;
+    reg [OUT_MANTISSA_WIDTH-1:0] outMantissaR;
+
+    // Normalization of subnormal inputs
+    reg [IN_MANTISSA_WIDTH-1:0] normMantissaVar;
+    reg [  OUT_EXP_WIDTH-1:0] normExpVar;
+
+    integer i;
+
+    always @(posedge clkIn) begin
+
+        // Shift the leading one of a subnormal mantissa out of the field
+        normMantissaVar = inMantissa;
+        normExpVar      = OUT_BIAS - IN_BIAS + 1;
+        for (i = 0; i < IN_MANTISSA_WIDTH; i = i + 1) begin
+            if (!normMantissaVar[IN_MANTISSA_WIDTH-1]) begin
+                normMantissaVar = normMantissaVar << 1;
+                normExpVar      = normExpVar - 1;
+            end
+        end
+        normMantissaVar = normMantissaVar << 1;
+        normExpVar      = normExpVar - 1;
+
+        /* Pipeline #1 */
+        outSignR            <= inSign;
+        if (inExp == IN_MAX_EXP) begin
+            // Infinity and NaN
+            outExpR         <= OUT_MAX_EXP;
+            outMantissaR    <= inMantissa << MANTISSA_SHIFT;
+        end else if (inExp == 0) begin
+            if ((inMantissa == 0) || (IN_EXP_WIDTH == OUT_EXP_WIDTH)) begin
+                // Zero, or subnormal of the same exponent range
+                outExpR         <= 0;
+                outMantissaR    <= inMantissa << MANTISSA_SHIFT;
+            end else begin
+                outExpR         <= normExpVar;
+                outMantissaR    <= normMantissaVar << MANTISSA_SHIFT;
+            end
+        end else begin
+            outExpR         <= inExp + OUT_BIAS - IN_BIAS;
+            outMantissaR    <= inMantissa << MANTISSA_SHIFT;
+        end
+    end
+
+    // Valid Process
+    always @(posedge clkIn or posedge rstIn) begin
+        if (rstIn) begin
+            validR <= 0;
+        end else begin
+            validR <= validIn;
+        end
+    end
+
+    assign dataOut  = {outSignR, outExpR, outMantissaR};
+    assign validOut = validR;
+
+endmodule
@@ -0,0 +1,117 @@
+`timescale 1ns/1ns
+
+module integer_multiply_and_accumulate (
+    clkIn,
+    rstIn,
+    dataAIn,
+    dataBIn,
+    validIn,
+    lastIn,
+    tagIn,
+    dataOut,
+    validOut,
+    tagOut);
+
+    // Signed integer counterpart of multiply_and_accumulate
+    // Products are summed by a registered adder tree and accumulated in
+    // ACC_WIDTH bits, which wrap on overflow. One accumulation completes
+    // per lastIn, the tag of its last beat is returned with the result.
+
+    // Width of the signed operands and of the accumulator
+    parameter DATA_WIDTH    = 8;
+    parameter ACC_WIDTH     = 32;
+
+    // Number of vectorized inputs
+    parameter VECTOR_SIZE   = 32;
+
+    // Width of the tag passed along with each accumulation
+    parameter TAG_WIDTH     = 1;
+
+    // Number of stages
+    localparam NUM_STAGES   = $clog2(VECTOR_SIZE);
+
+    // Port declarations
+    input clkIn;
+    input rstIn;
+
+    input [DATA_WIDTH*VECTOR_SIZE-1:0] dataAIn;
+    input [DATA_WIDTH*VECTOR_SIZE-1:0] dataBIn;
+    input [VECTOR_SIZE-1:0] validIn;
+    input lastIn;
+    input [TAG_WIDTH-1:0] tagIn;
+
+    output [ACC_WIDTH-1:0] dataOut;
+    output validOut;
+    output [TAG_WIDTH-1:0] tagOut;
+
+    // Adder tree, stage 0 holds the products (zero for invalid lanes)
+    // and stage i holds VECTOR_SIZE >> i partial sums
+    reg signed [ACC_WIDTH-1:0] treeR [0:NUM_STAGES][0:VECTOR_SIZE-1];
+
+    // Beat control along the tree
+    reg [NUM_STAGES:0] validR;
+    reg [NUM_STAGES:0] lastR;
+    reg [TAG_WIDTH-1:0] tagR [0:NUM_STAGES];
+
+    // Accumulator
+    reg signed [ACC_WIDTH-1:0] accumR;
+    reg signed [ACC_WIDTH-1:0] accumVar;
+    reg firstR;
+    reg [ACC_WIDTH-1:0] outDataR;
+    reg outValidR;
+    reg [TAG_WIDTH-1:0] outTagR;
+
+    integer i, j;
+
+    // Data Process
+    always @(posedge clkIn) begin
+
+        // Pipeline #1
+        for (j = 0; j < VECTOR_SIZE; j = j + 1) begin
+            if (validIn[j]) begin
+                treeR[0][j] <= $signed(dataAIn[j*DATA_WIDTH+:DATA_WIDTH]) * $signed(dataBIn[j*DATA_WIDTH+:DATA_WIDTH]);
+            end else begin
+                treeR[0][j] <= 0;
+            end
+        end
+        tagR[0]     <= tagIn;
+
+        // Adder tree, one level per cycle
+        for (i = 1; i <= NUM_STAGES; i = i + 1) begin
+            for (j = 0; j < (VECTOR_SIZE >> i); j = j + 1) begin
+                treeR[i][j] <= treeR[i-1][2*j] + treeR[i-1][2*j+1];
+            end
+            tagR[i]     <= tagR[i-1];
+        end
+
+        // Accumulate, the first beat after a last beat restarts the sum
+        accumVar = (firstR ? 0 : accumR) + treeR[NUM_STAGES][0];
+        if (validR[NUM_STAGES]) begin
+            accumR      <= accumVar;
+        end
+        outDataR    <= accumVar;
+        outTagR     <= tagR[NUM_STAGES];
+    end
+
+    // Valid Process
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            validR      <= 0;
+            lastR       <= 0;
+            firstR      <= 1;
+            outValidR   <= 0;
+        end else begin
+            validR      <= {validR[NUM_STAGES-1:0], |validIn};
+            lastR       <= {lastR[NUM_STAGES-1:0], lastIn & (|validIn)};
+            if (validR[NUM_STAGES]) begin
+                firstR  <= lastR[NUM_STAGES];
+            end
+            outValidR   <= validR[NUM_STAGES] & lastR[NUM_STAGES];
+        end
+    end
+
+    assign dataOut  = outDataR;
+    assign validOut = outValidR;
+    assign tagOut   = outTagR;
+
+endmodule
@@ -0,0 +1,132 @@
+`timescale 1ns/1ns
+
+module integer_requantize (
+    clkIn,
+    rstIn,
+    dataIn,
+    validIn,
+    biasIn,
+    reluIn,
+    multIn,
+    shiftIn,
+    zeroIn,
+    dataOut,
+    validOut);
+
+    // Per-tensor requantization of integer accumulations
+    //
+    //   acc = data + bias
+    //   out = clamp(((acc * mult) + 2^(shift-1)) >>> shift + zero)
+    //
+    // The bias add wraps in ACC_WIDTH bits. acc * mult is the full
+    // 2*ACC_WIDTH-bit signed product, rounding is half up (no rounding term
+    // when shift is zero) and the result is clamped to a signed
+    // OUT_WIDTH-bit value, returned sign-extended. With reluIn the lower
+    // clamp is the zero point, which is ReLU in the quantized domain.
+    // A zero multiplier passes acc through (clamped at zero with reluIn).
+
+    // Width of the accumulation and of the requantized value
+    parameter ACC_WIDTH     = 32;
+    parameter OUT_WIDTH     = 8;
+
+    // Derived parameters
+    localparam PROD_WIDTH   = 2*ACC_WIDTH;
+    localparam SHIFT_WIDTH  = $clog2(PROD_WIDTH);
+    localparam OUT_MAX      = 2**(OUT_WIDTH-1) - 1;
+    localparam OUT_MIN      = -(2**(OUT_WIDTH-1));
+
+    // Latency of module
+    localparam LATENCY      = 4;
+
+    // Port declarations
+    input clkIn;
+    input rstIn;
+
+    input [ACC_WIDTH-1:0] dataIn;
+    input validIn;
+    input [ ACC_WIDTH-1:0] biasIn;
+    input reluIn;
+    input [ ACC_WIDTH-1:0] multIn;
+    input [SHIFT_WIDTH-1:0] shiftIn;
+    input [ OUT_WIDTH-1:0] zeroIn;
+
+    output [ACC_WIDTH-1:0] dataOut;
+    output validOut;
+
+    // Pipeline #1
+    reg [ACC_WIDTH-1:0] accR;
+    reg [ ACC_WIDTH-1:0] multR;
+    reg [SHIFT_WIDTH-1:0] shiftR;
+    reg signed [OUT_WIDTH-1:0] zeroR;
+    reg reluR;
+
+    // Pipeline #2
+    reg signed [PROD_WIDTH-1:0] prod2R;
+    reg [ACC_WIDTH-1:0] raw2R;
+    reg bypass2R;
+    reg [SHIFT_WIDTH-1:0] shift2R;
+    reg signed [OUT_WIDTH-1:0] zero2R;
+    reg relu2R;
+
+    // Pipeline #3
+    reg signed [PROD_WIDTH-1:0] sum3R;
+    reg [ACC_WIDTH-1:0] raw3R;
+    reg bypass3R;
+    reg signed [PROD_WIDTH-1:0] min3R;
+    reg signed [PROD_WIDTH-1:0] roundVar;
+
+    // Pipeline #4
+    reg [ACC_WIDTH-1:0] data4R;
+
+    reg [LATENCY-1:0] validR;
+
+    // Data Process
+    always @(posedge clkIn) begin
+
+        // Pipeline #1
+        accR        <= dataIn + biasIn;
+        multR       <= multIn;
+        shiftR      <= shiftIn;
+        zeroR       <= zeroIn;
+        reluR       <= reluIn;
+
+        // Pipeline #2
+        prod2R      <= $signed(accR) * $signed(multR);
+        raw2R       <= accR;
+        bypass2R    <= (multR == 0);
+        shift2R     <= shiftR;
+        zero2R      <= zeroR;
+        relu2R      <= reluR;
+
+        // Pipeline #3
+        roundVar    = (shift2R == 0) ? 0 : ({{(PROD_WIDTH-1){1'b0}}, 1'b1} << (shift2R - 1));
+        sum3R       <= ((prod2R + roundVar) >>> shift2R) + zero2R;
+        raw3R       <= (relu2R && raw2R[ACC_WIDTH-1]) ? 0 : raw2R;
+        bypass3R    <= bypass2R;
+        min3R       <= relu2R ? zero2R : OUT_MIN;
+
+        // Pipeline #4
+        if (bypass3R) begin
+            data4R  <= raw3R;
+        end else if (sum3R > OUT_MAX) begin
+            data4R  <= OUT_MAX;
+        end else if (sum3R < min3R) begin
+            data4R  <= min3R;
+        end else begin
+            data4R  <= sum3R[ACC_WIDTH-1:0];
+        end
+    end
+
+    // Valid Process
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            validR  <= 0;
+        end else begin
+            validR  <= {validR[LATENCY-2:0], validIn};
+        end
+    end
+
+    assign dataOut  = data4R;
+    assign validOut = validR[LATENCY-1];
+
+endmodule
@@ -14,15 +14,23 @@ module multiply_and_accumulate (
     parameter FRAC_WIDTH    = 24;
     parameter EXP_WIDTH     = 8;
     
+    // Floating-point type of the inputs, narrower inputs (e.g. bfloat16)
+    // are widened to FRAC_WIDTH/EXP_WIDTH before the multipliers
+    parameter IN_FRAC_WIDTH = FRAC_WIDTH;
+    parameter IN_EXP_WIDTH  = EXP_WIDTH;
+    
     // Number of vectorized inputs
     parameter VECTOR_SIZE   = 8;
     
     // Derived floating point Parameters
     localparam DATA_WIDTH   = FRAC_WIDTH + EXP_WIDTH;
+    localparam IN_WIDTH     = IN_FRAC_WIDTH + IN_EXP_WIDTH;
+    localparam CONVERT      = (IN_FRAC_WIDTH != FRAC_WIDTH) || (IN_EXP_WIDTH != EXP_WIDTH);
     
     // Latency of Submodules
     localparam ADD_LATENCY  = 13;
     localparam MULT_LATENCY = 10;
+    localparam CONV_LATENCY = CONVERT ? 1 : 0;
     
     // Number of stages
     localparam NUM_STAGES   = $clog2(VECTOR_SIZE);
@@ -31,8 +39,8 @@ module multiply_and_accumulate (
     input clkIn;
     input rstIn;
     
-    input [DATA_WIDTH*VECTOR_SIZE-1:0] dataAIn;
-    input [DATA_WIDTH*VECTOR_SIZE-1:0] dataBIn;
+    input [IN_WIDTH*VECTOR_SIZE-1:0] dataAIn;
+    input [IN_WIDTH*VECTOR_SIZE-1:0] dataBIn;
     input [VECTOR_SIZE-1:0] validIn;
     input lastIn;
     
@@ -60,9 +68,40 @@ module multiply_and_accumulate (
         
             wire [DATA_WIDTH-1:0] dataA;
             wire [DATA_WIDTH-1:0] dataB;
+            wire valid;
+            
+            if (CONVERT) begin
             
-            assign dataA = dataAIn[(i*DATA_WIDTH) +: DATA_WIDTH];
-            assign dataB = dataBIn[(i*DATA_WIDTH) +: DATA_WIDTH];
+                // Widen inputs, products of the narrow inputs are exact
+                floating_point_convert #(
+                    .IN_FRAC_WIDTH(IN_FRAC_WIDTH),
+                    .IN_EXP_WIDTH(IN_EXP_WIDTH),
+                    .OUT_FRAC_WIDTH(FRAC_WIDTH),
+                    .OUT_EXP_WIDTH(EXP_WIDTH)) conv_a (
+                    .clkIn(clkIn),
+                    .rstIn(rstIn),
+                    .dataIn(dataAIn[(i*IN_WIDTH) +: IN_WIDTH]),
+                    .validIn(validIn[i]),
+                    .dataOut(dataA),
+                    .validOut(valid));
+                    
+                floating_point_convert #(
+                    .IN_FRAC_WIDTH(IN_FRAC_WIDTH),
+                    .IN_EXP_WIDTH(IN_EXP_WIDTH),
+                    .OUT_FRAC_WIDTH(FRAC_WIDTH),
+                    .OUT_EXP_WIDTH(EXP_WIDTH)) conv_b (
+                    .clkIn(clkIn),
+                    .rstIn(rstIn),
+                    .dataIn(dataBIn[(i*IN_WIDTH) +: IN_WIDTH]),
+                    .validIn(validIn[i]),
+                    .dataOut(dataB),
+                    .validOut());
+                    
+            end else begin
+                assign dataA = dataAIn[(i*DATA_WIDTH) +: DATA_WIDTH];
+                assign dataB = dataBIn[(i*DATA_WIDTH) +: DATA_WIDTH];
+                assign valid = validIn[i];
+            end
             
             // Elementwise multiplication
             floating_point_multiply #(.FRAC_WIDTH(FRAC_WIDTH), .EXP_WIDTH(EXP_WIDTH)) mult_j (
@@ -70,14 +109,14 @@ module multiply_and_accumulate (
                 .rstIn(rstIn),
                 .dataAIn(dataA),
                 .dataBIn(dataB),
-                .validIn(validIn[i]),
+                .validIn(valid),
                 .dataOut(multData[i]),
                 .validOut(multValid[i]));
         end
     endgenerate
     
     // Pipeline last signal
-    delay #(.DATA_WIDTH(1), .LATENCY(MULT_LATENCY)) delay_i (
+    delay #(.DATA_WIDTH(1), .LATENCY(CONV_LATENCY + MULT_LATENCY)) delay_i (
         .clkIn(clkIn),
         .rstIn(rstIn),
         .dataIn(lastIn),
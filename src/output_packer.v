@@ -0,0 +1,93 @@
+`timescale 1ns/1ns
+
+module output_packer (
+    clkIn,
+    rstIn,
+    dataIn,
+    validIn,
+    lastIn,
+    dataOut,
+    keepOut,
+    lastOut,
+    validOut);
+
+    // Packs results into words of OUT_WIDTH bits
+    // Results fill the lanes of a word starting at the least significant
+    // lane. A word is written once every lane is filled, or early at the
+    // last result of a job (lastIn), in which case keepOut marks the lanes
+    // that hold results and the others are zero. Words never hold results
+    // of two jobs.
+
+    // Width of a result and of a packed word
+    parameter DATA_WIDTH    = 32;
+    parameter OUT_WIDTH     = 64;
+
+    // Derived parameters
+    localparam NUM_LANES    = OUT_WIDTH/DATA_WIDTH;
+    localparam LANE_WIDTH   = (NUM_LANES > 1) ? $clog2(NUM_LANES) : 1;
+
+    // Port declarations
+    input clkIn;
+    input rstIn;
+
+    input [DATA_WIDTH-1:0] dataIn;
+    input validIn;
+    input lastIn;
+
+    output [OUT_WIDTH-1:0] dataOut;
+    output [NUM_LANES-1:0] keepOut;
+    output lastOut;
+    output validOut;
+
+    // Word being filled
+    reg [LANE_WIDTH-1:0] laneR;
+    reg [OUT_WIDTH-1:0] wordR;
+    reg [NUM_LANES-1:0] keepR;
+    reg [OUT_WIDTH-1:0] wordVar;
+    reg [NUM_LANES-1:0] keepVar;
+
+    // Output registers
+    reg [OUT_WIDTH-1:0] dataR;
+    reg [NUM_LANES-1:0] keepOutR;
+    reg lastR;
+    reg validR;
+
+    // Data Process
+    always @(posedge clkIn) begin
+        if (validIn) begin
+            // The first lane starts a new word
+            wordVar     = (laneR == 0) ? 0 : wordR;
+            keepVar     = (laneR == 0) ? 0 : keepR;
+            wordVar[laneR*DATA_WIDTH+:DATA_WIDTH] = dataIn;
+            keepVar[laneR] = 1'b1;
+            wordR       <= wordVar;
+            keepR       <= keepVar;
+            dataR       <= wordVar;
+            keepOutR    <= keepVar;
+            lastR       <= lastIn;
+        end
+    end
+
+    // Valid Process
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            laneR   <= 0;
+            validR  <= 0;
+        end else begin
+            validR  <= validIn && (lastIn || (laneR == NUM_LANES - 1));
+            if (validIn) begin
+                if (lastIn || (laneR == NUM_LANES - 1)) begin
+                    laneR   <= 0;
+                end else begin
+                    laneR   <= laneR + 1;
+                end
+            end
+        end
+    end
+
+    assign dataOut  = dataR;
+    assign keepOut  = keepOutR;
+    assign lastOut  = lastR;
+    assign validOut = validR;
+
+endmodule
@@ -0,0 +1,82 @@
+`timescale 1ns/1ns
+
+module perf_counters (
+    clkIn,
+    rstIn,
+    startIn,
+    stopIn,
+    clearIn,
+    eventsIn,
+    selIn,
+    runningOut,
+    dataOut);
+
+    // Bank of event counters with start/stop/clear controls
+    // Counter i adds the EVENT_WIDTH-bit increment i of eventsIn every
+    // cycle while running. startIn and stopIn switch counting on and off,
+    // clearIn zeroes every counter (and takes priority over the events of
+    // the same cycle). Counters saturate instead of wrapping. dataOut is
+    // counter selIn, registered.
+
+    // Number of counters, width of each increment and of each counter
+    parameter NUM_EVENTS    = 8;
+    parameter EVENT_WIDTH   = 8;
+    parameter COUNT_WIDTH   = 32;
+
+    // Derived parameters
+    localparam SEL_WIDTH    = (NUM_EVENTS > 1) ? $clog2(NUM_EVENTS) : 1;
+    localparam COUNT_MAX    = {COUNT_WIDTH{1'b1}};
+
+    // Port declarations
+    input clkIn;
+    input rstIn;
+
+    input startIn;
+    input stopIn;
+    input clearIn;
+    input [NUM_EVENTS*EVENT_WIDTH-1:0] eventsIn;
+    input [SEL_WIDTH-1:0] selIn;
+
+    output runningOut;
+    output [COUNT_WIDTH-1:0] dataOut;
+
+    reg runningR;
+    reg [COUNT_WIDTH-1:0] countR [0:NUM_EVENTS-1];
+    reg [COUNT_WIDTH:0] sumVar;
+    reg [COUNT_WIDTH-1:0] dataR;
+
+    integer i;
+
+    // Count Process
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            runningR    <= 0;
+            for (i = 0; i < NUM_EVENTS; i = i + 1) begin
+                countR[i] <= 0;
+            end
+        end else begin
+            if (startIn) begin
+                runningR    <= 1;
+            end else if (stopIn) begin
+                runningR    <= 0;
+            end
+            for (i = 0; i < NUM_EVENTS; i = i + 1) begin
+                sumVar = countR[i] + eventsIn[i*EVENT_WIDTH+:EVENT_WIDTH];
+                if (clearIn) begin
+                    countR[i] <= 0;
+                end else if (runningR) begin
+                    countR[i] <= sumVar[COUNT_WIDTH] ? COUNT_MAX : sumVar[COUNT_WIDTH-1:0];
+                end
+            end
+        end
+    end
+
+    // Read Process
+    always @(posedge clkIn) begin
+        dataR   <= countR[selIn];
+    end
+
+    assign runningOut = runningR;
+    assign dataOut    = dataR;
+
+endmodule
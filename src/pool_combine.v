@@ -0,0 +1,125 @@
+`timescale 1ns/1ns
+
+module pool_combine (
+    clkIn,
+    rstIn,
+    dataAIn,
+    dataBIn,
+    validIn,
+    combineIn,
+    avgIn,
+    dataOut,
+    validOut);
+
+    // Combines two samples of a pooling window
+    //
+    //   out = combine ? (avg ? a + b : max(a, b)) : a
+    //
+    // "FLOAT" samples are added by floating_point_add and compared in the
+    // IEEE-754 total order (-NaN < -Inf < ... < -0 < +0 < ... < +Inf < +NaN).
+    // "INT8" samples are signed ACC_WIDTH-bit integers, sums wrap.
+    // Latency is fixed for every operation, so samples stay in order.
+
+    // Parameters to define floating-point type
+    parameter FRAC_WIDTH    = 24;
+    parameter EXP_WIDTH     = 8;
+
+    // Sample type, "FLOAT" or "INT8" (see cnn_hw_accelerator.v)
+    parameter MAC_STYLE     = "FLOAT";
+
+    // Derived parameters
+    localparam DATA_WIDTH   = FRAC_WIDTH + EXP_WIDTH;
+    localparam SIGN_IDX     = DATA_WIDTH - 1;
+
+    // Latency of module, floating_point_add.v or a single register
+    localparam ADD_LATENCY  = 13;
+    localparam LATENCY      = (MAC_STYLE == "INT8") ? 1 : ADD_LATENCY;
+
+    // Port declarations
+    input clkIn;
+    input rstIn;
+
+    input [DATA_WIDTH-1:0] dataAIn;
+    input [DATA_WIDTH-1:0] dataBIn;
+    input validIn;
+    input combineIn;
+    input avgIn;
+
+    output [DATA_WIDTH-1:0] dataOut;
+    output validOut;
+
+    reg [LATENCY-1:0] validR;
+
+    generate
+        if (MAC_STYLE == "INT8") begin
+
+            // Pipeline #1
+            reg [DATA_WIDTH-1:0] dataR;
+
+            always @(posedge clkIn) begin
+                if (!combineIn) begin
+                    dataR   <= dataAIn;
+                end else if (avgIn) begin
+                    dataR   <= dataAIn + dataBIn;
+                end else if ($signed(dataBIn) > $signed(dataAIn)) begin
+                    dataR   <= dataBIn;
+                end else begin
+                    dataR   <= dataAIn;
+                end
+            end
+
+            assign dataOut = dataR;
+
+        end else begin
+
+            // Total order keys, negative values compare reversed
+            wire [DATA_WIDTH-1:0] keyA;
+            wire [DATA_WIDTH-1:0] keyB;
+
+            assign keyA = dataAIn[SIGN_IDX] ? ~dataAIn : {1'b1, dataAIn[SIGN_IDX-1:0]};
+            assign keyB = dataBIn[SIGN_IDX] ? ~dataBIn : {1'b1, dataBIn[SIGN_IDX-1:0]};
+
+            // Sum of both samples
+            wire [DATA_WIDTH-1:0] sum;
+
+            floating_point_add #(
+                .FRAC_WIDTH(FRAC_WIDTH),
+                .EXP_WIDTH(EXP_WIDTH)) add (
+                .clkIn(clkIn),
+                .rstIn(rstIn),
+                .dataAIn(dataAIn),
+                .dataBIn(dataBIn),
+                .validIn(validIn),
+                .dataOut(sum),
+                .validOut());
+
+            // Delay the maximum and the selects to match the adder
+            wire [DATA_WIDTH-1:0] max;
+            wire useSum;
+
+            delay #(
+                .LATENCY(ADD_LATENCY),
+                .DATA_WIDTH(DATA_WIDTH+1)) max_delay (
+                .clkIn(clkIn),
+                .rstIn(1'b0),
+                .dataIn({combineIn & avgIn, ((combineIn && (keyB > keyA)) ? dataBIn : dataAIn)}),
+                .dataOut({useSum, max}));
+
+            assign dataOut = useSum ? sum : max;
+
+        end
+    endgenerate
+
+    // Valid Process
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            validR  <= 0;
+        end else begin
+            // Shift in at the bottom, the top bit falls off
+            validR  <= {validR, validIn};
+        end
+    end
+
+    assign validOut = validR[LATENCY-1];
+
+endmodule
@@ -0,0 +1,606 @@
+`timescale 1ns/1ns
+
+module post_process (
+    clkIn,
+    rstIn,
+    jobValidIn,
+    biasEnIn,
+    biasIn,
+    actIn,
+    slopeIn,
+    poolSizeIn,
+    poolAvgIn,
+    maxRowIn,
+    maxColIn,
+    dataIn,
+    validIn,
+    dataOut,
+    lastOut,
+    validOut,
+    dropOut);
+
+    // Fused post-processing of the output stream of cnn_hw_accelerator.v
+    //
+    //   bias:       out = in + bias (biasEnIn)
+    //   activation: ReLU zeroes and leaky ReLU multiplies by slopeIn every
+    //               output with the sign bit set
+    //   pooling:    non-overlapping poolSizeIn x poolSizeIn windows (2 or 3)
+    //               of the maxRowIn+1 x maxColIn+1 output matrix, reduced
+    //               to their maximum or average. Outputs beyond the last
+    //               whole window are dropped, like floor mode pooling.
+    //
+    // Windows are reduced left to right (a0, a1, a2) in every row as
+    // (a0 op a1) op a2, then the row results top to bottom in the same
+    // order. The average multiplies the window sum by 1/4 or 1/9.
+    //
+    // "FLOAT" outputs must be single precision. "INT8" outputs are
+    // requantized integers: bias and ReLU are applied to the accumulation
+    // by integer_requantize.v, so only pooling is done here, and the
+    // average is rounded half up as (sum * 2^16/9 + 2^15) >> 16 (exact
+    // for sums of int8 values).
+    //
+    // The configuration of a job is pushed with jobValidIn when the job
+    // starts and applies to its outputs in order, up to JOB_DEPTH jobs may
+    // be in flight. Every stage has a fixed latency, a disabled stage
+    // passes outputs through unchanged. lastOut marks the last output of
+    // each job.
+    //
+    // dropOut counts the outputs absorbed into a window in each cycle,
+    // columns combined into a row result or row results written to the
+    // line buffer, and outputs outside the last whole window. Every
+    // output leaves as validOut or is counted once by dropOut.
+
+    // Parameters to define floating-point type
+    parameter FRAC_WIDTH        = 24;
+    parameter EXP_WIDTH         = 8;
+
+    // Output type, "FLOAT" or "INT8" (see cnn_hw_accelerator.v)
+    parameter MAC_STYLE         = "FLOAT";
+
+    // Width of the output row and column counts
+    parameter CNT_WIDTH         = 12;
+
+    // Maximum number of pooled columns, depth of the pooling line buffer
+    parameter POOL_COLS         = 1024;
+
+    // Derived parameters
+    localparam DATA_WIDTH       = FRAC_WIDTH + EXP_WIDTH;
+    localparam SIGN_IDX         = DATA_WIDTH - 1;
+    localparam POOL_ADDR_WIDTH  = (POOL_COLS > 1) ? $clog2(POOL_COLS) : 1;
+
+    // Activation types
+    localparam ACT_NONE         = 0;
+    localparam ACT_RELU         = 1;
+    localparam ACT_LEAKY        = 2;
+
+    // Queue of job configurations
+    localparam JOB_DEPTH        = 4;
+    localparam JOB_ADDR_WIDTH   = $clog2(JOB_DEPTH);
+
+    // Single precision reciprocals of the window sizes
+    localparam RECIP_4          = 32'h3E800000;
+    localparam RECIP_9          = 32'h3DE38E39;
+
+    // Integer reciprocals, 2^16/4 and 2^16/9
+    localparam INT_RECIP_4      = 16384;
+    localparam INT_RECIP_9      = 7282;
+    localparam INT_RECIP_SHIFT  = 16;
+
+    // Latency of submodules
+    localparam ADD_LATENCY      = 13;
+    localparam MULT_LATENCY     = 10;
+    localparam COMBINE_LATENCY  = (MAC_STYLE == "INT8") ? 1 : ADD_LATENCY;
+
+    // Pooling controls passed along with each output
+    // {window size, average, last column of window, last row of window,
+    //  last window of job, row of window, pooled column}
+    localparam POOL_CTL_WIDTH   = 2 + 1 + 1 + 1 + 1 + 1 + POOL_ADDR_WIDTH;
+
+    // Port declarations
+    input clkIn;
+    input rstIn;
+
+    input jobValidIn;
+    input biasEnIn;
+    input [DATA_WIDTH-1:0] biasIn;
+    input [1:0] actIn;
+    input [DATA_WIDTH-1:0] slopeIn;
+    input [1:0] poolSizeIn;
+    input poolAvgIn;
+    input [CNT_WIDTH-1:0] maxRowIn;
+    input [CNT_WIDTH-1:0] maxColIn;
+
+    input [DATA_WIDTH-1:0] dataIn;
+    input validIn;
+
+    output [DATA_WIDTH-1:0] dataOut;
+    output lastOut;
+    output validOut;
+    output [1:0] dropOut;
+
+    // Job configuration queue
+    reg jobBiasEnR [0:JOB_DEPTH-1];
+    reg [DATA_WIDTH-1:0] jobBiasR [0:JOB_DEPTH-1];
+    reg [1:0] jobActR [0:JOB_DEPTH-1];
+    reg [DATA_WIDTH-1:0] jobSlopeR [0:JOB_DEPTH-1];
+    reg [1:0] jobPoolR [0:JOB_DEPTH-1];
+    reg jobAvgR [0:JOB_DEPTH-1];
+    reg [CNT_WIDTH-1:0] jobMaxRowR [0:JOB_DEPTH-1];
+    reg [CNT_WIDTH-1:0] jobMaxColR [0:JOB_DEPTH-1];
+    reg [JOB_ADDR_WIDTH-1:0] jobWrPtrR;
+    reg [JOB_ADDR_WIDTH-1:0] jobRdPtrR;
+
+    // Position of the next output in the matrix and in its window
+    reg [CNT_WIDTH-1:0] rowR;
+    reg [CNT_WIDTH-1:0] colR;
+    reg [CNT_WIDTH:0] winRowR;
+    reg [CNT_WIDTH:0] winColR;
+    reg [1:0] hPosR;
+    reg [1:0] vPosR;
+    reg [POOL_ADDR_WIDTH-1:0] pcR;
+    reg [1:0] sizeVar;
+    reg [1:0] poolSizeVar;
+    reg keepVar;
+
+    // Pipeline #1
+    reg [DATA_WIDTH-1:0] data1R;
+    reg valid1R;
+    reg biasEn1R;
+    reg [DATA_WIDTH-1:0] bias1R;
+    reg [1:0] act1R;
+    reg [DATA_WIDTH-1:0] slope1R;
+    reg [1:0] size1R;
+    reg avg1R;
+    reg emit1R;
+    reg last1R;
+    reg final1R;
+    reg vPos1R;
+    reg [POOL_ADDR_WIDTH-1:0] pc1R;
+
+    // Job Queue Process
+    always @(posedge clkIn) begin
+        if (jobValidIn) begin
+            jobBiasEnR[jobWrPtrR]   <= biasEnIn;
+            jobBiasR  [jobWrPtrR]   <= biasIn;
+            jobActR   [jobWrPtrR]   <= actIn;
+            jobSlopeR [jobWrPtrR]   <= slopeIn;
+            jobPoolR  [jobWrPtrR]   <= (poolSizeIn < 2) ? 1 : poolSizeIn;
+            jobAvgR   [jobWrPtrR]   <= poolAvgIn;
+            jobMaxRowR[jobWrPtrR]   <= maxRowIn;
+            jobMaxColR[jobWrPtrR]   <= maxColIn;
+        end
+    end
+
+    // Position Process
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            jobWrPtrR   <= 0;
+            jobRdPtrR   <= 0;
+            rowR        <= 0;
+            colR        <= 0;
+            winRowR     <= 0;
+            winColR     <= 0;
+            hPosR       <= 0;
+            vPosR       <= 0;
+            pcR         <= 0;
+        end else begin
+            if (jobValidIn) begin
+                jobWrPtrR   <= jobWrPtrR + 1;
+            end
+            if (validIn) begin
+                sizeVar = jobPoolR[jobRdPtrR];
+                if (colR == jobMaxColR[jobRdPtrR]) begin
+                    colR        <= 0;
+                    winColR     <= 0;
+                    hPosR       <= 0;
+                    pcR         <= 0;
+                    if (rowR == jobMaxRowR[jobRdPtrR]) begin
+                        // Last output of the job
+                        rowR        <= 0;
+                        winRowR     <= 0;
+                        vPosR       <= 0;
+                        jobRdPtrR   <= jobRdPtrR + 1;
+                    end else begin
+                        rowR        <= rowR + 1;
+                        if (vPosR == sizeVar - 1) begin
+                            winRowR     <= winRowR + sizeVar;
+                            vPosR       <= 0;
+                        end else begin
+                            vPosR       <= vPosR + 1;
+                        end
+                    end
+                end else begin
+                    colR        <= colR + 1;
+                    if (hPosR == sizeVar - 1) begin
+                        winColR     <= winColR + sizeVar;
+                        hPosR       <= 0;
+                        pcR         <= pcR + 1;
+                    end else begin
+                        hPosR       <= hPosR + 1;
+                    end
+                end
+            end
+        end
+    end
+
+    // Pipeline #1
+    always @(posedge clkIn) begin
+        poolSizeVar = jobPoolR[jobRdPtrR];
+
+        // Window lies completely inside the output matrix
+        keepVar     = (winRowR + poolSizeVar - 1 <= jobMaxRowR[jobRdPtrR]) &&
+                      (winColR + poolSizeVar - 1 <= jobMaxColR[jobRdPtrR]);
+
+        data1R      <= dataIn;
+        biasEn1R    <= jobBiasEnR[jobRdPtrR];
+        bias1R      <= jobBiasR[jobRdPtrR];
+        act1R       <= jobActR[jobRdPtrR];
+        slope1R     <= jobSlopeR[jobRdPtrR];
+        size1R      <= poolSizeVar;
+        avg1R       <= jobAvgR[jobRdPtrR];
+        emit1R      <= keepVar && (hPosR == poolSizeVar - 1);
+        last1R      <= (vPosR == poolSizeVar - 1);
+        
+        // Next window starts beyond the output matrix in both directions
+        final1R     <= keepVar && (winRowR + 2*poolSizeVar - 1 > jobMaxRowR[jobRdPtrR]) &&
+                                  (winColR + 2*poolSizeVar - 1 > jobMaxColR[jobRdPtrR]);
+        vPos1R      <= vPosR[0];
+        pc1R        <= pcR;
+    end
+
+    // Valid Process
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            valid1R <= 0;
+        end else begin
+            valid1R <= validIn;
+        end
+    end
+
+    // Output of the bias and activation stages
+    wire [DATA_WIDTH-1:0] data3;
+    wire valid3;
+    wire [POOL_CTL_WIDTH-1:0] ctl3;
+
+    generate
+        if (MAC_STYLE == "INT8") begin
+
+            // Bias and ReLU are applied before requantization
+            assign data3    = data1R;
+            assign valid3   = valid1R;
+            assign ctl3     = {size1R, avg1R, emit1R, last1R, final1R, vPos1R, pc1R};
+
+        end else begin
+
+            // Bias stage
+            wire [DATA_WIDTH-1:0] sum;
+            wire [DATA_WIDTH-1:0] data2Raw;
+            wire [DATA_WIDTH-1:0] data2;
+            wire valid2;
+            wire biasEn2;
+            wire [1:0] act2;
+            wire [DATA_WIDTH-1:0] slope2;
+            wire [POOL_CTL_WIDTH-1:0] ctl2;
+
+            floating_point_add #(
+                .FRAC_WIDTH(FRAC_WIDTH),
+                .EXP_WIDTH(EXP_WIDTH)) bias_add (
+                .clkIn(clkIn),
+                .rstIn(rstIn),
+                .dataAIn(data1R),
+                .dataBIn(bias1R),
+                .validIn(valid1R),
+                .dataOut(sum),
+                .validOut(valid2));
+
+            delay #(
+                .LATENCY(ADD_LATENCY),
+                .DATA_WIDTH(2*DATA_WIDTH+3+POOL_CTL_WIDTH)) bias_delay (
+                .clkIn(clkIn),
+                .rstIn(1'b0),
+                .dataIn({biasEn1R, act1R, slope1R, size1R, avg1R, emit1R, last1R, final1R, vPos1R, pc1R, data1R}),
+                .dataOut({biasEn2, act2, slope2, ctl2, data2Raw}));
+
+            assign data2 = biasEn2 ? sum : data2Raw;
+
+            // Activation stage
+            wire [DATA_WIDTH-1:0] prod;
+            wire [DATA_WIDTH-1:0] data3Raw;
+            wire [1:0] act3;
+
+            floating_point_multiply #(
+                .FRAC_WIDTH(FRAC_WIDTH),
+                .EXP_WIDTH(EXP_WIDTH)) act_mult (
+                .clkIn(clkIn),
+                .rstIn(rstIn),
+                .dataAIn(data2),
+                .dataBIn(slope2),
+                .validIn(valid2),
+                .dataOut(prod),
+                .validOut(valid3));
+
+            delay #(
+                .LATENCY(MULT_LATENCY),
+                .DATA_WIDTH(DATA_WIDTH+2+POOL_CTL_WIDTH)) act_delay (
+                .clkIn(clkIn),
+                .rstIn(1'b0),
+                .dataIn({act2, ctl2, data2}),
+                .dataOut({act3, ctl3, data3Raw}));
+
+            assign data3 = !data3Raw[SIGN_IDX]  ? data3Raw :
+                           (act3 == ACT_RELU)   ? {DATA_WIDTH{1'b0}} :
+                           (act3 == ACT_LEAKY)  ? prod : data3Raw;
+
+        end
+    endgenerate
+
+    // Pipeline #4
+    // Gather the columns of a window row
+    reg [DATA_WIDTH-1:0] h0R;
+    reg [DATA_WIDTH-1:0] h1R;
+    reg [DATA_WIDTH-1:0] a4R;
+    reg [DATA_WIDTH-1:0] b4R;
+    reg [DATA_WIDTH-1:0] c4R;
+    reg [POOL_CTL_WIDTH-1:0] ctl4R;
+    reg valid4R;
+
+    // Window size and average select of each pooling control word
+    wire [1:0] size4;
+    wire avg4;
+
+    assign size4 = ctl3[POOL_CTL_WIDTH-1-:2];
+
+    always @(posedge clkIn) begin
+        if (valid3) begin
+            h0R     <= data3;
+            h1R     <= h0R;
+        end
+        a4R     <= (size4 == 3) ? h1R : (size4 == 2) ? h0R : data3;
+        b4R     <= (size4 == 3) ? h0R : data3;
+        c4R     <= data3;
+        ctl4R   <= ctl3;
+    end
+
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            valid4R <= 0;
+        end else begin
+            valid4R <= valid3 & ctl3[POOL_CTL_WIDTH-4];
+        end
+    end
+
+    assign avg4 = ctl4R[POOL_CTL_WIDTH-3];
+
+    // Outputs combined with the next column of their window or outside
+    // the last whole window
+    wire drop4;
+
+    assign drop4 = valid3 & !ctl3[POOL_CTL_WIDTH-4];
+
+    // Horizontal reduction (a0 op a1) op a2
+    wire [DATA_WIDTH-1:0] r5;
+    wire [DATA_WIDTH-1:0] c5;
+    wire [POOL_CTL_WIDTH-1:0] ctl5;
+    wire valid5;
+
+    pool_combine #(
+        .FRAC_WIDTH(FRAC_WIDTH),
+        .EXP_WIDTH(EXP_WIDTH),
+        .MAC_STYLE(MAC_STYLE)) row_combine_1 (
+        .clkIn(clkIn),
+        .rstIn(rstIn),
+        .dataAIn(a4R),
+        .dataBIn(b4R),
+        .validIn(valid4R),
+        .combineIn(ctl4R[POOL_CTL_WIDTH-1-:2] >= 2),
+        .avgIn(avg4),
+        .dataOut(r5),
+        .validOut(valid5));
+
+    delay #(
+        .LATENCY(COMBINE_LATENCY),
+        .DATA_WIDTH(DATA_WIDTH+POOL_CTL_WIDTH)) row_delay_1 (
+        .clkIn(clkIn),
+        .rstIn(1'b0),
+        .dataIn({ctl4R, c4R}),
+        .dataOut({ctl5, c5}));
+
+    wire [DATA_WIDTH-1:0] hSum;
+    wire [POOL_CTL_WIDTH-1:0] ctl6;
+    wire valid6;
+
+    pool_combine #(
+        .FRAC_WIDTH(FRAC_WIDTH),
+        .EXP_WIDTH(EXP_WIDTH),
+        .MAC_STYLE(MAC_STYLE)) row_combine_2 (
+        .clkIn(clkIn),
+        .rstIn(rstIn),
+        .dataAIn(r5),
+        .dataBIn(c5),
+        .validIn(valid5),
+        .combineIn(ctl5[POOL_CTL_WIDTH-1-:2] == 3),
+        .avgIn(ctl5[POOL_CTL_WIDTH-3]),
+        .dataOut(hSum),
+        .validOut(valid6));
+
+    delay #(
+        .LATENCY(COMBINE_LATENCY),
+        .DATA_WIDTH(POOL_CTL_WIDTH)) row_delay_2 (
+        .clkIn(clkIn),
+        .rstIn(1'b0),
+        .dataIn(ctl5),
+        .dataOut(ctl6));
+
+    // Pipeline #7
+    // Line buffer holds the row results of the first rows of each window
+    reg [DATA_WIDTH-1:0] lineR [0:1][0:POOL_COLS-1];
+    reg [DATA_WIDTH-1:0] a7R;
+    reg [DATA_WIDTH-1:0] b7R;
+    reg [DATA_WIDTH-1:0] c7R;
+    reg [1:0] size7R;
+    reg avg7R;
+    reg final7R;
+    reg valid7R;
+
+    wire [1:0] size6;
+    wire last6;
+    wire final6;
+    wire vPos6;
+    wire [POOL_ADDR_WIDTH-1:0] pc6;
+
+    assign {size6, last6, final6, vPos6, pc6} = {ctl6[POOL_CTL_WIDTH-1-:2], ctl6[POOL_CTL_WIDTH-5:0]};
+
+    // Row results held for the next row of their window
+    wire drop7;
+
+    assign drop7 = valid6 & !last6;
+    assign dropOut = drop4 + drop7;
+
+    always @(posedge clkIn) begin
+        if (valid6 && !last6) begin
+            lineR[vPos6][pc6] <= hSum;
+        end
+        a7R     <= (size6 == 1) ? hSum : lineR[0][pc6];
+        b7R     <= (size6 == 3) ? lineR[1][pc6] : hSum;
+        c7R     <= hSum;
+        size7R  <= size6;
+        avg7R   <= ctl6[POOL_CTL_WIDTH-3];
+        final7R <= final6;
+    end
+
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            valid7R <= 0;
+        end else begin
+            valid7R <= valid6 & last6;
+        end
+    end
+
+    // Vertical reduction (r0 op r1) op r2
+    wire [DATA_WIDTH-1:0] r8;
+    wire [DATA_WIDTH-1:0] c8;
+    wire [1:0] size8;
+    wire avg8;
+    wire final8;
+    wire valid8;
+
+    pool_combine #(
+        .FRAC_WIDTH(FRAC_WIDTH),
+        .EXP_WIDTH(EXP_WIDTH),
+        .MAC_STYLE(MAC_STYLE)) col_combine_1 (
+        .clkIn(clkIn),
+        .rstIn(rstIn),
+        .dataAIn(a7R),
+        .dataBIn(b7R),
+        .validIn(valid7R),
+        .combineIn(size7R >= 2),
+        .avgIn(avg7R),
+        .dataOut(r8),
+        .validOut(valid8));
+
+    delay #(
+        .LATENCY(COMBINE_LATENCY),
+        .DATA_WIDTH(DATA_WIDTH+4)) col_delay_1 (
+        .clkIn(clkIn),
+        .rstIn(1'b0),
+        .dataIn({size7R, avg7R, final7R, c7R}),
+        .dataOut({size8, avg8, final8, c8}));
+
+    wire [DATA_WIDTH-1:0] pool;
+    wire [1:0] size9;
+    wire avg9;
+    wire final9;
+    wire valid9;
+
+    pool_combine #(
+        .FRAC_WIDTH(FRAC_WIDTH),
+        .EXP_WIDTH(EXP_WIDTH),
+        .MAC_STYLE(MAC_STYLE)) col_combine_2 (
+        .clkIn(clkIn),
+        .rstIn(rstIn),
+        .dataAIn(r8),
+        .dataBIn(c8),
+        .validIn(valid8),
+        .combineIn(size8 == 3),
+        .avgIn(avg8),
+        .dataOut(pool),
+        .validOut(valid9));
+
+    delay #(
+        .LATENCY(COMBINE_LATENCY),
+        .DATA_WIDTH(4)) col_delay_2 (
+        .clkIn(clkIn),
+        .rstIn(1'b0),
+        .dataIn({size8, avg8, final8}),
+        .dataOut({size9, avg9, final9}));
+
+    // Scale window sums to averages
+    generate
+        if (MAC_STYLE == "INT8") begin
+
+            // Pipeline #1
+            reg signed [2*DATA_WIDTH-1:0] prodR;
+            reg [DATA_WIDTH-1:0] poolR;
+            reg scaleR;
+            reg finalR;
+
+            // Pipeline #2
+            reg signed [2*DATA_WIDTH-1:0] roundVar;
+            reg [DATA_WIDTH-1:0] outR;
+            reg lastR;
+            reg [1:0] validR;
+
+            always @(posedge clkIn) begin
+                prodR   <= $signed(pool) * ((size9 == 3) ? INT_RECIP_9 : INT_RECIP_4);
+                poolR   <= pool;
+                scaleR  <= avg9 && (size9 != 1);
+                finalR  <= final9;
+
+                roundVar = (prodR + (1 << (INT_RECIP_SHIFT - 1))) >>> INT_RECIP_SHIFT;
+                outR    <= scaleR ? roundVar[DATA_WIDTH-1:0] : poolR;
+                lastR   <= finalR;
+            end
+
+            always @(posedge clkIn) begin
+                if (rstIn) begin
+                    validR  <= 0;
+                end else begin
+                    validR  <= {validR[0], valid9};
+                end
+            end
+
+            assign dataOut  = outR;
+            assign lastOut  = lastR;
+            assign validOut = validR[1];
+
+        end else begin
+
+            wire [DATA_WIDTH-1:0] prod;
+            wire [DATA_WIDTH-1:0] poolOut;
+            wire scale;
+
+            floating_point_multiply #(
+                .FRAC_WIDTH(FRAC_WIDTH),
+                .EXP_WIDTH(EXP_WIDTH)) avg_mult (
+                .clkIn(clkIn),
+                .rstIn(rstIn),
+                .dataAIn(pool),
+                .dataBIn((size9 == 3) ? RECIP_9 : RECIP_4),
+                .validIn(valid9),
+                .dataOut(prod),
+                .validOut(validOut));
+
+            delay #(
+                .LATENCY(MULT_LATENCY),
+                .DATA_WIDTH(DATA_WIDTH+2)) avg_delay (
+                .clkIn(clkIn),
+                .rstIn(1'b0),
+                .dataIn({final9, avg9 && (size9 != 1), pool}),
+                .dataOut({lastOut, scale, poolOut}));
+
+            assign dataOut = scale ? prod : poolOut;
+
+        end
+    endgenerate
+
+endmodule
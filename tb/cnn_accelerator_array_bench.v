@@ -0,0 +1,296 @@
+`timescale 1ns/1ns
+
+module cnn_accelerator_array_bench (
+    clkIn,
+    rstIn,
+    doneOut,
+    cyclesOut,
+    loadCyclesOut,
+    errorsOut);
+
+    // Runs NUM_JOBS convolution tiles through a cnn_accelerator_array of
+    // NUM_CORES cores and checks every result against output.txt
+    //
+    // The data tile is loaded through the window of the next core and the
+    // filter broadcast to every core, then the job is started once the
+    // next core is free, as a host driving the array would. Odd jobs drop
+    // the last data row, so they produce one output row less and lastOut
+    // checks that the results leave in start order. Needs a stride 1,
+    // unpadded convolution of at least two output rows.
+
+    // RISCV bus interface
+    parameter BUS_ADDR_WIDTH = 32;
+    parameter BUS_DATA_WIDTH = 64;
+
+    // Array configuration
+    parameter NUM_CORES      = 4;
+    parameter VECTOR_SIZE    = 8;
+    parameter DATA_WIDTH     = 32;
+    parameter MAX_SIZE       = 4096; // < Max Rows > * < Max Cols >
+
+    // Number of tiles and maximum number of outputs per tile
+    parameter NUM_JOBS       = 16;
+    parameter MAX_OUTPUTS    = 65536;
+
+    // Dependent parameters for RISCV bus interface
+    localparam BUS_WE_WIDTH  = BUS_DATA_WIDTH/8;
+    localparam WE_WIDTH      = DATA_WIDTH/8;
+    localparam NUM_WORDS     = BUS_DATA_WIDTH/DATA_WIDTH;
+    localparam DIM_WIDTH     = $clog2(MAX_SIZE) + 1;
+    localparam CORE_SPAN     = 1 << ($clog2(MAX_SIZE) + $clog2(WE_WIDTH) + 1);
+    localparam NEXT_ADDR     = 0;
+    localparam ALL_ADDR      = CORE_SPAN;
+    localparam FILT_ADDR     = CORE_SPAN/2;
+    localparam CORE_WIDTH    = (NUM_CORES > 1) ? $clog2(NUM_CORES) : 1;
+
+    input clkIn;
+    input rstIn;
+    output reg doneOut;
+    output reg [31:0] cyclesOut;
+    output reg [31:0] loadCyclesOut;
+    output reg [31:0] errorsOut;
+
+    // Job operands and expected outputs read from data.txt, filt.txt and output.txt
+    reg [DATA_WIDTH-1:0] dataMem [0:MAX_SIZE-1];
+    reg [DATA_WIDTH-1:0] filtMem [0:MAX_SIZE-1];
+    reg [DATA_WIDTH-1:0] outMem  [0:MAX_OUTPUTS-1];
+
+    reg [DIM_WIDTH-1:0] dataColsR;
+    reg [DIM_WIDTH-1:0] dataRowsR;
+    reg [DIM_WIDTH-1:0] filtColsR;
+    reg [DIM_WIDTH-1:0] filtRowsR;
+    reg [DIM_WIDTH-1:0] jobRowsR;
+    integer numOutputs;
+    integer outCols;
+
+    // Bus and control registers
+    reg startR;
+    reg [BUS_WE_WIDTH-1:0] wrEnR;
+    reg [BUS_DATA_WIDTH-1:0] wrDataR;
+    reg [BUS_ADDR_WIDTH-1:0] addrR;
+
+    wire [DATA_WIDTH-1:0] resData;
+    wire resValid;
+    wire resLast;
+    wire busy;
+    wire [CORE_WIDTH-1:0] nextCore;
+
+    // Output checking, position within the job being drained
+    integer jobCnt;
+    integer outCnt;
+    integer cycleCnt;
+    integer lastCycle;
+
+    cnn_accelerator_array #(
+        .NUM_CORES(NUM_CORES),
+        .BUS_ADDR_WIDTH(BUS_ADDR_WIDTH),
+        .BUS_DATA_WIDTH(BUS_DATA_WIDTH),
+        .VECTOR_SIZE(VECTOR_SIZE),
+        .MAX_SIZE(MAX_SIZE)) array (
+        .clkIn(clkIn),
+        .rstIn(rstIn),
+        .startIn(startR),
+        .opTypeIn(1'b0),
+        .strideLog2In(2'd0),
+        .padIn(4'd0),
+        .dilationLog2In(2'd0),
+        .packIn(1'b0),
+        .quantMultIn(32'd0),
+        .quantShiftIn(6'd0),
+        .quantZeroIn(8'd0),
+        .biasEnIn(1'b0),
+        .biasIn(32'd0),
+        .actIn(2'd0),
+        .slopeIn(32'd0),
+        .poolSizeIn(2'd0),
+        .poolAvgIn(1'b0),
+        .filtRowsIn(filtRowsR),
+        .filtColsIn(filtColsR),
+        .dataRowsIn(jobRowsR),
+        .dataColsIn(dataColsR),
+        .channelsIn({{(DIM_WIDTH-1){1'b0}}, 1'b1}),
+        .dataBaseIn({(DIM_WIDTH-1){1'b0}}),
+        .filtBaseIn({(DIM_WIDTH-1){1'b0}}),
+        .holdBankIn(1'b0),
+        .addrIn(addrR),
+        .wrEnIn(wrEnR),
+        .wrDataIn(wrDataR),
+        .readyIn(1'b1),
+        .busyOut(busy),
+        .queueFullOut(),
+        .nextCoreOut(nextCore),
+        .validOut(resValid),
+        .dataOut(resData),
+        .keepOut(),
+        .lastOut(resLast),
+        .countOut(),
+        .perfStartIn(1'b0),
+        .perfStopIn(1'b0),
+        .perfClearIn(1'b0),
+        .perfSelIn(3'd0),
+        .perfDataOut());
+
+    // Read one matrix file (columns, rows, then elements)
+    task read_matrix;
+        input isFilt;
+        input [8*16-1:0] fileName;
+        output [DIM_WIDTH-1:0] cols;
+        output [DIM_WIDTH-1:0] rows;
+        output integer numElems;
+        integer fid, n;
+        reg [DATA_WIDTH-1:0] value;
+        begin
+            fid = $fopen(fileName, "r");
+            if (fid == 0) begin
+                $display("Could not open \"%0s\"", fileName);
+                $finish;
+            end
+            n = $fscanf(fid, "%h\n", value);
+            cols = value;
+            n = $fscanf(fid, "%h\n", value);
+            rows = value;
+            numElems = 0;
+            while (!$feof(fid)) begin
+                n = $fscanf(fid, "%h\n", value);
+                if (isFilt) begin
+                    filtMem[numElems] = value;
+                end else begin
+                    dataMem[numElems] = value;
+                end
+                numElems = numElems + 1;
+            end
+            $fclose(fid);
+        end
+    endtask
+
+    // Write one matrix from bus address base
+    task load_matrix;
+        input isFilt;
+        input integer numElems;
+        input integer base;
+        integer w, k;
+        begin
+            for (w = 0; w < (numElems + NUM_WORDS - 1)/NUM_WORDS; w = w + 1) begin
+                @(posedge clkIn);
+                addrR   <= base + w*BUS_WE_WIDTH;
+                for (k = 0; k < NUM_WORDS; k = k + 1) begin
+                    if (w*NUM_WORDS + k < numElems) begin
+                        wrDataR[k*DATA_WIDTH+:DATA_WIDTH]   <= isFilt ? filtMem[w*NUM_WORDS+k] : dataMem[w*NUM_WORDS+k];
+                        wrEnR[k*WE_WIDTH+:WE_WIDTH]         <= {WE_WIDTH{1'b1}};
+                    end else begin
+                        wrDataR[k*DATA_WIDTH+:DATA_WIDTH]   <= 0;
+                        wrEnR[k*WE_WIDTH+:WE_WIDTH]         <= {WE_WIDTH{1'b0}};
+                    end
+                end
+            end
+            @(posedge clkIn);
+            wrEnR   <= 0;
+        end
+    endtask
+
+    // Wait for the next core to release its bank, then start the job
+    task start_job;
+        input integer rows;
+        begin
+            @(negedge clkIn);
+            while (busy) begin
+                @(negedge clkIn);
+            end
+            @(posedge clkIn);
+            startR      <= 1;
+            jobRowsR    <= rows;
+            @(posedge clkIn);
+            startR      <= 0;
+        end
+    endtask
+
+    // Results of job n, odd jobs lack the last output row
+    function integer job_outputs;
+        input integer n;
+        begin
+            job_outputs = numOutputs - (n % 2)*outCols;
+        end
+    endfunction
+
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            cycleCnt    <= 0;
+        end else begin
+            cycleCnt    <= cycleCnt + 1;
+            if (resValid) begin
+                if (resData !== outMem[outCnt]) begin
+                    errorsOut = errorsOut + 1;
+                    $error("Error Detected at Time %t: %0d cores, job %0d: Meas = 0x%08H, Ref=0x%08H", $realtime,
+                        NUM_CORES, jobCnt, resData, outMem[outCnt]);
+                end
+
+                // Only the last output of each job is marked
+                if (resLast !== (outCnt == job_outputs(jobCnt) - 1)) begin
+                    errorsOut = errorsOut + 1;
+                    $error("Error Detected at Time %t: %0d cores, job %0d: lastOut = %b at output %0d", $realtime,
+                        NUM_CORES, jobCnt, resLast, outCnt);
+                end
+                if (resLast) begin
+                    lastCycle   = cycleCnt;
+                    jobCnt      = jobCnt + 1;
+                    outCnt      = 0;
+                end else begin
+                    outCnt      = outCnt + 1;
+                end
+            end
+        end
+    end
+
+    integer numData, numFilt, fid, n, job, startCycle, loadCycle, loadCycles;
+    reg [DATA_WIDTH-1:0] value;
+    initial begin
+        startR    = 0;
+        wrEnR     = 0;
+        wrDataR   = 0;
+        addrR     = 0;
+        jobRowsR  = 0;
+        jobCnt    = 0;
+        outCnt    = 0;
+        doneOut   = 0;
+        cyclesOut = 0;
+        errorsOut = 0;
+
+        read_matrix(0, "data.txt", dataColsR, dataRowsR, numData);
+        read_matrix(1, "filt.txt", filtColsR, filtRowsR, numFilt);
+        outCols = dataColsR - filtColsR + 1;
+
+        fid = $fopen("output.txt", "r");
+        if (fid == 0) begin
+            $display("Could not open \"output.txt\"");
+            $finish;
+        end
+        numOutputs = 0;
+        while (!$feof(fid)) begin
+            n = $fscanf(fid, "%h\n", value);
+            outMem[numOutputs] = value;
+            numOutputs = numOutputs + 1;
+        end
+        $fclose(fid);
+
+        @(negedge rstIn);
+
+        // Load each tile into the next core while the others compute,
+        // and count the bus cycles spent loading
+        startCycle = cycleCnt;
+        loadCycles = 0;
+        for (job = 0; job < NUM_JOBS; job = job + 1) begin
+            loadCycle = cycleCnt;
+            load_matrix(0, numData, NEXT_ADDR);
+            load_matrix(1, numFilt, ALL_ADDR + FILT_ADDR);
+            loadCycles = loadCycles + cycleCnt - loadCycle;
+            start_job(dataRowsR - (job % 2));
+        end
+        loadCyclesOut = loadCycles/NUM_JOBS;
+        while (jobCnt < NUM_JOBS) begin
+            @(negedge clkIn);
+        end
+        cyclesOut   = lastCycle - startCycle;
+        doneOut     = 1;
+    end
+
+endmodule
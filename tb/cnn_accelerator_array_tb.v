@@ -0,0 +1,65 @@
+`timescale 1ns/1ns
+
+module cnn_accelerator_array_tb;
+
+    parameter CLK_PERIOD     = 10;
+    parameter RESET_TIME     = 100;
+
+    // Arrays of 1 to MAX_CORES cores run side by side
+    parameter MAX_CORES      = 8;
+
+    // Array configuration, see cnn_accelerator_array_bench.v
+    parameter VECTOR_SIZE    = 8;
+    parameter MAX_SIZE       = 4096; // < Max Rows > * < Max Cols >
+    parameter NUM_JOBS       = 16;
+
+    wire clk;
+    wire rst;
+
+    wire [MAX_CORES-1:0] done;
+    wire [32*MAX_CORES-1:0] cycles;
+    wire [32*MAX_CORES-1:0] loadCycles;
+    wire [32*MAX_CORES-1:0] errors;
+
+    clk_gen #(.CLK_PERIOD(CLK_PERIOD)) clk_gen_i (.clkOut(clk));
+    rst_gen #(.RESET_TIME(RESET_TIME)) rst_gen_i (.rstOut(rst));
+
+    // One bench per array size, all running the same tiles
+    genvar i;
+    generate
+        for (i = 0; i < MAX_CORES; i = i + 1) begin : bench
+            cnn_accelerator_array_bench #(
+                .NUM_CORES(i+1),
+                .VECTOR_SIZE(VECTOR_SIZE),
+                .MAX_SIZE(MAX_SIZE),
+                .NUM_JOBS(NUM_JOBS)) bench_i (
+                .clkIn(clk),
+                .rstIn(rst),
+                .doneOut(done[i]),
+                .cyclesOut(cycles[32*i+:32]),
+                .loadCyclesOut(loadCycles[32*i+:32]),
+                .errorsOut(errors[32*i+:32]));
+        end
+    endgenerate
+
+    // Throughput scaling table, cycles per tile against one core
+    integer k, errCnt;
+    initial begin
+        errCnt = 0;
+        wait (&done);
+        $display("%0d tiles, %0d bus cycles per tile to load", NUM_JOBS, loadCycles[31:0]);
+        $display("cores  cycles  cycles/tile  speedup");
+        for (k = 0; k < MAX_CORES; k = k + 1) begin
+            $display("%5d  %6d  %11d  %7.2f", k + 1, cycles[32*k+:32], cycles[32*k+:32]/NUM_JOBS,
+                (1.0*cycles[31:0])/cycles[32*k+:32]);
+            errCnt = errCnt + errors[32*k+:32];
+        end
+        if (errCnt != 0) begin
+            $display("FAILED: %0d mismatches", errCnt);
+        end else begin
+            $display("PASSED");
+        end
+        $finish;
+    end
+
+endmodule
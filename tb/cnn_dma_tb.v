@@ -0,0 +1,363 @@
+`timescale 1ns/1ns
+
+module cnn_dma_tb;
+
+    parameter CLK_PERIOD     = 10;
+    parameter RESET_TIME     = 100;
+
+    // RISCV bus interface
+    parameter BUS_ADDR_WIDTH = 32;
+    parameter BUS_DATA_WIDTH = 64;
+
+    // Hardware accelerator overrides
+    parameter VECTOR_SIZE    = 8;
+    parameter DATA_WIDTH     = 32;
+    parameter MAX_SIZE       = 4096; // < Max Rows > * < Max Cols >
+
+    // Operation type (0 = 2D convolution, 1 = matrix multiply)
+    parameter OP_TYPE        = 0;
+
+    // Convolution stride and dilation (log2) and zero padding
+    parameter STRIDE_LOG2    = 0;
+    parameter PAD            = 0;
+    parameter DILATION_LOG2  = 0;
+
+    // Number of jobs chained in the descriptor list
+    parameter NUM_JOBS       = 2;
+
+    // Memory model configuration
+    parameter MEM_WORDS      = 65536;
+    parameter RD_LATENCY     = 4;
+    parameter STALL_RATE     = 10;
+
+    // Maximum number of outputs per job
+    parameter MAX_OUTPUTS    = 65536;
+
+    // Memory layout, rows are padded so tiles are strided and
+    // some rows start in the upper half of a bus word
+    localparam DESC_ADDR     = 32'h0000_0000;
+    localparam DATA_ADDR     = 32'h0001_0000;
+    localparam FILT_ADDR     = 32'h0002_0004;
+    localparam OUT_ADDR      = 32'h0003_0000;
+    localparam OUT_JOB_BYTES = 32'h0002_0000;
+    localparam DATA_PAD      = 12;
+    localparam FILT_PAD      = 4;
+    localparam OUT_PAD       = 20;
+
+    // Descriptor types
+    localparam DESC_DATA     = 0;
+    localparam DESC_FILT     = 1;
+    localparam DESC_RUN      = 2;
+
+    localparam BUS_WE_WIDTH  = BUS_DATA_WIDTH/8;
+    localparam DIM_WIDTH     = $clog2(MAX_SIZE) + 1;
+
+    wire clk;
+    wire rst;
+
+    // Job operands and expected outputs read from data.txt, filt.txt and output.txt
+    reg [DATA_WIDTH-1:0] dataMem [0:MAX_SIZE-1];
+    reg [DATA_WIDTH-1:0] filtMem [0:MAX_SIZE-1];
+    reg [DATA_WIDTH-1:0] outMem  [0:MAX_OUTPUTS-1];
+
+    reg [DIM_WIDTH-1:0] dataCols, dataRows, filtCols, filtRows;
+    integer outRows, outCols, numOutputs;
+
+    // DMA control
+    reg startR;
+    wire dmaBusy;
+    wire dmaDone;
+
+    // Memory bus
+    wire memReqValid, memReqReady, memReqWr;
+    wire [BUS_ADDR_WIDTH-1:0] memReqAddr;
+    wire [  BUS_WE_WIDTH-1:0] memReqWrEn;
+    wire [BUS_DATA_WIDTH-1:0] memReqData;
+    wire memRspValid;
+    wire [BUS_DATA_WIDTH-1:0] memRspData;
+
+    // Accelerator interface
+    wire accStart, accOpType, accBusy, accValid, accReady;
+    wire [DIM_WIDTH-1:0] accFiltRows, accFiltCols, accDataRows, accDataCols;
+    wire [1:0] accStrideLog2, accDilationLog2;
+    wire [3:0] accPad;
+    wire [BUS_ADDR_WIDTH-1:0] accAddr;
+    wire [  BUS_WE_WIDTH-1:0] accWrEn;
+    wire [BUS_DATA_WIDTH-1:0] accWrData;
+    wire [DATA_WIDTH-1:0] accData;
+
+    clk_gen #(.CLK_PERIOD(CLK_PERIOD)) clk_gen_i (.clkOut(clk));
+    rst_gen #(.RESET_TIME(RESET_TIME)) rst_gen_i (.rstOut(rst));
+
+    mem_model #(
+        .ADDR_WIDTH(BUS_ADDR_WIDTH),
+        .DATA_WIDTH(BUS_DATA_WIDTH),
+        .MEM_WORDS(MEM_WORDS),
+        .RD_LATENCY(RD_LATENCY),
+        .STALL_RATE(STALL_RATE)) mem (
+        .clkIn(clk),
+        .rstIn(rst),
+        .reqValidIn(memReqValid),
+        .reqReadyOut(memReqReady),
+        .reqWrIn(memReqWr),
+        .reqAddrIn(memReqAddr),
+        .reqWrEnIn(memReqWrEn),
+        .reqDataIn(memReqData),
+        .rspValidOut(memRspValid),
+        .rspDataOut(memRspData));
+
+    cnn_dma #(
+        .BUS_ADDR_WIDTH(BUS_ADDR_WIDTH),
+        .BUS_DATA_WIDTH(BUS_DATA_WIDTH),
+        .MAX_SIZE(MAX_SIZE)) dma (
+        .clkIn(clk),
+        .rstIn(rst),
+        .startIn(startR),
+        .descAddrIn(DESC_ADDR),
+        .busyOut(dmaBusy),
+        .doneOut(dmaDone),
+        .memReqValidOut(memReqValid),
+        .memReqReadyIn(memReqReady),
+        .memReqWrOut(memReqWr),
+        .memReqAddrOut(memReqAddr),
+        .memReqWrEnOut(memReqWrEn),
+        .memReqDataOut(memReqData),
+        .memRspValidIn(memRspValid),
+        .memRspDataIn(memRspData),
+        .accStartOut(accStart),
+        .accOpTypeOut(accOpType),
+        .accStrideLog2Out(accStrideLog2),
+        .accPadOut(accPad),
+        .accDilationLog2Out(accDilationLog2),
+        .accFiltRowsOut(accFiltRows),
+        .accFiltColsOut(accFiltCols),
+        .accDataRowsOut(accDataRows),
+        .accDataColsOut(accDataCols),
+        .accAddrOut(accAddr),
+        .accWrEnOut(accWrEn),
+        .accWrDataOut(accWrData),
+        .accBusyIn(accBusy),
+        .accValidIn(accValid),
+        .accDataIn(accData),
+        .accReadyOut(accReady));
+
+    cnn_hw_accelerator #(
+        .BUS_ADDR_WIDTH(BUS_ADDR_WIDTH),
+        .BUS_DATA_WIDTH(BUS_DATA_WIDTH),
+        .VECTOR_SIZE(VECTOR_SIZE),
+        .MAX_SIZE(MAX_SIZE)) accel (
+        .clkIn(clk),
+        .rstIn(rst),
+        .startIn(accStart),
+        .opTypeIn(accOpType),
+        .strideLog2In(accStrideLog2),
+        .padIn(accPad),
+        .dilationLog2In(accDilationLog2),
+        .packIn(1'b0),
+        .quantMultIn(32'd0),
+        .quantShiftIn(6'd0),
+        .quantZeroIn(8'd0),
+        .biasEnIn(1'b0),
+        .biasIn(32'd0),
+        .actIn(2'd0),
+        .slopeIn(32'd0),
+        .poolSizeIn(2'd0),
+        .poolAvgIn(1'b0),
+        .filtRowsIn(accFiltRows),
+        .filtColsIn(accFiltCols),
+        .dataRowsIn(accDataRows),
+        .dataColsIn(accDataCols),
+        .channelsIn({{(DIM_WIDTH-1){1'b0}}, 1'b1}),
+        .dataBaseIn({(DIM_WIDTH-1){1'b0}}),
+        .filtBaseIn({(DIM_WIDTH-1){1'b0}}),
+        .holdBankIn(1'b0),
+        .addrIn(accAddr),
+        .wrEnIn(accWrEn),
+        .wrDataIn(accWrData),
+        .readyIn(accReady),
+        .busyOut(accBusy),
+        .queueFullOut(),
+        .validOut(accValid),
+        .dataOut(accData),
+        .keepOut(),
+        .lastOut(),
+        .countOut(),
+        .perfStartIn(1'b0),
+        .perfStopIn(1'b0),
+        .perfClearIn(1'b0),
+        .perfSelIn(3'd0),
+        .perfDataOut());
+
+    // Read one matrix file (columns, rows, then elements)
+    task read_matrix;
+        input isFilt;
+        input [8*16-1:0] fileName;
+        output [DIM_WIDTH-1:0] cols;
+        output [DIM_WIDTH-1:0] rows;
+        integer fid, n, idx;
+        reg [DATA_WIDTH-1:0] value;
+        begin
+            fid = $fopen(fileName, "r");
+            if (fid == 0) begin
+                $display("Could not open \"%0s\"", fileName);
+                $finish;
+            end
+            n = $fscanf(fid, "%h\n", value);
+            cols = value;
+            n = $fscanf(fid, "%h\n", value);
+            rows = value;
+            idx = 0;
+            while (!$feof(fid)) begin
+                n = $fscanf(fid, "%h\n", value);
+                if (isFilt) begin
+                    filtMem[idx] = value;
+                end else begin
+                    dataMem[idx] = value;
+                end
+                idx = idx + 1;
+            end
+            $fclose(fid);
+        end
+    endtask
+
+    // Backdoor access to 32-bit elements of the memory model
+    task mem_write32;
+        input [BUS_ADDR_WIDTH-1:0] addr;
+        input [DATA_WIDTH-1:0] value;
+        begin
+            if (addr[2]) begin
+                mem.memR[addr >> 3][63:32] = value;
+            end else begin
+                mem.memR[addr >> 3][31:0]  = value;
+            end
+        end
+    endtask
+
+    function [DATA_WIDTH-1:0] mem_read32;
+        input [BUS_ADDR_WIDTH-1:0] addr;
+        begin
+            mem_read32 = addr[2] ? mem.memR[addr >> 3][63:32] : mem.memR[addr >> 3][31:0];
+        end
+    endfunction
+
+    // Descriptor words
+    task write_desc;
+        input integer idx;
+        input [31:0] addr;
+        input [31:0] stride;
+        input [15:0] rows;
+        input [15:0] cols;
+        input [1:0] descType;
+        input last;
+        begin
+            mem.memR[(DESC_ADDR >> 3) + 2*idx]     = {stride, addr};
+            mem.memR[(DESC_ADDR >> 3) + 2*idx + 1] = {20'd0, DILATION_LOG2[1:0], PAD[3:0], STRIDE_LOG2[1:0], last, OP_TYPE[0], descType, cols, rows};
+        end
+    endtask
+
+    integer i, r, c, job, n, fid, errCnt;
+    integer dataStride, filtStride, outStride;
+    integer startCycle, cycleCnt;
+    reg [DATA_WIDTH-1:0] value;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            cycleCnt    <= 0;
+        end else begin
+            cycleCnt    <= cycleCnt + 1;
+        end
+    end
+
+    initial begin
+        startR  = 0;
+        errCnt  = 0;
+
+        read_matrix(0, "data.txt", dataCols, dataRows);
+        read_matrix(1, "filt.txt", filtCols, filtRows);
+
+        fid = $fopen("output.txt", "r");
+        if (fid == 0) begin
+            $display("Could not open \"output.txt\"");
+            $finish;
+        end
+        numOutputs = 0;
+        while (!$feof(fid)) begin
+            n = $fscanf(fid, "%h\n", value);
+            outMem[numOutputs] = value;
+            numOutputs = numOutputs + 1;
+        end
+        $fclose(fid);
+
+        if (OP_TYPE == 1) begin
+            outRows = dataRows;
+            outCols = filtRows;
+        end else begin
+            outRows = ((dataRows + 2*PAD - ((filtRows - 1) << DILATION_LOG2) - 1) >> STRIDE_LOG2) + 1;
+            outCols = ((dataCols + 2*PAD - ((filtCols - 1) << DILATION_LOG2) - 1) >> STRIDE_LOG2) + 1;
+        end
+
+        // Place operands in memory
+        for (i = 0; i < MEM_WORDS; i = i + 1) begin
+            mem.memR[i] = 0;
+        end
+        dataStride = 4*dataCols + DATA_PAD;
+        filtStride = 4*filtCols + FILT_PAD;
+        outStride  = 4*outCols + OUT_PAD;
+        for (r = 0; r < dataRows; r = r + 1) begin
+            for (c = 0; c < dataCols; c = c + 1) begin
+                mem_write32(DATA_ADDR + r*dataStride + 4*c, dataMem[r*dataCols + c]);
+            end
+        end
+        for (r = 0; r < filtRows; r = r + 1) begin
+            for (c = 0; c < filtCols; c = c + 1) begin
+                mem_write32(FILT_ADDR + r*filtStride + 4*c, filtMem[r*filtCols + c]);
+            end
+        end
+
+        // Every job reloads both operands and writes its own output region
+        for (job = 0; job < NUM_JOBS; job = job + 1) begin
+            write_desc(3*job,     DATA_ADDR, dataStride, dataRows, dataCols, DESC_DATA, 0);
+            write_desc(3*job + 1, FILT_ADDR, filtStride, filtRows, filtCols, DESC_FILT, 0);
+            write_desc(3*job + 2, OUT_ADDR + job*OUT_JOB_BYTES, outStride, outRows, outCols, DESC_RUN, job == NUM_JOBS - 1);
+        end
+
+        @(negedge rst);
+        @(posedge clk);
+        startR      <= 1;
+        startCycle  = cycleCnt;
+        @(posedge clk);
+        startR      <= 0;
+
+        @(posedge dmaDone);
+        @(negedge clk);
+        $display("DMA list of %0d jobs done in %0d cycles", NUM_JOBS, cycleCnt - startCycle);
+
+        // Compare results in memory with reference
+        for (job = 0; job < NUM_JOBS; job = job + 1) begin
+            for (r = 0; r < outRows; r = r + 1) begin
+                for (c = 0; c < outCols; c = c + 1) begin
+                    value = mem_read32(OUT_ADDR + job*OUT_JOB_BYTES + r*outStride + 4*c);
+                    if (value !== outMem[r*outCols + c]) begin
+                        errCnt = errCnt + 1;
+                        $error("Job %0d output (%0d, %0d): Meas = 0x%08H, Ref=0x%08H", job, r, c, value, outMem[r*outCols + c]);
+                    end
+                end
+                // Padding after each row must be untouched
+                for (c = outCols; c < outCols + OUT_PAD/4; c = c + 1) begin
+                    if (mem_read32(OUT_ADDR + job*OUT_JOB_BYTES + r*outStride + 4*c) !== 0) begin
+                        errCnt = errCnt + 1;
+                        $error("Job %0d row %0d: padding overwritten", job, r);
+                    end
+                end
+            end
+        end
+
+        if (errCnt != 0) begin
+            $display("FAILED: %0d mismatches", errCnt);
+        end else begin
+            $display("PASSED");
+        end
+        $finish;
+    end
+
+endmodule
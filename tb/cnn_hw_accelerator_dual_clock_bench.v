@@ -0,0 +1,308 @@
+`timescale 1ns/1ns
+
+module cnn_hw_accelerator_dual_clock_bench (
+    busClkIn,
+    coreClkIn,
+    rstIn,
+    doneOut,
+    cyclesOut,
+    jobCyclesOut,
+    errorsOut);
+
+    // Runs NUM_JOBS convolutions through a cnn_hw_accelerator_dual_clock
+    // and checks every result against output.txt
+    //
+    // Operands are written on the bus clock, holding each write while
+    // wrReadyOut is low, and each job is started once busyOut drops, so
+    // the next one loads while the previous one computes on the core
+    // clock. Odd jobs drop the last data row, so they produce one output
+    // row less and lastOut checks the job boundaries. cyclesOut counts bus
+    // cycles from the first write to the last result, jobCyclesOut the bus
+    // cycles from startIn to the last result averaged over the jobs. Needs
+    // a stride 1, unpadded convolution of at least two output rows.
+
+    // RISCV bus interface
+    parameter BUS_ADDR_WIDTH = 32;
+    parameter BUS_DATA_WIDTH = 64;
+
+    // Accelerator configuration
+    parameter VECTOR_SIZE    = 8;
+    parameter DATA_WIDTH     = 32;
+    parameter MAX_SIZE       = 4096; // < Max Rows > * < Max Cols >
+
+    // Number of jobs and maximum number of outputs per job
+    parameter NUM_JOBS       = 4;
+    parameter MAX_OUTPUTS    = 65536;
+
+    // Dependent parameters for RISCV bus interface
+    localparam BUS_WE_WIDTH  = BUS_DATA_WIDTH/8;
+    localparam WE_WIDTH      = DATA_WIDTH/8;
+    localparam NUM_WORDS     = BUS_DATA_WIDTH/DATA_WIDTH;
+    localparam DIM_WIDTH     = $clog2(MAX_SIZE) + 1;
+    localparam DATA_ADDR     = 0;
+    localparam FILT_ADDR     = 1 << ($clog2(MAX_SIZE) + $clog2(WE_WIDTH));
+
+    input busClkIn;
+    input coreClkIn;
+    input rstIn;
+    output reg doneOut;
+    output reg [31:0] cyclesOut;
+    output reg [31:0] jobCyclesOut;
+    output reg [31:0] errorsOut;
+
+    // Job operands and expected outputs read from data.txt, filt.txt and output.txt
+    reg [DATA_WIDTH-1:0] dataMem [0:MAX_SIZE-1];
+    reg [DATA_WIDTH-1:0] filtMem [0:MAX_SIZE-1];
+    reg [DATA_WIDTH-1:0] outMem  [0:MAX_OUTPUTS-1];
+
+    reg [DIM_WIDTH-1:0] dataColsR;
+    reg [DIM_WIDTH-1:0] dataRowsR;
+    reg [DIM_WIDTH-1:0] filtColsR;
+    reg [DIM_WIDTH-1:0] filtRowsR;
+    reg [DIM_WIDTH-1:0] jobRowsR;
+    integer numOutputs;
+    integer outCols;
+
+    // Bus and control registers
+    reg startR;
+    reg [BUS_WE_WIDTH-1:0] wrEnR;
+    reg [BUS_DATA_WIDTH-1:0] wrDataR;
+    reg [BUS_ADDR_WIDTH-1:0] addrR;
+
+    wire [DATA_WIDTH-1:0] resData;
+    wire resValid;
+    wire resLast;
+    wire busy;
+    wire wrReady;
+
+    // Output checking, position within the job being drained
+    integer startCnt;
+    integer jobCnt;
+    integer outCnt;
+    integer cycleCnt;
+    integer lastCycle;
+    integer jobCycles;
+    integer startCycle [0:NUM_JOBS-1];
+
+    cnn_hw_accelerator_dual_clock #(
+        .BUS_ADDR_WIDTH(BUS_ADDR_WIDTH),
+        .BUS_DATA_WIDTH(BUS_DATA_WIDTH),
+        .VECTOR_SIZE(VECTOR_SIZE),
+        .MAX_SIZE(MAX_SIZE)) accel (
+        .busClkIn(busClkIn),
+        .coreClkIn(coreClkIn),
+        .rstIn(rstIn),
+        .startIn(startR),
+        .opTypeIn(1'b0),
+        .strideLog2In(2'd0),
+        .padIn(4'd0),
+        .dilationLog2In(2'd0),
+        .packIn(1'b0),
+        .quantMultIn(32'd0),
+        .quantShiftIn(6'd0),
+        .quantZeroIn(8'd0),
+        .biasEnIn(1'b0),
+        .biasIn(32'd0),
+        .actIn(2'd0),
+        .slopeIn(32'd0),
+        .poolSizeIn(2'd0),
+        .poolAvgIn(1'b0),
+        .filtRowsIn(filtRowsR),
+        .filtColsIn(filtColsR),
+        .dataRowsIn(jobRowsR),
+        .dataColsIn(dataColsR),
+        .channelsIn({{(DIM_WIDTH-1){1'b0}}, 1'b1}),
+        .dataBaseIn({(DIM_WIDTH-1){1'b0}}),
+        .filtBaseIn({(DIM_WIDTH-1){1'b0}}),
+        .holdBankIn(1'b0),
+        .addrIn(addrR),
+        .wrEnIn(wrEnR),
+        .wrDataIn(wrDataR),
+        .wrReadyOut(wrReady),
+        .readyIn(1'b1),
+        .busyOut(busy),
+        .queueFullOut(),
+        .validOut(resValid),
+        .dataOut(resData),
+        .keepOut(),
+        .lastOut(resLast),
+        .countOut(),
+        .perfStartIn(1'b0),
+        .perfStopIn(1'b0),
+        .perfClearIn(1'b0),
+        .perfSelIn(3'd0),
+        .perfDataOut());
+
+    // Read one matrix file (columns, rows, then elements)
+    task read_matrix;
+        input isFilt;
+        input [8*16-1:0] fileName;
+        output [DIM_WIDTH-1:0] cols;
+        output [DIM_WIDTH-1:0] rows;
+        output integer numElems;
+        integer fid, n;
+        reg [DATA_WIDTH-1:0] value;
+        begin
+            fid = $fopen(fileName, "r");
+            if (fid == 0) begin
+                $display("Could not open \"%0s\"", fileName);
+                $finish;
+            end
+            n = $fscanf(fid, "%h\n", value);
+            cols = value;
+            n = $fscanf(fid, "%h\n", value);
+            rows = value;
+            numElems = 0;
+            while (!$feof(fid)) begin
+                n = $fscanf(fid, "%h\n", value);
+                if (isFilt) begin
+                    filtMem[numElems] = value;
+                end else begin
+                    dataMem[numElems] = value;
+                end
+                numElems = numElems + 1;
+            end
+            $fclose(fid);
+        end
+    endtask
+
+    // Write one matrix from bus address base, each word is held until
+    // wrReadyOut takes it
+    task load_matrix;
+        input isFilt;
+        input integer numElems;
+        input integer base;
+        integer w, k;
+        begin
+            for (w = 0; w < (numElems + NUM_WORDS - 1)/NUM_WORDS; w = w + 1) begin
+                @(posedge busClkIn);
+                addrR   <= base + w*BUS_WE_WIDTH;
+                for (k = 0; k < NUM_WORDS; k = k + 1) begin
+                    if (w*NUM_WORDS + k < numElems) begin
+                        wrDataR[k*DATA_WIDTH+:DATA_WIDTH]   <= isFilt ? filtMem[w*NUM_WORDS+k] : dataMem[w*NUM_WORDS+k];
+                        wrEnR[k*WE_WIDTH+:WE_WIDTH]         <= {WE_WIDTH{1'b1}};
+                    end else begin
+                        wrDataR[k*DATA_WIDTH+:DATA_WIDTH]   <= 0;
+                        wrEnR[k*WE_WIDTH+:WE_WIDTH]         <= {WE_WIDTH{1'b0}};
+                    end
+                end
+                @(negedge busClkIn);
+                while (!wrReady) begin
+                    @(negedge busClkIn);
+                end
+            end
+            @(posedge busClkIn);
+            wrEnR   <= 0;
+        end
+    endtask
+
+    // Wait for the load bank to be released, then start the job
+    task start_job;
+        input integer rows;
+        begin
+            @(negedge busClkIn);
+            while (busy || !wrReady) begin
+                @(negedge busClkIn);
+            end
+            @(posedge busClkIn);
+            startR      <= 1;
+            jobRowsR    <= rows;
+            @(posedge busClkIn);
+            startR      <= 0;
+        end
+    endtask
+
+    // Results of job n, odd jobs lack the last output row
+    function integer job_outputs;
+        input integer n;
+        begin
+            job_outputs = numOutputs - (n % 2)*outCols;
+        end
+    endfunction
+
+    always @(posedge busClkIn) begin
+        if (rstIn) begin
+            cycleCnt    <= 0;
+        end else begin
+            cycleCnt    <= cycleCnt + 1;
+            if (startR) begin
+                startCycle[startCnt] = cycleCnt;
+                startCnt = startCnt + 1;
+            end
+            if (resValid) begin
+                if (resData !== outMem[outCnt]) begin
+                    errorsOut = errorsOut + 1;
+                    $error("Error Detected at Time %t: job %0d: Meas = 0x%08H, Ref=0x%08H", $realtime, jobCnt,
+                        resData, outMem[outCnt]);
+                end
+
+                // Only the last output of each job is marked
+                if (resLast !== (outCnt == job_outputs(jobCnt) - 1)) begin
+                    errorsOut = errorsOut + 1;
+                    $error("Error Detected at Time %t: job %0d: lastOut = %b at output %0d", $realtime, jobCnt,
+                        resLast, outCnt);
+                end
+                if (resLast) begin
+                    lastCycle   = cycleCnt;
+                    jobCycles   = jobCycles + cycleCnt - startCycle[jobCnt];
+                    jobCnt      = jobCnt + 1;
+                    outCnt      = 0;
+                end else begin
+                    outCnt      = outCnt + 1;
+                end
+            end
+        end
+    end
+
+    integer numData, numFilt, fid, n, job, firstCycle;
+    reg [DATA_WIDTH-1:0] value;
+    initial begin
+        startR       = 0;
+        wrEnR        = 0;
+        wrDataR      = 0;
+        addrR        = 0;
+        jobRowsR     = 0;
+        startCnt     = 0;
+        jobCnt       = 0;
+        outCnt       = 0;
+        jobCycles    = 0;
+        doneOut      = 0;
+        cyclesOut    = 0;
+        jobCyclesOut = 0;
+        errorsOut    = 0;
+
+        read_matrix(0, "data.txt", dataColsR, dataRowsR, numData);
+        read_matrix(1, "filt.txt", filtColsR, filtRowsR, numFilt);
+        outCols = dataColsR - filtColsR + 1;
+
+        fid = $fopen("output.txt", "r");
+        if (fid == 0) begin
+            $display("Could not open \"output.txt\"");
+            $finish;
+        end
+        numOutputs = 0;
+        while (!$feof(fid)) begin
+            n = $fscanf(fid, "%h\n", value);
+            outMem[numOutputs] = value;
+            numOutputs = numOutputs + 1;
+        end
+        $fclose(fid);
+
+        @(negedge rstIn);
+
+        // Load each job while the previous one computes
+        firstCycle = cycleCnt;
+        for (job = 0; job < NUM_JOBS; job = job + 1) begin
+            load_matrix(0, numData, DATA_ADDR);
+            load_matrix(1, numFilt, FILT_ADDR);
+            start_job(dataRowsR - (job % 2));
+        end
+        while (jobCnt < NUM_JOBS) begin
+            @(negedge busClkIn);
+        end
+        cyclesOut    = lastCycle - firstCycle;
+        jobCyclesOut = jobCycles/NUM_JOBS;
+        doneOut      = 1;
+    end
+
+endmodule
@@ -0,0 +1,77 @@
+`timescale 1ns/1ns
+
+module cnn_hw_accelerator_dual_clock_tb;
+
+    parameter BUS_PERIOD     = 12;
+    parameter RESET_TIME     = 100;
+
+    // Core clock periods swept against the bus clock, one bench each. The
+    // core is slower, as fast or up to three times faster than the bus,
+    // and the 12:10 pair keeps shifting the phase between the two clocks
+    parameter NUM_RATIOS     = 6;
+    parameter [8*NUM_RATIOS-1:0] CORE_PERIODS = {8'd4, 8'd6, 8'd8, 8'd10, 8'd12, 8'd16};
+
+    // Accelerator configuration, see cnn_hw_accelerator_dual_clock_bench.v
+    parameter VECTOR_SIZE    = 8;
+    parameter MAX_SIZE       = 4096; // < Max Rows > * < Max Cols >
+    parameter NUM_JOBS       = 4;
+
+    wire busClk;
+    wire rst;
+
+    wire [NUM_RATIOS-1:0] coreClk;
+    wire [NUM_RATIOS-1:0] done;
+    wire [32*NUM_RATIOS-1:0] cycles;
+    wire [32*NUM_RATIOS-1:0] jobCycles;
+    wire [32*NUM_RATIOS-1:0] errors;
+
+    clk_gen #(.CLK_PERIOD(BUS_PERIOD)) clk_gen_i (.clkOut(busClk));
+    rst_gen #(.RESET_TIME(RESET_TIME)) rst_gen_i (.rstOut(rst));
+
+    // One bench per core clock, all running the same jobs
+    genvar i;
+    generate
+        for (i = 0; i < NUM_RATIOS; i = i + 1) begin : bench
+            clk_gen #(.CLK_PERIOD(CORE_PERIODS[8*i+:8])) core_clk_gen_i (.clkOut(coreClk[i]));
+
+            cnn_hw_accelerator_dual_clock_bench #(
+                .VECTOR_SIZE(VECTOR_SIZE),
+                .MAX_SIZE(MAX_SIZE),
+                .NUM_JOBS(NUM_JOBS)) bench_i (
+                .busClkIn(busClk),
+                .coreClkIn(coreClk[i]),
+                .rstIn(rst),
+                .doneOut(done[i]),
+                .cyclesOut(cycles[32*i+:32]),
+                .jobCyclesOut(jobCycles[32*i+:32]),
+                .errorsOut(errors[32*i+:32]));
+        end
+    endgenerate
+
+    // Bus cycles per job against the core running on the bus clock
+    integer k, refIdx, errCnt;
+    initial begin
+        errCnt = 0;
+        wait (&done);
+        refIdx = 0;
+        for (k = 0; k < NUM_RATIOS; k = k + 1) begin
+            if (CORE_PERIODS[8*k+:8] == BUS_PERIOD) begin
+                refIdx = k;
+            end
+        end
+        $display("%0d jobs, %0d ns bus clock", NUM_JOBS, BUS_PERIOD);
+        $display("core ns  core/bus  bus cycles  cycles/job  speedup");
+        for (k = 0; k < NUM_RATIOS; k = k + 1) begin
+            $display("%7d  %8.2f  %10d  %10d  %7.2f", CORE_PERIODS[8*k+:8], (1.0*BUS_PERIOD)/CORE_PERIODS[8*k+:8],
+                cycles[32*k+:32], jobCycles[32*k+:32], (1.0*jobCycles[32*refIdx+:32])/jobCycles[32*k+:32]);
+            errCnt = errCnt + errors[32*k+:32];
+        end
+        if (errCnt != 0) begin
+            $display("FAILED: %0d mismatches", errCnt);
+        end else begin
+            $display("PASSED");
+        end
+        $finish;
+    end
+
+endmodule
@@ -0,0 +1,300 @@
+`timescale 1ns/1ns
+
+module cnn_hw_accelerator_gemm_tb;
+
+    // Matrix multiply shapes from cnn_hw_accelerator_golden, run back to
+    // back behind a convolution (data.txt holds A (M x K) and filt.txt B
+    // transposed (N x K)):
+    //   mkdir -p gemm_conv gemm_k13 gemm_m1 gemm_n1
+    //   ./cnn_hw_accelerator_golden --dir gemm_conv --data-rows 12 --data-cols 12 --filt-rows 3 --filt-cols 3
+    //   ./cnn_hw_accelerator_golden --dir gemm_k13 --op gemm --data-rows 5 --data-cols 13 --filt-rows 6
+    //   ./cnn_hw_accelerator_golden --dir gemm_m1 --op gemm --data-rows 1 --data-cols 24 --filt-rows 7
+    //   ./cnn_hw_accelerator_golden --dir gemm_n1 --op gemm --data-rows 9 --data-cols 20 --filt-rows 1
+
+    parameter CLK_PERIOD     = 10;
+    parameter RESET_TIME     = 100;
+
+    // RISCV bus interface
+    parameter BUS_ADDR_WIDTH = 32;
+    parameter BUS_DATA_WIDTH = 64;
+
+    // Hardware accelerator overrides
+    parameter VECTOR_SIZE    = 8;
+    parameter DATA_WIDTH     = 32;
+    parameter MAX_SIZE       = 4096; // < Max Rows > * < Max Cols >
+
+    // Maximum number of outputs over all jobs
+    parameter MAX_OUTPUTS    = 4096;
+
+    // Operation types
+    localparam OP_CONV       = 0;
+    localparam OP_GEMM       = 1;
+
+    // Dependent parameters for RISCV bus interface
+    localparam BUS_WE_WIDTH  = BUS_DATA_WIDTH/8;
+    localparam WE_WIDTH      = DATA_WIDTH/8;
+    localparam NUM_WORDS     = BUS_DATA_WIDTH/DATA_WIDTH;
+    localparam DIM_WIDTH     = $clog2(MAX_SIZE) + 1;
+    localparam DATA_ADDR     = 0;
+    localparam FILT_ADDR     = 1 << ($clog2(MAX_SIZE) + $clog2(WE_WIDTH));
+
+    wire clk;
+    wire rst;
+
+    // Operands of the job being loaded, and the expected outputs of all
+    // jobs in order with the last output of each job marked
+    reg [DATA_WIDTH-1:0] dataMem [0:MAX_SIZE-1];
+    reg [DATA_WIDTH-1:0] filtMem [0:MAX_SIZE-1];
+    reg [DATA_WIDTH-1:0] outMem  [0:MAX_OUTPUTS-1];
+    reg                  lastMem [0:MAX_OUTPUTS-1];
+    integer numOutputs;
+
+    // Dimensions of the loaded job, applied on startIn
+    reg [DIM_WIDTH-1:0] dataColsR;
+    reg [DIM_WIDTH-1:0] dataRowsR;
+    reg [DIM_WIDTH-1:0] filtColsR;
+    reg [DIM_WIDTH-1:0] filtRowsR;
+    reg opTypeR;
+    integer numData, numFilt;
+
+    // Bus and control registers
+    reg startR;
+    reg [BUS_WE_WIDTH-1:0] wrEnR;
+    reg [BUS_DATA_WIDTH-1:0] wrDataR;
+    reg [BUS_ADDR_WIDTH-1:0] addrR;
+
+    wire [DATA_WIDTH-1:0] resData;
+    wire resValid;
+    wire resLast;
+    wire busy;
+
+    // Output checking
+    integer outCnt;
+    integer errCnt;
+
+    clk_gen #(.CLK_PERIOD(CLK_PERIOD)) clk_gen_i (.clkOut(clk));
+    rst_gen #(.RESET_TIME(RESET_TIME)) rst_gen_i (.rstOut(rst));
+
+    cnn_hw_accelerator #(
+        .BUS_ADDR_WIDTH(BUS_ADDR_WIDTH),
+        .BUS_DATA_WIDTH(BUS_DATA_WIDTH),
+        .VECTOR_SIZE(VECTOR_SIZE),
+        .MAX_SIZE(MAX_SIZE)) accel (
+        .clkIn(clk),
+        .rstIn(rst),
+        .startIn(startR),
+        .opTypeIn(opTypeR),
+        .strideLog2In(2'd0),
+        .padIn(4'd0),
+        .dilationLog2In(2'd0),
+        .packIn(1'b0),
+        .quantMultIn(32'd0),
+        .quantShiftIn(6'd0),
+        .quantZeroIn(8'd0),
+        .biasEnIn(1'b0),
+        .biasIn(32'd0),
+        .actIn(2'd0),
+        .slopeIn(32'd0),
+        .poolSizeIn(2'd0),
+        .poolAvgIn(1'b0),
+        .filtRowsIn(filtRowsR),
+        .filtColsIn(filtColsR),
+        .dataRowsIn(dataRowsR),
+        .dataColsIn(dataColsR),
+        .channelsIn({{(DIM_WIDTH-1){1'b0}}, 1'b1}),
+        .dataBaseIn({(DIM_WIDTH-1){1'b0}}),
+        .filtBaseIn({(DIM_WIDTH-1){1'b0}}),
+        .holdBankIn(1'b0),
+        .addrIn(addrR),
+        .wrEnIn(wrEnR),
+        .wrDataIn(wrDataR),
+        .readyIn(1'b1),
+        .busyOut(busy),
+        .queueFullOut(),
+        .validOut(resValid),
+        .dataOut(resData),
+        .keepOut(),
+        .lastOut(resLast),
+        .countOut(),
+        .perfStartIn(1'b0),
+        .perfStopIn(1'b0),
+        .perfClearIn(1'b0),
+        .perfSelIn(3'd0),
+        .perfDataOut());
+
+    // Read one matrix file (columns, rows, then elements)
+    task read_matrix;
+        input isFilt;
+        input [8*32-1:0] fileName;
+        output [DIM_WIDTH-1:0] cols;
+        output [DIM_WIDTH-1:0] rows;
+        output integer numElems;
+        integer fid, n;
+        reg [DATA_WIDTH-1:0] value;
+        begin
+            fid = $fopen(fileName, "r");
+            if (fid == 0) begin
+                $display("Could not open \"%0s\"", fileName);
+                $finish;
+            end
+            n = $fscanf(fid, "%h\n", value);
+            cols = value;
+            n = $fscanf(fid, "%h\n", value);
+            rows = value;
+            numElems = 0;
+            while (!$feof(fid)) begin
+                n = $fscanf(fid, "%h\n", value);
+                if (isFilt) begin
+                    filtMem[numElems] = value;
+                end else begin
+                    dataMem[numElems] = value;
+                end
+                numElems = numElems + 1;
+            end
+            $fclose(fid);
+        end
+    endtask
+
+    // Append the expected outputs of one job
+    task read_outputs;
+        input [8*32-1:0] fileName;
+        integer fid, n;
+        reg [DATA_WIDTH-1:0] value;
+        begin
+            fid = $fopen(fileName, "r");
+            if (fid == 0) begin
+                $display("Could not open \"%0s\"", fileName);
+                $finish;
+            end
+            while (!$feof(fid)) begin
+                n = $fscanf(fid, "%h\n", value);
+                outMem[numOutputs]  = value;
+                lastMem[numOutputs] = 0;
+                numOutputs = numOutputs + 1;
+            end
+            lastMem[numOutputs-1] = 1;
+            $fclose(fid);
+        end
+    endtask
+
+    // Write one matrix into the load bank, rows back to back
+    task load_matrix;
+        input isFilt;
+        input integer numElems;
+        integer w, k;
+        begin
+            for (w = 0; w < (numElems + NUM_WORDS - 1)/NUM_WORDS; w = w + 1) begin
+                @(posedge clk);
+                addrR   <= (isFilt ? FILT_ADDR : DATA_ADDR) + w*BUS_WE_WIDTH;
+                for (k = 0; k < NUM_WORDS; k = k + 1) begin
+                    if (w*NUM_WORDS + k < numElems) begin
+                        wrDataR[k*DATA_WIDTH+:DATA_WIDTH]   <= isFilt ? filtMem[w*NUM_WORDS+k] : dataMem[w*NUM_WORDS+k];
+                        wrEnR[k*WE_WIDTH+:WE_WIDTH]         <= {WE_WIDTH{1'b1}};
+                    end else begin
+                        wrDataR[k*DATA_WIDTH+:DATA_WIDTH]   <= 0;
+                        wrEnR[k*WE_WIDTH+:WE_WIDTH]         <= {WE_WIDTH{1'b0}};
+                    end
+                end
+            end
+            @(posedge clk);
+            wrEnR   <= 0;
+        end
+    endtask
+
+    // Read the vectors of one job and load them into the free bank
+    task load_job;
+        input isGemm;
+        input [8*32-1:0] dataFile;
+        input [8*32-1:0] filtFile;
+        input [8*32-1:0] outFile;
+        reg [DIM_WIDTH-1:0] dataCols, dataRows, filtCols, filtRows;
+        begin
+            read_matrix(0, dataFile, dataCols, dataRows, numData);
+            read_matrix(1, filtFile, filtCols, filtRows, numFilt);
+            read_outputs(outFile);
+            load_matrix(0, numData);
+            load_matrix(1, numFilt);
+            opTypeR     = isGemm;
+            dataColsR   = dataCols;
+            dataRowsR   = dataRows;
+            filtColsR   = filtCols;
+            filtRowsR   = filtRows;
+        end
+    endtask
+
+    // Wait for the current job to release its bank, then start the next one
+    task start_job;
+        begin
+            @(negedge clk);
+            while (busy) begin
+                @(negedge clk);
+            end
+            @(posedge clk);
+            startR  <= 1;
+            @(posedge clk);
+            startR  <= 0;
+        end
+    endtask
+
+    // Outputs of all jobs arrive in order
+    always @(posedge clk) begin
+        if (!rst && resValid) begin
+            if (outCnt >= numOutputs) begin
+                errCnt  = errCnt + 1;
+                $error("Error Detected at Time %t: Unexpected Data (0x%08H) Received", $realtime, resData);
+            end else begin
+                if (resData !== outMem[outCnt]) begin
+                    errCnt  = errCnt + 1;
+                    $error("Error Detected at Time %t: output %0d Meas = 0x%08H, Ref=0x%08H", $realtime, outCnt, resData, outMem[outCnt]);
+                end
+                if (resLast !== lastMem[outCnt]) begin
+                    errCnt  = errCnt + 1;
+                    $error("Error Detected at Time %t: lastOut = %b at output %0d", $realtime, resLast, outCnt);
+                end
+            end
+            outCnt  = outCnt + 1;
+        end
+    end
+
+    initial begin
+        startR      = 0;
+        wrEnR       = 0;
+        wrDataR     = 0;
+        addrR       = 0;
+        opTypeR     = 0;
+        dataColsR   = 0;
+        dataRowsR   = 0;
+        filtColsR   = 0;
+        filtRowsR   = 0;
+        numOutputs  = 0;
+        outCnt      = 0;
+        errCnt      = 0;
+
+        @(negedge rst);
+
+        // Each job is loaded while the previous one computes, so every
+        // GEMM starts as soon as the bank of the job before it is free
+        load_job(OP_CONV, "gemm_conv/data.txt", "gemm_conv/filt.txt", "gemm_conv/output.txt");
+        start_job;
+        load_job(OP_GEMM, "gemm_k13/data.txt", "gemm_k13/filt.txt", "gemm_k13/output.txt");
+        start_job;
+        load_job(OP_GEMM, "gemm_m1/data.txt", "gemm_m1/filt.txt", "gemm_m1/output.txt");
+        start_job;
+        load_job(OP_GEMM, "gemm_n1/data.txt", "gemm_n1/filt.txt", "gemm_n1/output.txt");
+        start_job;
+
+        while (outCnt < numOutputs) begin
+            @(negedge clk);
+        end
+        repeat (100) @(negedge clk);
+
+        $display("%0d outputs from a convolution and GEMMs with K = 13, M = 1 and N = 1", numOutputs);
+        if ((errCnt != 0) || (outCnt != numOutputs)) begin
+            $display("FAILED: %0d mismatches, %0d of %0d outputs", errCnt, outCnt, numOutputs);
+        end else begin
+            $display("PASSED");
+        end
+        $finish;
+    end
+
+endmodule
@@ -0,0 +1,367 @@
+`timescale 1ns/1ns
+
+module cnn_hw_accelerator_pingpong_tb;
+
+    parameter CLK_PERIOD     = 10;
+    parameter RESET_TIME     = 100;
+
+    // RISCV bus interface
+    parameter BUS_ADDR_WIDTH = 32;
+    parameter BUS_DATA_WIDTH = 64;
+
+    // Hardware accelerator overrides
+    parameter VECTOR_SIZE    = 8;
+    parameter DATA_WIDTH     = 32;
+    parameter MAX_SIZE       = 4096; // < Max Rows > * < Max Cols >
+
+    // Operation type (0 = 2D convolution, 1 = matrix multiply)
+    parameter OP_TYPE        = 0;
+
+    // Convolution stride and dilation (log2) and zero padding
+    parameter STRIDE_LOG2    = 0;
+    parameter PAD            = 0;
+    parameter DILATION_LOG2  = 0;
+
+    // Number of back-to-back jobs run in each mode
+    parameter NUM_JOBS       = 4;
+
+    // Maximum number of outputs per job
+    parameter MAX_OUTPUTS    = 65536;
+
+    // Dependent parameters for RISCV bus interface
+    localparam BUS_WE_WIDTH  = BUS_DATA_WIDTH/8;
+    localparam WE_WIDTH      = DATA_WIDTH/8;
+    localparam NUM_WORDS     = BUS_DATA_WIDTH/DATA_WIDTH;
+    localparam DIM_WIDTH     = $clog2(MAX_SIZE) + 1;
+    localparam DATA_ADDR     = 0;
+    localparam FILT_ADDR     = 1 << ($clog2(MAX_SIZE) + $clog2(WE_WIDTH));
+
+    wire clk;
+    wire rst;
+
+    // Job operands and expected outputs read from data.txt, filt.txt and output.txt
+    reg [DATA_WIDTH-1:0] dataMem [0:MAX_SIZE-1];
+    reg [DATA_WIDTH-1:0] filtMem [0:MAX_SIZE-1];
+    reg [DATA_WIDTH-1:0] outMem  [0:MAX_OUTPUTS-1];
+
+    reg [DIM_WIDTH-1:0] dataColsR;
+    reg [DIM_WIDTH-1:0] dataRowsR;
+    reg [DIM_WIDTH-1:0] filtColsR;
+    reg [DIM_WIDTH-1:0] filtRowsR;
+    integer numOutputs;
+
+    // Element offsets of the job within its bank, and whether it holds
+    // the bank of the previous job
+    reg [DIM_WIDTH-2:0] dataBaseR;
+    reg [DIM_WIDTH-2:0] filtBaseR;
+    reg holdR;
+
+    // Bus and control registers
+    reg startR;
+    reg [BUS_WE_WIDTH-1:0] wrEnR;
+    reg [BUS_DATA_WIDTH-1:0] wrDataR;
+    reg [BUS_ADDR_WIDTH-1:0] addrR;
+
+    wire [DATA_WIDTH-1:0] resData;
+    wire resValid;
+    wire resLast;
+    wire busy;
+    wire queueFull;
+
+    // Output checking
+    integer outCnt;
+    integer errCnt;
+
+    // Cycle counter and cycle of the last output of each job
+    integer cycleCnt;
+    integer lastCycle [0:3*NUM_JOBS-1];
+
+    clk_gen #(.CLK_PERIOD(CLK_PERIOD)) clk_gen_i (.clkOut(clk));
+    rst_gen #(.RESET_TIME(RESET_TIME)) rst_gen_i (.rstOut(rst));
+
+    cnn_hw_accelerator #(
+        .BUS_ADDR_WIDTH(BUS_ADDR_WIDTH),
+        .BUS_DATA_WIDTH(BUS_DATA_WIDTH),
+        .VECTOR_SIZE(VECTOR_SIZE),
+        .MAX_SIZE(MAX_SIZE)) accel (
+        .clkIn(clk),
+        .rstIn(rst),
+        .startIn(startR),
+        .opTypeIn(OP_TYPE[0]),
+        .strideLog2In(STRIDE_LOG2[1:0]),
+        .padIn(PAD[3:0]),
+        .dilationLog2In(DILATION_LOG2[1:0]),
+        .packIn(1'b0),
+        .quantMultIn(32'd0),
+        .quantShiftIn(6'd0),
+        .quantZeroIn(8'd0),
+        .biasEnIn(1'b0),
+        .biasIn(32'd0),
+        .actIn(2'd0),
+        .slopeIn(32'd0),
+        .poolSizeIn(2'd0),
+        .poolAvgIn(1'b0),
+        .filtRowsIn(filtRowsR),
+        .filtColsIn(filtColsR),
+        .dataRowsIn(dataRowsR),
+        .dataColsIn(dataColsR),
+        .channelsIn({{(DIM_WIDTH-1){1'b0}}, 1'b1}),
+        .dataBaseIn(dataBaseR),
+        .filtBaseIn(filtBaseR),
+        .holdBankIn(holdR),
+        .addrIn(addrR),
+        .wrEnIn(wrEnR),
+        .wrDataIn(wrDataR),
+        .readyIn(1'b1),
+        .busyOut(busy),
+        .queueFullOut(queueFull),
+        .validOut(resValid),
+        .dataOut(resData),
+        .keepOut(),
+        .lastOut(resLast),
+        .countOut(),
+        .perfStartIn(1'b0),
+        .perfStopIn(1'b0),
+        .perfClearIn(1'b0),
+        .perfSelIn(3'd0),
+        .perfDataOut());
+
+    // Read one matrix file (columns, rows, then elements)
+    task read_matrix;
+        input isFilt;
+        input [8*16-1:0] fileName;
+        output [DIM_WIDTH-1:0] cols;
+        output [DIM_WIDTH-1:0] rows;
+        output integer numElems;
+        integer fid, n;
+        reg [DATA_WIDTH-1:0] value;
+        begin
+            fid = $fopen(fileName, "r");
+            if (fid == 0) begin
+                $display("Could not open \"%0s\"", fileName);
+                $finish;
+            end
+            n = $fscanf(fid, "%h\n", value);
+            cols = value;
+            n = $fscanf(fid, "%h\n", value);
+            rows = value;
+            numElems = 0;
+            while (!$feof(fid)) begin
+                n = $fscanf(fid, "%h\n", value);
+                if (isFilt) begin
+                    filtMem[numElems] = value;
+                end else begin
+                    dataMem[numElems] = value;
+                end
+                numElems = numElems + 1;
+            end
+            $fclose(fid);
+        end
+    endtask
+
+    // Write one matrix into the load bank from element offset base (a
+    // multiple of the elements per bus write)
+    task load_matrix;
+        input isFilt;
+        input integer numElems;
+        input integer base;
+        integer w, k;
+        begin
+            for (w = 0; w < (numElems + NUM_WORDS - 1)/NUM_WORDS; w = w + 1) begin
+                @(posedge clk);
+                addrR   <= (isFilt ? FILT_ADDR : DATA_ADDR) + base*WE_WIDTH + w*BUS_WE_WIDTH;
+                for (k = 0; k < NUM_WORDS; k = k + 1) begin
+                    if (w*NUM_WORDS + k < numElems) begin
+                        wrDataR[k*DATA_WIDTH+:DATA_WIDTH]   <= isFilt ? filtMem[w*NUM_WORDS+k] : dataMem[w*NUM_WORDS+k];
+                        wrEnR[k*WE_WIDTH+:WE_WIDTH]         <= {WE_WIDTH{1'b1}};
+                    end else begin
+                        wrDataR[k*DATA_WIDTH+:DATA_WIDTH]   <= 0;
+                        wrEnR[k*WE_WIDTH+:WE_WIDTH]         <= {WE_WIDTH{1'b0}};
+                    end
+                end
+            end
+            @(posedge clk);
+            wrEnR   <= 0;
+        end
+    endtask
+
+    // Wait for the current job to release its bank, then start the next one
+    task start_job;
+        begin
+            @(negedge clk);
+            while (busy) begin
+                @(negedge clk);
+            end
+            @(posedge clk);
+            startR  <= 1;
+            @(posedge clk);
+            startR  <= 0;
+        end
+    endtask
+
+    // Queue a job once there is room, holding the bank of the previous job
+    // or swapping banks
+    task queue_job;
+        input hold;
+        input integer dataBase;
+        input integer filtBase;
+        begin
+            @(negedge clk);
+            while (queueFull || (!hold && busy)) begin
+                @(negedge clk);
+            end
+            @(posedge clk);
+            startR      <= 1;
+            holdR       <= hold;
+            dataBaseR   <= dataBase;
+            filtBaseR   <= filtBase;
+            @(posedge clk);
+            startR      <= 0;
+        end
+    endtask
+
+    // Wait for the current job to release its bank
+    task wait_job;
+        begin
+            @(negedge clk);
+            while (busy) begin
+                @(negedge clk);
+            end
+        end
+    endtask
+
+    // Wait for all outputs of the given number of jobs
+    task wait_outputs;
+        input integer numJobs;
+        begin
+            while (outCnt < numJobs*numOutputs) begin
+                @(negedge clk);
+            end
+        end
+    endtask
+
+    // Every job uses the same operands, so outputs repeat every numOutputs
+    always @(posedge clk) begin
+        if (rst) begin
+            cycleCnt    <= 0;
+        end else begin
+            cycleCnt    <= cycleCnt + 1;
+            if (resValid) begin
+                if (resData !== outMem[outCnt % numOutputs]) begin
+                    errCnt  = errCnt + 1;
+                    $error("Error Detected at Time %t: Meas = 0x%08H, Ref=0x%08H", $realtime, resData, outMem[outCnt % numOutputs]);
+                end
+                
+                // Only the last output of each job is marked
+                if (resLast !== (outCnt % numOutputs == numOutputs - 1)) begin
+                    errCnt  = errCnt + 1;
+                    $error("Error Detected at Time %t: lastOut = %b at output %0d", $realtime, resLast, outCnt);
+                end
+                if (resLast) begin
+                    lastCycle[outCnt / numOutputs] = cycleCnt;
+                end
+                outCnt  = outCnt + 1;
+            end
+        end
+    end
+
+    integer numData, numFilt, fid, n, job;
+    integer dataStride, filtStride;
+    integer startCycle, serialCycles, overlapCycles, queuedCycles;
+    reg [DATA_WIDTH-1:0] value;
+    initial begin
+        startR  = 0;
+        wrEnR   = 0;
+        wrDataR = 0;
+        addrR   = 0;
+        dataBaseR = 0;
+        filtBaseR = 0;
+        holdR   = 0;
+        outCnt  = 0;
+        errCnt  = 0;
+
+        read_matrix(0, "data.txt", dataColsR, dataRowsR, numData);
+        read_matrix(1, "filt.txt", filtColsR, filtRowsR, numFilt);
+
+        fid = $fopen("output.txt", "r");
+        if (fid == 0) begin
+            $display("Could not open \"output.txt\"");
+            $finish;
+        end
+        numOutputs = 0;
+        while (!$feof(fid)) begin
+            n = $fscanf(fid, "%h\n", value);
+            outMem[numOutputs] = value;
+            numOutputs = numOutputs + 1;
+        end
+        $fclose(fid);
+
+        @(negedge rst);
+
+        // Single buffered: load, compute, wait, repeat
+        startCycle = cycleCnt;
+        for (job = 0; job < NUM_JOBS; job = job + 1) begin
+            load_matrix(0, numData, 0);
+            load_matrix(1, numFilt, 0);
+            start_job;
+            wait_job;
+        end
+        wait_outputs(NUM_JOBS);
+        serialCycles = cycleCnt - startCycle;
+
+        // Ping-pong: load job N+1 while job N computes
+        startCycle = cycleCnt;
+        load_matrix(0, numData, 0);
+        load_matrix(1, numFilt, 0);
+        for (job = 0; job < NUM_JOBS; job = job + 1) begin
+            start_job;
+            if (job < NUM_JOBS - 1) begin
+                load_matrix(0, numData, 0);
+                load_matrix(1, numFilt, 0);
+            end
+        end
+        wait_outputs(2*NUM_JOBS);
+        overlapCycles = cycleCnt - startCycle;
+
+        // Queued: load every job into one bank at its own offsets, then
+        // queue them back to back holding that bank
+        dataStride = ((numData + NUM_WORDS - 1)/NUM_WORDS)*NUM_WORDS;
+        filtStride = ((numFilt + NUM_WORDS - 1)/NUM_WORDS)*NUM_WORDS;
+        if ((NUM_JOBS*dataStride > MAX_SIZE) || (NUM_JOBS*filtStride > MAX_SIZE)) begin
+            $display("%0d jobs do not fit in one bank", NUM_JOBS);
+            $finish;
+        end
+        startCycle = cycleCnt;
+        for (job = 0; job < NUM_JOBS; job = job + 1) begin
+            load_matrix(0, numData, job*dataStride);
+            load_matrix(1, numFilt, job*filtStride);
+        end
+        for (job = 0; job < NUM_JOBS; job = job + 1) begin
+            queue_job(job != 0, job*dataStride, job*filtStride);
+        end
+        wait_outputs(3*NUM_JOBS);
+        queuedCycles = cycleCnt - startCycle;
+
+        $display("Jobs: %0d x (%0dx%0d data, %0dx%0d filter, %0d outputs)", NUM_JOBS,
+            dataRowsR, dataColsR, filtRowsR, filtColsR, numOutputs);
+        $display("Single buffered: %0d cycles (%0d cycles/job)", serialCycles, serialCycles/NUM_JOBS);
+        $display("Ping-pong:       %0d cycles (%0d cycles/job)", overlapCycles, overlapCycles/NUM_JOBS);
+        $display("Queued:          %0d cycles (%0d cycles/job)", queuedCycles, queuedCycles/NUM_JOBS);
+        $display("Speedup:         %0.2f ping-pong, %0.2f queued", (1.0*serialCycles)/overlapCycles,
+            (1.0*serialCycles)/queuedCycles);
+        
+        // Sustained rate, cycles between the last outputs of consecutive
+        // jobs once the first one has completed
+        $display("Cycles between jobs: %0d single buffered, %0d ping-pong, %0d queued",
+            (lastCycle[NUM_JOBS-1] - lastCycle[0])/(NUM_JOBS-1),
+            (lastCycle[2*NUM_JOBS-1] - lastCycle[NUM_JOBS])/(NUM_JOBS-1),
+            (lastCycle[3*NUM_JOBS-1] - lastCycle[2*NUM_JOBS])/(NUM_JOBS-1));
+        if (errCnt != 0) begin
+            $display("FAILED: %0d mismatches", errCnt);
+        end else begin
+            $display("PASSED");
+        end
+        $finish;
+    end
+
+endmodule
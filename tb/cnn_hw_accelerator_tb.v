@@ -9,9 +9,65 @@ module cnn_hw_accelerator_tb;
     
     // Hardware accelerator overrides
     parameter VECTOR_SIZE    = 8;
-    parameter DATA_WIDTH     = 32;
     parameter MAX_SIZE       = 4096; // < Max Rows > * < Max Cols >
     
+    // Operand type (bfloat16: 8/8 with VECTOR_SIZE = 16, FP16: 11/5)
+    // Outputs are always single precision
+    parameter FRAC_WIDTH     = 24;
+    parameter EXP_WIDTH      = 8;
+    
+    // MAC engine ("FLOAT" or "INT8" with VECTOR_SIZE = 32) and the
+    // requantization of INT8 outputs (QUANT_MULT = 0 for raw int32 sums)
+    parameter MAC_STYLE      = "FLOAT";
+    parameter QUANT_MULT     = 0;
+    parameter QUANT_SHIFT    = 0;
+    parameter QUANT_ZERO     = 0;
+    
+    // Operation type (0 = 2D convolution, 1 = matrix multiply)
+    parameter OP_TYPE        = 0;
+
+    // Convolution stride and dilation (log2) and zero padding
+    parameter STRIDE_LOG2    = 0;
+    parameter PAD            = 0;
+    parameter DILATION_LOG2  = 0;
+    
+    // Input channels, data.txt and filt.txt hold the CHANNELS planes
+    // stacked by rows (see cnn_hw_accelerator_golden --channels)
+    parameter CHANNELS       = 1;
+    
+    // Sliding-window line buffer (0 = read every window from RAM)
+    parameter LINE_BUFFER    = 1;
+    
+    // Pack consecutive filter rows into each beat, data rows are then
+    // written with the row pitch expected by the accelerator
+    parameter PACK           = 0;
+    
+    // Post-processing: bias (BIAS_EN), activation (0 = none, 1 = ReLU,
+    // 2 = leaky ReLU with slope SLOPE) and POOL_SIZE x POOL_SIZE max or
+    // average (POOL_AVG) pooling, BIAS and SLOPE are single precision
+    // bit patterns (BIAS is an int32 for MAC_STYLE = "INT8")
+    parameter BIAS_EN        = 0;
+    parameter BIAS           = 0;
+    parameter ACT            = 0;
+    parameter SLOPE          = 0;
+    parameter POOL_SIZE      = 0;
+    parameter POOL_AVG       = 0;
+    
+    // Width of dataOut (e.g. BUS_DATA_WIDTH to pack results into bus
+    // words), packed words are unpacked here one result per cycle
+    parameter OUT_DATA_WIDTH = 32;
+    
+    // Throttled consumer, readyIn is high READY_HIGH of every READY_PERIOD
+    // cycles (e.g. 1 and 4 to drain at a quarter of the output rate)
+    parameter READY_HIGH     = 1;
+    parameter READY_PERIOD   = 1;
+    
+    // Vector files hold one 32-bit hex value per line, 16-bit operands
+    // are in the low bits
+    localparam FILE_WIDTH    = 32;
+    localparam OUT_LANES     = OUT_DATA_WIDTH/FILE_WIDTH;
+    localparam DATA_WIDTH    = (MAC_STYLE == "INT8") ? 8 : FRAC_WIDTH + EXP_WIDTH;
+    
     // Dependent parameters for RISCV bus interface
     localparam BUS_WE_WIDTH  = BUS_DATA_WIDTH/8;
     localparam WE_WIDTH      = DATA_WIDTH/8;
@@ -33,11 +89,11 @@ module cnn_hw_accelerator_tb;
     wire clk;
     wire rst;
     
-    wire [DATA_WIDTH-1:0] data;
+    wire [FILE_WIDTH-1:0] data;
     wire dataValid;
     wire dataLast;
     
-    wire [DATA_WIDTH-1:0] filt;
+    wire [FILE_WIDTH-1:0] filt;
     wire filtValid;
     wire filtLast;
     
@@ -58,10 +114,25 @@ module cnn_hw_accelerator_tb;
     reg [CNT_WIDTH-1:0] cntR;
     reg firstR;
     
-    wire [DATA_WIDTH-1:0] resData;
+    // Data matrix layout
+    reg [DIM_WIDTH-1:0] pitchR;
+    reg [DIM_WIDTH-1:0] colR;
+    reg [DIM_WIDTH-1:0] elemR;
+    
+    wire [OUT_DATA_WIDTH-1:0] resData;
+    wire [     OUT_LANES-1:0] resKeep;
+    wire resLast;
     wire resValid;
+    wire resReady;
+    wire [31:0] resCount;
     wire error;
     
+    // Packed word being checked, one lane per cycle
+    reg [OUT_DATA_WIDTH-1:0] wordR;
+    reg [     OUT_LANES-1:0] pendR;
+    wire [FILE_WIDTH-1:0] checkData;
+    wire checkValid;
+    
     clk_gen #(.CLK_PERIOD(CLK_PERIOD)) clk_gen_i (.clkOut(clk));
     rst_gen #(.RESET_TIME(RESET_TIME)) rst_gen_i (.rstOut(rst));
     
@@ -99,14 +170,18 @@ module cnn_hw_accelerator_tb;
             wrDataR     <= 0;
             cntR        <= 0;
             firstR      <= 0;
+            pitchR      <= 0;
+            colR        <= 0;
+            elemR       <= 0;
         end else begin
             startR      <= 0;
             wrEnR       <= 0;
             case (stateR)
+                // Filter is loaded first as the data pitch depends on it
                 IDLE : begin
-                    if (dataValid) begin
-                        dataReadyR  <= 1;
-                        stateR      <= DCOLS;
+                    if (filtValid) begin
+                        filtReadyR  <= 1;
+                        stateR      <= FCOLS;
                     end
                 end
                 DCOLS : begin
@@ -114,32 +189,33 @@ module cnn_hw_accelerator_tb;
                     stateR          <= DROWS;
                 end
                 DROWS : begin
-                    cntR            <= 0;
-                    addrR           <= DATA_ADDR;
-                    firstR          <= 1;
+                    colR            <= 0;
+                    elemR           <= 0;
                     dataRowsR       <= data;
+                    if (PACK) begin
+                        pitchR      <= dataColsR + ((filtColsR - dataColsR) & (VECTOR_SIZE - 1));
+                    end else begin
+                        pitchR      <= dataColsR;
+                    end
                     stateR          <= DLOAD;
                 end
+                
+                // One element per bus write, rows start every pitchR elements
                 DLOAD : begin
-                    cntR            <= cntR + 1;
-                    wrDataR[cntR*DATA_WIDTH+:DATA_WIDTH] <= data;
-                    for (i = 0; i < NUM_WORDS; i = i + 1) begin
-                        if ((cntR == (NUM_WORDS - 1)) || dataLast) begin
-                            cntR        <= 0;
-                            if (firstR) begin
-                                firstR  <= 0;
-                            end else begin
-                                addrR   <= addrR + BUS_WE_WIDTH;
-                            end
-                            if (cntR >= i) begin
-                                wrEnR[i*WE_WIDTH+:WE_WIDTH] <= {WE_WIDTH{1'b1}};
-                            end
-                        end
+                    addrR           <= DATA_ADDR + elemR/NUM_WORDS*BUS_WE_WIDTH;
+                    wrDataR[(elemR % NUM_WORDS)*DATA_WIDTH+:DATA_WIDTH] <= data[DATA_WIDTH-1:0];
+                    wrEnR[(elemR % NUM_WORDS)*WE_WIDTH+:WE_WIDTH]       <= {WE_WIDTH{1'b1}};
+                    if (colR == dataColsR - 1) begin
+                        colR        <= 0;
+                        elemR       <= elemR + pitchR - colR;
+                    end else begin
+                        colR        <= colR + 1;
+                        elemR       <= elemR + 1;
                     end
                     if (dataLast) begin
                         dataReadyR  <= 0;
-                        filtReadyR  <= 1;
-                        stateR      <= FCOLS;
+                        startR      <= 1;
+                        stateR      <= IDLE;
                     end
                 end
                 FCOLS : begin
@@ -157,7 +233,7 @@ module cnn_hw_accelerator_tb;
                 end
                 FLOAD : begin
                     cntR            <= cntR + 1;
-                    wrDataR[cntR*DATA_WIDTH+:DATA_WIDTH] <= filt;
+                    wrDataR[cntR*DATA_WIDTH+:DATA_WIDTH] <= filt[DATA_WIDTH-1:0];
                     for (i = 0; i < NUM_WORDS; i = i + 1) begin
                         if ((cntR == (NUM_WORDS - 1)) || filtLast) begin
                             cntR        <= 0;
@@ -173,8 +249,8 @@ module cnn_hw_accelerator_tb;
                     end
                     if (filtLast) begin
                         filtReadyR  <= 0;
-                        startR      <= 1;
-                        stateR      <= IDLE;
+                        dataReadyR  <= 1;
+                        stateR      <= DCOLS;
                     end
                 end
             endcase
@@ -184,27 +260,172 @@ module cnn_hw_accelerator_tb;
     cnn_hw_accelerator #(
         .BUS_ADDR_WIDTH(BUS_ADDR_WIDTH),
         .BUS_DATA_WIDTH(BUS_DATA_WIDTH),
+        .FRAC_WIDTH(FRAC_WIDTH),
+        .EXP_WIDTH(EXP_WIDTH),
         .VECTOR_SIZE(VECTOR_SIZE),
-        .MAX_SIZE(MAX_SIZE)) accel (
+        .MAC_STYLE(MAC_STYLE),
+        .MAX_SIZE(MAX_SIZE),
+        .LINE_BUFFER(LINE_BUFFER),
+        .OUT_DATA_WIDTH(OUT_DATA_WIDTH)) accel (
         .clkIn(clk),
         .rstIn(rst),
         .startIn(startR),
-        .filtRowsIn(filtRowsR),
+        .opTypeIn(OP_TYPE[0]),
+        .strideLog2In(STRIDE_LOG2[1:0]),
+        .padIn(PAD[3:0]),
+        .dilationLog2In(DILATION_LOG2[1:0]),
+        .packIn(PACK[0]),
+        .quantMultIn(QUANT_MULT[31:0]),
+        .quantShiftIn(QUANT_SHIFT[5:0]),
+        .quantZeroIn(QUANT_ZERO[7:0]),
+        .biasEnIn(BIAS_EN[0]),
+        .biasIn(BIAS[31:0]),
+        .actIn(ACT[1:0]),
+        .slopeIn(SLOPE[31:0]),
+        .poolSizeIn(POOL_SIZE[1:0]),
+        .poolAvgIn(POOL_AVG[0]),
+        .filtRowsIn(filtRowsR/CHANNELS),
         .filtColsIn(filtColsR),
-        .dataRowsIn(dataRowsR),
+        .dataRowsIn(dataRowsR/CHANNELS),
         .dataColsIn(dataColsR),
+        .channelsIn(CHANNELS[DIM_WIDTH-1:0]),
+        .dataBaseIn({(DIM_WIDTH-1){1'b0}}),
+        .filtBaseIn({(DIM_WIDTH-1){1'b0}}),
+        .holdBankIn(1'b0),
         .addrIn(addrR),
         .wrEnIn(wrEnR),
         .wrDataIn(wrDataR),
-        .readyIn(1'b1),
+        .readyIn(resReady),
         .validOut(resValid),
-        .dataOut(resData));
+        .dataOut(resData),
+        .keepOut(resKeep),
+        .lastOut(resLast),
+        .countOut(resCount),
+        .perfStartIn(startR),
+        .perfStopIn(perfStopR),
+        .perfClearIn(startR),
+        .perfSelIn(perfSelR),
+        .perfDataOut(perfData));
+    
+    // Take the next word while checking the last lane of this one
+    reg [31:0] readyCntR;
+    
+    always @(posedge clk) begin
+        if (rst || (readyCntR == READY_PERIOD - 1)) begin
+            readyCntR   <= 0;
+        end else begin
+            readyCntR   <= readyCntR + 1;
+        end
+    end
+    
+    assign resReady     = ((pendR >> 1) == 0) && (readyCntR < READY_HIGH);
+    assign checkData    = wordR[FILE_WIDTH-1:0];
+    assign checkValid   = pendR[0];
+    
+    always @(posedge clk) begin
+        if (rst) begin
+            pendR   <= 0;
+        end else if (resValid && resReady) begin
+            wordR   <= resData;
+            pendR   <= resKeep;
+        end else begin
+            wordR   <= wordR >> FILE_WIDTH;
+            pendR   <= pendR >> 1;
+        end
+    end
+    
+    // Performance counters run from startIn to the last output and are
+    // then read back through perfSelIn, one counter per cycle
+    localparam PERF_EVENTS = 8;
+    
+    reg perfStopR;
+    reg perfReadR;
+    reg [2:0] perfSelR;
+    reg [2:0] perfIdxR;
+    reg perfIdxValidR;
+    wire [31:0] perfData;
+    reg [31:0] perfR [0:PERF_EVENTS-1];
+    
+    // Cycles from startIn to the last output and results buffered
+    integer numOutputs, outCnt, cycleCnt, startCycle, endCycle, maxCount;
+    integer fid, n;
+    reg [FILE_WIDTH-1:0] value;
+    initial begin
+        numOutputs = 0;
+        fid = $fopen("output.txt", "r");
+        if (fid != 0) begin
+            while (!$feof(fid)) begin
+                n = $fscanf(fid, "%h\n", value);
+                numOutputs = numOutputs + 1;
+            end
+            $fclose(fid);
+        end
+    end
+    
+    always @(posedge clk) begin
+        if (rst) begin
+            outCnt          <= 0;
+            cycleCnt        <= 0;
+            startCycle      <= 0;
+            endCycle        <= 0;
+            maxCount        = 0;
+            perfStopR       <= 0;
+            perfReadR       <= 0;
+            perfSelR        <= 0;
+            perfIdxR        <= 0;
+            perfIdxValidR   <= 0;
+        end else begin
+            cycleCnt        <= cycleCnt + 1;
+            perfStopR       <= 0;
+            if (startR) begin
+                startCycle  <= cycleCnt;
+            end
+            if (resCount > maxCount) begin
+                maxCount    = resCount;
+            end
+            if (checkValid) begin
+                outCnt      <= outCnt + 1;
+                if (outCnt + 1 == numOutputs) begin
+                    endCycle    <= cycleCnt;
+                    perfStopR   <= 1;
+                    perfReadR   <= 1;
+                    perfSelR    <= 0;
+                end
+            end
+            
+            // perfDataOut follows perfSelIn one cycle later
+            if (perfReadR) begin
+                perfSelR    <= perfSelR + 1;
+                if (perfSelR == PERF_EVENTS - 1) begin
+                    perfReadR   <= 0;
+                end
+            end
+            perfIdxR        <= perfSelR;
+            perfIdxValidR   <= perfReadR;
+            if (perfIdxValidR) begin
+                perfR[perfIdxR] = perfData;
+                if (perfIdxR == PERF_EVENTS - 1) begin
+                    $display("%0d outputs in %0d cycles", numOutputs, endCycle - startCycle);
+                    $display("Busy cycles:      %0d", perfR[0]);
+                    $display("Throttle stalls:  %0d cycles", perfR[1]);
+                    $display("Data RAM reads:   %0d (%0.2f per output)", perfR[3], (1.0*perfR[3])/numOutputs);
+                    $display("Filter RAM reads: %0d (%0.2f per output)", perfR[4], (1.0*perfR[4])/numOutputs);
+                    $display("MAC beats:        %0d (%0.2f per output, %0.1f%% lane utilization, %0d lanes masked)",
+                        perfR[5], (1.0*perfR[5])/numOutputs, 100.0 - (100.0*perfR[2])/(perfR[5]*VECTOR_SIZE), perfR[2]);
+                    $display("Results written:  %0d", perfR[6]);
+                    $display("Output stalls:    %0d cycles with readyIn low", perfR[7]);
+                    $display("Results buffered: %0d at most, %0d per dataOut word", maxCount, OUT_LANES);
+                end
+            end
+        end
+    end
     
-    file_checker check (
+    file_checker #(
+        .EXACT_MATCH(MAC_STYLE == "INT8")) check (
         .clkIn(clk),
         .rstIn(rst),
-        .validIn(resValid),
-        .dataIn(resData),
+        .validIn(checkValid),
+        .dataIn(checkData),
         .errorOut(error));
         
 endmodule
\ No newline at end of file
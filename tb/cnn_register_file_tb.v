@@ -0,0 +1,469 @@
+`timescale 1ns/1ns
+
+module cnn_register_file_tb;
+
+    parameter CLK_PERIOD     = 10;
+    parameter RESET_TIME     = 100;
+
+    // RISCV bus interface
+    parameter BUS_ADDR_WIDTH = 32;
+    parameter BUS_DATA_WIDTH = 64;
+
+    // Hardware accelerator overrides
+    parameter VECTOR_SIZE    = 8;
+    parameter DATA_WIDTH     = 32;
+    parameter MAX_SIZE       = 4096; // < Max Rows > * < Max Cols >
+
+    // Operation type (0 = 2D convolution, 1 = matrix multiply)
+    parameter OP_TYPE        = 0;
+
+    // Convolution stride and dilation (log2) and zero padding
+    parameter STRIDE_LOG2    = 0;
+    parameter PAD            = 0;
+    parameter DILATION_LOG2  = 0;
+
+    // Maximum number of outputs per job
+    parameter MAX_OUTPUTS    = 65536;
+
+    // Bus-functional model of the host: every access goes through the
+    // register file the way models/cnn_driver.c does. Two jobs run back to
+    // back, the second is loaded while the first computes and is submitted
+    // (and refused while busy) while the first is polled.
+
+    // Accelerator address map (see cnn_register_file.v)
+    localparam FILT_ADDR     = 1 << ($clog2(MAX_SIZE) + 2);
+    localparam REG_ADDR      = 2*FILT_ADDR;
+
+    // Register offsets
+    localparam REG_CONTROL   = 32'h00;
+    localparam REG_STATUS    = 32'h04;
+    localparam REG_IRQ_EN    = 32'h08;
+    localparam REG_OP        = 32'h0C;
+    localparam REG_FILT_DIMS = 32'h10;
+    localparam REG_DATA_DIMS = 32'h14;
+    localparam REG_RESULT    = 32'h2C;
+    localparam REG_PERF_CTRL = 32'h30;
+    localparam REG_PERF_SEL  = 32'h34;
+    localparam REG_PERF_DATA = 32'h38;
+    localparam REG_ERROR     = 32'h3C;
+    localparam REG_CHANNELS  = 32'h44;
+
+    localparam BUS_WE_WIDTH  = BUS_DATA_WIDTH/8;
+    localparam DIM_WIDTH     = $clog2(MAX_SIZE) + 1;
+    localparam COUNT_WIDTH   = $clog2(512) + 1;
+
+    wire clk;
+    wire rst;
+
+    // Job operands and expected outputs read from data.txt, filt.txt and output.txt
+    reg [DATA_WIDTH-1:0] dataMem [0:MAX_SIZE-1];
+    reg [DATA_WIDTH-1:0] filtMem [0:MAX_SIZE-1];
+    reg [DATA_WIDTH-1:0] outMem  [0:MAX_OUTPUTS-1];
+
+    reg [DIM_WIDTH-1:0] dataCols, dataRows, filtCols, filtRows;
+    integer numOutputs;
+
+    // Host bus
+    reg [BUS_ADDR_WIDTH-1:0] addrR;
+    reg [  BUS_WE_WIDTH-1:0] wrEnR;
+    reg [BUS_DATA_WIDTH-1:0] wrDataR;
+    reg rdEnR;
+    wire [BUS_DATA_WIDTH-1:0] rdData;
+    wire rdValid;
+    wire irq;
+
+    // Accelerator interface
+    wire accStart, accOpType, accPack, accBusy, accQueueFull, accValid, accReady, accLast, accHoldBank;
+    wire accBiasEn, accPoolAvg;
+    wire [DIM_WIDTH-1:0] accFiltRows, accFiltCols, accDataRows, accDataCols, accChannels;
+    wire [DIM_WIDTH-2:0] accDataBase, accFiltBase;
+    wire [1:0] accStrideLog2, accDilationLog2, accAct, accPoolSize;
+    wire [3:0] accPad;
+    wire [DATA_WIDTH-1:0] accQuantMult, accBias, accSlope;
+    wire [5:0] accQuantShift;
+    wire [7:0] accQuantZero;
+    wire [BUS_ADDR_WIDTH-1:0] accAddr;
+    wire [  BUS_WE_WIDTH-1:0] accWrEn;
+    wire [BUS_DATA_WIDTH-1:0] accWrData;
+    wire [DATA_WIDTH-1:0] accData;
+    wire [COUNT_WIDTH-1:0] accCount;
+    wire accPerfStart, accPerfStop, accPerfClear;
+    wire [2:0] accPerfSel;
+    wire [31:0] accPerfData;
+
+    clk_gen #(.CLK_PERIOD(CLK_PERIOD)) clk_gen_i (.clkOut(clk));
+    rst_gen #(.RESET_TIME(RESET_TIME)) rst_gen_i (.rstOut(rst));
+
+    cnn_register_file #(
+        .BUS_ADDR_WIDTH(BUS_ADDR_WIDTH),
+        .BUS_DATA_WIDTH(BUS_DATA_WIDTH),
+        .MAX_SIZE(MAX_SIZE),
+        .DATA_WIDTH(DATA_WIDTH),
+        .VECTOR_SIZE(VECTOR_SIZE),
+        .COUNT_WIDTH(COUNT_WIDTH)) regs (
+        .clkIn(clk),
+        .rstIn(rst),
+        .addrIn(addrR),
+        .wrEnIn(wrEnR),
+        .wrDataIn(wrDataR),
+        .rdEnIn(rdEnR),
+        .rdDataOut(rdData),
+        .rdValidOut(rdValid),
+        .irqOut(irq),
+        .accStartOut(accStart),
+        .accOpTypeOut(accOpType),
+        .accStrideLog2Out(accStrideLog2),
+        .accPadOut(accPad),
+        .accDilationLog2Out(accDilationLog2),
+        .accPackOut(accPack),
+        .accQuantMultOut(accQuantMult),
+        .accQuantShiftOut(accQuantShift),
+        .accQuantZeroOut(accQuantZero),
+        .accBiasEnOut(accBiasEn),
+        .accBiasOut(accBias),
+        .accActOut(accAct),
+        .accSlopeOut(accSlope),
+        .accPoolSizeOut(accPoolSize),
+        .accPoolAvgOut(accPoolAvg),
+        .accFiltRowsOut(accFiltRows),
+        .accFiltColsOut(accFiltCols),
+        .accDataRowsOut(accDataRows),
+        .accDataColsOut(accDataCols),
+        .accChannelsOut(accChannels),
+        .accDataBaseOut(accDataBase),
+        .accFiltBaseOut(accFiltBase),
+        .accHoldBankOut(accHoldBank),
+        .accAddrOut(accAddr),
+        .accWrEnOut(accWrEn),
+        .accWrDataOut(accWrData),
+        .accBusyIn(accBusy),
+        .accQueueFullIn(accQueueFull),
+        .accValidIn(accValid),
+        .accDataIn(accData),
+        .accLastIn(accLast),
+        .accCountIn(accCount),
+        .accReadyOut(accReady),
+        .accPerfStartOut(accPerfStart),
+        .accPerfStopOut(accPerfStop),
+        .accPerfClearOut(accPerfClear),
+        .accPerfSelOut(accPerfSel),
+        .accPerfDataIn(accPerfData));
+
+    cnn_hw_accelerator #(
+        .BUS_ADDR_WIDTH(BUS_ADDR_WIDTH),
+        .BUS_DATA_WIDTH(BUS_DATA_WIDTH),
+        .VECTOR_SIZE(VECTOR_SIZE),
+        .MAX_SIZE(MAX_SIZE)) accel (
+        .clkIn(clk),
+        .rstIn(rst),
+        .startIn(accStart),
+        .opTypeIn(accOpType),
+        .strideLog2In(accStrideLog2),
+        .padIn(accPad),
+        .dilationLog2In(accDilationLog2),
+        .packIn(accPack),
+        .quantMultIn(accQuantMult),
+        .quantShiftIn(accQuantShift),
+        .quantZeroIn(accQuantZero),
+        .biasEnIn(accBiasEn),
+        .biasIn(accBias),
+        .actIn(accAct),
+        .slopeIn(accSlope),
+        .poolSizeIn(accPoolSize),
+        .poolAvgIn(accPoolAvg),
+        .filtRowsIn(accFiltRows),
+        .filtColsIn(accFiltCols),
+        .dataRowsIn(accDataRows),
+        .dataColsIn(accDataCols),
+        .channelsIn(accChannels),
+        .dataBaseIn(accDataBase),
+        .filtBaseIn(accFiltBase),
+        .holdBankIn(accHoldBank),
+        .addrIn(accAddr),
+        .wrEnIn(accWrEn),
+        .wrDataIn(accWrData),
+        .readyIn(accReady),
+        .busyOut(accBusy),
+        .queueFullOut(accQueueFull),
+        .validOut(accValid),
+        .dataOut(accData),
+        .keepOut(),
+        .lastOut(accLast),
+        .countOut(accCount),
+        .perfStartIn(accPerfStart),
+        .perfStopIn(accPerfStop),
+        .perfClearIn(accPerfClear),
+        .perfSelIn(accPerfSel),
+        .perfDataOut(accPerfData));
+
+    integer n, fid, errCnt, busyRetries, cycleCnt, startCycle;
+    integer readA, readB;
+    reg [31:0] value;
+    reg [31:0] errors;
+
+    // Read one matrix file (columns, rows, then elements)
+    task read_matrix;
+        input isFilt;
+        input [8*16-1:0] fileName;
+        output [DIM_WIDTH-1:0] cols;
+        output [DIM_WIDTH-1:0] rows;
+        integer fid, n, idx;
+        reg [DATA_WIDTH-1:0] value;
+        begin
+            fid = $fopen(fileName, "r");
+            if (fid == 0) begin
+                $display("Could not open \"%0s\"", fileName);
+                $finish;
+            end
+            n = $fscanf(fid, "%h\n", value);
+            cols = value;
+            n = $fscanf(fid, "%h\n", value);
+            rows = value;
+            idx = 0;
+            while (!$feof(fid)) begin
+                n = $fscanf(fid, "%h\n", value);
+                if (isFilt) begin
+                    filtMem[idx] = value;
+                end else begin
+                    dataMem[idx] = value;
+                end
+                idx = idx + 1;
+            end
+            $fclose(fid);
+        end
+    endtask
+
+    // 32-bit bus write, one cycle
+    task bus_write;
+        input [BUS_ADDR_WIDTH-1:0] addr;
+        input [31:0] value;
+        begin
+            @(posedge clk);
+            addrR   <= addr;
+            wrEnR   <= addr[2] ? {{(BUS_WE_WIDTH/2){1'b1}}, {(BUS_WE_WIDTH/2){1'b0}}} : {(BUS_WE_WIDTH/2){1'b1}};
+            wrDataR <= {(BUS_DATA_WIDTH/32){value}};
+            @(posedge clk);
+            wrEnR   <= 0;
+        end
+    endtask
+
+    // 32-bit bus read, returns once rdValidOut is seen
+    task bus_read;
+        input [BUS_ADDR_WIDTH-1:0] addr;
+        output [31:0] value;
+        begin
+            @(posedge clk);
+            addrR   <= addr;
+            rdEnR   <= 1;
+            @(posedge clk);
+            rdEnR   <= 0;
+            @(posedge clk);
+            while (!rdValid) begin
+                @(posedge clk);
+            end
+            value   = rdData[31:0];
+        end
+    endtask
+
+    // Load the operands of a job into the load bank
+    task load_job;
+        integer idx;
+        begin
+            for (idx = 0; idx < filtRows*filtCols; idx = idx + 1) begin
+                bus_write(FILT_ADDR + 4*idx, filtMem[idx]);
+            end
+            for (idx = 0; idx < dataRows*dataCols; idx = idx + 1) begin
+                bus_write(4*idx, dataMem[idx]);
+            end
+        end
+    endtask
+
+    // Start a job, returns the ERROR register
+    task submit_job;
+        output [31:0] errors;
+        begin
+            bus_write(REG_ADDR + REG_OP, {22'd0, DILATION_LOG2[1:0], PAD[3:0], STRIDE_LOG2[1:0], 1'b0, OP_TYPE[0]});
+            bus_write(REG_ADDR + REG_FILT_DIMS, {{(16-DIM_WIDTH){1'b0}}, filtCols, {(16-DIM_WIDTH){1'b0}}, filtRows});
+            bus_write(REG_ADDR + REG_DATA_DIMS, {{(16-DIM_WIDTH){1'b0}}, dataCols, {(16-DIM_WIDTH){1'b0}}, dataRows});
+            bus_write(REG_ADDR + REG_CONTROL, 1);
+            bus_read(REG_ADDR + REG_ERROR, errors);
+            if (errors != 0) begin
+                bus_write(REG_ADDR + REG_ERROR, errors);
+            end
+        end
+    endtask
+
+    // Start a job that must be refused for its dimensions, without
+    // starting anything
+    task refuse_job;
+        input [31:0] op;
+        input [31:0] filtDims;
+        input [31:0] dataDims;
+        input [31:0] channels;
+        input [8*24-1:0] name;
+        reg [31:0] errors;
+        reg [31:0] status;
+        begin
+            bus_write(REG_ADDR + REG_OP, op);
+            bus_write(REG_ADDR + REG_FILT_DIMS, filtDims);
+            bus_write(REG_ADDR + REG_DATA_DIMS, dataDims);
+            bus_write(REG_ADDR + REG_CHANNELS, channels);
+            bus_write(REG_ADDR + REG_CONTROL, 1);
+            bus_read(REG_ADDR + REG_ERROR, errors);
+            bus_read(REG_ADDR + REG_STATUS, status);
+            if ((errors != 2) || status[0] || (status[7:4] != 0)) begin
+                errCnt = errCnt + 1;
+                $error("%0s job not refused: ERROR = 0x%08H, STATUS = 0x%08H", name, errors, status);
+            end
+            bus_write(REG_ADDR + REG_ERROR, errors);
+            bus_write(REG_ADDR + REG_CHANNELS, 0);
+        end
+    endtask
+
+    // Read the results buffered so far, as cnn_poll does
+    task poll_job;
+        input integer job;
+        inout integer numRead;
+        integer k;
+        reg [31:0] status;
+        reg [31:0] value;
+        begin
+            bus_read(REG_ADDR + REG_STATUS, status);
+            for (k = 0; (k < status[31:16]) && (numRead < numOutputs); k = k + 1) begin
+                bus_read(REG_ADDR + REG_RESULT, value);
+                if (value !== outMem[numRead]) begin
+                    errCnt = errCnt + 1;
+                    $error("Job %0d output %0d: Meas = 0x%08H, Ref=0x%08H", job, numRead, value, outMem[numRead]);
+                end
+                numRead = numRead + 1;
+            end
+        end
+    endtask
+
+    always @(posedge clk) begin
+        if (rst) begin
+            cycleCnt    <= 0;
+        end else begin
+            cycleCnt    <= cycleCnt + 1;
+        end
+    end
+
+    initial begin
+        addrR   = 0;
+        wrEnR   = 0;
+        wrDataR = 0;
+        rdEnR   = 0;
+        errCnt  = 0;
+
+        read_matrix(0, "data.txt", dataCols, dataRows);
+        read_matrix(1, "filt.txt", filtCols, filtRows);
+
+        fid = $fopen("output.txt", "r");
+        if (fid == 0) begin
+            $display("Could not open \"output.txt\"");
+            $finish;
+        end
+        numOutputs = 0;
+        while (!$feof(fid)) begin
+            n = $fscanf(fid, "%h\n", value);
+            outMem[numOutputs] = value;
+            numOutputs = numOutputs + 1;
+        end
+        $fclose(fid);
+
+        @(negedge rst);
+
+        // Dimensions outside 1..MAX_SIZE are refused
+        bus_write(REG_ADDR + REG_CONTROL, 1);
+        bus_read(REG_ADDR + REG_ERROR, errors);
+        if (errors != 2) begin
+            errCnt = errCnt + 1;
+            $error("Empty job not refused: ERROR = 0x%08H", errors);
+        end
+        bus_write(REG_ADDR + REG_ERROR, errors);
+
+        // Stacks whose size wraps in 32 bits (4 x 32768 x 32768), and
+        // filters larger than the padded data, plain and dilated
+        refuse_job(0, {16'h8000, 16'h8000}, {16'h8000, 16'h8000}, 4, "Oversized");
+        refuse_job(0, {16'd5, 16'd5}, {16'd4, 16'd4}, 1, "Inverted");
+        refuse_job({22'd0, 2'd1, 4'd0, 4'd0}, {16'd3, 16'd3}, {16'd4, 16'd4}, 1, "Inverted dilated");
+        refuse_job({22'd0, 2'd0, 4'd1, 4'd0}, {16'd3, 16'd8}, {16'd5, 16'd5}, 1, "Inverted padded");
+
+        // First job, counted by the performance counters
+        bus_write(REG_ADDR + REG_IRQ_EN, 1);
+        bus_write(REG_ADDR + REG_PERF_CTRL, 5);
+        load_job;
+        startCycle = cycleCnt;
+        submit_job(errors);
+        if (errors != 0) begin
+            errCnt = errCnt + 1;
+            $error("First job refused: ERROR = 0x%08H", errors);
+        end
+
+        // Second job, loaded while the first computes
+        load_job;
+        readA       = 0;
+        busyRetries = 0;
+        submit_job(errors);
+        while (errors == 1) begin
+            busyRetries = busyRetries + 1;
+            poll_job(0, readA);
+            submit_job(errors);
+        end
+        if (errors != 0) begin
+            errCnt = errCnt + 1;
+            $error("Second job refused: ERROR = 0x%08H", errors);
+        end
+        while (readA < numOutputs) begin
+            poll_job(0, readA);
+        end
+        bus_write(REG_ADDR + REG_PERF_CTRL, 2);
+        $display("First job: %0d outputs in %0d cycles, second start refused %0d times while busy",
+            numOutputs, cycleCnt - startCycle, busyRetries);
+
+        // Done interrupt of the first job
+        bus_read(REG_ADDR + REG_STATUS, value);
+        if (!value[1] || !irq) begin
+            errCnt = errCnt + 1;
+            $error("Done not raised: STATUS = 0x%08H, irq = %0d", value, irq);
+        end
+        bus_write(REG_ADDR + REG_STATUS, 2);
+        @(posedge clk);
+        @(posedge clk);
+        if (irq) begin
+            errCnt = errCnt + 1;
+            $error("Interrupt not cleared with done");
+        end
+
+        // Results counted while the first job ran
+        bus_write(REG_ADDR + REG_PERF_SEL, 6);
+        bus_read(REG_ADDR + REG_PERF_DATA, value);
+        $display("Results written while counting: %0d", value);
+
+        readB = 0;
+        while (readB < numOutputs) begin
+            poll_job(1, readB);
+        end
+        bus_read(REG_ADDR + REG_STATUS, value);
+        if (value[7:4] != 0) begin
+            errCnt = errCnt + 1;
+            $error("Jobs left after the last result: STATUS = 0x%08H", value);
+        end
+
+        // A read from an empty FIFO is flagged
+        bus_read(REG_ADDR + REG_RESULT, value);
+        bus_read(REG_ADDR + REG_ERROR, errors);
+        if (errors != 4) begin
+            errCnt = errCnt + 1;
+            $error("Empty read not flagged: ERROR = 0x%08H", errors);
+        end
+
+        if (errCnt != 0) begin
+            $display("FAILED: %0d mismatches", errCnt);
+        end else begin
+            $display("PASSED");
+        end
+        $finish;
+    end
+
+endmodule
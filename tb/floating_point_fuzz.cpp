@@ -0,0 +1,557 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "floating_point_unit_sim.h"
+#include "sim_harness.h"
+
+// Differential fuzzing of src/floating_point_add.v (default) or
+// src/floating_point_multiply.v (-DFP_UNIT_MULTIPLY) against floating_point.c
+//
+// Worker processes each drive their own verilated unit with batches of
+// random operand pairs, one pair per cycle, and compare every result
+// bit-for-bit with the C model. Operands are biased towards the cases
+// uniform bit patterns rarely reach: zeros, subnormals, the smallest and
+// largest exponents, Inf and NaN, mantissas that carry into the exponent
+// when rounded and round-to-even ties. Pairs are biased towards each other:
+// near-cancelling sums, exponent differences around the alignment shift
+// width, and products at the subnormal and overflow boundaries.
+//
+// Each worker shrinks its failing pairs by clearing operand bits while the
+// mismatch persists, so the reported cases are as small as possible. With
+// --out-dir the minimized pairs are also written as input_a.txt,
+// input_b.txt and output.txt (C model results) for replay in
+// tb/floating_point_add_tb.v or tb/floating_point_multiply_tb.v.
+//
+// The RTL and the C model share their design, so a defect of both is not a
+// mismatch. --ieee also compares the C model with the IEEE-754 arithmetic
+// of the host (round to nearest even, any NaN matching any NaN) and lists
+// the minimized deviations separately, without failing the run.
+//
+// Build from the repository root with (one command):
+//   verilator --cc --exe --build -O3 -Wno-fatal -Isrc --top-module floating_point_add
+//     src/floating_point_add.v tb/floating_point_fuzz.cpp models/floating_point.c
+//     -CFLAGS "-std=c++17 -I../models -I../tb" -o floating_point_add_fuzz
+// and for the multiplier --top-module floating_point_multiply,
+// src/floating_point_multiply.v, -CFLAGS "... -DFP_UNIT_MULTIPLY" and
+// -o floating_point_multiply_fuzz.
+
+// Pairs per batch streamed through the unit
+constexpr std::size_t BATCH_SIZE   = 65536;
+
+// Failing pairs minimized and reported per worker
+constexpr uint32_t MAX_CASES       = 16;
+
+// Kinds of operand pairs
+enum PairKind
+{
+    PAIR_RANDOM,
+    PAIR_SPECIAL,
+    PAIR_CANCEL,
+    PAIR_ALIGN,
+    PAIR_UNDERFLOW,
+    PAIR_OVERFLOW,
+    NUM_PAIR_KINDS
+};
+
+static const char *const pair_names[NUM_PAIR_KINDS] = {
+    "random",
+    "special",
+    "cancel",
+    "align",
+    "underflow",
+    "overflow"
+};
+
+// Failing pair as found and after minimization
+struct FuzzCase
+{
+    uint32_t a;
+    uint32_t b;
+    uint32_t minA;
+    uint32_t minB;
+    uint32_t measured;
+    uint32_t kind;
+};
+
+// Totals of one worker, followed by its cases on the pipe
+struct WorkerReport
+{
+    uint64_t vectors;
+    uint64_t cycles;
+    uint64_t errors;
+    uint64_t errorsByKind[NUM_PAIR_KINDS];
+    uint64_t ieeeErrors;
+    uint32_t numCases;
+    uint32_t numIeeeCases;
+};
+
+static void usage(const char *name)
+{
+    std::printf("Usage: %s [options]\n", name);
+    std::printf("  --vectors N     pairs to test over all workers, 0 for no limit (default 16777216)\n");
+    std::printf("  --seconds N     stop after N seconds, 0 for no limit (default 0)\n");
+    std::printf("  --workers N     worker processes, 0 for all cores (default 0)\n");
+    std::printf("  --seed N        random seed (default 0)\n");
+    std::printf("  --out-dir PATH  write the minimized failing pairs as replay vectors\n");
+    std::printf("  --ieee          also compare the C model with host IEEE-754 arithmetic\n");
+}
+
+// Biased operand pairs
+class PairGenerator
+{
+public:
+    PairGenerator(unsigned seed, unsigned worker)
+    {
+        std::seed_seq seq = {seed, worker};
+        gen_.seed(seq);
+    }
+
+    PairKind pair(uint32_t &a, uint32_t &b)
+    {
+        PairKind kind = (PairKind) uniform(NUM_PAIR_KINDS);
+        a = operand();
+        switch (kind)
+        {
+            case PAIR_RANDOM:
+                a = (uint32_t) gen_();
+                b = (uint32_t) gen_();
+                break;
+
+            // Both operands from the biased classes
+            case PAIR_SPECIAL:
+                b = operand();
+                break;
+
+            // Opposite sign, equal or nearly equal magnitude
+            case PAIR_CANCEL:
+                b = (a ^ 0x80000000u) + (uint32_t) (uniform(9) - 4);
+                break;
+
+            // Exponent difference around the alignment shift width
+            case PAIR_ALIGN:
+                b = with_exponent(operand(), exponent(a) + uniform(61) - 30);
+                break;
+
+            // Product exponent around the smallest normal
+            case PAIR_UNDERFLOW:
+                b = with_exponent(operand(), 127 - exponent(a) + uniform(51) - 25);
+                break;
+
+            // Product exponent around the largest normal
+            default:
+                b = with_exponent(operand(), 381 - exponent(a) + uniform(9) - 4);
+                break;
+        }
+        if (uniform(2))
+        {
+            std::swap(a, b);
+        }
+        return kind;
+    }
+
+private:
+    std::mt19937_64 gen_;
+
+    int uniform(int n) { return (int) (gen_() % (uint64_t) n); }
+
+    static int exponent(uint32_t x) { return (int) ((x >> 23) & 0xFF); }
+
+    static uint32_t with_exponent(uint32_t x, int exp)
+    {
+        exp = (exp < 0) ? 0 : (exp > 255) ? 255 : exp;
+        return (x & 0x807FFFFFu) | ((uint32_t) exp << 23);
+    }
+
+    // Mantissa with few set bits, all ones, or a round-to-even tie in its
+    // low bits
+    uint32_t mantissa()
+    {
+        uint32_t m = (uint32_t) gen_() & 0x7FFFFF;
+        switch (uniform(6))
+        {
+            case 0: return 0;
+            case 1: return 0x7FFFFF - (uint32_t) uniform(4);
+            case 2: return m | 0x7FFF00;
+            case 3: return (m & ~0xFFu) | 0x80;
+            case 4: return 1u << uniform(23);
+            default: return m;
+        }
+    }
+
+    uint32_t operand()
+    {
+        uint32_t sign = (uint32_t) uniform(2) << 31;
+        int exp;
+        switch (uniform(8))
+        {
+            case 0: return sign;
+            case 1: exp = 0; break;
+            case 2: exp = 1 + uniform(2); break;
+            case 3: exp = 253 + uniform(2); break;
+            case 4: return sign | 0x7F800000u;
+            case 5: return sign | 0x7F800000u | ((uint32_t) (gen_() % 0x7FFFFF) + 1);
+            case 6: exp = 120 + uniform(16); break;
+            default: exp = 1 + uniform(254); break;
+        }
+        return sign | ((uint32_t) exp << 23) | mantissa();
+    }
+};
+
+// Result of the host floating-point unit
+static uint32_t ieee_model(uint32_t a, uint32_t b)
+{
+    float fa, fb, fr;
+    std::memcpy(&fa, &a, sizeof(float));
+    std::memcpy(&fb, &b, sizeof(float));
+#ifdef FP_UNIT_MULTIPLY
+    fr = fa * fb;
+#else
+    fr = fa + fb;
+#endif
+    uint32_t r;
+    std::memcpy(&r, &fr, sizeof(float));
+    return r;
+}
+
+// Whether the C model deviates from IEEE-754, NaN payloads aside
+static bool ieee_mismatch(uint32_t a, uint32_t b)
+{
+    uint32_t model = unit_model(a, b);
+    uint32_t ieee = ieee_model(a, b);
+    bool modelNaN = ((model & 0x7F800000u) == 0x7F800000u) && (model & 0x7FFFFF);
+    bool ieeeNaN = ((ieee & 0x7F800000u) == 0x7F800000u) && (ieee & 0x7FFFFF);
+    return (modelNaN || ieeeNaN) ? (modelNaN != ieeeNaN) : (model != ieee);
+}
+
+// Clear operand bits while fails(a, b) holds, highest bits first so signs
+// and exponents simplify before mantissas
+template <typename Fails>
+static void minimize(uint32_t &a, uint32_t &b, Fails fails)
+{
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (int bit = 31; bit >= 0; --bit)
+        {
+            uint32_t mask = 1u << bit;
+            if ((a & mask) && fails(a & ~mask, b))
+            {
+                a &= ~mask;
+                changed = true;
+            }
+            if ((b & mask) && fails(a, b & ~mask))
+            {
+                b &= ~mask;
+                changed = true;
+            }
+        }
+    }
+}
+
+// Fuzz until the vector or time budget runs out, then report on fd
+static void run_worker(unsigned seed, unsigned worker, uint64_t maxVectors, double maxSeconds, bool ieee, int fd)
+{
+    auto start = std::chrono::steady_clock::now();
+    PairGenerator generator(seed, worker);
+    UnitSim sim;
+    WorkerReport report = {};
+    std::vector<FuzzCase> cases, ieeeCases;
+    std::vector<uint32_t> a(BATCH_SIZE), b(BATCH_SIZE), kinds(BATCH_SIZE);
+
+    while (((maxVectors == 0) || (report.vectors < maxVectors)) &&
+        ((maxSeconds <= 0) || (sim_harness::seconds_since(start) < maxSeconds)))
+    {
+        std::size_t n = BATCH_SIZE;
+        if ((maxVectors != 0) && (maxVectors - report.vectors < n))
+        {
+            n = (std::size_t) (maxVectors - report.vectors);
+        }
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            kinds[i] = generator.pair(a[i], b[i]);
+        }
+        StreamResult result;
+        sim.run(a.data(), b.data(), n, result, [&](std::size_t i, uint32_t measured, uint32_t)
+        {
+            ++report.errorsByKind[kinds[i]];
+            if (cases.size() < MAX_CASES)
+            {
+                cases.push_back({a[i], b[i], a[i], b[i], measured, kinds[i]});
+            }
+        });
+        for (std::size_t i = 0; ieee && (i < n); ++i)
+        {
+            if (ieee_mismatch(a[i], b[i]))
+            {
+                ++report.ieeeErrors;
+                if (ieeeCases.size() < MAX_CASES)
+                {
+                    ieeeCases.push_back({a[i], b[i], a[i], b[i], unit_model(a[i], b[i]), kinds[i]});
+                }
+            }
+        }
+        report.vectors += n;
+        report.cycles  += result.cycles;
+        report.errors  += result.errors;
+        if (result.timeout)
+        {
+            std::printf("Worker %u: no result from %s\n", worker, UNIT_NAME);
+            break;
+        }
+    }
+
+    for (FuzzCase &c : cases)
+    {
+        minimize(c.minA, c.minB, [&](uint32_t x, uint32_t y) { return sim.mismatch(x, y); });
+        sim.mismatch(c.minA, c.minB, &c.measured);
+    }
+    for (FuzzCase &c : ieeeCases)
+    {
+        minimize(c.minA, c.minB, ieee_mismatch);
+        c.measured = unit_model(c.minA, c.minB);
+    }
+    report.numCases = (uint32_t) cases.size();
+    report.numIeeeCases = (uint32_t) ieeeCases.size();
+    cases.insert(cases.end(), ieeeCases.begin(), ieeeCases.end());
+    if ((write(fd, &report, sizeof(report)) != (ssize_t) sizeof(report)) || (!cases.empty() &&
+        (write(fd, cases.data(), cases.size()*sizeof(FuzzCase)) != (ssize_t) (cases.size()*sizeof(FuzzCase)))))
+    {
+        std::printf("Worker %u: could not report\n", worker);
+    }
+}
+
+// Read exactly size bytes unless the worker died
+static bool read_all(int fd, void *data, std::size_t size)
+{
+    char *ptr = static_cast<char *>(data);
+    while (size > 0)
+    {
+        ssize_t n = read(fd, ptr, size);
+        if (n <= 0)
+        {
+            return false;
+        }
+        ptr  += n;
+        size -= (std::size_t) n;
+    }
+    return true;
+}
+
+static bool write_replay(const std::string &dir, const std::vector<std::pair<uint32_t, uint32_t>> &pairs)
+{
+    FILE *fa = std::fopen((dir + "/input_a.txt").c_str(), "w");
+    FILE *fb = std::fopen((dir + "/input_b.txt").c_str(), "w");
+    FILE *fo = std::fopen((dir + "/output.txt").c_str(), "w");
+    bool ok = fa && fb && fo;
+    for (std::size_t i = 0; ok && (i < pairs.size()); ++i)
+    {
+        std::fprintf(fa, "%08X\n", pairs[i].first);
+        std::fprintf(fb, "%08X\n", pairs[i].second);
+        std::fprintf(fo, "%08X\n", unit_model(pairs[i].first, pairs[i].second));
+    }
+    if (fa) std::fclose(fa);
+    if (fb) std::fclose(fb);
+    if (fo) std::fclose(fo);
+    if (!ok)
+    {
+        std::printf("Could not write replay vectors to \"%s\"\n", dir.c_str());
+    }
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t maxVectors = 16777216;
+    double maxSeconds = 0;
+    int numWorkers = 0;
+    unsigned seed = 0;
+    std::string outDir;
+    bool ieee = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--ieee")
+        {
+            ieee = true;
+        }
+        else if ((arg == "--out-dir") && hasValue)
+        {
+            outDir = argv[++i];
+        }
+        else if ((arg == "--seconds") && hasValue)
+        {
+            maxSeconds = std::strtod(argv[++i], nullptr);
+        }
+        else if (hasValue && (arg == "--vectors" || arg == "--workers" || arg == "--seed"))
+        {
+            unsigned long long value = std::strtoull(argv[++i], nullptr, 0);
+            if (arg == "--vectors") maxVectors = value;
+            if (arg == "--workers") numWorkers = (int) value;
+            if (arg == "--seed")    seed = (unsigned) value;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (numWorkers <= 0)
+    {
+        numWorkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (numWorkers <= 0)
+    {
+        numWorkers = 1;
+    }
+    if ((maxVectors == 0) && (maxSeconds <= 0))
+    {
+        std::printf("Set --vectors or --seconds\n");
+        return 1;
+    }
+
+    // Vectors are split evenly, the first workers take the remainder
+    auto start = std::chrono::steady_clock::now();
+    std::vector<pid_t> pids(numWorkers);
+    std::vector<int> fds(numWorkers);
+    std::fflush(stdout);
+    for (int w = 0; w < numWorkers; ++w)
+    {
+        int pipeFds[2];
+        if (pipe(pipeFds) != 0)
+        {
+            std::printf("Could not create a pipe\n");
+            return 1;
+        }
+        uint64_t share = (maxVectors == 0) ? 0 : maxVectors/numWorkers + ((uint64_t) w < maxVectors % numWorkers);
+        pids[w] = fork();
+        if (pids[w] == 0)
+        {
+            close(pipeFds[0]);
+            if ((maxVectors == 0) || (share > 0))
+            {
+                run_worker(seed, (unsigned) w, share, maxSeconds, ieee, pipeFds[1]);
+            }
+            else
+            {
+                WorkerReport report = {};
+                ssize_t n = write(pipeFds[1], &report, sizeof(report));
+                (void) n;
+            }
+            std::fflush(stdout);
+            _exit(0);
+        }
+        close(pipeFds[1]);
+        if (pids[w] < 0)
+        {
+            std::printf("Could not start worker %d\n", w);
+            return 1;
+        }
+        fds[w] = pipeFds[0];
+    }
+
+    // Collect the reports, minimized pairs are deduplicated
+    WorkerReport total = {};
+    std::vector<FuzzCase> cases, ieeeCases;
+    std::set<std::pair<uint32_t, uint32_t>> seen;
+    std::vector<std::pair<uint32_t, uint32_t>> replay;
+    int lost = 0;
+    for (int w = 0; w < numWorkers; ++w)
+    {
+        WorkerReport report;
+        bool ok = read_all(fds[w], &report, sizeof(report));
+        std::vector<FuzzCase> workerCases(ok ? report.numCases + report.numIeeeCases : 0);
+        ok = ok && (workerCases.empty() || read_all(fds[w], workerCases.data(), workerCases.size()*sizeof(FuzzCase)));
+        close(fds[w]);
+        int status = 0;
+        waitpid(pids[w], &status, 0);
+        if (!ok || !WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+        {
+            ++lost;
+            continue;
+        }
+        total.vectors += report.vectors;
+        total.cycles  += report.cycles;
+        total.errors  += report.errors;
+        total.ieeeErrors += report.ieeeErrors;
+        ieeeCases.insert(ieeeCases.end(), workerCases.begin() + report.numCases, workerCases.end());
+        workerCases.resize(report.numCases);
+        for (int k = 0; k < NUM_PAIR_KINDS; ++k)
+        {
+            total.errorsByKind[k] += report.errorsByKind[k];
+        }
+        for (const FuzzCase &c : workerCases)
+        {
+            cases.push_back(c);
+            if (seen.insert({c.minA, c.minB}).second)
+            {
+                replay.push_back({c.minA, c.minB});
+            }
+        }
+    }
+    double seconds = sim_harness::seconds_since(start);
+
+    std::printf("%s: %llu vectors on %d workers, %llu cycles in %f seconds (%.0f vectors/s)\n", UNIT_NAME,
+        (unsigned long long) total.vectors, numWorkers, (unsigned long long) total.cycles, seconds,
+        (seconds > 0) ? total.vectors/seconds : 0.0);
+    if (total.errors != 0)
+    {
+        std::printf("Mismatches by pair kind:");
+        for (int k = 0; k < NUM_PAIR_KINDS; ++k)
+        {
+            std::printf(" %s %llu", pair_names[k], (unsigned long long) total.errorsByKind[k]);
+        }
+        std::printf("\n");
+        std::printf("Minimized failing pairs (%zu distinct of %zu reported):\n", replay.size(), cases.size());
+        seen.clear();
+        for (const FuzzCase &c : cases)
+        {
+            if (seen.insert({c.minA, c.minB}).second)
+            {
+                std::printf("  A = 0x%08X, B = 0x%08X: Meas = 0x%08X, Ref = 0x%08X (%s, found as 0x%08X, 0x%08X)\n",
+                    c.minA, c.minB, c.measured, unit_model(c.minA, c.minB), pair_names[c.kind], c.a, c.b);
+            }
+        }
+        if (!outDir.empty())
+        {
+            write_replay(outDir, replay);
+        }
+    }
+    if (ieee)
+    {
+        std::printf("C model deviates from IEEE-754 for %llu vectors\n", (unsigned long long) total.ieeeErrors);
+        seen.clear();
+        for (const FuzzCase &c : ieeeCases)
+        {
+            if (seen.insert({c.minA, c.minB}).second)
+            {
+                std::printf("  A = 0x%08X, B = 0x%08X: Model = 0x%08X, IEEE = 0x%08X (%s)\n", c.minA, c.minB,
+                    c.measured, ieee_model(c.minA, c.minB), pair_names[c.kind]);
+            }
+        }
+    }
+    if (lost != 0)
+    {
+        std::printf("FAILED: %d workers did not report\n", lost);
+        return 1;
+    }
+    if (total.errors != 0)
+    {
+        std::printf("FAILED: %llu mismatches\n", (unsigned long long) total.errors);
+        return 1;
+    }
+    std::printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,125 @@
+#ifndef FLOATING_POINT_UNIT_SIM_H
+#define FLOATING_POINT_UNIT_SIM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "verilated.h"
+
+#include "floating_point.h"
+
+// Verilated src/floating_point_add.v (default) or src/floating_point_multiply.v
+// (-DFP_UNIT_MULTIPLY) and its C model in floating_point.c, for
+// tb/floating_point_fuzz.cpp
+
+#ifdef FP_UNIT_MULTIPLY
+#include "Vfloating_point_multiply.h"
+typedef Vfloating_point_multiply FpUnit;
+static const char *const UNIT_NAME = "floating_point_multiply";
+static inline uint32_t unit_model(uint32_t a, uint32_t b) { return floating_point_multiply_bits(a, b); }
+#else
+#include "Vfloating_point_add.h"
+typedef Vfloating_point_add FpUnit;
+static const char *const UNIT_NAME = "floating_point_add";
+static inline uint32_t unit_model(uint32_t a, uint32_t b) { return floating_point_add_bits(a, b); }
+#endif
+
+// Cycles allowed for the pipeline to drain after the last pair
+constexpr int DRAIN_CYCLES = 64;
+
+// Outcome of a stream of pairs
+struct StreamResult
+{
+    std::size_t errors = 0;
+    uint64_t cycles    = 0;
+    bool timeout       = false;
+};
+
+// One instance of the unit driven cycle by cycle
+class UnitSim
+{
+public:
+    UnitSim() : top_(&context_, "top")
+    {
+        top_.rstIn   = 1;
+        top_.validIn = 0;
+        for (int i = 0; i < 10; ++i)
+        {
+            tick();
+        }
+        top_.rstIn   = 0;
+        tick();
+    }
+
+    ~UnitSim() { top_.final(); }
+
+    void tick()
+    {
+        top_.clkIn = 0;
+        top_.eval();
+        top_.clkIn = 1;
+        top_.eval();
+        ++cycles_;
+    }
+
+    // One pair per cycle, results leave in order and are compared with the
+    // C model, onMismatch(index, measured, expected) reports differences
+    template <typename OnMismatch>
+    void run(const uint32_t *a, const uint32_t *b, std::size_t n, StreamResult &result, OnMismatch onMismatch)
+    {
+        uint64_t start = cycles_;
+        std::size_t numIn = 0, numOut = 0;
+        int idle = 0;
+        while ((numOut < n) && (idle < DRAIN_CYCLES))
+        {
+            top_.validIn = (numIn < n);
+            if (numIn < n)
+            {
+                top_.dataAIn = a[numIn];
+                top_.dataBIn = b[numIn];
+                ++numIn;
+            }
+            tick();
+            if (top_.validOut)
+            {
+                uint32_t measured = (uint32_t) top_.dataOut;
+                uint32_t expected = unit_model(a[numOut], b[numOut]);
+                if (measured != expected)
+                {
+                    ++result.errors;
+                    onMismatch(numOut, measured, expected);
+                }
+                ++numOut;
+                idle = 0;
+            }
+            else if (numIn == n)
+            {
+                ++idle;
+            }
+        }
+        top_.validIn = 0;
+        result.timeout = result.timeout || (numOut < n);
+        result.cycles += cycles_ - start;
+    }
+
+    // Whether the unit and the C model differ for one pair, measured
+    // receives the result of the unit
+    bool mismatch(uint32_t a, uint32_t b, uint32_t *measured = nullptr)
+    {
+        StreamResult result;
+        uint32_t value = unit_model(a, b);
+        run(&a, &b, 1, result, [&](std::size_t, uint32_t meas, uint32_t) { value = meas; });
+        if (measured)
+        {
+            *measured = value;
+        }
+        return (result.errors != 0) || result.timeout;
+    }
+
+private:
+    VerilatedContext context_;
+    FpUnit top_;
+    uint64_t cycles_ = 0;
+};
+
+#endif
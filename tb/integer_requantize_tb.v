@@ -0,0 +1,120 @@
+`timescale 1ns/1ns
+
+module integer_requantize_tb;
+
+    // Edge cases of the 64-bit product and rounding add, the expected
+    // values are from integer_requantize() in models/integer_mac.c
+
+    parameter CLK_PERIOD = 10;
+    parameter RESET_TIME = 100;
+
+    localparam NUM_VECTORS = 11;
+
+    wire clk;
+    wire rst;
+
+    reg [31:0] dataR;
+    reg validR;
+    reg [31:0] multR;
+    reg [5:0] shiftR;
+    reg [7:0] zeroR;
+
+    wire [31:0] data;
+    wire valid;
+
+    // acc, mult, shift, zero and expected output of each vector
+    reg [31:0] accMem  [0:NUM_VECTORS-1];
+    reg [31:0] multMem [0:NUM_VECTORS-1];
+    reg [5:0] shiftMem [0:NUM_VECTORS-1];
+    reg [7:0] zeroMem  [0:NUM_VECTORS-1];
+    reg [31:0] outMem  [0:NUM_VECTORS-1];
+
+    integer inCnt, outCnt, errCnt;
+
+    clk_gen #(.CLK_PERIOD(CLK_PERIOD)) clk_gen_i (.clkOut(clk));
+    rst_gen #(.RESET_TIME(RESET_TIME)) rst_gen_i (.rstOut(rst));
+
+    integer_requantize requant (
+        .clkIn(clk),
+        .rstIn(rst),
+        .dataIn(dataR),
+        .validIn(validR),
+        .biasIn(32'd0),
+        .reluIn(1'b0),
+        .multIn(multR),
+        .shiftIn(shiftR),
+        .zeroIn(zeroR),
+        .dataOut(data),
+        .validOut(valid));
+
+    task set_vector;
+        input integer idx;
+        input [31:0] acc;
+        input [31:0] mult;
+        input [5:0] shift;
+        input [7:0] zero;
+        input [31:0] out;
+        begin
+            accMem[idx]     = acc;
+            multMem[idx]    = mult;
+            shiftMem[idx]   = shift;
+            zeroMem[idx]    = zero;
+            outMem[idx]     = out;
+        end
+    endtask
+
+    initial begin
+        // INT32_MIN * INT32_MIN = 2^62, plus 2^62 for a shift of 63 wraps
+        set_vector( 0, 32'h80000000, 32'h80000000, 63, 8'h00, 32'hFFFFFFFF);
+        set_vector( 1, 32'h80000000, 32'h80000000, 62, 8'h00, 32'h00000001);
+        set_vector( 2, 32'h80000000, 32'h80000000, 63, 8'h03, 32'h00000002);
+        set_vector( 3, 32'h7FFFFFFF, 32'h80000000, 63, 8'h00, 32'h00000000);
+        set_vector( 4, 32'h80000000, 32'h7FFFFFFF, 63, 8'h00, 32'h00000000);
+        set_vector( 5, 32'h80000000, 32'h80000000,  0, 8'h00, 32'h0000007F);
+        set_vector( 6, 32'hFFFFFFFF, 32'h80000000, 31, 8'h00, 32'h00000001);
+        set_vector( 7, 32'h00000001, 32'h80000000, 31, 8'h80, 32'hFFFFFF80);
+        set_vector( 8, 32'h7FFFFFFF, 32'h7FFFFFFF, 62, 8'h00, 32'h00000001);
+        set_vector( 9, 32'h7FFFFFFF, 32'h7FFFFFFF, 63, 8'h00, 32'h00000000);
+        set_vector(10, 32'h00000064, 32'h40000000, 36, 8'h05, 32'h00000007);
+    end
+
+    // One vector per cycle
+    always @(posedge clk) begin
+        if (rst) begin
+            inCnt   <= 0;
+            validR  <= 0;
+        end else begin
+            validR  <= 0;
+            if (inCnt < NUM_VECTORS) begin
+                dataR   <= accMem[inCnt];
+                multR   <= multMem[inCnt];
+                shiftR  <= shiftMem[inCnt];
+                zeroR   <= zeroMem[inCnt];
+                validR  <= 1;
+                inCnt   <= inCnt + 1;
+            end
+        end
+    end
+
+    always @(posedge clk) begin
+        if (rst) begin
+            outCnt  = 0;
+            errCnt  = 0;
+        end else if (valid) begin
+            if (data !== outMem[outCnt]) begin
+                errCnt  = errCnt + 1;
+                $error("Vector %0d: Meas = 0x%08H, Ref=0x%08H", outCnt, data, outMem[outCnt]);
+            end
+            outCnt  = outCnt + 1;
+            if (outCnt == NUM_VECTORS) begin
+                if (errCnt != 0) begin
+                    $display("FAILED: %0d mismatches", errCnt);
+                end else begin
+                    $display("PASSED");
+                end
+                $finish;
+            end
+        end
+    end
+
+endmodule
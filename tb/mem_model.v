@@ -0,0 +1,83 @@
+`timescale 1ns/1ns
+
+module mem_model (
+    clkIn,
+    rstIn,
+    reqValidIn,
+    reqReadyOut,
+    reqWrIn,
+    reqAddrIn,
+    reqWrEnIn,
+    reqDataIn,
+    rspValidOut,
+    rspDataOut);
+
+    // Simulated host memory with valid/ready requests
+    // Reads return in order after RD_LATENCY cycles, writes are posted
+    // STALL_RATE percent of cycles deassert ready
+    parameter ADDR_WIDTH  = 32;
+    parameter DATA_WIDTH  = 64;
+    parameter MEM_WORDS   = 65536;
+    parameter RD_LATENCY  = 4;
+    parameter STALL_RATE  = 0;
+
+    localparam WE_WIDTH   = DATA_WIDTH/8;
+    localparam WORD_LO    = $clog2(WE_WIDTH);
+
+    input clkIn;
+    input rstIn;
+
+    input  reqValidIn;
+    output reqReadyOut;
+    input  reqWrIn;
+    input  [ADDR_WIDTH-1:0] reqAddrIn;
+    input  [  WE_WIDTH-1:0] reqWrEnIn;
+    input  [DATA_WIDTH-1:0] reqDataIn;
+
+    output rspValidOut;
+    output [DATA_WIDTH-1:0] rspDataOut;
+
+    reg [DATA_WIDTH-1:0] memR [0:MEM_WORDS-1];
+
+    reg readyR;
+    reg [RD_LATENCY-1:0] rspValidR;
+    reg [DATA_WIDTH-1:0] rspDataR [0:RD_LATENCY-1];
+
+    wire accept;
+    wire [ADDR_WIDTH-1:0] wordIdx;
+
+    assign accept  = reqValidIn & readyR;
+    assign wordIdx = reqAddrIn >> WORD_LO;
+
+    integer i;
+    always @(posedge clkIn) begin
+        if (rstIn) begin
+            readyR      <= 0;
+            rspValidR   <= 0;
+        end else begin
+            readyR      <= (($random & 32'h7FFFFFFF) % 100) >= STALL_RATE;
+
+            // Byte-enabled writes
+            if (accept && reqWrIn) begin
+                for (i = 0; i < WE_WIDTH; i = i + 1) begin
+                    if (reqWrEnIn[i]) begin
+                        memR[wordIdx][8*i+:8] <= reqDataIn[8*i+:8];
+                    end
+                end
+            end
+
+            // Read response pipeline
+            rspValidR[0]    <= accept & !reqWrIn;
+            rspDataR[0]     <= memR[wordIdx];
+            for (i = 1; i < RD_LATENCY; i = i + 1) begin
+                rspValidR[i]    <= rspValidR[i-1];
+                rspDataR[i]     <= rspDataR[i-1];
+            end
+        end
+    end
+
+    assign reqReadyOut = readyR;
+    assign rspValidOut = rspValidR[RD_LATENCY-1];
+    assign rspDataOut  = rspDataR[RD_LATENCY-1];
+
+endmodule
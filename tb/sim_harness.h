@@ -0,0 +1,18 @@
+#ifndef SIM_HARNESS_H
+#define SIM_HARNESS_H
+
+#include <chrono>
+
+// Shared pieces of the Verilator testbenches (tb/floating_point_fuzz.cpp):
+// timing
+
+namespace sim_harness
+{
+    // Wall-clock seconds since start
+    inline double seconds_since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+#endif